@@ -0,0 +1,429 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "ISoftRepoBench.hpp"
+#include "AllocCounter.hpp"
+#include "RequestArena.hpp"
+#include "Catalog.hpp"
+#include <ErrorSystem.hpp>
+#include <ModCache.hpp>
+#include <ModuleController.hpp>
+#include <algorithm>
+#include <iomanip>
+
+using namespace std;
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CISoftRepoBench ISoftRepoBench;
+
+MAIN_ENTRY_OBJECT(ISoftRepoBench)
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CISoftRepoBench::CISoftRepoBench(void)
+{
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+int CISoftRepoBench::Init(int argc,char* argv[])
+{
+    int result = BenchOptions.ParseCmdLine(argc,argv);
+
+    // should we exit or was it error?
+    if( result != SO_CONTINUE ) return(result);
+
+    vout.Attach(Console);
+    if( BenchOptions.GetOptVerbose() ) {
+        vout.Verbosity(CVerboseStr::high);
+    } else {
+        vout.Verbosity(CVerboseStr::low);
+    }
+
+    vout << low;
+    vout << endl;
+    vout << "# ==============================================================================" << endl;
+    vout << "# ams-isoftrepo-bench" << endl;
+    vout << "# ==============================================================================" << endl;
+
+    // load server config
+    CServerConfigPtr config;
+    if( LoadConfig(BenchOptions.GetArgConfigFile(),config,vout) == false ) return(SO_USER_ERROR);
+    CTemplateSetPtr templates;
+    if( LoadTemplates(config->TemplatePath,templates,vout) == false ) return(SO_USER_ERROR);
+    ApplyConfig(config,templates,PrepareSites(config));
+
+    // bundle overrides, only the default site is measured
+    BundleName = config->Sites.front().BundleName;
+    BundlePath = config->Sites.front().BundlePath;
+    if( BenchOptions.IsOptBundleNameSet() ) {
+        BundleName = BenchOptions.GetOptBundleName();
+    }
+    if( BenchOptions.IsOptBundlePathSet() ) {
+        BundlePath = BenchOptions.GetOptBundlePath();
+    }
+    GetSites()->GetDefaultSite()->Catalog.SetBundles(BundleName,BundlePath);
+
+    vout << "# Bundles    = " << BundleName << endl;
+    vout << "# Path       = " << BundlePath << endl;
+    vout << "# Iterations = " << BenchOptions.GetOptIterations() << endl;
+    vout << "# Warmup     = " << BenchOptions.GetOptWarmup() << endl;
+    vout << "#" << endl;
+
+    return(SO_CONTINUE);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CISoftRepoBench::Run(void)
+{
+    if( BenchOptions.GetOptCatalog() ) return(RunCatalog());
+
+    if( PrepareActions() == false ) return(false);
+
+    vout << low;
+    vout << "# action              ops/s   p50 [ms]   p99 [ms]  allocs/req  w/o arena  bytes/page" << endl;
+    vout << "# --------------- ---------- ---------- ---------- ----------- ---------- -----------" << endl;
+
+    for(CBenchAction& action : Actions){
+        if( BenchOptions.IsOptActionSet() && (BenchOptions.GetOptAction() != action.Name) ) continue;
+        if( action.Modules.empty() ) {
+            vout << "# " << left << setw(15) << action.Name << right << " no synthetic requests" << endl;
+            continue;
+        }
+        if( RunAction(action) == false ) return(false);
+    }
+
+    return(true);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CISoftRepoBench::Finalize(void)
+{
+    if( ErrorSystem.IsError() || BenchOptions.GetOptVerbose() ){
+        vout << low;
+        ErrorSystem.PrintErrors(vout);
+    }
+    vout << endl;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CISoftRepoBench::PrepareActions(void)
+{
+    // handlers share this snapshot, it does not expire during the benchmark
+    CRepoSitePtr site = GetSites()->GetDefaultSite();
+    site->Catalog.SetTimeToLive(0);
+    CCatalogSnapshotPtr snapshot = site->Catalog.GetSnapshot();
+    if( snapshot == NULL ) {
+        ES_ERROR("unable to build catalog");
+        return(false);
+    }
+
+    const CCatalogTable& table = snapshot->Table;
+    if( table.GetModuleTable().size() == 0 ) {
+        ES_ERROR("catalog has no modules");
+        return(false);
+    }
+
+    CBenchAction categories;
+    categories.Name = "categories";
+    categories.Action = "categories";
+    categories.Handler = &CISoftRepoBench::_ListCategories;
+    categories.Modules.push_back(NULL);
+    categories.IncludeVers = "false";
+
+    CBenchAction categories_vers = categories;
+    categories_vers.Name = "categories-vers";
+    categories_vers.IncludeVers = "true";
+
+    CBenchAction module;
+    module.Name = "module";
+    module.Action = "module";
+    module.Handler = &CISoftRepoBench::_Module;
+
+    CBenchAction versions;
+    versions.Name = "versions";
+    versions.Action = "versions";
+    versions.Handler = &CISoftRepoBench::_ModuleVersions;
+
+    CBenchAction version;
+    version.Name = "version";
+    version.Action = "version";
+    version.Handler = &CISoftRepoBench::_Version;
+
+    CBenchAction build;
+    build.Name = "build";
+    build.Action = "build";
+    build.Handler = &CISoftRepoBench::_Build;
+
+    // synthetic requests cover the catalog evenly
+    size_t max_requests = BenchOptions.GetOptIterations();
+
+    for(const CCatalogModule& mod : table.GetModuleTable()){
+        CSmallString module_name = table.GetString(mod.Name);
+        module.Modules.push_back(module_name);
+        versions.Modules.push_back(module_name);
+
+        for(uint32_t i = mod.FirstBuild; i < mod.FirstBuild + mod.NumOfBuilds; i++){
+            const CCatalogBuild& bld = table.GetBuildTable()[i];
+            CSmallString ver = table.GetString(bld.Version);
+            version.Modules.push_back(module_name + ":" + ver);
+            build.Modules.push_back(module_name + ":" + ver + ":" + table.GetString(bld.Arch)
+                                    + ":" + table.GetString(bld.Mode));
+        }
+    }
+
+    CBenchAction* actions[4] = { &module, &versions, &version, &build };
+    for(int i=0; i < 4; i++){
+        std::vector<CSmallString>& mods = actions[i]->Modules;
+        std::sort(mods.begin(),mods.end());
+        mods.erase(std::unique(mods.begin(),mods.end()),mods.end());
+        if( mods.size() > max_requests ){
+            // keep evenly spaced sample
+            std::vector<CSmallString> sample;
+            for(size_t j=0; j < max_requests; j++){
+                sample.push_back(mods[j * mods.size() / max_requests]);
+            }
+            mods.swap(sample);
+        }
+    }
+
+    Actions.push_back(categories);
+    Actions.push_back(categories_vers);
+    Actions.push_back(module);
+    Actions.push_back(versions);
+    Actions.push_back(version);
+    Actions.push_back(build);
+
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+void CISoftRepoBench::SetupRequest(CFCGIRequest& request,const CBenchAction& action,size_t index)
+{
+    request.Params.SetValue("SERVER_NAME","localhost");
+    request.Params.SetValue("SERVER_PORT","80");
+    request.Params.SetValue("SCRIPT_NAME","/isoftrepo/fcgi-bin/isoftrepo.fcgi");
+    request.Params.SetValue("REMOTE_ADDR","127.0.0.1");
+    request.Params.SetValue("action",action.Action);
+    if( action.IncludeVers != NULL ) {
+        request.Params.SetValue("include_vers",action.IncludeVers);
+    }
+    const CSmallString& module = action.Modules[index % action.Modules.size()];
+    if( module != NULL ) {
+        request.Params.SetValue("module",module);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+bool CISoftRepoBench::RunAction(const CBenchAction& action)
+{
+    int niters = BenchOptions.GetOptIterations();
+    int nwarmup = BenchOptions.GetOptWarmup();
+
+    std::vector<uint64_t>   latencies;
+    latencies.reserve(niters);
+
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    uint64_t total = 0;
+
+    for(int i=-nwarmup; i < niters; i++){
+        CFCGIRequest request;
+        SetupRequest(request,action,i < 0 ? 0 : i);
+
+        std::string page;
+
+        uint64_t nallocs = CAllocCounter::GetNumOfAllocations();
+        uint64_t start = GetMonotonicTime();
+
+        bool result = (this->*action.Handler)(request,page);
+        CRequestArena::GetThreadArena().Reset();
+
+        uint64_t time = GetMonotonicTime() - start;
+        nallocs = CAllocCounter::GetNumOfAllocations() - nallocs;
+
+        if( result == false ) {
+            CSmallString error;
+            error << "handler failed for action '" << action.Name << "'";
+            ES_ERROR(error);
+            return(false);
+        }
+        if( i < 0 ) continue;
+
+        latencies.push_back(time);
+        allocations += nallocs;
+        bytes += page.size();
+        total += time;
+    }
+
+    std::sort(latencies.begin(),latencies.end());
+
+    double ops = total > 0 ? niters / (total * 1.0e-6) : 0.0;
+    double p50 = latencies[(niters-1)*50/100] * 1.0e-3;
+    double p99 = latencies[(niters-1)*99/100] * 1.0e-3;
+
+    vout << "  " << left << setw(15) << action.Name << right << fixed;
+    vout << " " << setw(10) << setprecision(1) << ops;
+    vout << " " << setw(10) << setprecision(3) << p50;
+    vout << " " << setw(10) << setprecision(3) << p99;
+    vout << " " << setw(11) << setprecision(1) << (double)allocations / niters;
+    vout << " " << setw(10) << setprecision(1) << CountHeapAllocations(action);
+    vout << " " << setw(11) << bytes / niters;
+    vout << endl;
+
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+double CISoftRepoBench::CountHeapAllocations(const CBenchAction& action)
+{
+    // a shorter untimed pass is enough for counting
+    int niters = std::min(BenchOptions.GetOptIterations(),100);
+
+    CRequestArena::SetEnabled(false);
+
+    uint64_t allocations = 0;
+    for(int i=0; i < niters; i++){
+        CFCGIRequest request;
+        SetupRequest(request,action,i);
+
+        std::string page;
+
+        uint64_t nallocs = CAllocCounter::GetNumOfAllocations();
+        (this->*action.Handler)(request,page);
+        allocations += CAllocCounter::GetNumOfAllocations() - nallocs;
+    }
+
+    CRequestArena::SetEnabled(true);
+
+    return((double)allocations / niters);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CISoftRepoBench::RunCatalog(void)
+{
+    vout << low;
+    vout << "# loader           ms/rebuild   p50 [ms]   p99 [ms]  allocs/rebuild  MB/rebuild  peak [MB]" << endl;
+    vout << "# --------------- ----------- ---------- ---------- --------------- ----------- ----------" << endl;
+
+    if( RunCatalogLoader("dom",false) == false ) return(false);
+    if( RunCatalogLoader("stream",true) == false ) return(false);
+
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CISoftRepoBench::RunCatalogLoader(const char* p_name,bool stream)
+{
+    int niters = BenchOptions.GetOptIterations();
+    int nwarmup = BenchOptions.GetOptWarmup();
+
+    std::vector<uint64_t>   latencies;
+    latencies.reserve(niters);
+
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    uint64_t peak = 0;
+    uint64_t total = 0;
+
+    for(int i=-nwarmup; i < niters; i++){
+        uint64_t live = CAllocCounter::GetLiveBytes();
+        uint64_t nallocs = CAllocCounter::GetNumOfAllocations();
+        uint64_t nbytes = CAllocCounter::GetNumOfBytes();
+        CAllocCounter::ResetPeak();
+
+        bool     result;
+        uint64_t time;
+        if( stream ) {
+            uint64_t start = GetMonotonicTime();
+            CCatalogSnapshotPtr catalog = CCatalog::BuildSnapshot(BundleName,BundlePath);
+            time = GetMonotonicTime() - start;
+            result = catalog != NULL;
+        } else {
+            CModuleController controller;
+            CModCache         cache;
+            uint64_t start = GetMonotonicTime();
+            controller.InitModuleControllerConfig(BundleName,BundlePath);
+            result = controller.LoadBundles(EMBC_BIG);
+            if( result ) controller.MergeBundles(cache);
+            time = GetMonotonicTime() - start;
+        }
+
+        if( result == false ) {
+            CSmallString error;
+            error << "unable to load catalog with '" << p_name << "'";
+            ES_ERROR(error);
+            return(false);
+        }
+        if( i < 0 ) continue;
+
+        latencies.push_back(time);
+        allocations += CAllocCounter::GetNumOfAllocations() - nallocs;
+        bytes += CAllocCounter::GetNumOfBytes() - nbytes;
+        peak = std::max(peak,CAllocCounter::GetPeakBytes() - live);
+        total += time;
+    }
+
+    std::sort(latencies.begin(),latencies.end());
+
+    double avg = total * 1.0e-3 / niters;
+    double p50 = latencies[(niters-1)*50/100] * 1.0e-3;
+    double p99 = latencies[(niters-1)*99/100] * 1.0e-3;
+
+    vout << "  " << left << setw(15) << p_name << right << fixed;
+    vout << " " << setw(11) << setprecision(3) << avg;
+    vout << " " << setw(10) << setprecision(3) << p50;
+    vout << " " << setw(10) << setprecision(3) << p99;
+    vout << " " << setw(15) << setprecision(1) << (double)allocations / niters;
+    vout << " " << setw(11) << setprecision(2) << bytes / niters / 1048576.0;
+    vout << " " << setw(10) << setprecision(2) << peak / 1048576.0;
+    vout << endl;
+
+    return(true);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
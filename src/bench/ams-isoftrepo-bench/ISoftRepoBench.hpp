@@ -0,0 +1,91 @@
+#ifndef ISoftRepoBenchH
+#define ISoftRepoBenchH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "ISoftRepoServer.hpp"
+#include "ISoftRepoBenchOptions.hpp"
+#include <vector>
+#include <string>
+
+//------------------------------------------------------------------------------
+
+/// page handler with its synthetic requests
+
+class CBenchAction {
+public:
+    typedef bool (CISoftRepoServer::*THandler)(CFCGIRequest& request,std::string& page);
+
+    CSmallString                Name;           // name in the report
+    CSmallString                Action;         // value of the action parameter
+    THandler                    Handler;
+    std::vector<CSmallString>   Modules;        // values of the module parameter
+    CSmallString                IncludeVers;    // value of the include_vers parameter
+};
+
+//------------------------------------------------------------------------------
+
+/// runs the server page handlers in-process, output goes to a null sink
+
+class CISoftRepoBench : public CISoftRepoServer {
+public:
+    CISoftRepoBench(void);
+
+// main methods ----------------------------------------------------------------
+    /// init options
+    int Init(int argc,char* argv[]);
+
+    /// main part of program
+    bool Run(void);
+
+    /// finalize
+    void Finalize(void);
+
+// section of private data -----------------------------------------------------
+private:
+    CISoftRepoBenchOptions      BenchOptions;
+    std::vector<CBenchAction>   Actions;
+    CSmallString                BundleName;
+    CFileName                   BundlePath;
+
+    /// prepare synthetic requests from the catalog
+    bool PrepareActions(void);
+
+    /// setup request parameters
+    void SetupRequest(CFCGIRequest& request,const CBenchAction& action,size_t index);
+
+    /// measure one action
+    bool RunAction(const CBenchAction& action);
+
+    /// average number of heap allocations per request with request arenas disabled
+    double CountHeapAllocations(const CBenchAction& action);
+
+    /// compare DOM loading of big bundle caches with the streaming snapshot build
+    bool RunCatalog(void);
+
+    /// measure one catalog loader
+    bool RunCatalogLoader(const char* p_name,bool stream);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef ISoftRepoBenchOptionsH
+#define ISoftRepoBenchOptionsH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <SimpleOptions.hpp>
+
+//------------------------------------------------------------------------------
+
+class CISoftRepoBenchOptions : public CSimpleOptions {
+public:
+    // constructor - tune option setup
+    CISoftRepoBenchOptions(void);
+
+    // program name and description -----------------------------------------------
+    CSO_PROG_NAME_BEGIN
+    "ams-isoftrepo-bench"
+    CSO_PROG_NAME_END
+
+    CSO_PROG_DESC_BEGIN
+    "Measures throughput of isoftrepo.fcgi page handlers without a web server."
+    CSO_PROG_DESC_END
+
+    // list of all options and arguments ------------------------------------------
+    CSO_LIST_BEGIN
+    // arguments ----------------------------
+    CSO_ARG(CSmallString,ConfigFile)
+    // options ------------------------------
+    CSO_OPT(CSmallString,BundleName)
+    CSO_OPT(CSmallString,BundlePath)
+    CSO_OPT(CSmallString,Action)
+    CSO_OPT(int,Iterations)
+    CSO_OPT(int,Warmup)
+    CSO_OPT(bool,Catalog)
+    CSO_OPT(bool,Help)
+    CSO_OPT(bool,Version)
+    CSO_OPT(bool,Verbose)
+    CSO_LIST_END
+
+    CSO_MAP_BEGIN
+    // description of arguments ---------------------------------------------------
+    CSO_MAP_ARG(CSmallString,                   /* argument type */
+                ConfigFile,                          /* argument name */
+                NULL,                           /* default value */
+                true,                           /* is argument mandatory */
+                "configfile",                        /* parametr name */
+                "the name of the server configuration file\n")   /* argument description */
+    // description of options -----------------------------------------------------
+    CSO_MAP_OPT(CSmallString,                   /* option type */
+                BundleName,                        /* option name */
+                NULL,                          /* default value */
+                false,                          /* is option mandatory */
+                'n',                           /* short option name */
+                "names",                      /* long option name */
+                "NAMES",                           /* parametr name */
+                "comma separated list of bundles, it overrides the configuration file")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(CSmallString,                   /* option type */
+                BundlePath,                        /* option name */
+                NULL,                          /* default value */
+                false,                          /* is option mandatory */
+                'p',                           /* short option name */
+                "path",                      /* long option name */
+                "PATH",                           /* parametr name */
+                "directory with bundles, it overrides the configuration file")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(CSmallString,                   /* option type */
+                Action,                        /* option name */
+                NULL,                          /* default value */
+                false,                          /* is option mandatory */
+                'a',                           /* short option name */
+                "action",                      /* long option name */
+                "ACTION",                           /* parametr name */
+                "benchmark only the given action (categories, module, versions, version, build)")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(int,                           /* option type */
+                Iterations,                        /* option name */
+                100,                          /* default value */
+                false,                          /* is option mandatory */
+                'i',                           /* short option name */
+                "iterations",                      /* long option name */
+                "NUMBER",                           /* parametr name */
+                "number of measured requests per action")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(int,                           /* option type */
+                Warmup,                        /* option name */
+                5,                          /* default value */
+                false,                          /* is option mandatory */
+                'w',                           /* short option name */
+                "warmup",                      /* long option name */
+                "NUMBER",                           /* parametr name */
+                "number of unmeasured requests per action")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(bool,                           /* option type */
+                Catalog,                        /* option name */
+                false,                          /* default value */
+                false,                          /* is option mandatory */
+                'c',                           /* short option name */
+                "catalog",                      /* long option name */
+                NULL,                           /* parametr name */
+                "measure rebuilds of the catalog snapshot instead of page handlers")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(bool,                           /* option type */
+                Verbose,                        /* option name */
+                false,                          /* default value */
+                false,                          /* is option mandatory */
+                'v',                           /* short option name */
+                "verbose",                      /* long option name */
+                NULL,                           /* parametr name */
+                "increase output verbosity")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(bool,                           /* option type */
+                Version,                        /* option name */
+                false,                          /* default value */
+                false,                          /* is option mandatory */
+                '\0',                           /* short option name */
+                "version",                      /* long option name */
+                NULL,                           /* parametr name */
+                "output version information and exit")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(bool,                           /* option type */
+                Help,                        /* option name */
+                false,                          /* default value */
+                false,                          /* is option mandatory */
+                'h',                           /* short option name */
+                "help",                      /* long option name */
+                NULL,                           /* parametr name */
+                "display this help and exit")   /* option description */
+    CSO_MAP_END
+
+    // final operation with options ------------------------------------------------
+private:
+    virtual int CheckOptions(void);
+    virtual int FinalizeOptions(void);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,234 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "FCGIBench.hpp"
+#include <ErrorSystem.hpp>
+#include <algorithm>
+#include <thread>
+#include <time.h>
+#include <stdio.h>
+
+using namespace std;
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CFCGIBench FCGIBench;
+
+MAIN_ENTRY_OBJECT(FCGIBench)
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+static uint64_t GetTime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return((uint64_t)ts.tv_sec*1000000 + ts.tv_nsec/1000);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CFCGIBenchResult::CFCGIBenchResult(void)
+{
+    NumOfErrors = 0;
+    NumOfConnects = 0;
+    Duration = 0;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CFCGIBench::CFCGIBench(void)
+    : NextRequest(0)
+{
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+int CFCGIBench::Init(int argc,char* argv[])
+{
+    int result = Options.ParseCmdLine(argc,argv);
+
+    // should we exit or was it error?
+    if( result != SO_CONTINUE ) return(result);
+
+    vout.Attach(Console);
+    if( Options.GetOptVerbose() ) {
+        vout.Verbosity(CVerboseStr::high);
+    } else {
+        vout.Verbosity(CVerboseStr::low);
+    }
+
+    return(SO_CONTINUE);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CFCGIBench::Run(void)
+{
+    if( Options.IsOptServerSet() ) {
+        CFCGIClient client;
+        if( client.SetServer(Options.GetOptServer()) == false ) return(false);
+    }
+
+    vout << low;
+    vout << "# Requests    = " << Options.GetOptRequests() << " per scenario" << endl;
+    vout << "# Concurrency = " << Options.GetOptConcurrency() << endl;
+    vout << "# Query       = " << Options.GetOptQuery() << endl;
+    vout << endl;
+    vout << "# Scenario          Count   Errors       req/s    p50 [ms]    p99 [ms]    max [ms] connections" << endl;
+    vout << "# ------------ ---------- -------- ----------- ----------- ----------- ----------- -----------" << endl;
+
+    bool result = true;
+    if( Options.IsOptServerSet() ) {
+        result &= RunScenario("tcp",false,false);
+        result &= RunScenario("tcp-keep",false,true);
+    }
+    if( Options.IsOptSocketSet() ) {
+        result &= RunScenario("unix",true,false);
+        result &= RunScenario("unix-keep",true,true);
+    }
+
+    return(result);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CFCGIBench::Finalize(void)
+{
+    if( ErrorSystem.IsError() || Options.GetOptVerbose() ){
+        vout << low;
+        ErrorSystem.PrintErrors(vout);
+    }
+    vout << endl;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CFCGIBench::RunScenario(const std::string& name,bool unix_socket,bool keep_conn)
+{
+    CFCGIBenchResult result;
+    result.Name = name;
+
+    NextRequest = 0;
+    uint64_t start = GetTime();
+
+    std::vector<std::thread> workers;
+    for(int i=0; i < Options.GetOptConcurrency(); i++){
+        workers.push_back(std::thread(&CFCGIBench::RunWorker,this,unix_socket,keep_conn,std::ref(result)));
+    }
+    for(std::thread& worker : workers){
+        worker.join();
+    }
+
+    result.Duration = GetTime() - start;
+    PrintResult(result);
+
+    return(result.NumOfErrors == 0);
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIBench::RunWorker(bool unix_socket,bool keep_conn,CFCGIBenchResult& result)
+{
+    CFCGIClient client;
+    std::string port = "0";
+    if( unix_socket ) {
+        client.SetSocket(Options.GetOptSocket());
+    } else {
+        client.SetServer(Options.GetOptServer());
+        port = std::string(Options.GetOptServer());
+        port = port.substr(port.rfind(':')+1);
+    }
+    client.SetKeepConn(keep_conn);
+
+    std::string query(Options.GetOptQuery());
+    std::string uri = std::string(Options.GetOptScriptName()) + "?" + query;
+
+    TFCGIParams params;
+    params.push_back(make_pair(string("REQUEST_METHOD"),string("GET")));
+    params.push_back(make_pair(string("QUERY_STRING"),query));
+    params.push_back(make_pair(string("REQUEST_URI"),uri));
+    params.push_back(make_pair(string("SCRIPT_NAME"),string(Options.GetOptScriptName())));
+    params.push_back(make_pair(string("SERVER_NAME"),string(Options.GetOptServerName())));
+    params.push_back(make_pair(string("SERVER_PORT"),port));
+    params.push_back(make_pair(string("SERVER_PROTOCOL"),string("HTTP/1.1")));
+    params.push_back(make_pair(string("REMOTE_ADDR"),string("127.0.0.1")));
+    params.push_back(make_pair(string("GATEWAY_INTERFACE"),string("CGI/1.1")));
+
+    std::vector<uint64_t>   latencies;
+    size_t                  num_of_errors = 0;
+
+    while( NextRequest++ < Options.GetOptRequests() ){
+        int      status = 0;
+        size_t   length = 0;
+        uint64_t start = GetTime();
+        bool     ok = client.ExecuteRequest(params,status,length);
+        latencies.push_back(GetTime() - start);
+        if( (ok == false) || (status >= 400) ) num_of_errors++;
+    }
+
+    client.Close();
+
+    std::lock_guard<std::mutex> lock(ResultLock);
+    result.NumOfErrors += num_of_errors;
+    result.NumOfConnects += client.GetNumOfConnects();
+    result.Latencies.insert(result.Latencies.end(),latencies.begin(),latencies.end());
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIBench::PrintResult(CFCGIBenchResult& result)
+{
+    size_t count = result.Latencies.size();
+    if( count == 0 ) return;
+    std::sort(result.Latencies.begin(),result.Latencies.end());
+
+    double p50 = result.Latencies[(count-1)*50/100] * 1.0e-3;
+    double p99 = result.Latencies[(count-1)*99/100] * 1.0e-3;
+    double max = result.Latencies[count-1] * 1.0e-3;
+    double rps = result.Duration > 0 ? count / (result.Duration * 1.0e-6) : 0.0;
+
+    char buffer[256];
+    snprintf(buffer,sizeof(buffer),"  %-12s %10lu %8lu %11.1f %11.3f %11.3f %11.3f %11lu",
+             result.Name.c_str(),(unsigned long)count,(unsigned long)result.NumOfErrors,rps,p50,p99,max,
+             (unsigned long)result.NumOfConnects);
+    vout << buffer << endl;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
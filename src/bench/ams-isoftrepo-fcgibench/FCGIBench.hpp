@@ -0,0 +1,88 @@
+#ifndef FCGIBenchH
+#define FCGIBenchH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "FCGIBenchOptions.hpp"
+#include "FCGIClient.hpp"
+#include <VerboseStr.hpp>
+#include <TerminalStr.hpp>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+
+/// result of one transport scenario
+
+class CFCGIBenchResult {
+public:
+    CFCGIBenchResult(void);
+
+    std::string             Name;
+    size_t                  NumOfErrors;
+    size_t                  NumOfConnects;
+    uint64_t                Duration;   // in usec
+    std::vector<uint64_t>   Latencies;  // in usec
+};
+
+//------------------------------------------------------------------------------
+
+/// compares FastCGI transports (TCP x unix socket, new x kept connection)
+
+class CFCGIBench {
+public:
+    CFCGIBench(void);
+
+// main methods ----------------------------------------------------------------
+    /// init options
+    int Init(int argc,char* argv[]);
+
+    /// main part of program
+    bool Run(void);
+
+    /// finalize
+    void Finalize(void);
+
+// section of private data -----------------------------------------------------
+private:
+    CFCGIBenchOptions       Options;
+    CTerminalStr            Console;
+    CVerboseStr             vout;
+    std::atomic<int>        NextRequest;
+    std::mutex              ResultLock;
+
+    /// run one scenario
+    bool RunScenario(const std::string& name,bool unix_socket,bool keep_conn);
+
+    /// worker executing requests
+    void RunWorker(bool unix_socket,bool keep_conn,CFCGIBenchResult& result);
+
+    /// print one line of the report
+    void PrintResult(CFCGIBenchResult& result);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
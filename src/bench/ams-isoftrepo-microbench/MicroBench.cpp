@@ -0,0 +1,559 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "MicroBench.hpp"
+#include <AllocCounter.hpp>
+#include <ErrorSystem.hpp>
+#include <ModUtils.hpp>
+#include <FCGIParams.hpp>
+#include <TemplatePreprocessor.hpp>
+#include <XMLParser.hpp>
+#include <XMLPrinter.hpp>
+#include <algorithm>
+#include <iomanip>
+#include <random>
+#include <time.h>
+#include <stdlib.h>
+
+using namespace std;
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CMicroBench MicroBench;
+
+MAIN_ENTRY_OBJECT(MicroBench)
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+static uint64_t GetTime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return((uint64_t)ts.tv_sec*1000000000 + ts.tv_nsec);
+}
+
+//------------------------------------------------------------------------------
+
+const CMicroCase CMicroBench::Cases[] = {
+    { "parse-module-name",    &CMicroBench::SetupParseModuleName,    &CMicroBench::RunParseModuleName },
+    { "encode-string",        &CMicroBench::SetupEncodeString,       &CMicroBench::RunEncodeString },
+    { "sort-versions",        &CMicroBench::SetupSortVersions,       &CMicroBench::RunSortVersions },
+    { "template-params",      &CMicroBench::SetupTemplateParams,     &CMicroBench::RunTemplateParams },
+    { "preprocess-template",  &CMicroBench::SetupPreprocessTemplate, &CMicroBench::RunPreprocessTemplate },
+    { "print-xml",            &CMicroBench::SetupPrintXML,           &CMicroBench::RunPrintXML },
+};
+
+const size_t CMicroBench::NumOfCases = sizeof(CMicroBench::Cases)/sizeof(CMicroBench::Cases[0]);
+
+//------------------------------------------------------------------------------
+
+// it resembles a version list of the module page
+static const char* MicroTemplate =
+    "<html>\n"
+    "<body>\n"
+    "<h2>_MODULE</h2>\n"
+    "<ul>\n"
+    "<!--DO CYCLE VERSIONS-->\n"
+    "<li class=\"_CLASS\"><a href=\"_SERVERSCRIPTURI?action=version&amp;module=_MODVERURL\">_MODVER</a></li>\n"
+    "<!--END CYCLE VERSIONS-->\n"
+    "</ul>\n"
+    "<!--IF DEFAULT-->\n"
+    "<p>_DEFAULT</p>\n"
+    "<!--END IF DEFAULT-->\n"
+    "</body>\n"
+    "</html>\n";
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CMicroResult::CMicroResult(void)
+{
+    Size = 0;
+    Iterations = 0;
+    NsPerOp = 0;
+    AllocsPerOp = 0;
+    BytesPerOp = 0;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CMicroBench::CMicroBench(void)
+{
+    Sink = 0;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+int CMicroBench::Init(int argc,char* argv[])
+{
+    int result = Options.ParseCmdLine(argc,argv);
+
+    // should we exit or was it error?
+    if( result != SO_CONTINUE ) return(result);
+
+    vout.Attach(Console);
+    if( Options.GetOptVerbose() ) {
+        vout.Verbosity(CVerboseStr::high);
+    } else {
+        vout.Verbosity(CVerboseStr::low);
+    }
+
+    if( ParseSizes() == false ) return(SO_USER_ERROR);
+
+    if( Options.IsOptBenchmarkSet() ) {
+        bool found = false;
+        for(size_t i=0; i < NumOfCases; i++) {
+            if( Options.GetOptBenchmark() == Cases[i].Name ) found = true;
+        }
+        if( found == false ) {
+            CSmallString error;
+            error << "unknown benchmark '" << Options.GetOptBenchmark() << "'";
+            ES_ERROR(error);
+            return(SO_USER_ERROR);
+        }
+    }
+
+    return(SO_CONTINUE);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CMicroBench::Run(void)
+{
+    vout << low;
+    vout << "# Minimum time = " << Options.GetOptMinTime() << " ms per benchmark and size" << endl;
+    vout << endl;
+    vout << "# Benchmark                 Size   Iterations        ns/op   allocs/op    bytes/op" << endl;
+    vout << "# ------------------- ---------- ------------ ------------ ----------- -----------" << endl;
+
+    for(size_t i=0; i < NumOfCases; i++) {
+        if( Options.IsOptBenchmarkSet() && (Options.GetOptBenchmark() != Cases[i].Name) ) continue;
+        for(size_t size : Sizes) {
+            if( Measure(Cases[i],size) == false ) {
+                CSmallString error;
+                error << "benchmark '" << Cases[i].Name << "' failed for size " << (int)size;
+                ES_ERROR(error);
+                return(false);
+            }
+        }
+    }
+
+    if( Options.IsOptJSONSet() ) {
+        if( WriteJSON() == false ) return(false);
+    }
+
+    vout << high;
+    vout << endl;
+    vout << "# Sink = " << Sink << endl;
+
+    return(true);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CMicroBench::Finalize(void)
+{
+    if( ErrorSystem.IsError() || Options.GetOptVerbose() ){
+        vout << low;
+        ErrorSystem.PrintErrors(vout);
+    }
+    vout << endl;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CMicroBench::ParseSizes(void)
+{
+    const char* p_str = Options.GetOptSizes();
+    while( (p_str != NULL) && (*p_str != '\0') ) {
+        char* p_end = NULL;
+        long size = strtol(p_str,&p_end,10);
+        if( (p_end == p_str) || (size <= 0) || ((*p_end != ',') && (*p_end != '\0')) ) {
+            CSmallString error;
+            error << "illegal list of sizes '" << Options.GetOptSizes() << "'";
+            ES_ERROR(error);
+            return(false);
+        }
+        Sizes.push_back(size);
+        p_str = (*p_end == ',') ? p_end + 1 : p_end;
+    }
+
+    if( Sizes.empty() ) {
+        ES_ERROR("at least one size is required");
+        return(false);
+    }
+
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CMicroBench::Measure(const CMicroCase& mcase,size_t size)
+{
+    if( (this->*mcase.Setup)(size) == false ) return(false);
+
+    // warm up, it also checks that the body works
+    if( (this->*mcase.Body)() == false ) return(false);
+
+    uint64_t min_time = (uint64_t)Options.GetOptMinTime()*1000000;
+    uint64_t iters = 1;
+
+    for(;;) {
+        uint64_t allocs = CAllocCounter::GetNumOfAllocations();
+        uint64_t bytes = CAllocCounter::GetNumOfBytes();
+        uint64_t start = GetTime();
+
+        for(uint64_t i=0; i < iters; i++) {
+            if( (this->*mcase.Body)() == false ) return(false);
+        }
+
+        uint64_t elapsed = GetTime() - start;
+        allocs = CAllocCounter::GetNumOfAllocations() - allocs;
+        bytes = CAllocCounter::GetNumOfBytes() - bytes;
+
+        if( elapsed >= min_time ) {
+            CMicroResult result;
+            result.Name = mcase.Name;
+            result.Size = size;
+            result.Iterations = iters;
+            result.NsPerOp = (double)elapsed / iters;
+            result.AllocsPerOp = (double)allocs / iters;
+            result.BytesPerOp = (double)bytes / iters;
+            PrintResult(result);
+            Results.push_back(result);
+            return(true);
+        }
+
+        // estimate the number of iterations for the minimum time
+        // with a margin, but grow at most hundred times per round
+        uint64_t next = iters*100;
+        if( elapsed > 0 ) next = min(next,iters*min_time/elapsed + iters/5);
+        iters = max(next,iters+1);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CMicroBench::PrintResult(const CMicroResult& result)
+{
+    vout << low;
+    vout << "  " << left << setw(19) << result.Name << right;
+    vout << " " << setw(10) << result.Size;
+    vout << " " << setw(12) << result.Iterations;
+    vout << fixed;
+    vout << " " << setw(12) << setprecision(1) << result.NsPerOp;
+    vout << " " << setw(11) << setprecision(2) << result.AllocsPerOp;
+    vout << " " << setw(11) << setprecision(1) << result.BytesPerOp;
+    vout << endl;
+}
+
+//------------------------------------------------------------------------------
+
+bool CMicroBench::WriteJSON(void)
+{
+    if( Options.GetOptJSON() == "-" ) {
+        WriteJSON(stdout);
+        return(true);
+    }
+
+    FILE* p_fout = fopen(Options.GetOptJSON(),"w");
+    if( p_fout == NULL ) {
+        CSmallString error;
+        error << "unable to open JSON file '" << Options.GetOptJSON() << "'";
+        ES_ERROR(error);
+        return(false);
+    }
+
+    WriteJSON(p_fout);
+
+    if( fclose(p_fout) != 0 ) {
+        CSmallString error;
+        error << "unable to write JSON file '" << Options.GetOptJSON() << "'";
+        ES_ERROR(error);
+        return(false);
+    }
+
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+void CMicroBench::WriteJSON(FILE* p_fout)
+{
+    // names of benchmarks do not need escaping
+    fprintf(p_fout,"{\n");
+    fprintf(p_fout,"  \"program\": \"%s\",\n",(const char*)Options.GetProgramName());
+    fprintf(p_fout,"  \"min_time_ms\": %d,\n",Options.GetOptMinTime());
+    fprintf(p_fout,"  \"results\": [\n");
+    for(size_t i=0; i < Results.size(); i++) {
+        const CMicroResult& result = Results[i];
+        fprintf(p_fout,"    { \"name\": \"%s\", \"size\": %lu, \"iterations\": %llu, "
+                       "\"ns_per_op\": %.1f, \"allocs_per_op\": %.2f, \"bytes_per_op\": %.1f }%s\n",
+                result.Name.c_str(),(unsigned long)result.Size,(unsigned long long)result.Iterations,
+                result.NsPerOp,result.AllocsPerOp,result.BytesPerOp,
+                (i + 1 < Results.size()) ? "," : "");
+    }
+    fprintf(p_fout,"  ]\n");
+    fprintf(p_fout,"}\n");
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CMicroBench::SetupParseModuleName(size_t size)
+{
+    // the size is the length of the module name
+    std::string module;
+    for(size_t i=0; i < size; i++) module += (char)('a' + i % 26);
+    module += ":1.2.3:x86_64:para";
+
+    Strings.clear();
+    Strings.push_back(module.c_str());
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CMicroBench::RunParseModuleName(void)
+{
+    CSmallString name,ver,arch,mode;
+    CModUtils::ParseModuleName(Strings[0],name,ver,arch,mode);
+    Sink += name.GetLength() + ver.GetLength() + arch.GetLength() + mode.GetLength();
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CMicroBench::SetupEncodeString(size_t size)
+{
+    // the size is the length of the string, every fourth character is escaped
+    static const char* chars = "abc:def/ghi ";
+    std::string str;
+    for(size_t i=0; i < size; i++) str += chars[i % 12];
+
+    Strings.clear();
+    Strings.push_back(str.c_str());
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CMicroBench::RunEncodeString(void)
+{
+    Sink += CFCGIParams::EncodeString(Strings[0]).GetLength();
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CMicroBench::SetupSortVersions(size_t size)
+{
+    // the size is the number of versions, they have to be unique
+    // the order is shuffled with a fixed seed to be the same in all runs
+    Strings.clear();
+    for(size_t i=0; i < size; i++) {
+        CSmallString version;
+        version << (int)(i / 10) << "." << (int)(i % 10);
+        Strings.push_back(version);
+    }
+    std::mt19937 random(12345);
+    std::shuffle(Strings.begin(),Strings.end(),random);
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CMicroBench::RunSortVersions(void)
+{
+    // it includes building of the list as when catalog tables are built
+    Versions.clear();
+    for(size_t i=0; i < Strings.size(); i++) {
+        CVerRecord verrcd;
+        verrcd.version = Strings[i];
+        verrcd.verindx = i % 3;
+        Versions.push_back(verrcd);
+    }
+    Versions.sort(sort_tokens);
+    Sink += Versions.front().verindx;
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CMicroBench::SetupTemplateParams(size_t size)
+{
+    // the size is the number of rows of the cycle
+    SetupSortVersions(size);
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CMicroBench::RunTemplateParams(void)
+{
+    CTemplateParams params;
+    if( FillParams(params) == false ) return(false);
+    Sink++;
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CMicroBench::SetupPreprocessTemplate(size_t size)
+{
+    // the size is the number of rows of the cycle
+    if( LoadTemplate() == false ) return(false);
+    SetupSortVersions(size);
+
+    Params.reset(new CTemplateParams);
+    return(FillParams(*Params));
+}
+
+//------------------------------------------------------------------------------
+
+bool CMicroBench::RunPreprocessTemplate(void)
+{
+    CTemplatePreprocessor preprocessor;
+    CXMLDocument          output_xml;
+
+    preprocessor.SetInputTemplate(&Template);
+    preprocessor.SetOutputDocument(&output_xml);
+
+    if( preprocessor.PreprocessTemplate(Params.get()) == false ) {
+        ES_ERROR("unable to preprocess template");
+        return(false);
+    }
+    Sink += output_xml.GetNumberOfChildNodes();
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CMicroBench::SetupPrintXML(size_t size)
+{
+    // the size is the number of rows of the printed document
+    if( SetupPreprocessTemplate(size) == false ) return(false);
+
+    CTemplatePreprocessor preprocessor;
+    Document.reset(new CXMLDocument);
+
+    preprocessor.SetInputTemplate(&Template);
+    preprocessor.SetOutputDocument(Document.get());
+
+    if( preprocessor.PreprocessTemplate(Params.get()) == false ) {
+        ES_ERROR("unable to preprocess template");
+        return(false);
+    }
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CMicroBench::RunPrintXML(void)
+{
+    CXMLPrinter xml_printer;
+
+    xml_printer.SetPrintedXMLNode(Document.get());
+    xml_printer.SetPrintAsItIs(true);
+
+    unsigned char* p_data;
+    unsigned int   len = 0;
+
+    if( (p_data = xml_printer.Print(len)) == NULL ) {
+        ES_ERROR("unable to print output");
+        return(false);
+    }
+    delete[] p_data;
+
+    Sink += len;
+    return(true);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CMicroBench::LoadTemplate(void)
+{
+    Template.RemoveAllChildNodes();
+
+    CXMLParser xml_parser;
+    xml_parser.SetOutputXMLNode(&Template);
+    xml_parser.EnableWhiteCharacters(true);
+
+    if( xml_parser.Parse(MicroTemplate,strlen(MicroTemplate)) == false ) {
+        ES_ERROR("unable to parse template");
+        return(false);
+    }
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CMicroBench::FillParams(CTemplateParams& params)
+{
+    // the same sequence as in module page handlers
+    params.Initialize();
+    params.SetParam("MODULE","abinit");
+    params.SetParam("SERVERSCRIPTURI","/isoftrepo.fcgi");
+
+    params.StartCycle("VERSIONS");
+    for(size_t i=0; i < Strings.size(); i++) {
+        CSmallString modver;
+        modver << "abinit:" << Strings[i];
+        params.SetParam("CLASS",i == 0 ? "default" : "other");
+        params.SetParam("MODVER",modver);
+        params.SetParam("MODVERURL",CFCGIParams::EncodeString(modver));
+        params.NextRun();
+    }
+    params.EndCycle("VERSIONS");
+
+    params.StartCondition("DEFAULT",true);
+    if( ! Strings.empty() ) params.SetParam("DEFAULT",Strings[0]);
+    params.EndCondition("DEFAULT");
+
+    if( params.Finalize() == false ) {
+        ES_ERROR("unable to prepare template parameters");
+        return(false);
+    }
+    return(true);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
@@ -0,0 +1,143 @@
+#ifndef MicroBenchH
+#define MicroBenchH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "MicroBenchOptions.hpp"
+#include <VerRecord.hpp>
+#include <VerboseStr.hpp>
+#include <TerminalStr.hpp>
+#include <Template.hpp>
+#include <TemplateParams.hpp>
+#include <XMLDocument.hpp>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+
+//------------------------------------------------------------------------------
+
+class CMicroBench;
+
+/// measured primitive, the setup prepares input of the given size outside
+/// of the measured time, the body is executed repeatedly, false means error
+
+class CMicroCase {
+public:
+    const char*     Name;
+    bool (CMicroBench::*Setup)(size_t size);
+    bool (CMicroBench::*Body)(void);
+};
+
+//------------------------------------------------------------------------------
+
+/// result of one primitive and input size
+
+class CMicroResult {
+public:
+    CMicroResult(void);
+
+    std::string     Name;
+    size_t          Size;
+    uint64_t        Iterations;
+    double          NsPerOp;
+    double          AllocsPerOp;
+    double          BytesPerOp;
+};
+
+//------------------------------------------------------------------------------
+
+/// microbenchmarks of primitives executed by every request
+
+class CMicroBench {
+public:
+    CMicroBench(void);
+
+// main methods ----------------------------------------------------------------
+    /// init options
+    int Init(int argc,char* argv[]);
+
+    /// main part of program
+    bool Run(void);
+
+    /// finalize
+    void Finalize(void);
+
+// section of private data -----------------------------------------------------
+private:
+    CMicroBenchOptions              Options;
+    CTerminalStr                    Console;
+    CVerboseStr                     vout;
+    std::vector<size_t>             Sizes;
+    std::vector<CMicroResult>       Results;
+    uint64_t                        Sink;       // keeps results of bodies alive
+
+    /// all measured primitives
+    static const CMicroCase         Cases[];
+    static const size_t             NumOfCases;
+
+    // inputs prepared by setups
+    std::vector<CSmallString>       Strings;
+    std::list<CVerRecord>           Versions;
+    CTemplate                       Template;
+    std::unique_ptr<CTemplateParams> Params;
+    std::unique_ptr<CXMLDocument>   Document;
+
+    /// parse list of sizes
+    bool ParseSizes(void);
+
+    /// measure one primitive for one size
+    bool Measure(const CMicroCase& mcase,size_t size);
+
+    /// print one line of the report
+    void PrintResult(const CMicroResult& result);
+
+    /// write all results in JSON format
+    bool WriteJSON(void);
+    void WriteJSON(FILE* p_fout);
+
+    // primitives
+    bool SetupParseModuleName(size_t size);
+    bool RunParseModuleName(void);
+    bool SetupEncodeString(size_t size);
+    bool RunEncodeString(void);
+    bool SetupSortVersions(size_t size);
+    bool RunSortVersions(void);
+    bool SetupTemplateParams(size_t size);
+    bool RunTemplateParams(void);
+    bool SetupPreprocessTemplate(size_t size);
+    bool RunPreprocessTemplate(void);
+    bool SetupPrintXML(size_t size);
+    bool RunPrintXML(void);
+
+    /// template with one cycle of rows
+    bool LoadTemplate(void);
+
+    /// fill parameters of the template, rows are given by Strings
+    bool FillParams(CTemplateParams& params);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
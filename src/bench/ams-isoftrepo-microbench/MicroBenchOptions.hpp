@@ -0,0 +1,129 @@
+#ifndef MicroBenchOptionsH
+#define MicroBenchOptionsH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <SimpleOptions.hpp>
+
+//------------------------------------------------------------------------------
+
+class CMicroBenchOptions : public CSimpleOptions {
+public:
+    // constructor - tune option setup
+    CMicroBenchOptions(void);
+
+    // program name and description -----------------------------------------------
+    CSO_PROG_NAME_BEGIN
+    "ams-isoftrepo-microbench"
+    CSO_PROG_NAME_END
+
+    CSO_PROG_DESC_BEGIN
+    "Measures primitives used by every request of isoftrepo.fcgi: module name parsing, URL encoding, version ordering, template parameters, template preprocessing and XML printing."
+    CSO_PROG_DESC_END
+
+    // list of all options and arguments ------------------------------------------
+    CSO_LIST_BEGIN
+    // options ------------------------------
+    CSO_OPT(CSmallString,Benchmark)
+    CSO_OPT(CSmallString,Sizes)
+    CSO_OPT(int,MinTime)
+    CSO_OPT(CSmallString,JSON)
+    CSO_OPT(bool,Help)
+    CSO_OPT(bool,Version)
+    CSO_OPT(bool,Verbose)
+    CSO_LIST_END
+
+    CSO_MAP_BEGIN
+    // description of options -----------------------------------------------------
+    CSO_MAP_OPT(CSmallString,                   /* option type */
+                Benchmark,                        /* option name */
+                NULL,                          /* default value */
+                false,                          /* is option mandatory */
+                'b',                           /* short option name */
+                "benchmark",                      /* long option name */
+                "NAME",                           /* parametr name */
+                "measure only the given primitive (parse-module-name, encode-string, sort-versions, template-params, preprocess-template, print-xml)")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(CSmallString,                   /* option type */
+                Sizes,                        /* option name */
+                "1,10,100,1000",                          /* default value */
+                false,                          /* is option mandatory */
+                's',                           /* short option name */
+                "sizes",                      /* long option name */
+                "LIST",                           /* parametr name */
+                "comma separated list of input sizes, the meaning of the size is given by the primitive")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(int,                           /* option type */
+                MinTime,                        /* option name */
+                200,                          /* default value */
+                false,                          /* is option mandatory */
+                't',                           /* short option name */
+                "mintime",                      /* long option name */
+                "MS",                           /* parametr name */
+                "minimum measured time of each primitive and size in ms")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(CSmallString,                   /* option type */
+                JSON,                        /* option name */
+                NULL,                          /* default value */
+                false,                          /* is option mandatory */
+                'j',                           /* short option name */
+                "json",                      /* long option name */
+                "FILE",                           /* parametr name */
+                "write results also in JSON format into the file for comparison of commits, - for standard output")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(bool,                           /* option type */
+                Verbose,                        /* option name */
+                false,                          /* default value */
+                false,                          /* is option mandatory */
+                'v',                           /* short option name */
+                "verbose",                      /* long option name */
+                NULL,                           /* parametr name */
+                "increase output verbosity")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(bool,                           /* option type */
+                Version,                        /* option name */
+                false,                          /* default value */
+                false,                          /* is option mandatory */
+                '\0',                           /* short option name */
+                "version",                      /* long option name */
+                NULL,                           /* parametr name */
+                "output version information and exit")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(bool,                           /* option type */
+                Help,                        /* option name */
+                false,                          /* default value */
+                false,                          /* is option mandatory */
+                'h',                           /* short option name */
+                "help",                      /* long option name */
+                NULL,                           /* parametr name */
+                "display this help and exit")   /* option description */
+    CSO_MAP_END
+
+    // final operation with options ------------------------------------------------
+private:
+    virtual int CheckOptions(void);
+    virtual int FinalizeOptions(void);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
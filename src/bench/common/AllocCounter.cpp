@@ -0,0 +1,116 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "AllocCounter.hpp"
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+#include <malloc.h>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+static std::atomic<uint64_t> NumOfAllocations(0);
+static std::atomic<uint64_t> NumOfBytes(0);
+static std::atomic<uint64_t> LiveBytes(0);     // usable sizes of live blocks
+static std::atomic<uint64_t> PeakBytes(0);
+
+//------------------------------------------------------------------------------
+
+uint64_t CAllocCounter::GetNumOfAllocations(void)
+{
+    return(NumOfAllocations.load(std::memory_order_relaxed));
+}
+
+//------------------------------------------------------------------------------
+
+uint64_t CAllocCounter::GetNumOfBytes(void)
+{
+    return(NumOfBytes.load(std::memory_order_relaxed));
+}
+
+//------------------------------------------------------------------------------
+
+uint64_t CAllocCounter::GetLiveBytes(void)
+{
+    return(LiveBytes.load(std::memory_order_relaxed));
+}
+
+//------------------------------------------------------------------------------
+
+uint64_t CAllocCounter::GetPeakBytes(void)
+{
+    return(PeakBytes.load(std::memory_order_relaxed));
+}
+
+//------------------------------------------------------------------------------
+
+void CAllocCounter::ResetPeak(void)
+{
+    PeakBytes.store(LiveBytes.load(std::memory_order_relaxed),std::memory_order_relaxed);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void* operator new(size_t size)
+{
+    NumOfAllocations.fetch_add(1,std::memory_order_relaxed);
+    NumOfBytes.fetch_add(size,std::memory_order_relaxed);
+    void* p_mem = malloc(size == 0 ? 1 : size);
+    if( p_mem == NULL ) throw std::bad_alloc();
+
+    uint64_t usable = malloc_usable_size(p_mem);
+    uint64_t live = LiveBytes.fetch_add(usable,std::memory_order_relaxed) + usable;
+    uint64_t peak = PeakBytes.load(std::memory_order_relaxed);
+    while( (live > peak) && (PeakBytes.compare_exchange_weak(peak,live,std::memory_order_relaxed) == false) );
+
+    return(p_mem);
+}
+
+//------------------------------------------------------------------------------
+
+void* operator new[](size_t size)
+{
+    return(operator new(size));
+}
+
+//------------------------------------------------------------------------------
+
+void operator delete(void* p_mem) noexcept
+{
+    if( p_mem != NULL ) LiveBytes.fetch_sub(malloc_usable_size(p_mem),std::memory_order_relaxed);
+    free(p_mem);
+}
+
+//------------------------------------------------------------------------------
+
+void operator delete[](void* p_mem) noexcept
+{
+    operator delete(p_mem);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
@@ -0,0 +1,52 @@
+#ifndef AllocCounterH
+#define AllocCounterH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+
+/// counts allocations done through the global operator new
+/// the counter is linked only into benchmark programs
+
+class CAllocCounter {
+public:
+    /// number of allocations since the program start
+    static uint64_t GetNumOfAllocations(void);
+
+    /// number of allocated bytes since the program start
+    static uint64_t GetNumOfBytes(void);
+
+    /// number of currently allocated bytes
+    static uint64_t GetLiveBytes(void);
+
+    /// maximum of allocated bytes since the last reset
+    static uint64_t GetPeakBytes(void);
+
+    /// start tracking of the peak from the current state
+    static void ResetPeak(void);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,474 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "GenBundles.hpp"
+#include <ErrorSystem.hpp>
+#include <SmallTimeAndDate.hpp>
+#include <sys/stat.h>
+#include <errno.h>
+#include <string.h>
+
+using namespace std;
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+// bundle layout read by CModuleController::LoadBundles
+#define BUNDLE_DIR          "_ams_bundle"
+#define BUNDLE_CONFIG       "bundle.xml"
+#define BUNDLE_CACHE_SMALL  "cache-small.xml"
+#define BUNDLE_CACHE_BIG    "cache-big.xml"
+
+//------------------------------------------------------------------------------
+
+static const char* ModuleWords[] = {
+    "amber", "gromacs", "orca", "gaussian", "cp2k", "namd", "vmd", "pymol",
+    "blast", "hmmer", "bowtie", "samtools", "openmpi", "fftw", "lapack", "python",
+    "cuda", "gcc", "intel", "rosetta", "autodock", "cmake", "boost", "hdf5"
+};
+
+static const char* CategoryWords[] = {
+    "Molecular Dynamics", "Quantum Chemistry", "Bioinformatics", "Docking",
+    "Visualization", "Compilers", "Libraries", "Development", "Structure Prediction",
+    "Utilities", "Parallel Environment", "Databases"
+};
+
+static const char* DocWords[] = {
+    "the", "module", "provides", "simulation", "package", "for", "analysis", "of",
+    "molecular", "systems", "with", "support", "parallel", "execution", "and",
+    "accelerated", "kernels", "data", "structures", "input", "output", "files"
+};
+
+#define NUM_OF(array) (sizeof(array)/sizeof(array[0]))
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CGenBundles GenBundles;
+
+MAIN_ENTRY_OBJECT(GenBundles)
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CGenBundles::CGenBundles(void)
+{
+    NumOfBuilds = 0;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+int CGenBundles::Init(int argc,char* argv[])
+{
+    int result = Options.ParseCmdLine(argc,argv);
+
+    // should we exit or was it error?
+    if( result != SO_CONTINUE ) return(result);
+
+    vout.Attach(Console);
+    if( Options.GetOptVerbose() ) {
+        vout.Verbosity(CVerboseStr::high);
+    } else {
+        vout.Verbosity(CVerboseStr::low);
+    }
+
+    SplitList(Options.GetOptArchs(),Archs);
+    SplitList(Options.GetOptModes(),Modes);
+
+    if( Archs.empty() || Modes.empty() ) {
+        ES_ERROR("at least one architecture and one mode is required");
+        return(SO_USER_ERROR);
+    }
+
+    Random.seed(Options.GetOptSeed());
+
+    return(SO_CONTINUE);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CGenBundles::Run(void)
+{
+    CFileName output_dir = Options.GetArgOutputDir();
+
+    if( CreateDirectory(output_dir) == false ) {
+        CSmallString error;
+        error << "unable to create output directory '" << output_dir << "'";
+        ES_ERROR(error);
+        return(false);
+    }
+
+    PrepareNames();
+
+    CSmallString bundle_names;
+    for(int i=0; i < Options.GetOptBundles(); i++){
+        char buffer[64];
+        snprintf(buffer,sizeof(buffer),"%s%02d",(const char*)Options.GetOptPrefix(),i+1);
+        if( i > 0 ) bundle_names << ",";
+        bundle_names << buffer;
+
+        vout << high;
+        vout << "Writing bundle " << buffer << " ..." << endl;
+        if( WriteBundle(i,output_dir / CSmallString(buffer)) == false ) return(false);
+    }
+
+    vout << low;
+    vout << "# Bundles    = " << Options.GetOptBundles() << endl;
+    vout << "# Categories = " << CategoryNames.size() << endl;
+    vout << "# Modules    = " << ModuleNames.size() << endl;
+    vout << "# Builds     = " << NumOfBuilds << endl;
+    vout << "#" << endl;
+    vout << "# server configuration:" << endl;
+    vout << "<ams name=\"" << bundle_names << "\"" << endl;
+    vout << "     path=\"" << output_dir << "\"/>" << endl;
+
+    return(true);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CGenBundles::Finalize(void)
+{
+    if( ErrorSystem.IsError() || Options.GetOptVerbose() ){
+        vout << low;
+        ErrorSystem.PrintErrors(vout);
+    }
+    vout << endl;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CGenBundles::PrepareNames(void)
+{
+    for(int i=0; i < Options.GetOptCategories(); i++){
+        char buffer[128];
+        if( i < (int)NUM_OF(CategoryWords) ){
+            snprintf(buffer,sizeof(buffer),"%s",CategoryWords[i]);
+        } else {
+            snprintf(buffer,sizeof(buffer),"%s %d",CategoryWords[i % NUM_OF(CategoryWords)],
+                     (int)(i / NUM_OF(CategoryWords)));
+        }
+        CategoryNames.push_back(buffer);
+    }
+
+    for(int i=0; i < Options.GetOptModules(); i++){
+        char buffer[128];
+        if( i < (int)NUM_OF(ModuleWords) ){
+            snprintf(buffer,sizeof(buffer),"%s",ModuleWords[i]);
+        } else {
+            snprintf(buffer,sizeof(buffer),"%s%d",ModuleWords[i % NUM_OF(ModuleWords)],
+                     (int)(i / NUM_OF(ModuleWords)));
+        }
+        ModuleNames.push_back(buffer);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+bool CGenBundles::WriteBundle(int bundle_id,const CFileName& bundle_dir)
+{
+    CFileName config_dir = bundle_dir / BUNDLE_DIR;
+    if( CreateDirectory(config_dir) == false ) {
+        CSmallString error;
+        error << "unable to create bundle directory '" << config_dir << "'";
+        ES_ERROR(error);
+        return(false);
+    }
+
+    CSmallString bundle_name = bundle_dir.GetFileNameExt();
+
+    // bundle config
+    CFileName config_name = config_dir / BUNDLE_CONFIG;
+    FILE* p_fout = fopen(config_name,"w");
+    if( p_fout == NULL ) {
+        CSmallString error;
+        error << "unable to create '" << config_name << "'";
+        ES_ERROR(error);
+        return(false);
+    }
+    fprintf(p_fout,"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    fprintf(p_fout,"<bundle name=\"%s\" maintainer=\"Maintainer %d\" contact=\"support%d@example.org\"/>\n",
+            (const char*)bundle_name,bundle_id+1,bundle_id+1);
+    fclose(p_fout);
+
+    // caches
+    CFileName small_name = config_dir / BUNDLE_CACHE_SMALL;
+    CFileName big_name = config_dir / BUNDLE_CACHE_BIG;
+    FILE* p_small = fopen(small_name,"w");
+    FILE* p_big = fopen(big_name,"w");
+    if( (p_small == NULL) || (p_big == NULL) ) {
+        if( p_small ) fclose(p_small);
+        if( p_big ) fclose(p_big);
+        CSmallString error;
+        error << "unable to create cache files in '" << config_dir << "'";
+        ES_ERROR(error);
+        return(false);
+    }
+
+    fprintf(p_small,"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<cache>\n");
+    fprintf(p_big,"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<cache>\n");
+
+    for(int i=bundle_id; i < (int)ModuleNames.size(); i += Options.GetOptBundles()){
+        WriteModule(p_small,p_big,i,bundle_name);
+    }
+
+    fprintf(p_small,"</cache>\n");
+    fprintf(p_big,"</cache>\n");
+
+    bool result = (ferror(p_small) == 0) && (ferror(p_big) == 0);
+    fclose(p_small);
+    fclose(p_big);
+
+    if( result == false ) {
+        CSmallString error;
+        error << "unable to write cache files in '" << config_dir << "'";
+        ES_ERROR(error);
+    }
+
+    return(result);
+}
+
+//------------------------------------------------------------------------------
+
+void CGenBundles::WriteModule(FILE* p_small,FILE* p_big,int module_id,const CSmallString& bundle_name)
+{
+    FILE* files[2] = { p_small, p_big };
+
+    // the same random sequence for both caches
+    std::mt19937 state = Random;
+    std::mt19937 final_state;
+
+    for(int f=0; f < 2; f++){
+        Random = state;
+        FILE* p_fout = files[f];
+
+        fprintf(p_fout,"  <module name=\"%s\" bundle=\"%s\">\n",ModuleNames[module_id].c_str(),
+                (const char*)bundle_name);
+
+        // categories
+        fprintf(p_fout,"    <categories>\n");
+        int ncats = 1 + GetRandom(2);
+        for(int i=0; i < ncats; i++){
+            fprintf(p_fout,"      <category name=\"%s\"/>\n",
+                    CategoryNames[(module_id + i*7) % CategoryNames.size()].c_str());
+        }
+        fprintf(p_fout,"    </categories>\n");
+
+        // module level access rules and dependencies
+        if( GetRandom(100) < Options.GetOptACL() ) WriteACL(p_fout,"    ");
+        if( Options.GetOptDeps() > 0 ) WriteDeps(p_fout,module_id,"    ");
+
+        // builds
+        fprintf(p_fout,"    <builds>\n");
+        for(int v=0; v < Options.GetOptVersions(); v++){
+            for(const std::string& arch : Archs){
+                for(const std::string& mode : Modes){
+                    WriteBuild(p_fout,module_id,v,arch,mode);
+                    if( f == 0 ) NumOfBuilds++;
+                }
+            }
+        }
+        fprintf(p_fout,"    </builds>\n");
+
+        // default build
+        fprintf(p_fout,"    <default ver=\"%s\" arch=\"auto\" mode=\"auto\"/>\n",
+                GetVersion(module_id,Options.GetOptVersions()-1).c_str());
+
+        // documentation only in the big cache
+        if( (f == 1) && (Options.GetOptDocSize() > 0) ){
+            fprintf(p_fout,"    <doc>\n      <p>");
+            int size = 0;
+            int words = 0;
+            while( size < Options.GetOptDocSize() ){
+                const char* p_word = DocWords[GetRandom(NUM_OF(DocWords))];
+                size += fprintf(p_fout,"%s ",p_word);
+                words++;
+                if( words % 60 == 0 ) size += fprintf(p_fout,"</p>\n      <p>");
+            }
+            fprintf(p_fout,"</p>\n    </doc>\n");
+        }
+
+        fprintf(p_fout,"  </module>\n");
+        final_state = Random;
+    }
+
+    Random = final_state;
+}
+
+//------------------------------------------------------------------------------
+
+void CGenBundles::WriteBuild(FILE* p_fout,int module_id,int ver_id,const std::string& arch,
+                             const std::string& mode)
+{
+    const std::string& name = ModuleNames[module_id];
+    std::string ver = GetVersion(module_id,ver_id);
+
+    fprintf(p_fout,"      <build ver=\"%s\" arch=\"%s\" mode=\"%s\" verindx=\"%d\">\n",
+            ver.c_str(),arch.c_str(),mode.c_str(),ver_id+1);
+
+    // setup
+    fprintf(p_fout,"        <setup>\n");
+    for(int i=0; i < Options.GetOptSetup(); i++){
+        switch(i % 4){
+            case 0:
+                fprintf(p_fout,"          <variable name=\"PATH\" value=\"/software/%s/%s/%s/bin\" operation=\"prepend\" priority=\"modaction\"/>\n",
+                        name.c_str(),ver.c_str(),arch.c_str());
+                break;
+            case 1:
+                fprintf(p_fout,"          <variable name=\"LD_LIBRARY_PATH\" value=\"/software/%s/%s/%s/lib\" operation=\"prepend\" priority=\"modaction\"/>\n",
+                        name.c_str(),ver.c_str(),arch.c_str());
+                break;
+            case 2:
+                if( GetRandom(10) == 0 ){
+                    fprintf(p_fout,"          <variable name=\"LICENSE_KEY_%d\" value=\"%08x\" operation=\"set\" priority=\"normal\" secret=\"true\"/>\n",
+                            i,(unsigned int)Random());
+                } else {
+                    fprintf(p_fout,"          <variable name=\"%s_HOME_%d\" value=\"/software/%s/%s\" operation=\"set\" priority=\"normal\"/>\n",
+                            name.c_str(),i,name.c_str(),ver.c_str());
+                }
+                break;
+            case 3:
+                if( i % 8 == 3 ){
+                    fprintf(p_fout,"          <script name=\"/software/%s/%s/setup.sh\" type=\"inline\" priority=\"normal\"/>\n",
+                            name.c_str(),ver.c_str());
+                } else {
+                    fprintf(p_fout,"          <alias name=\"%s%d\" value=\"%s --mode %s\" priority=\"normal\"/>\n",
+                            name.c_str(),i,name.c_str(),mode.c_str());
+                }
+                break;
+        }
+    }
+    fprintf(p_fout,"        </setup>\n");
+
+    if( Options.GetOptDeps() > 0 ) WriteDeps(p_fout,module_id,"        ");
+    if( GetRandom(100) < Options.GetOptACL() ) WriteACL(p_fout,"        ");
+
+    fprintf(p_fout,"      </build>\n");
+}
+
+//------------------------------------------------------------------------------
+
+void CGenBundles::WriteACL(FILE* p_fout,const char* p_indent)
+{
+    const char* p_default = GetRandom(2) == 0 ? "allow" : "deny";
+    fprintf(p_fout,"%s<acl default=\"%s\">\n",p_indent,p_default);
+    int nrules = 1 + GetRandom(3);
+    for(int i=0; i < nrules; i++){
+        fprintf(p_fout,"%s  <%s group=\"group%d\"/>\n",p_indent,
+                GetRandom(3) == 0 ? "deny" : "allow",GetRandom(50));
+    }
+    fprintf(p_fout,"%s</acl>\n",p_indent);
+}
+
+//------------------------------------------------------------------------------
+
+void CGenBundles::WriteDeps(FILE* p_fout,int module_id,const char* p_indent)
+{
+    static const char* types[] = { "pre", "post", "rt", "conflict" };
+
+    fprintf(p_fout,"%s<deps>\n",p_indent);
+    for(int i=0; i < Options.GetOptDeps(); i++){
+        int dep_id = GetRandom(ModuleNames.size());
+        if( dep_id == module_id ) dep_id = (dep_id + 1) % ModuleNames.size();
+        std::string dep = ModuleNames[dep_id];
+        // a mixture of name, name:ver and full build dependencies
+        switch(GetRandom(3)){
+            case 1:
+                dep += ":" + GetVersion(dep_id,GetRandom(Options.GetOptVersions()));
+                break;
+            case 2:
+                dep += ":" + GetVersion(dep_id,GetRandom(Options.GetOptVersions()));
+                dep += ":" + Archs[GetRandom(Archs.size())];
+                dep += ":" + Modes[GetRandom(Modes.size())];
+                break;
+        }
+        fprintf(p_fout,"%s  <dep name=\"%s\" type=\"%s\"/>\n",p_indent,dep.c_str(),
+                types[GetRandom(NUM_OF(types))]);
+    }
+    fprintf(p_fout,"%s</deps>\n",p_indent);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+const std::string CGenBundles::GetVersion(int module_id,int ver_id)
+{
+    char buffer[64];
+    snprintf(buffer,sizeof(buffer),"%d.%d.%d",1 + ver_id / 10,ver_id % 10,module_id % 7);
+    return(buffer);
+}
+
+//------------------------------------------------------------------------------
+
+int CGenBundles::GetRandom(int max)
+{
+    if( max <= 0 ) return(0);
+    return( Random() % max );
+}
+
+//------------------------------------------------------------------------------
+
+void CGenBundles::SplitList(const CSmallString& list,std::vector<std::string>& items)
+{
+    std::string item;
+    for(const char* p = list; (p != NULL) && (*p != '\0'); p++){
+        if( *p == ',' ){
+            if( ! item.empty() ) items.push_back(item);
+            item.clear();
+        } else {
+            item += *p;
+        }
+    }
+    if( ! item.empty() ) items.push_back(item);
+}
+
+//------------------------------------------------------------------------------
+
+bool CGenBundles::CreateDirectory(const CFileName& path)
+{
+    std::string current;
+    std::string full(path);
+    size_t pos = 0;
+    while( pos != std::string::npos ){
+        pos = full.find('/',pos+1);
+        current = full.substr(0,pos);
+        if( current.empty() ) continue;
+        if( (mkdir(current.c_str(),0755) != 0) && (errno != EEXIST) ) return(false);
+    }
+    return(true);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
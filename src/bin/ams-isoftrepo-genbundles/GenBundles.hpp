@@ -0,0 +1,99 @@
+#ifndef GenBundlesH
+#define GenBundlesH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "GenBundlesOptions.hpp"
+#include <VerboseStr.hpp>
+#include <TerminalStr.hpp>
+#include <FileName.hpp>
+#include <random>
+#include <string>
+#include <vector>
+#include <stdio.h>
+
+//------------------------------------------------------------------------------
+
+/// writes synthetic bundle trees readable by CModuleController::LoadBundles
+/// files are written as a stream so the memory does not depend on the size
+
+class CGenBundles {
+public:
+    CGenBundles(void);
+
+// main methods ----------------------------------------------------------------
+    /// init options
+    int Init(int argc,char* argv[]);
+
+    /// main part of program
+    bool Run(void);
+
+    /// finalize
+    void Finalize(void);
+
+// section of private data -----------------------------------------------------
+private:
+    CGenBundlesOptions          Options;
+    CTerminalStr                Console;
+    CVerboseStr                 vout;
+    std::mt19937                Random;
+    std::vector<std::string>    Archs;
+    std::vector<std::string>    Modes;
+    std::vector<std::string>    ModuleNames;
+    std::vector<std::string>    CategoryNames;
+    size_t                      NumOfBuilds;
+
+    /// create names of modules and categories
+    void PrepareNames(void);
+
+    /// write one bundle
+    bool WriteBundle(int bundle_id,const CFileName& bundle_dir);
+
+    /// write one module into both caches
+    void WriteModule(FILE* p_small,FILE* p_big,int module_id,const CSmallString& bundle_name);
+
+    /// write build record
+    void WriteBuild(FILE* p_fout,int module_id,int ver_id,const std::string& arch,
+                    const std::string& mode);
+
+    /// write access rules
+    void WriteACL(FILE* p_fout,const char* p_indent);
+
+    /// write dependencies
+    void WriteDeps(FILE* p_fout,int module_id,const char* p_indent);
+
+    /// get version string
+    const std::string GetVersion(int module_id,int ver_id);
+
+    /// random number from the interval <0;max)
+    int GetRandom(int max);
+
+    /// split comma separated list
+    static void SplitList(const CSmallString& list,std::vector<std::string>& items);
+
+    /// create directory including parents
+    static bool CreateDirectory(const CFileName& path);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
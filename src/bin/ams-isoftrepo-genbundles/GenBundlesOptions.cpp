@@ -0,0 +1,115 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "GenBundlesOptions.hpp"
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CGenBundlesOptions::CGenBundlesOptions(void)
+{
+    SetShowMiniUsage(true);
+}
+
+//------------------------------------------------------------------------------
+
+int CGenBundlesOptions::CheckOptions(void)
+{
+    if( GetOptBundles() <= 0 ) {
+        if( IsError == false ) fprintf(stderr,"\n");
+        fprintf(stderr,"%s: number of bundles has to be greater than zero\n",(const char*)GetProgramName());
+        IsError = true;
+        return(SO_OPTS_ERROR);
+    }
+    if( GetOptCategories() <= 0 ) {
+        if( IsError == false ) fprintf(stderr,"\n");
+        fprintf(stderr,"%s: number of categories has to be greater than zero\n",(const char*)GetProgramName());
+        IsError = true;
+        return(SO_OPTS_ERROR);
+    }
+    if( GetOptModules() <= 0 ) {
+        if( IsError == false ) fprintf(stderr,"\n");
+        fprintf(stderr,"%s: number of modules has to be greater than zero\n",(const char*)GetProgramName());
+        IsError = true;
+        return(SO_OPTS_ERROR);
+    }
+    if( GetOptVersions() <= 0 ) {
+        if( IsError == false ) fprintf(stderr,"\n");
+        fprintf(stderr,"%s: number of versions has to be greater than zero\n",(const char*)GetProgramName());
+        IsError = true;
+        return(SO_OPTS_ERROR);
+    }
+    if( GetOptDeps() < 0 ) {
+        if( IsError == false ) fprintf(stderr,"\n");
+        fprintf(stderr,"%s: number of dependencies cannot be negative\n",(const char*)GetProgramName());
+        IsError = true;
+        return(SO_OPTS_ERROR);
+    }
+    if( GetOptSetup() < 0 ) {
+        if( IsError == false ) fprintf(stderr,"\n");
+        fprintf(stderr,"%s: number of setup entries cannot be negative\n",(const char*)GetProgramName());
+        IsError = true;
+        return(SO_OPTS_ERROR);
+    }
+    if( GetOptDocSize() < 0 ) {
+        if( IsError == false ) fprintf(stderr,"\n");
+        fprintf(stderr,"%s: documentation size cannot be negative\n",(const char*)GetProgramName());
+        IsError = true;
+        return(SO_OPTS_ERROR);
+    }
+    if( (GetOptACL() < 0) || (GetOptACL() > 100) ) {
+        if( IsError == false ) fprintf(stderr,"\n");
+        fprintf(stderr,"%s: ACL percentage has to be in the range 0-100\n",(const char*)GetProgramName());
+        IsError = true;
+        return(SO_OPTS_ERROR);
+    }
+    return(SO_CONTINUE);
+}
+
+//------------------------------------------------------------------------------
+
+int CGenBundlesOptions::FinalizeOptions(void)
+{
+    bool ret_opt = false;
+
+    if( GetOptHelp() == true ) {
+        PrintUsage();
+        ret_opt = true;
+    }
+
+    if( GetOptVersion() == true ) {
+        PrintVersion();
+        ret_opt = true;
+    }
+
+    if( ret_opt == true ) {
+        printf("\n");
+        return(SO_EXIT);
+    }
+
+    return(SO_CONTINUE);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
@@ -0,0 +1,218 @@
+#ifndef GenBundlesOptionsH
+#define GenBundlesOptionsH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <SimpleOptions.hpp>
+
+//------------------------------------------------------------------------------
+
+class CGenBundlesOptions : public CSimpleOptions {
+public:
+    // constructor - tune option setup
+    CGenBundlesOptions(void);
+
+    // program name and description -----------------------------------------------
+    CSO_PROG_NAME_BEGIN
+    "ams-isoftrepo-genbundles"
+    CSO_PROG_NAME_END
+
+    CSO_PROG_DESC_BEGIN
+    "Generates synthetic AMS bundles for scale testing of isoftrepo.fcgi."
+    CSO_PROG_DESC_END
+
+    // list of all options and arguments ------------------------------------------
+    CSO_LIST_BEGIN
+    // arguments ----------------------------
+    CSO_ARG(CSmallString,OutputDir)
+    // options ------------------------------
+    CSO_OPT(int,Bundles)
+    CSO_OPT(int,Categories)
+    CSO_OPT(int,Modules)
+    CSO_OPT(int,Versions)
+    CSO_OPT(CSmallString,Archs)
+    CSO_OPT(CSmallString,Modes)
+    CSO_OPT(int,ACL)
+    CSO_OPT(int,Deps)
+    CSO_OPT(int,Setup)
+    CSO_OPT(int,DocSize)
+    CSO_OPT(int,Seed)
+    CSO_OPT(CSmallString,Prefix)
+    CSO_OPT(bool,Help)
+    CSO_OPT(bool,Version)
+    CSO_OPT(bool,Verbose)
+    CSO_LIST_END
+
+    CSO_MAP_BEGIN
+    // description of arguments ---------------------------------------------------
+    CSO_MAP_ARG(CSmallString,                   /* argument type */
+                OutputDir,                          /* argument name */
+                NULL,                           /* default value */
+                true,                           /* is argument mandatory */
+                "outputdir",                        /* parametr name */
+                "the directory where bundles are created\n")   /* argument description */
+    // description of options -----------------------------------------------------
+    CSO_MAP_OPT(int,                           /* option type */
+                Bundles,                        /* option name */
+                4,                          /* default value */
+                false,                          /* is option mandatory */
+                'b',                           /* short option name */
+                "bundles",                      /* long option name */
+                "NUMBER",                           /* parametr name */
+                "number of generated bundles")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(int,                           /* option type */
+                Categories,                        /* option name */
+                20,                          /* default value */
+                false,                          /* is option mandatory */
+                'c',                           /* short option name */
+                "categories",                      /* long option name */
+                "NUMBER",                           /* parametr name */
+                "number of module categories")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(int,                           /* option type */
+                Modules,                        /* option name */
+                1500,                          /* default value */
+                false,                          /* is option mandatory */
+                'm',                           /* short option name */
+                "modules",                      /* long option name */
+                "NUMBER",                           /* parametr name */
+                "total number of modules in all bundles")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(int,                           /* option type */
+                Versions,                        /* option name */
+                5,                          /* default value */
+                false,                          /* is option mandatory */
+                'r',                           /* short option name */
+                "versions",                      /* long option name */
+                "NUMBER",                           /* parametr name */
+                "number of versions per module")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(CSmallString,                           /* option type */
+                Archs,                        /* option name */
+                "x86_64,x86_64_avx2,x86_64_gpu_cuda",                          /* default value */
+                false,                          /* is option mandatory */
+                'a',                           /* short option name */
+                "archs",                      /* long option name */
+                "LIST",                           /* parametr name */
+                "comma separated list of build architectures")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(CSmallString,                           /* option type */
+                Modes,                        /* option name */
+                "single,para",                          /* default value */
+                false,                          /* is option mandatory */
+                'o',                           /* short option name */
+                "modes",                      /* long option name */
+                "LIST",                           /* parametr name */
+                "comma separated list of build modes")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(int,                           /* option type */
+                ACL,                        /* option name */
+                10,                          /* default value */
+                false,                          /* is option mandatory */
+                'l',                           /* short option name */
+                "acl",                      /* long option name */
+                "PERCENT",                           /* parametr name */
+                "percentage of modules and builds with access rules")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(int,                           /* option type */
+                Deps,                        /* option name */
+                2,                          /* default value */
+                false,                          /* is option mandatory */
+                'd',                           /* short option name */
+                "deps",                      /* long option name */
+                "NUMBER",                           /* parametr name */
+                "number of dependencies per build")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(int,                           /* option type */
+                Setup,                        /* option name */
+                6,                          /* default value */
+                false,                          /* is option mandatory */
+                'e',                           /* short option name */
+                "setup",                      /* long option name */
+                "NUMBER",                           /* parametr name */
+                "number of setup entries per build")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(int,                           /* option type */
+                DocSize,                        /* option name */
+                2048,                          /* default value */
+                false,                          /* is option mandatory */
+                'z',                           /* short option name */
+                "docsize",                      /* long option name */
+                "BYTES",                           /* parametr name */
+                "approximate size of module documentation")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(int,                           /* option type */
+                Seed,                        /* option name */
+                1,                          /* default value */
+                false,                          /* is option mandatory */
+                's',                           /* short option name */
+                "seed",                      /* long option name */
+                "NUMBER",                           /* parametr name */
+                "seed of the random generator")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(CSmallString,                           /* option type */
+                Prefix,                        /* option name */
+                "bundle",                          /* default value */
+                false,                          /* is option mandatory */
+                'p',                           /* short option name */
+                "prefix",                      /* long option name */
+                "NAME",                           /* parametr name */
+                "prefix of bundle names")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(bool,                           /* option type */
+                Verbose,                        /* option name */
+                false,                          /* default value */
+                false,                          /* is option mandatory */
+                'v',                           /* short option name */
+                "verbose",                      /* long option name */
+                NULL,                           /* parametr name */
+                "increase output verbosity")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(bool,                           /* option type */
+                Version,                        /* option name */
+                false,                          /* default value */
+                false,                          /* is option mandatory */
+                '\0',                           /* short option name */
+                "version",                      /* long option name */
+                NULL,                           /* parametr name */
+                "output version information and exit")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(bool,                           /* option type */
+                Help,                        /* option name */
+                false,                          /* default value */
+                false,                          /* is option mandatory */
+                'h',                           /* short option name */
+                "help",                      /* long option name */
+                NULL,                           /* parametr name */
+                "display this help and exit")   /* option description */
+    CSO_MAP_END
+
+    // final operation with options ------------------------------------------------
+private:
+    virtual int CheckOptions(void);
+    virtual int FinalizeOptions(void);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
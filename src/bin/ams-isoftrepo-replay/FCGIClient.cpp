@@ -0,0 +1,351 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "FCGIClient.hpp"
+#include <ErrorSystem.hpp>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+// FastCGI protocol constants
+#define FCGI_VERSION_1          1
+#define FCGI_BEGIN_REQUEST      1
+#define FCGI_END_REQUEST        3
+#define FCGI_PARAMS             4
+#define FCGI_STDIN              5
+#define FCGI_STDOUT             6
+#define FCGI_STDERR             7
+#define FCGI_RESPONDER          1
+#define FCGI_KEEP_CONN          1
+#define FCGI_REQUEST_ID         1
+#define FCGI_MAX_CONTENT        65535
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CFCGIClient::CFCGIClient(void)
+{
+    Port = 0;
+    Socket = -1;
+    KeepConn = false;
+    NumOfConnects = 0;
+}
+
+//------------------------------------------------------------------------------
+
+CFCGIClient::~CFCGIClient(void)
+{
+    Close();
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CFCGIClient::SetServer(const CSmallString& address)
+{
+    std::string addr(address);
+    size_t pos = addr.rfind(':');
+    if( pos == std::string::npos ) {
+        ES_ERROR("server address must be in the form host:port");
+        return(false);
+    }
+    Host = addr.substr(0,pos);
+    Port = atoi(addr.substr(pos+1).c_str());
+    if( Port <= 0 ) {
+        ES_ERROR("illegal server port");
+        return(false);
+    }
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIClient::SetSocket(const CSmallString& path)
+{
+    SocketPath = std::string(path);
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIClient::SetKeepConn(bool keep_conn)
+{
+    KeepConn = keep_conn;
+}
+
+//------------------------------------------------------------------------------
+
+size_t CFCGIClient::GetNumOfConnects(void) const
+{
+    return(NumOfConnects);
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIClient::Close(void)
+{
+    if( Socket >= 0 ) close(Socket);
+    Socket = -1;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CFCGIClient::Connect(void)
+{
+    Close();
+    NumOfConnects++;
+
+    if( ! SocketPath.empty() ) {
+        struct sockaddr_un addr;
+        memset(&addr,0,sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if( SocketPath.size() >= sizeof(addr.sun_path) ) {
+            ES_ERROR("socket path is too long");
+            return(false);
+        }
+        strcpy(addr.sun_path,SocketPath.c_str());
+        Socket = socket(AF_UNIX,SOCK_STREAM,0);
+        if( Socket < 0 ) return(false);
+        if( connect(Socket,(struct sockaddr*)&addr,sizeof(addr)) != 0 ) {
+            Close();
+            return(false);
+        }
+        return(true);
+    }
+
+    struct addrinfo  hints;
+    struct addrinfo* p_res = NULL;
+    memset(&hints,0,sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    char port[16];
+    snprintf(port,sizeof(port),"%d",Port);
+    if( getaddrinfo(Host.c_str(),port,&hints,&p_res) != 0 ) {
+        ES_ERROR("unable to resolve server address");
+        return(false);
+    }
+
+    for(struct addrinfo* p_ai = p_res; p_ai != NULL; p_ai = p_ai->ai_next){
+        Socket = socket(p_ai->ai_family,p_ai->ai_socktype,p_ai->ai_protocol);
+        if( Socket < 0 ) continue;
+        if( connect(Socket,p_ai->ai_addr,p_ai->ai_addrlen) == 0 ) break;
+        Close();
+    }
+    freeaddrinfo(p_res);
+
+    if( Socket < 0 ) return(false);
+
+    int flag = 1;
+    setsockopt(Socket,IPPROTO_TCP,TCP_NODELAY,&flag,sizeof(flag));
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CFCGIClient::ExecuteRequest(const TFCGIParams& params,int& status,size_t& length)
+{
+    bool reused = Socket >= 0;
+
+    if( reused == false ) {
+        if( Connect() == false ) return(false);
+    }
+
+    if( Exchange(params,status,length) == true ) return(true);
+
+    // the server can close kept connection at any time
+    if( reused == false ) return(false);
+    if( Connect() == false ) return(false);
+
+    return(Exchange(params,status,length));
+}
+
+//------------------------------------------------------------------------------
+
+bool CFCGIClient::Exchange(const TFCGIParams& params,int& status,size_t& length)
+{
+    status = 0;
+    length = 0;
+
+    // begin request
+    Buffer.clear();
+    unsigned char begin[8];
+    memset(begin,0,sizeof(begin));
+    begin[1] = FCGI_RESPONDER;
+    begin[2] = KeepConn ? FCGI_KEEP_CONN : 0;
+    AppendRecord(FCGI_BEGIN_REQUEST,begin,sizeof(begin));
+
+    // parameters
+    std::vector<unsigned char> data;
+    for(const std::pair<std::string,std::string>& param : params){
+        AppendLength(data,param.first.size());
+        AppendLength(data,param.second.size());
+        data.insert(data.end(),param.first.begin(),param.first.end());
+        data.insert(data.end(),param.second.begin(),param.second.end());
+    }
+    size_t pos = 0;
+    while( pos < data.size() ){
+        size_t len = data.size() - pos;
+        if( len > FCGI_MAX_CONTENT ) len = FCGI_MAX_CONTENT;
+        AppendRecord(FCGI_PARAMS,&data[pos],len);
+        pos += len;
+    }
+    AppendRecord(FCGI_PARAMS,NULL,0);
+    AppendRecord(FCGI_STDIN,NULL,0);
+
+    if( WriteAll(&Buffer[0],Buffer.size()) == false ) {
+        Close();
+        return(false);
+    }
+
+    // response
+    std::string headers;
+    bool        in_headers = true;
+    unsigned char header[8];
+    std::vector<unsigned char> content(FCGI_MAX_CONTENT+255);
+
+    for(;;){
+        if( ReadAll(header,sizeof(header)) == false ) {
+            Close();
+            return(false);
+        }
+        int type = header[1];
+        size_t clen = (header[4] << 8) | header[5];
+        size_t plen = header[6];
+        if( ReadAll(&content[0],clen+plen) == false ) {
+            Close();
+            return(false);
+        }
+
+        if( type == FCGI_STDOUT ) {
+            length += clen;
+            if( in_headers ) {
+                headers.append((const char*)&content[0],clen);
+                if( headers.find("\r\n\r\n") != std::string::npos ) in_headers = false;
+            }
+        }
+        if( type == FCGI_END_REQUEST ) {
+            int app_status = (content[0] << 24) | (content[1] << 16) | (content[2] << 8) | content[3];
+            int proto_status = content[4];
+            if( KeepConn == false ) Close();
+            if( (app_status != 0) || (proto_status != 0) ) {
+                Close();
+                return(false);
+            }
+            break;
+        }
+    }
+
+    // status from headers
+    status = 200;
+    size_t spos = headers.find("Status:");
+    size_t hend = headers.find("\r\n\r\n");
+    if( (spos != std::string::npos) && (spos < hend) ) {
+        status = atoi(headers.c_str() + spos + 7);
+    }
+    if( hend != std::string::npos ) length -= hend + 4;
+
+    return(true);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CFCGIClient::AppendRecord(int type,const unsigned char* p_data,size_t len)
+{
+    unsigned char header[8];
+    header[0] = FCGI_VERSION_1;
+    header[1] = type;
+    header[2] = (FCGI_REQUEST_ID >> 8) & 0xFF;
+    header[3] = FCGI_REQUEST_ID & 0xFF;
+    header[4] = (len >> 8) & 0xFF;
+    header[5] = len & 0xFF;
+    header[6] = 0;
+    header[7] = 0;
+    Buffer.insert(Buffer.end(),header,header+8);
+    if( len > 0 ) Buffer.insert(Buffer.end(),p_data,p_data+len);
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIClient::AppendLength(std::vector<unsigned char>& data,size_t len)
+{
+    if( len < 128 ) {
+        data.push_back(len);
+    } else {
+        data.push_back(((len >> 24) & 0x7F) | 0x80);
+        data.push_back((len >> 16) & 0xFF);
+        data.push_back((len >> 8) & 0xFF);
+        data.push_back(len & 0xFF);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+bool CFCGIClient::WriteAll(const unsigned char* p_data,size_t len)
+{
+    while( len > 0 ){
+        ssize_t ret = send(Socket,p_data,len,MSG_NOSIGNAL);
+        if( ret < 0 ) {
+            if( errno == EINTR ) continue;
+            return(false);
+        }
+        p_data += ret;
+        len -= ret;
+    }
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CFCGIClient::ReadAll(unsigned char* p_data,size_t len)
+{
+    while( len > 0 ){
+        ssize_t ret = read(Socket,p_data,len);
+        if( ret < 0 ) {
+            if( errno == EINTR ) continue;
+            return(false);
+        }
+        if( ret == 0 ) return(false);
+        p_data += ret;
+        len -= ret;
+    }
+    return(true);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
@@ -0,0 +1,85 @@
+#ifndef FCGIClientH
+#define FCGIClientH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <SmallString.hpp>
+#include <string>
+#include <vector>
+#include <utility>
+
+//------------------------------------------------------------------------------
+
+/// FastCGI parameters of one request
+typedef std::vector< std::pair<std::string,std::string> > TFCGIParams;
+
+//------------------------------------------------------------------------------
+
+/// minimal FastCGI client speaking the responder role over TCP or unix socket
+/// the connection can be kept open for subsequent requests
+
+class CFCGIClient {
+public:
+    CFCGIClient(void);
+    ~CFCGIClient(void);
+
+// setup methods ---------------------------------------------------------------
+    /// set TCP server address in the form host:port
+    bool SetServer(const CSmallString& address);
+
+    /// set unix domain socket
+    void SetSocket(const CSmallString& path);
+
+    /// ask server to keep connection open (FCGI_KEEP_CONN)
+    void SetKeepConn(bool keep_conn);
+
+// main methods ----------------------------------------------------------------
+    /// execute request, status is parsed from the response headers
+    bool ExecuteRequest(const TFCGIParams& params,int& status,size_t& length);
+
+    /// close connection
+    void Close(void);
+
+    /// number of opened connections
+    size_t GetNumOfConnects(void) const;
+
+// section of private data -----------------------------------------------------
+private:
+    std::string             Host;
+    int                     Port;
+    std::string             SocketPath;
+    int                     Socket;
+    bool                    KeepConn;
+    size_t                  NumOfConnects;
+    std::vector<unsigned char> Buffer;
+
+    bool Connect(void);
+    bool Exchange(const TFCGIParams& params,int& status,size_t& length);
+    void AppendRecord(int type,const unsigned char* p_data,size_t len);
+    bool WriteAll(const unsigned char* p_data,size_t len);
+    bool ReadAll(unsigned char* p_data,size_t len);
+    static void AppendLength(std::vector<unsigned char>& data,size_t len);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
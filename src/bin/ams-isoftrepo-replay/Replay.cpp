@@ -0,0 +1,376 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "Replay.hpp"
+#include <ErrorSystem.hpp>
+#include <algorithm>
+#include <fstream>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+
+using namespace std;
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CReplay Replay;
+
+MAIN_ENTRY_OBJECT(Replay)
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+static uint64_t GetTime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return((uint64_t)ts.tv_sec*1000000 + ts.tv_nsec/1000);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CReplayRequest::CReplayRequest(void)
+{
+    Offset = 0;
+}
+
+//------------------------------------------------------------------------------
+
+CReplayStatistics::CReplayStatistics(void)
+{
+    NumOfErrors = 0;
+    NumOfBytes = 0;
+}
+
+//------------------------------------------------------------------------------
+
+void CReplayStatistics::Merge(const CReplayStatistics& stat)
+{
+    NumOfErrors += stat.NumOfErrors;
+    NumOfBytes += stat.NumOfBytes;
+    Latencies.insert(Latencies.end(),stat.Latencies.begin(),stat.Latencies.end());
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CReplay::CReplay(void)
+    : NextRequest(0)
+{
+    StartTime = 0;
+    NumOfConnects = 0;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+int CReplay::Init(int argc,char* argv[])
+{
+    int result = Options.ParseCmdLine(argc,argv);
+
+    // should we exit or was it error?
+    if( result != SO_CONTINUE ) return(result);
+
+    vout.Attach(Console);
+    if( Options.GetOptVerbose() ) {
+        vout.Verbosity(CVerboseStr::high);
+    } else {
+        vout.Verbosity(CVerboseStr::low);
+    }
+
+    return(SO_CONTINUE);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CReplay::Run(void)
+{
+    // test server address
+    CFCGIClient client;
+    if( Options.IsOptSocketSet() ) {
+        client.SetSocket(Options.GetOptSocket());
+    } else {
+        if( client.SetServer(Options.GetOptServer()) == false ) return(false);
+    }
+
+    if( LoadLog() == false ) return(false);
+
+    if( Requests.empty() ) {
+        ES_ERROR("no isoftrepo requests found in the access log");
+        return(false);
+    }
+
+    vout << low;
+    vout << "# Requests    = " << Requests.size() << endl;
+    vout << "# Concurrency = " << Options.GetOptConcurrency() << endl;
+    vout << "# Keep conn   = " << (Options.GetOptKeepConn() ? "true" : "false") << endl;
+    if( Options.GetOptRate() > 0.0 ) {
+        vout << "# Rate        = " << Options.GetOptRate() << "x" << endl;
+    } else {
+        vout << "# Rate        = maximum" << endl;
+    }
+
+    // execute
+    StartTime = GetTime();
+
+    std::vector<std::thread> workers;
+    for(int i=0; i < Options.GetOptConcurrency(); i++){
+        workers.push_back(std::thread(&CReplay::RunWorker,this));
+    }
+    for(std::thread& worker : workers){
+        worker.join();
+    }
+
+    PrintReport(GetTime() - StartTime);
+
+    return(true);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CReplay::Finalize(void)
+{
+    if( ErrorSystem.IsError() || Options.GetOptVerbose() ){
+        vout << low;
+        ErrorSystem.PrintErrors(vout);
+    }
+    vout << endl;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CReplay::LoadLog(void)
+{
+    ifstream ifs(Options.GetArgLogFile());
+    if( ! ifs ) {
+        CSmallString error;
+        error << "unable to open access log '" << Options.GetArgLogFile() << "'";
+        ES_ERROR(error);
+        return(false);
+    }
+
+    std::string script_name(Options.GetOptScriptName());
+    size_t      pos = script_name.rfind('/');
+    std::string script_base = script_name.substr(pos == std::string::npos ? 0 : pos+1);
+
+    time_t first_time = 0;
+    size_t num_of_skipped = 0;
+    string line;
+
+    while( getline(ifs,line) ){
+        CReplayRequest request;
+        time_t         time = 0;
+        if( (ParseLine(line,request,time) == false) ||
+            (request.RequestURI.find(script_base) == std::string::npos) ) {
+            num_of_skipped++;
+            continue;
+        }
+        if( Requests.empty() ) first_time = time;
+        if( time > first_time ) {
+            request.Offset = (uint64_t)(time - first_time)*1000000;
+        }
+        Requests.push_back(request);
+        if( (Options.GetOptLimit() > 0) && ((int)Requests.size() >= Options.GetOptLimit()) ) break;
+    }
+
+    vout << high;
+    vout << "Loaded requests : " << Requests.size() << endl;
+    vout << "Skipped lines   : " << num_of_skipped << endl;
+
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CReplay::ParseLine(const std::string& line,CReplayRequest& request,time_t& time)
+{
+    // remote address
+    size_t pos = line.find(' ');
+    if( pos == std::string::npos ) return(false);
+    request.RemoteAddr = line.substr(0,pos);
+
+    // timestamp [10/Oct/2000:13:55:36 -0700]
+    size_t tbeg = line.find('[',pos);
+    size_t tend = line.find(']',tbeg);
+    if( (tbeg == std::string::npos) || (tend == std::string::npos) ) return(false);
+    struct tm tm;
+    memset(&tm,0,sizeof(tm));
+    if( strptime(line.substr(tbeg+1,tend-tbeg-1).c_str(),"%d/%b/%Y:%H:%M:%S",&tm) == NULL ) return(false);
+    time = timegm(&tm);
+
+    // request "GET /uri HTTP/1.1"
+    size_t rbeg = line.find('"',tend);
+    if( rbeg == std::string::npos ) return(false);
+    size_t rend = line.find('"',rbeg+1);
+    if( rend == std::string::npos ) return(false);
+    std::string req = line.substr(rbeg+1,rend-rbeg-1);
+    if( req.compare(0,4,"GET ") != 0 ) return(false);
+    size_t uend = req.find(' ',4);
+    request.RequestURI = req.substr(4,uend == std::string::npos ? std::string::npos : uend-4);
+
+    size_t qpos = request.RequestURI.find('?');
+    if( qpos != std::string::npos ) {
+        request.QueryString = request.RequestURI.substr(qpos+1);
+    }
+
+    // action
+    request.Action = "categories";
+    size_t apos = 0;
+    while( (apos = request.QueryString.find("action=",apos)) != std::string::npos ){
+        if( (apos == 0) || (request.QueryString[apos-1] == '&') ) {
+            size_t aend = request.QueryString.find('&',apos);
+            request.Action = request.QueryString.substr(apos+7,aend == std::string::npos ? std::string::npos : aend-apos-7);
+            break;
+        }
+        apos += 7;
+    }
+
+    return(true);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CReplay::RunWorker(void)
+{
+    CFCGIClient client;
+    if( Options.IsOptSocketSet() ) {
+        client.SetSocket(Options.GetOptSocket());
+    } else {
+        client.SetServer(Options.GetOptServer());
+    }
+    client.SetKeepConn(Options.GetOptKeepConn());
+
+    std::map<std::string,CReplayStatistics> statistics;
+    std::string port = std::string(Options.GetOptServer());
+    port = port.substr(port.rfind(':')+1);
+
+    for(;;){
+        size_t index = NextRequest++;
+        if( index >= Requests.size() ) break;
+
+        const CReplayRequest& request = Requests[index];
+
+        // keep the original spacing of requests
+        if( Options.GetOptRate() > 0.0 ) {
+            uint64_t due = StartTime + (uint64_t)(request.Offset / Options.GetOptRate());
+            uint64_t now = GetTime();
+            if( due > now ) usleep(due - now);
+        }
+
+        TFCGIParams params;
+        params.push_back(make_pair(string("REQUEST_METHOD"),string("GET")));
+        params.push_back(make_pair(string("QUERY_STRING"),request.QueryString));
+        params.push_back(make_pair(string("REQUEST_URI"),request.RequestURI));
+        params.push_back(make_pair(string("SCRIPT_NAME"),string(Options.GetOptScriptName())));
+        params.push_back(make_pair(string("SERVER_NAME"),string(Options.GetOptServerName())));
+        params.push_back(make_pair(string("SERVER_PORT"),port));
+        params.push_back(make_pair(string("SERVER_PROTOCOL"),string("HTTP/1.1")));
+        params.push_back(make_pair(string("REMOTE_ADDR"),request.RemoteAddr));
+        params.push_back(make_pair(string("GATEWAY_INTERFACE"),string("CGI/1.1")));
+
+        int      status = 0;
+        size_t   length = 0;
+        uint64_t start = GetTime();
+        bool     result = client.ExecuteRequest(params,status,length);
+        uint64_t latency = GetTime() - start;
+
+        CReplayStatistics& stat = statistics[request.Action];
+        stat.Latencies.push_back(latency);
+        stat.NumOfBytes += length;
+        if( (result == false) || (status >= 400) ) stat.NumOfErrors++;
+    }
+
+    client.Close();
+
+    std::lock_guard<std::mutex> lock(StatisticsLock);
+    NumOfConnects += client.GetNumOfConnects();
+    for(const std::pair<const std::string,CReplayStatistics>& item : statistics){
+        Statistics[item.first].Merge(item.second);
+    }
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CReplay::PrintReport(uint64_t duration)
+{
+    vout << low;
+    vout << endl;
+    vout << "# Action          Count   Errors       req/s    p50 [ms]    p90 [ms]    p99 [ms]    max [ms]  bytes/req" << endl;
+    vout << "# ------------ -------- -------- ----------- ----------- ----------- ----------- ----------- ----------" << endl;
+
+    CReplayStatistics total;
+    for(std::pair<const std::string,CReplayStatistics>& item : Statistics){
+        PrintStatistics(item.first,item.second,duration);
+        total.Merge(item.second);
+    }
+    vout << "# ------------ -------- -------- ----------- ----------- ----------- ----------- ----------- ----------" << endl;
+    PrintStatistics("total",total,duration);
+    vout << endl;
+    char buffer[64];
+    snprintf(buffer,sizeof(buffer),"%.3f",duration * 1.0e-6);
+    vout << "# Duration    = " << buffer << " s" << endl;
+    vout << "# Connections = " << NumOfConnects << endl;
+}
+
+//------------------------------------------------------------------------------
+
+void CReplay::PrintStatistics(const std::string& name,CReplayStatistics& stat,uint64_t duration)
+{
+    size_t count = stat.Latencies.size();
+    if( count == 0 ) return;
+    std::sort(stat.Latencies.begin(),stat.Latencies.end());
+
+    double p50 = stat.Latencies[(count-1)*50/100] * 1.0e-3;
+    double p90 = stat.Latencies[(count-1)*90/100] * 1.0e-3;
+    double p99 = stat.Latencies[(count-1)*99/100] * 1.0e-3;
+    double max = stat.Latencies[count-1] * 1.0e-3;
+    double rps = duration > 0 ? count / (duration * 1.0e-6) : 0.0;
+
+    char buffer[256];
+    snprintf(buffer,sizeof(buffer),"  %-12s %8lu %8lu %11.1f %11.3f %11.3f %11.3f %11.3f %10lu",
+             name.c_str(),(unsigned long)count,(unsigned long)stat.NumOfErrors,rps,p50,p90,p99,max,
+             (unsigned long)(stat.NumOfBytes / count));
+    vout << buffer << endl;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
@@ -0,0 +1,115 @@
+#ifndef ReplayH
+#define ReplayH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "ReplayOptions.hpp"
+#include "FCGIClient.hpp"
+#include <VerboseStr.hpp>
+#include <TerminalStr.hpp>
+#include <atomic>
+#include <mutex>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+
+/// one request parsed from the access log
+
+class CReplayRequest {
+public:
+    CReplayRequest(void);
+
+    uint64_t        Offset;         // offset from the first request in usec
+    std::string     Action;
+    std::string     QueryString;
+    std::string     RequestURI;
+    std::string     RemoteAddr;
+};
+
+//------------------------------------------------------------------------------
+
+/// statistics of one action
+
+class CReplayStatistics {
+public:
+    CReplayStatistics(void);
+
+    size_t                  NumOfErrors;
+    size_t                  NumOfBytes;
+    std::vector<uint64_t>   Latencies;  // in usec
+
+    /// merge statistics
+    void Merge(const CReplayStatistics& stat);
+};
+
+//------------------------------------------------------------------------------
+
+/// replays isoftrepo.fcgi requests from an access log against the FastCGI server
+
+class CReplay {
+public:
+    CReplay(void);
+
+// main methods ----------------------------------------------------------------
+    /// init options
+    int Init(int argc,char* argv[]);
+
+    /// main part of program
+    bool Run(void);
+
+    /// finalize
+    void Finalize(void);
+
+// section of private data -----------------------------------------------------
+private:
+    CReplayOptions                              Options;
+    CTerminalStr                                Console;
+    CVerboseStr                                 vout;
+    std::vector<CReplayRequest>                 Requests;
+    std::atomic<size_t>                         NextRequest;
+    uint64_t                                    StartTime;
+    std::mutex                                  StatisticsLock;
+    std::map<std::string,CReplayStatistics>     Statistics;
+    size_t                                      NumOfConnects;
+
+    /// load requests from the access log
+    bool LoadLog(void);
+
+    /// parse one log line
+    bool ParseLine(const std::string& line,CReplayRequest& request,time_t& time);
+
+    /// worker executing requests
+    void RunWorker(void);
+
+    /// print final report
+    void PrintReport(uint64_t duration);
+
+    /// print one line of the report
+    void PrintStatistics(const std::string& name,CReplayStatistics& stat,uint64_t duration);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
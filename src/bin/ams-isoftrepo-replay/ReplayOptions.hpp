@@ -0,0 +1,178 @@
+#ifndef ReplayOptionsH
+#define ReplayOptionsH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <SimpleOptions.hpp>
+
+//------------------------------------------------------------------------------
+
+class CReplayOptions : public CSimpleOptions {
+public:
+    // constructor - tune option setup
+    CReplayOptions(void);
+
+    // program name and description -----------------------------------------------
+    CSO_PROG_NAME_BEGIN
+    "ams-isoftrepo-replay"
+    CSO_PROG_NAME_END
+
+    CSO_PROG_DESC_BEGIN
+    "Replays isoftrepo.fcgi requests from a web server access log directly against the FastCGI server."
+    CSO_PROG_DESC_END
+
+    // list of all options and arguments ------------------------------------------
+    CSO_LIST_BEGIN
+    // arguments ----------------------------
+    CSO_ARG(CSmallString,LogFile)
+    // options ------------------------------
+    CSO_OPT(CSmallString,Server)
+    CSO_OPT(CSmallString,Socket)
+    CSO_OPT(bool,KeepConn)
+    CSO_OPT(int,Concurrency)
+    CSO_OPT(double,Rate)
+    CSO_OPT(int,Limit)
+    CSO_OPT(CSmallString,ScriptName)
+    CSO_OPT(CSmallString,ServerName)
+    CSO_OPT(bool,Help)
+    CSO_OPT(bool,Version)
+    CSO_OPT(bool,Verbose)
+    CSO_LIST_END
+
+    CSO_MAP_BEGIN
+    // description of arguments ---------------------------------------------------
+    CSO_MAP_ARG(CSmallString,                   /* argument type */
+                LogFile,                          /* argument name */
+                NULL,                           /* default value */
+                true,                           /* is argument mandatory */
+                "logfile",                        /* parametr name */
+                "nginx or Apache access log in the common or combined format\n")   /* argument description */
+    // description of options -----------------------------------------------------
+    CSO_MAP_OPT(CSmallString,                           /* option type */
+                Server,                        /* option name */
+                "127.0.0.1:32696",                          /* default value */
+                false,                          /* is option mandatory */
+                's',                           /* short option name */
+                "server",                      /* long option name */
+                "HOST:PORT",                           /* parametr name */
+                "FastCGI server address")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(CSmallString,                           /* option type */
+                Socket,                        /* option name */
+                NULL,                          /* default value */
+                false,                          /* is option mandatory */
+                'u',                           /* short option name */
+                "socket",                      /* long option name */
+                "PATH",                           /* parametr name */
+                "unix domain socket of the FastCGI server, it overrides --server")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(bool,                           /* option type */
+                KeepConn,                        /* option name */
+                false,                          /* default value */
+                false,                          /* is option mandatory */
+                'k',                           /* short option name */
+                "keepconn",                      /* long option name */
+                NULL,                           /* parametr name */
+                "reuse connections for subsequent requests (FCGI_KEEP_CONN)")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(int,                           /* option type */
+                Concurrency,                        /* option name */
+                8,                          /* default value */
+                false,                          /* is option mandatory */
+                'c',                           /* short option name */
+                "concurrency",                      /* long option name */
+                "NUMBER",                           /* parametr name */
+                "number of concurrent connections")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(double,                           /* option type */
+                Rate,                        /* option name */
+                0.0,                          /* default value */
+                false,                          /* is option mandatory */
+                'r',                           /* short option name */
+                "rate",                      /* long option name */
+                "FACTOR",                           /* parametr name */
+                "replay speed relative to the log timestamps, zero - as fast as possible")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(int,                           /* option type */
+                Limit,                        /* option name */
+                0,                          /* default value */
+                false,                          /* is option mandatory */
+                'n',                           /* short option name */
+                "limit",                      /* long option name */
+                "NUMBER",                           /* parametr name */
+                "replay at most this number of requests, zero - all")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(CSmallString,                           /* option type */
+                ScriptName,                        /* option name */
+                "/isoftrepo/fcgi-bin/isoftrepo.fcgi",                          /* default value */
+                false,                          /* is option mandatory */
+                'p',                           /* short option name */
+                "scriptname",                      /* long option name */
+                "PATH",                           /* parametr name */
+                "value of SCRIPT_NAME sent to the server")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(CSmallString,                           /* option type */
+                ServerName,                        /* option name */
+                "localhost",                          /* default value */
+                false,                          /* is option mandatory */
+                'e',                           /* short option name */
+                "servername",                      /* long option name */
+                "NAME",                           /* parametr name */
+                "value of SERVER_NAME sent to the server")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(bool,                           /* option type */
+                Verbose,                        /* option name */
+                false,                          /* default value */
+                false,                          /* is option mandatory */
+                'v',                           /* short option name */
+                "verbose",                      /* long option name */
+                NULL,                           /* parametr name */
+                "increase output verbosity")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(bool,                           /* option type */
+                Version,                        /* option name */
+                false,                          /* default value */
+                false,                          /* is option mandatory */
+                '\0',                           /* short option name */
+                "version",                      /* long option name */
+                NULL,                           /* parametr name */
+                "output version information and exit")   /* option description */
+    //----------------------------------------------------------------------
+    CSO_MAP_OPT(bool,                           /* option type */
+                Help,                        /* option name */
+                false,                          /* default value */
+                false,                          /* is option mandatory */
+                'h',                           /* short option name */
+                "help",                      /* long option name */
+                NULL,                           /* parametr name */
+                "display this help and exit")   /* option description */
+    CSO_MAP_END
+
+    // final operation with options ------------------------------------------------
+private:
+    virtual int CheckOptions(void);
+    virtual int FinalizeOptions(void);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
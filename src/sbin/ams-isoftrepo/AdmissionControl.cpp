@@ -0,0 +1,188 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "AdmissionControl.hpp"
+#include "ServerMetrics.hpp"
+#include <chrono>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CAdmissionTicket::CAdmissionTicket(void)
+{
+    Arrival = GetMonotonicTime();
+    Reserved = false;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CAdmissionControl::CAdmissionControl(void)
+{
+    NumOfSlots = 0;
+    QueueDepth = 0;
+    Deadline = 0;
+    NumOfActive = 0;
+    NumOfWaiting = 0;
+    NumOfReserved = 0;
+    NumOfQueued = 0;
+    NumOfShedQueue = 0;
+    NumOfShedDeadline = 0;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CAdmissionControl::SetLimits(int slots,int queue_depth,int deadline)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+    NumOfSlots = slots > 0 ? slots : 0;
+    QueueDepth = queue_depth > 0 ? queue_depth : 0;
+    Deadline = deadline > 0 ? deadline : 0;
+    SlotFreed.notify_all();
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CAdmissionControl::Reserve(void)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+
+    if( (NumOfSlots > 0) && (NumOfReserved >= NumOfSlots + QueueDepth) ) {
+        NumOfShedQueue++;
+        return(false);
+    }
+
+    NumOfReserved++;
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+void CAdmissionControl::Release(void)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+    NumOfReserved--;
+}
+
+//------------------------------------------------------------------------------
+
+EAdmission CAdmissionControl::Enter(uint64_t arrival)
+{
+    std::unique_lock<std::mutex> lock(Lock);
+
+    if( (NumOfSlots == 0) || (NumOfActive < NumOfSlots) ) {
+        NumOfActive++;
+        return(EAD_ADMITTED);
+    }
+
+    NumOfWaiting++;
+    NumOfQueued++;
+
+    bool admitted;
+    if( Deadline > 0 ) {
+        // the time spent before the request reached the worker counts too
+        uint64_t now = GetMonotonicTime();
+        uint64_t end = arrival + (uint64_t)Deadline*1000;
+        admitted = false;
+        if( end > now ) {
+            admitted = SlotFreed.wait_for(lock,std::chrono::microseconds(end - now),
+                        [this]{ return((NumOfSlots == 0) || (NumOfActive < NumOfSlots)); });
+        }
+    } else {
+        SlotFreed.wait(lock,[this]{ return((NumOfSlots == 0) || (NumOfActive < NumOfSlots)); });
+        admitted = true;
+    }
+
+    NumOfWaiting--;
+
+    if( admitted == false ) {
+        NumOfReserved--;
+        NumOfShedDeadline++;
+        return(EAD_DEADLINE);
+    }
+
+    NumOfActive++;
+    return(EAD_ADMITTED);
+}
+
+//------------------------------------------------------------------------------
+
+void CAdmissionControl::Leave(void)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+    NumOfActive--;
+    NumOfReserved--;
+    SlotFreed.notify_one();
+}
+
+//------------------------------------------------------------------------------
+
+bool CAdmissionControl::CheckDeadline(uint64_t arrival)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+
+    if( (NumOfSlots == 0) || (Deadline == 0) ) return(true);
+    if( GetMonotonicTime() <= arrival + (uint64_t)Deadline*1000 ) return(true);
+
+    NumOfShedDeadline++;
+    return(false);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CAdmissionControl::PrintMetrics(std::string& output)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_admission_active","gauge",
+                                 "Number of requests in processing slots.");
+    CServerMetrics::AppendSample(output,"isoftrepo_admission_active",NULL,NumOfActive);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_admission_waiting","gauge",
+                                 "Number of requests waiting for a processing slot.");
+    CServerMetrics::AppendSample(output,"isoftrepo_admission_waiting",NULL,NumOfWaiting);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_admission_reserved","gauge",
+                                 "Number of accepted requests that are queued, waiting or processed.");
+    CServerMetrics::AppendSample(output,"isoftrepo_admission_reserved",NULL,NumOfReserved);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_admission_queued_total","counter",
+                                 "Number of requests that had to wait for a processing slot.");
+    CServerMetrics::AppendSample(output,"isoftrepo_admission_queued_total",NULL,NumOfQueued);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_admission_shed_total","counter",
+                                 "Number of requests answered with 503.");
+    CServerMetrics::AppendSample(output,"isoftrepo_admission_shed_total","reason=\"queue\"",NumOfShedQueue);
+    CServerMetrics::AppendSample(output,"isoftrepo_admission_shed_total","reason=\"deadline\"",NumOfShedDeadline);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
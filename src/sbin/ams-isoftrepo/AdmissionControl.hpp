@@ -0,0 +1,104 @@
+#ifndef AdmissionControlH
+#define AdmissionControlH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+
+/// result of admission
+enum EAdmission {
+    EAD_ADMITTED    = 0,
+    EAD_QUEUE_FULL  = 1,    // too many waiting requests
+    EAD_DEADLINE    = 2     // waiting exceeded the deadline
+};
+
+//------------------------------------------------------------------------------
+
+/// admission state of one request, it is created when the request is accepted
+/// and travels with the request to the worker
+
+class CAdmissionTicket {
+public:
+    CAdmissionTicket(void);
+
+    uint64_t    Arrival;    // in us, monotonic
+    bool        Reserved;   // the request holds a reservation
+};
+
+//------------------------------------------------------------------------------
+
+/// limits number of requests processed at once
+/// requests are reserved when they are accepted, requests above the slots
+/// and the queue depth are shed at once so they never occupy a worker,
+/// reserved requests wait for a slot until the deadline counted from arrival
+
+class CAdmissionControl {
+public:
+    CAdmissionControl(void);
+
+// setup methods ---------------------------------------------------------------
+    /// set limits, zero slots - admission control is disabled
+    void SetLimits(int slots,int queue_depth,int deadline);
+
+// main methods ----------------------------------------------------------------
+    /// reserve place for accepted request, false if it must be shed
+    bool Reserve(void);
+
+    /// release reservation of request that did not enter
+    void Release(void);
+
+    /// enter with reservation, Leave must be called for admitted requests,
+    /// the reservation is released for rejected ones
+    EAdmission Enter(uint64_t arrival);
+
+    /// leave processing slot and release the reservation
+    void Leave(void);
+
+    /// false and counted as shed if the deadline of request has passed
+    bool CheckDeadline(uint64_t arrival);
+
+    /// print admission metrics
+    void PrintMetrics(std::string& output);
+
+// section of private data -----------------------------------------------------
+private:
+    std::mutex                  Lock;
+    std::condition_variable     SlotFreed;
+    int                         NumOfSlots;
+    int                         QueueDepth;
+    int                         Deadline;       // in ms
+    int                         NumOfActive;
+    int                         NumOfWaiting;
+    int                         NumOfReserved;  // queued, waiting and active
+    uint64_t                    NumOfQueued;    // total number of requests that had to wait
+    uint64_t                    NumOfShedQueue;
+    uint64_t                    NumOfShedDeadline;
+};
+
+//------------------------------------------------------------------------------
+
+#endif
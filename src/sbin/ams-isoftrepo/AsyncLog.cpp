@@ -0,0 +1,232 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "AsyncLog.hpp"
+#include "ServerMetrics.hpp"
+#include <ErrorSystem.hpp>
+#include <string.h>
+#include <stdio.h>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CAsyncLog::CAsyncLog(void)
+    : Tail(0), NumOfRecords(0), NumOfDropped(0), NumOfTruncated(0)
+{
+    Slots = new CLogSlot[ASYNC_LOG_CAPACITY];
+    for(uint64_t i=0; i < ASYNC_LOG_CAPACITY; i++){
+        Slots[i].Sequence.store(i,std::memory_order_relaxed);
+    }
+    Head = 0;
+    Console = NULL;
+    sem_init(&Pending,0,0);
+}
+
+//------------------------------------------------------------------------------
+
+CAsyncLog::~CAsyncLog(void)
+{
+    sem_destroy(&Pending);
+    delete[] Slots;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CAsyncLog::SetConsole(CVerboseStr* p_vout)
+{
+    Console = p_vout;
+}
+
+//------------------------------------------------------------------------------
+
+void CAsyncLog::SetWatcherLogName(const CFileName& name)
+{
+    std::lock_guard<std::mutex> lock(NameLock);
+    WatcherLogName = name;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CAsyncLog::Push(ELogTarget target,const char* p_text,size_t length)
+{
+    // claim a slot, the buffer is full when the slot was not consumed yet
+    uint64_t  pos = Tail.load(std::memory_order_relaxed);
+    CLogSlot* p_slot;
+    for(;;){
+        p_slot = &Slots[pos & (ASYNC_LOG_CAPACITY-1)];
+        uint64_t seq = p_slot->Sequence.load(std::memory_order_acquire);
+        int64_t  diff = (int64_t)seq - (int64_t)pos;
+        if( diff == 0 ) {
+            if( Tail.compare_exchange_weak(pos,pos+1,std::memory_order_relaxed) ) break;
+        } else if( diff < 0 ) {
+            NumOfDropped.fetch_add(1,std::memory_order_relaxed);
+            return(false);
+        } else {
+            pos = Tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    if( length > ASYNC_LOG_RECORD_SIZE ) {
+        length = ASYNC_LOG_RECORD_SIZE;
+        NumOfTruncated.fetch_add(1,std::memory_order_relaxed);
+    }
+    p_slot->Target = target;
+    p_slot->Time = time(NULL);
+    p_slot->Length = length;
+    memcpy(p_slot->Text,p_text,length);
+
+    // publish the slot to the log thread
+    p_slot->Sequence.store(pos+1,std::memory_order_release);
+    NumOfRecords.fetch_add(1,std::memory_order_relaxed);
+    sem_post(&Pending);
+
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CAsyncLog::Push(ELogTarget target,const std::string& text)
+{
+    return(Push(target,text.c_str(),text.size()));
+}
+
+//------------------------------------------------------------------------------
+
+bool CAsyncLog::PushLines(ELogTarget target,const std::string& text)
+{
+    // long outputs, e.g. printed config, do not fit into one record
+    bool   result = true;
+    size_t start = 0;
+    while( start < text.size() ){
+        size_t end = text.find('\n',start);
+        end = (end == std::string::npos) ? text.size() : end + 1;
+        result &= Push(target,text.c_str() + start,end - start);
+        start = end;
+    }
+    return(result);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CAsyncLog::ExecuteThread(void)
+{
+    while( ThreadTerminated == false ){
+        // wake up periodically to check for termination
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME,&deadline);
+        deadline.tv_sec += 1;
+
+        if( sem_timedwait(&Pending,&deadline) != 0 ) continue;
+        while( sem_trywait(&Pending) == 0 );
+
+        WritePending();
+    }
+
+    // records pushed before termination
+    WritePending();
+}
+
+//------------------------------------------------------------------------------
+
+bool CAsyncLog::WritePending(void)
+{
+    CFileName log_name;
+    {
+        std::lock_guard<std::mutex> lock(NameLock);
+        log_name = WatcherLogName;
+    }
+
+    FILE* p_fout = NULL;
+    bool  found = false;
+
+    for(;;){
+        CLogSlot* p_slot = &Slots[Head & (ASYNC_LOG_CAPACITY-1)];
+        if( p_slot->Sequence.load(std::memory_order_acquire) != Head + 1 ) break;
+        found = true;
+
+        if( (p_slot->Target == ELT_CONSOLE) || (p_slot->Target == ELT_NOTICE) ) {
+            if( Console != NULL ) {
+                if( p_slot->Target == ELT_CONSOLE ) {
+                    *Console << high;
+                } else {
+                    *Console << low;
+                }
+                Console->write(p_slot->Text,p_slot->Length);
+                Console->flush();
+            }
+        }
+
+        if( (p_slot->Target == ELT_WATCHER) && (log_name != NULL) ) {
+            // the log is opened once per batch, it can be rotated in between
+            if( p_fout == NULL ) p_fout = fopen(log_name,"a");
+            if( p_fout != NULL ) {
+                // the time of the record, not of the write
+                struct tm tm;
+                char      stamp[32];
+                localtime_r(&p_slot->Time,&tm);
+                strftime(stamp,sizeof(stamp),"%Y-%m-%d %H:%M:%S",&tm);
+                fprintf(p_fout,"%s %.*s\n",stamp,(int)p_slot->Length,p_slot->Text);
+            }
+        }
+
+        // return the slot to producers
+        p_slot->Sequence.store(Head + ASYNC_LOG_CAPACITY,std::memory_order_release);
+        Head++;
+    }
+
+    if( p_fout != NULL ) fclose(p_fout);
+
+    return(found);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CAsyncLog::PrintMetrics(std::string& output)
+{
+    CServerMetrics::AppendHeader(output,"isoftrepo_log_records_total","counter",
+                                 "Number of log records accepted by the asynchronous log.");
+    CServerMetrics::AppendSample(output,"isoftrepo_log_records_total",NULL,
+                                 NumOfRecords.load(std::memory_order_relaxed));
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_log_dropped_total","counter",
+                                 "Number of log records dropped because the log buffer was full.");
+    CServerMetrics::AppendSample(output,"isoftrepo_log_dropped_total",NULL,
+                                 NumOfDropped.load(std::memory_order_relaxed));
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_log_truncated_total","counter",
+                                 "Number of log records truncated to the maximum record length.");
+    CServerMetrics::AppendSample(output,"isoftrepo_log_truncated_total",NULL,
+                                 NumOfTruncated.load(std::memory_order_relaxed));
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
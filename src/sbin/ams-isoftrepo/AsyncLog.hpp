@@ -0,0 +1,121 @@
+#ifndef AsyncLogH
+#define AsyncLogH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <SmallThread.hpp>
+#include <SmallString.hpp>
+#include <FileName.hpp>
+#include <VerboseStr.hpp>
+#include <semaphore.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <time.h>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+
+/// number of records in the ring buffer, it must be a power of two
+#define ASYNC_LOG_CAPACITY      1024
+
+/// maximum length of one record, longer records are truncated
+#define ASYNC_LOG_RECORD_SIZE   1024
+
+//------------------------------------------------------------------------------
+
+/// destination of log records
+enum ELogTarget {
+    ELT_CONSOLE,    // vout with high verbosity
+    ELT_NOTICE,     // vout with low verbosity
+    ELT_WATCHER     // watcher log, prefixed by the record time
+};
+
+//------------------------------------------------------------------------------
+
+/// one slot of the ring buffer
+
+class CLogSlot {
+public:
+    std::atomic<uint64_t>   Sequence;
+    ELogTarget              Target;
+    time_t                  Time;
+    size_t                  Length;
+    char                    Text[ASYNC_LOG_RECORD_SIZE];
+};
+
+//------------------------------------------------------------------------------
+
+/// non-blocking logging for request paths
+/// workers push records into a bounded lock-free multi-producer ring buffer,
+/// a single background thread formats and writes them, records that do not
+/// fit into the full buffer are dropped and counted
+
+class CAsyncLog : public CSmallThread {
+public:
+    CAsyncLog(void);
+    ~CAsyncLog(void);
+
+// setup methods ---------------------------------------------------------------
+    /// set console stream, it is used only by the log thread
+    void SetConsole(CVerboseStr* p_vout);
+
+    /// set name of the watcher log, empty name disables it
+    void SetWatcherLogName(const CFileName& name);
+
+// main methods ----------------------------------------------------------------
+    /// push record, it never blocks, false if the record was dropped
+    bool Push(ELogTarget target,const char* p_text,size_t length);
+
+    /// push record, it never blocks, false if the record was dropped
+    bool Push(ELogTarget target,const std::string& text);
+
+    /// push each line of the text as one record, false if any was dropped
+    bool PushLines(ELogTarget target,const std::string& text);
+
+    /// print log metrics
+    void PrintMetrics(std::string& output);
+
+// section of private data -----------------------------------------------------
+private:
+    CLogSlot*               Slots;
+    std::atomic<uint64_t>   Tail;           // next slot for producers
+    uint64_t                Head;           // next slot for the log thread
+    sem_t                   Pending;
+    std::atomic<uint64_t>   NumOfRecords;
+    std::atomic<uint64_t>   NumOfDropped;
+    std::atomic<uint64_t>   NumOfTruncated;
+
+    // owned by the log thread
+    CVerboseStr*            Console;
+    std::mutex              NameLock;
+    CFileName               WatcherLogName;
+
+    virtual void ExecuteThread(void);
+
+    /// write all pending records, false if there were none
+    bool WritePending(void);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
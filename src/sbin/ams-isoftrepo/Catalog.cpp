@@ -0,0 +1,505 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "Catalog.hpp"
+#include "ServerMetrics.hpp"
+#include "RequestTimer.hpp"
+#include <ErrorSystem.hpp>
+#include <XMLParser.hpp>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+// texts of parsed module records kept by each snapshot
+#define RECORD_CACHE_SIZE   (16*1024*1024)
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CCatalogSnapshot::CCatalogSnapshot(void)
+{
+    Generation = 0;
+    SharedGeneration = 0;
+    CreationTime = 0;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CXMLElement* CCatalogSnapshot::GetModuleRecord(uint32_t module,CCatalogRecordPtr& holder,bool cache) const
+{
+    holder = RecordCache.Find(module);
+    if( holder ) return(holder->Module);
+
+    const char* p_text;
+    size_t      length;
+    if( Mapping != NULL ) {
+        if( Mapping->GetRecord(module,p_text,length) == false ) return(NULL);
+    } else {
+        if( RecordTexts.GetRecord(module,p_text,length) == false ) return(NULL);
+    }
+
+    // concurrent requests can parse the same record, one of them is cached
+    CCatalogRecordPtr record(new CCatalogRecord);
+    CXMLParser xml_parser;
+    xml_parser.SetOutputXMLNode(&record->Document);
+    if( xml_parser.Parse(p_text,length) == false ) {
+        ES_ERROR("unable to parse module record");
+        return(NULL);
+    }
+    record->Module = record->Document.GetFirstChildElement("module");
+    if( record->Module == NULL ) {
+        ES_ERROR("module record has no module");
+        return(NULL);
+    }
+    CXMLElement* p_build = record->Module->GetChildElementByPath("builds/build");
+    while( p_build != NULL ) {
+        record->Builds.push_back(p_build);
+        p_build = p_build->GetNextSiblingElement("build");
+    }
+
+    if( cache ) RecordCache.Insert(module,record,length);
+    holder = record;
+    return(holder->Module);
+}
+
+//------------------------------------------------------------------------------
+
+CXMLElement* CCatalogSnapshot::GetBuildRecord(uint32_t build,CCatalogRecordPtr& holder) const
+{
+    if( build >= Table.GetBuildTable().size() ) return(NULL);
+    uint32_t module = Table.GetBuildTable()[build].Module;
+    if( GetModuleRecord(module,holder) == NULL ) return(NULL);
+
+    // the j-th build element of module is the build FirstBuild+j
+    uint32_t index = build - Table.GetModuleTable()[module].FirstBuild;
+    if( index >= holder->Builds.size() ) return(NULL);
+    return(holder->Builds[index]);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CCatalogRecordCache::CCatalogRecordCache(void)
+{
+    Size = 0;
+}
+
+//------------------------------------------------------------------------------
+
+CCatalogRecordPtr CCatalogRecordCache::Find(uint32_t module)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+    std::unordered_map<uint32_t,TRecordList::iterator>::iterator it = Index.find(module);
+    if( it == Index.end() ) return(CCatalogRecordPtr());
+    Records.splice(Records.begin(),Records,it->second);
+    return(it->second->Record);
+}
+
+//------------------------------------------------------------------------------
+
+void CCatalogRecordCache::Insert(uint32_t module,const CCatalogRecordPtr& record,size_t size)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+    if( Index.find(module) != Index.end() ) return;
+    if( size > RECORD_CACHE_SIZE ) return;
+
+    CRecordEntry entry;
+    entry.Module = module;
+    entry.Size = size;
+    entry.Record = record;
+    Records.push_front(entry);
+    Index[module] = Records.begin();
+    Size += size;
+
+    while( Size > RECORD_CACHE_SIZE ){
+        Size -= Records.back().Size;
+        Index.erase(Records.back().Module);
+        Records.pop_back();
+    }
+}
+
+//------------------------------------------------------------------------------
+
+size_t CCatalogRecordCache::GetNumOfRecords(void)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+    return(Records.size());
+}
+
+//------------------------------------------------------------------------------
+
+size_t CCatalogRecordCache::GetSize(void)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+    return(Size);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CCatalog::CCatalog(void)
+{
+    TimeToLive = 60*1000000;
+    Building = false;
+    Outdated = false;
+    Epoch = 0;
+    Generation = 0;
+    NumOfRebuilds = 0;
+    NumOfFailures = 0;
+    NumOfCoalesced = 0;
+    NumOfStale = 0;
+    NumOfPublished = 0;
+    NumOfAttached = 0;
+    SharingMode = ESCM_NONE;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CCatalog::SetBundles(const CSmallString& name,const CFileName& path)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+    BundleName = name;
+    BundlePath = path;
+    std::atomic_store(&Current,CCatalogSnapshotPtr());
+    Epoch++;
+}
+
+//------------------------------------------------------------------------------
+
+void CCatalog::SetTimeToLive(int ttl)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+    if( ttl < 0 ) ttl = 0;
+    TimeToLive = (uint64_t)ttl*1000000;
+}
+
+//------------------------------------------------------------------------------
+
+void CCatalog::SetSharing(ESharedCatalogMode mode,const CSmallString& segment)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+    SharingMode = mode;
+    Shared.SetSegment(mode,segment);
+}
+
+//------------------------------------------------------------------------------
+
+void CCatalog::SetPrewarmer(const TSnapshotPrewarmer& prewarmer)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+    Prewarmer = prewarmer;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CCatalogSnapshotPtr CCatalog::GetSnapshot(void)
+{
+    CCatalogSnapshotPtr current = std::atomic_load(&Current);
+    if( current ) {
+        // the replacement is prepared by Refresh, do not block the request
+        if( Outdated.load(std::memory_order_relaxed) ) NumOfStale++;
+        return(current);
+    }
+    return(Rebuild(false));
+}
+
+//------------------------------------------------------------------------------
+
+void CCatalog::Refresh(void)
+{
+    Rebuild(true);
+}
+
+//------------------------------------------------------------------------------
+
+CCatalogSnapshotPtr CCatalog::Rebuild(bool prewarm)
+{
+    std::unique_lock<std::mutex> lock(Lock);
+
+    // zero when the catalog is not attached or nothing is published yet
+    uint64_t shared_generation = 0;
+    if( SharingMode == ESCM_ATTACH ) shared_generation = Shared.GetGeneration();
+
+    CCatalogSnapshotPtr current = std::atomic_load(&Current);
+    if( current ) {
+        if( shared_generation != 0 ) {
+            if( current->SharedGeneration == shared_generation ) return(current);
+        } else {
+            if( (TimeToLive == 0) || (GetMonotonicTime() - current->CreationTime < TimeToLive) ) {
+                return(current);
+            }
+        }
+    }
+
+    if( Building ) {
+        if( current ) return(current);
+        NumOfCoalesced++;
+        Built.wait(lock,[this]{ return((Building == false) || std::atomic_load(&Current)); });
+        return(std::atomic_load(&Current));
+    }
+
+    // this thread rebuilds the catalog
+    Building = true;
+    Outdated = current != NULL;
+    CSmallString        name = BundleName;
+    CFileName           path = BundlePath;
+    uint64_t            epoch = Epoch;
+    ESharedCatalogMode  mode = SharingMode;
+    lock.unlock();
+
+    CCatalogSnapshotPtr snapshot = AcquireSnapshot(mode,shared_generation,name,path);
+
+    lock.lock();
+    TSnapshotPrewarmer prewarmer;
+    if( snapshot && (epoch == Epoch) ) {
+        // the generation is final, prewarmed pages are stored under it
+        snapshot->Generation = ++Generation;
+        if( prewarm && current ) prewarmer = Prewarmer;
+    }
+    lock.unlock();
+
+    // Building is still set, thus requests keep the current snapshot
+    if( prewarmer ) prewarmer(snapshot);
+
+    lock.lock();
+    Building = false;
+    Outdated = false;
+    if( snapshot == NULL ) {
+        NumOfFailures++;
+    } else if( (epoch == Epoch) && InstallSnapshot(snapshot) ) {
+        NumOfRebuilds++;
+    }
+    // otherwise bundles were changed in the meantime, the snapshot is obsolete
+    Built.notify_all();
+
+    return(std::atomic_load(&Current));
+}
+
+//------------------------------------------------------------------------------
+
+void CCatalog::PublishSnapshot(const CCatalogSnapshotPtr& snapshot,
+                               const CSmallString& name,const CFileName& path)
+{
+    std::unique_lock<std::mutex> lock(Lock);
+    ESharedCatalogMode mode = SharingMode;
+    lock.unlock();
+
+    bool published = false;
+    if( mode == ESCM_PUBLISH ) {
+        published = Shared.PublishSnapshot(*snapshot);
+        if( published == false ) {
+            ES_ERROR("unable to publish catalog in shared memory");
+        }
+    }
+
+    lock.lock();
+    // rebuilds of the previous bundles are not installed anymore
+    BundleName = name;
+    BundlePath = path;
+    Epoch++;
+    snapshot->Generation = ++Generation;
+    if( published ) NumOfPublished++;
+    TSnapshotPrewarmer prewarmer;
+    if( std::atomic_load(&Current) ) prewarmer = Prewarmer;
+    lock.unlock();
+
+    // pages of unchanged modules are likely requested again
+    if( prewarmer ) prewarmer(snapshot);
+
+    lock.lock();
+    if( InstallSnapshot(snapshot) ) NumOfRebuilds++;
+    Built.notify_all();
+}
+
+//------------------------------------------------------------------------------
+
+bool CCatalog::InstallSnapshot(const CCatalogSnapshotPtr& snapshot)
+{
+    // generations only grow, thus pages cached for the current one stay valid
+    CCatalogSnapshotPtr current = std::atomic_load(&Current);
+    for(;;){
+        if( current && (current->Generation >= snapshot->Generation) ) return(false);
+        if( std::atomic_compare_exchange_strong(&Current,&current,snapshot) ) return(true);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+CCatalogSnapshotPtr CCatalog::BuildSnapshot(const CSmallString& name,const CFileName& path)
+{
+    CCatalogSnapshotPtr snapshot(new CCatalogSnapshot);
+
+    {
+        // no DOM of the caches is built, records are parsed on demand
+        CPhaseTimer phase(ERP_LOAD_BUNDLES);
+        if( snapshot->Table.Load(name,path,snapshot->RecordTexts) == false ) {
+            ES_ERROR("unable to load bundles");
+            return(CCatalogSnapshotPtr());
+        }
+    }
+    {
+        CPhaseTimer phase(ERP_MERGE_BUNDLES);
+        snapshot->Bitmaps.Build(snapshot->Table);
+    }
+    snapshot->CreationTime = GetMonotonicTime();
+
+    return(snapshot);
+}
+
+//------------------------------------------------------------------------------
+
+CCatalogSnapshotPtr CCatalog::AcquireSnapshot(ESharedCatalogMode mode,uint64_t shared_generation,
+                                              const CSmallString& name,const CFileName& path)
+{
+    if( shared_generation != 0 ) {
+        CCatalogSnapshotPtr snapshot(new CCatalogSnapshot);
+        if( Shared.LoadSnapshot(*snapshot) == true ) {
+            // tables are mapped, only bitmaps are built by each process
+            snapshot->Bitmaps.Build(snapshot->Table);
+            std::lock_guard<std::mutex> lock(Lock);
+            NumOfAttached++;
+            return(snapshot);
+        }
+        ES_ERROR("unable to load shared catalog, building it locally");
+    }
+
+    CCatalogSnapshotPtr snapshot = BuildSnapshot(name,path);
+    if( snapshot && (mode == ESCM_PUBLISH) ) {
+        if( Shared.PublishSnapshot(*snapshot) == true ) {
+            std::lock_guard<std::mutex> lock(Lock);
+            NumOfPublished++;
+        } else {
+            ES_ERROR("unable to publish catalog in shared memory");
+        }
+    }
+    return(snapshot);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CCatalog::PrintMetrics(std::string& output,const char* p_labels)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+    CCatalogSnapshotPtr current = std::atomic_load(&Current);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_catalog_generation","gauge",
+                                 "Generation of the current catalog snapshot.");
+    CServerMetrics::AppendSample(output,"isoftrepo_catalog_generation",p_labels,Generation);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_catalog_age_seconds","gauge",
+                                 "Age of the current catalog snapshot.");
+    double age = current ? (GetMonotonicTime() - current->CreationTime) * 1.0e-6 : 0.0;
+    CServerMetrics::AppendSample(output,"isoftrepo_catalog_age_seconds",p_labels,age);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_catalog_rebuilds_total","counter",
+                                 "Number of catalog rebuilds.");
+    CServerMetrics::AppendSample(output,"isoftrepo_catalog_rebuilds_total",p_labels,NumOfRebuilds);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_catalog_rebuild_failures_total","counter",
+                                 "Number of failed catalog rebuilds.");
+    CServerMetrics::AppendSample(output,"isoftrepo_catalog_rebuild_failures_total",p_labels,NumOfFailures);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_catalog_coalesced_total","counter",
+                                 "Number of requests that waited for a rebuild started by another request.");
+    CServerMetrics::AppendSample(output,"isoftrepo_catalog_coalesced_total",p_labels,NumOfCoalesced);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_catalog_stale_total","counter",
+                                 "Number of requests served from an expired snapshot during a rebuild.");
+    CServerMetrics::AppendSample(output,"isoftrepo_catalog_stale_total",p_labels,NumOfStale);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_catalog_modules","gauge",
+                                 "Number of modules in the current catalog snapshot.");
+    CServerMetrics::AppendSample(output,"isoftrepo_catalog_modules",p_labels,
+                                 current ? current->Table.GetModuleTable().size() : 0);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_catalog_builds","gauge",
+                                 "Number of builds in the current catalog snapshot.");
+    CServerMetrics::AppendSample(output,"isoftrepo_catalog_builds",p_labels,
+                                 current ? current->Table.GetBuildTable().size() : 0);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_catalog_bitmaps","gauge",
+                                 "Number of filter bitmaps in the current catalog snapshot.");
+    CServerMetrics::AppendSample(output,"isoftrepo_catalog_bitmaps",p_labels,
+                                 current ? current->Bitmaps.GetNumOfBitmaps() : 0);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_catalog_bitmaps_bytes","gauge",
+                                 "Size of filter bitmaps in the current catalog snapshot.");
+    CServerMetrics::AppendSample(output,"isoftrepo_catalog_bitmaps_bytes",p_labels,
+                                 current ? current->Bitmaps.GetSize() : 0);
+
+    // record texts are kept only by local snapshot, shared segment is mapped
+    // only by attached snapshot
+    std::string memory_labels;
+    CServerMetrics::AppendHeader(output,"isoftrepo_catalog_memory_bytes","gauge",
+                                 "Memory used by parts of the current catalog snapshot.");
+    memory_labels = std::string(p_labels) + ",part=\"tables\"";
+    CServerMetrics::AppendSample(output,"isoftrepo_catalog_memory_bytes",memory_labels.c_str(),
+                                 current ? current->Table.GetSize() : 0);
+    memory_labels = std::string(p_labels) + ",part=\"bitmaps\"";
+    CServerMetrics::AppendSample(output,"isoftrepo_catalog_memory_bytes",memory_labels.c_str(),
+                                 current ? current->Bitmaps.GetSize() : 0);
+    memory_labels = std::string(p_labels) + ",part=\"records\"";
+    CServerMetrics::AppendSample(output,"isoftrepo_catalog_memory_bytes",memory_labels.c_str(),
+                                 current ? current->RecordTexts.GetSize() : 0);
+    memory_labels = std::string(p_labels) + ",part=\"parsed\"";
+    CServerMetrics::AppendSample(output,"isoftrepo_catalog_memory_bytes",memory_labels.c_str(),
+                                 current ? current->RecordCache.GetSize() : 0);
+    memory_labels = std::string(p_labels) + ",part=\"shared\"";
+    CServerMetrics::AppendSample(output,"isoftrepo_catalog_memory_bytes",memory_labels.c_str(),
+                                 (current && current->Mapping) ? current->Mapping->GetSize() : 0);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_catalog_cached_records","gauge",
+                                 "Number of parsed module records cached by the current catalog snapshot.");
+    CServerMetrics::AppendSample(output,"isoftrepo_catalog_cached_records",p_labels,
+                                 current ? current->RecordCache.GetNumOfRecords() : 0);
+
+    if( SharingMode == ESCM_NONE ) return;
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_catalog_shared_generation","gauge",
+                                 "Shared memory generation of the current catalog snapshot.");
+    uint64_t shared = current ? current->SharedGeneration : 0;
+    CServerMetrics::AppendSample(output,"isoftrepo_catalog_shared_generation",p_labels,shared);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_catalog_published_total","counter",
+                                 "Number of catalog snapshots published in shared memory.");
+    CServerMetrics::AppendSample(output,"isoftrepo_catalog_published_total",p_labels,NumOfPublished);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_catalog_attached_total","counter",
+                                 "Number of catalog snapshots loaded from shared memory.");
+    CServerMetrics::AppendSample(output,"isoftrepo_catalog_attached_total",p_labels,NumOfAttached);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
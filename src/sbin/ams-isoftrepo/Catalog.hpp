@@ -0,0 +1,222 @@
+#ifndef CatalogH
+#define CatalogH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <SmallString.hpp>
+#include <FileName.hpp>
+#include <ModCache.hpp>
+#include <XMLDocument.hpp>
+#include <XMLElement.hpp>
+#include "SharedCatalog.hpp"
+#include "CatalogTable.hpp"
+#include "CatalogBitmap.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+
+/// module record parsed from its text
+
+class CCatalogRecord {
+public:
+    CXMLDocument                Document;
+    CXMLElement*                Module;     // in Document
+    std::vector<CXMLElement*>   Builds;     // build elements in the order of the table
+};
+
+//------------------------------------------------------------------------------
+
+typedef std::shared_ptr<CCatalogRecord> CCatalogRecordPtr;
+
+//------------------------------------------------------------------------------
+
+/// parsed module records of a snapshot, the least recently used records are
+/// dropped when texts of cached records exceed the limit, records are kept
+/// alive by requests using them
+
+class CCatalogRecordCache {
+public:
+    CCatalogRecordCache(void);
+
+// main methods ----------------------------------------------------------------
+    /// get cached record, NULL if it is not cached
+    CCatalogRecordPtr Find(uint32_t module);
+
+    /// add parsed record, size - length of its text
+    void Insert(uint32_t module,const CCatalogRecordPtr& record,size_t size);
+
+// information methods ---------------------------------------------------------
+    /// number of cached records
+    size_t GetNumOfRecords(void);
+
+    /// texts of cached records in bytes
+    size_t GetSize(void);
+
+// section of private data -----------------------------------------------------
+private:
+    class CRecordEntry {
+    public:
+        uint32_t            Module;
+        size_t              Size;
+        CCatalogRecordPtr   Record;
+    };
+    typedef std::list<CRecordEntry>     TRecordList;
+
+    std::mutex                                      Lock;
+    TRecordList                                     Records;    // most recently used first
+    std::unordered_map<uint32_t,TRecordList::iterator>  Index;
+    size_t                                          Size;
+};
+
+//------------------------------------------------------------------------------
+
+/// catalog of modules shared by all requests, it is never modified once built
+/// tables are loaded from bundle caches in one streaming pass, only texts
+/// of module records are kept, they are parsed on first use and cached
+/// snapshot attached to shared memory uses its tables and record texts
+/// directly from the mapped segment
+
+class CCatalogSnapshot {
+public:
+    CCatalogSnapshot(void);
+
+// information methods ---------------------------------------------------------
+    /// get module record in the order of Table, records are parsed once
+    /// and cached unless cache is false, the holder keeps the parsed record
+    /// alive
+    CXMLElement* GetModuleRecord(uint32_t module,CCatalogRecordPtr& holder,bool cache = true) const;
+
+    /// get build record by its index in Table, the holder keeps the parsed
+    /// module record alive
+    CXMLElement* GetBuildRecord(uint32_t build,CCatalogRecordPtr& holder) const;
+
+    CModCache                   Cache;      // empty, used for documentation of modules
+    CCatalogRecordTexts         RecordTexts;    // texts of records, empty for attached snapshot
+    CCatalogTable               Table;      // compact tables of bundle caches
+    CCatalogBitmapIndex         Bitmaps;    // filters over builds of Table
+    CSharedCatalogMappingPtr    Mapping;    // segment used by attached snapshot
+    mutable CCatalogRecordCache RecordCache;    // parsed records
+    uint64_t                    Generation;
+    uint64_t                    SharedGeneration;   // zero - not published in shared memory
+    uint64_t                    CreationTime;       // monotonic time in usec
+};
+
+//------------------------------------------------------------------------------
+
+typedef std::shared_ptr<CCatalogSnapshot> CCatalogSnapshotPtr;
+
+/// prepares caches for a new snapshot before it replaces the current one
+typedef std::function<void(const CCatalogSnapshotPtr& snapshot)> TSnapshotPrewarmer;
+
+//------------------------------------------------------------------------------
+
+/// provides the current catalog snapshot
+/// requests always get the current snapshot, expired or outdated snapshot is
+/// replaced by Refresh in the background, only the very first snapshot is
+/// built by a request and concurrent requests wait for it
+/// attached catalog follows generations published by another process instead
+/// of the lifetime, it is built locally until the first one is published
+/// new snapshot replacing an existing one gets its generation first, then it
+/// is passed to the prewarmer and finally installed by compare-and-swap unless
+/// a newer snapshot is current already
+
+class CCatalog {
+public:
+    CCatalog(void);
+
+// setup methods ---------------------------------------------------------------
+    /// set bundles used for the catalog
+    void SetBundles(const CSmallString& name,const CFileName& path);
+
+    /// set lifetime of snapshots in seconds, zero - snapshots do not expire
+    void SetTimeToLive(int ttl);
+
+    /// set sharing of the catalog with other server processes
+    void SetSharing(ESharedCatalogMode mode,const CSmallString& segment);
+
+    /// set prewarmer of new snapshots
+    void SetPrewarmer(const TSnapshotPrewarmer& prewarmer);
+
+// main methods ----------------------------------------------------------------
+    /// get current snapshot, it can be NULL if the catalog cannot be built
+    /// it never waits for rebuilds once the first snapshot exists
+    CCatalogSnapshotPtr GetSnapshot(void);
+
+    /// replace bundles and snapshot at once, the snapshot is built by the caller
+    void PublishSnapshot(const CCatalogSnapshotPtr& snapshot,
+                         const CSmallString& name,const CFileName& path);
+
+    /// build new snapshot
+    static CCatalogSnapshotPtr BuildSnapshot(const CSmallString& name,const CFileName& path);
+
+    /// rebuild expired snapshot or switch to a newly published one,
+    /// the new snapshot is prewarmed before it is installed
+    void Refresh(void);
+
+    /// print catalog metrics
+    void PrintMetrics(std::string& output,const char* p_labels);
+
+// section of private data -----------------------------------------------------
+private:
+    std::mutex                  Lock;
+    std::condition_variable     Built;
+    CSmallString                BundleName;
+    CFileName                   BundlePath;
+    uint64_t                    TimeToLive;     // in usec
+    CCatalogSnapshotPtr         Current;        // use atomic operations
+    ESharedCatalogMode          SharingMode;
+    CSharedCatalog              Shared;
+    TSnapshotPrewarmer          Prewarmer;
+    bool                        Building;
+    std::atomic<bool>           Outdated;       // current snapshot is being replaced
+    uint64_t                    Epoch;          // changed with bundles
+    uint64_t                    Generation;
+    uint64_t                    NumOfRebuilds;
+    uint64_t                    NumOfFailures;
+    uint64_t                    NumOfCoalesced; // requests waiting for a rebuild
+    std::atomic<uint64_t>       NumOfStale;     // requests served during a rebuild
+    uint64_t                    NumOfPublished;
+    uint64_t                    NumOfAttached;  // snapshots loaded from shared memory
+
+    /// rebuild missing or outdated snapshot, prewarm - prewarm the new one
+    CCatalogSnapshotPtr Rebuild(bool prewarm);
+
+    /// install snapshot unless a newer one is current
+    bool InstallSnapshot(const CCatalogSnapshotPtr& snapshot);
+
+    /// build snapshot or load the published one
+    CCatalogSnapshotPtr AcquireSnapshot(ESharedCatalogMode mode,uint64_t shared_generation,
+                                        const CSmallString& name,const CFileName& path);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,415 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "CatalogBitmap.hpp"
+#include "CatalogTable.hpp"
+#include <algorithm>
+#include <string.h>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+// tokens of architectures are separated by hashes, e.g. x86_64#avx2#cuda
+#define ARCH_TOKEN_SEPARATOR '#'
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CCatalogBitmap::CCatalogBitmap(void)
+{
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CCatalogBitmap::Set(uint32_t bit)
+{
+    uint32_t pos = bit >> 6;
+    if( Positions.empty() || (Positions.back() != pos) ) {
+        Positions.push_back(pos);
+        Words.push_back(0);
+    }
+    Words.back() |= (uint64_t)1 << (bit & 63);
+}
+
+//------------------------------------------------------------------------------
+
+bool CCatalogBitmap::Test(uint32_t bit) const
+{
+    uint32_t pos = bit >> 6;
+    size_t   i = FindWord(pos);
+    if( (i == Positions.size()) || (Positions[i] != pos) ) return(false);
+    return( (Words[i] & ((uint64_t)1 << (bit & 63))) != 0 );
+}
+
+//------------------------------------------------------------------------------
+
+bool CCatalogBitmap::TestRange(uint32_t first,uint32_t num) const
+{
+    if( num == 0 ) return(false);
+    uint32_t last = first + num - 1;
+    uint32_t lpos = last >> 6;
+
+    for(size_t i = FindWord(first >> 6); (i < Positions.size()) && (Positions[i] <= lpos); i++){
+        uint64_t mask = ~(uint64_t)0;
+        if( Positions[i] == (first >> 6) ) mask &= ~(uint64_t)0 << (first & 63);
+        if( Positions[i] == lpos ) mask &= ~(uint64_t)0 >> (63 - (last & 63));
+        if( (Words[i] & mask) != 0 ) return(true);
+    }
+    return(false);
+}
+
+//------------------------------------------------------------------------------
+
+void CCatalogBitmap::Clear(void)
+{
+    Positions.clear();
+    Words.clear();
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CCatalogBitmap::And(const CCatalogBitmap& left,const CCatalogBitmap& right,CCatalogBitmap& result)
+{
+    CCatalogBitmap tmp;
+    size_t i = 0, j = 0;
+    while( (i < left.Positions.size()) && (j < right.Positions.size()) ){
+        if( left.Positions[i] < right.Positions[j] ) {
+            i++;
+        } else if( left.Positions[i] > right.Positions[j] ) {
+            j++;
+        } else {
+            uint64_t word = left.Words[i] & right.Words[j];
+            if( word != 0 ) {
+                tmp.Positions.push_back(left.Positions[i]);
+                tmp.Words.push_back(word);
+            }
+            i++;
+            j++;
+        }
+    }
+    result.Positions.swap(tmp.Positions);
+    result.Words.swap(tmp.Words);
+}
+
+//------------------------------------------------------------------------------
+
+void CCatalogBitmap::Or(const CCatalogBitmap& left,const CCatalogBitmap& right,CCatalogBitmap& result)
+{
+    CCatalogBitmap tmp;
+    tmp.Positions.reserve(left.Positions.size() + right.Positions.size());
+    tmp.Words.reserve(left.Words.size() + right.Words.size());
+    size_t i = 0, j = 0;
+    while( (i < left.Positions.size()) || (j < right.Positions.size()) ){
+        if( (j == right.Positions.size())
+            || ((i < left.Positions.size()) && (left.Positions[i] < right.Positions[j])) ) {
+            tmp.Positions.push_back(left.Positions[i]);
+            tmp.Words.push_back(left.Words[i]);
+            i++;
+        } else if( (i == left.Positions.size()) || (left.Positions[i] > right.Positions[j]) ) {
+            tmp.Positions.push_back(right.Positions[j]);
+            tmp.Words.push_back(right.Words[j]);
+            j++;
+        } else {
+            tmp.Positions.push_back(left.Positions[i]);
+            tmp.Words.push_back(left.Words[i] | right.Words[j]);
+            i++;
+            j++;
+        }
+    }
+    result.Positions.swap(tmp.Positions);
+    result.Words.swap(tmp.Words);
+}
+
+//------------------------------------------------------------------------------
+
+void CCatalogBitmap::AndNot(const CCatalogBitmap& left,const CCatalogBitmap& right,CCatalogBitmap& result)
+{
+    CCatalogBitmap tmp;
+    size_t j = 0;
+    for(size_t i=0; i < left.Positions.size(); i++){
+        while( (j < right.Positions.size()) && (right.Positions[j] < left.Positions[i]) ) j++;
+        uint64_t word = left.Words[i];
+        if( (j < right.Positions.size()) && (right.Positions[j] == left.Positions[i]) ) {
+            word &= ~right.Words[j];
+        }
+        if( word != 0 ) {
+            tmp.Positions.push_back(left.Positions[i]);
+            tmp.Words.push_back(word);
+        }
+    }
+    result.Positions.swap(tmp.Positions);
+    result.Words.swap(tmp.Words);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CCatalogBitmap::IsEmpty(void) const
+{
+    return(Words.empty());
+}
+
+//------------------------------------------------------------------------------
+
+size_t CCatalogBitmap::GetCount(void) const
+{
+    size_t count = 0;
+    for(uint64_t word : Words) count += __builtin_popcountll(word);
+    return(count);
+}
+
+//------------------------------------------------------------------------------
+
+void CCatalogBitmap::GetBits(std::vector<uint32_t>& bits) const
+{
+    bits.clear();
+    for(size_t i=0; i < Words.size(); i++){
+        uint64_t word = Words[i];
+        while( word != 0 ) {
+            bits.push_back((Positions[i] << 6) + __builtin_ctzll(word));
+            word &= word - 1;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+size_t CCatalogBitmap::GetSize(void) const
+{
+    return( Positions.capacity() * sizeof(uint32_t) + Words.capacity() * sizeof(uint64_t) );
+}
+
+//------------------------------------------------------------------------------
+
+size_t CCatalogBitmap::FindWord(uint32_t pos) const
+{
+    return( std::lower_bound(Positions.begin(),Positions.end(),pos) - Positions.begin() );
+}
+
+//------------------------------------------------------------------------------
+
+void CCatalogBitmap::Compact(void)
+{
+    Positions.shrink_to_fit();
+    Words.shrink_to_fit();
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CCatalogFilter::CCatalogFilter(void)
+{
+    ACL = -1;
+}
+
+//------------------------------------------------------------------------------
+
+void CCatalogFilter::SetFilter(const char* p_archs,const char* p_modes,const char* p_bundles,
+                               const char* p_acl)
+{
+    SplitList(p_archs,ArchTokens);
+    SplitList(p_modes,Modes);
+    SplitList(p_bundles,Bundles);
+
+    ACL = -1;
+    if( p_acl != NULL ) {
+        if( strcmp(p_acl,"true") == 0 ) ACL = 1;
+        if( strcmp(p_acl,"false") == 0 ) ACL = 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+bool CCatalogFilter::IsEmpty(void) const
+{
+    return( ArchTokens.empty() && Modes.empty() && Bundles.empty() && (ACL < 0) );
+}
+
+//------------------------------------------------------------------------------
+
+void CCatalogFilter::AppendKey(std::string& key) const
+{
+    const std::vector<std::string>* lists[3] = { &ArchTokens, &Modes, &Bundles };
+    for(int i=0; i < 3; i++){
+        for(size_t j=0; j < lists[i]->size(); j++){
+            if( j > 0 ) key += ',';
+            key += (*lists[i])[j];
+        }
+        key += '\n';
+    }
+    key += std::to_string(ACL);
+}
+
+//------------------------------------------------------------------------------
+
+void CCatalogFilter::SplitList(const char* p_list,std::vector<std::string>& values)
+{
+    values.clear();
+    std::string item;
+    for(const char* p = p_list; ; p++){
+        if( (p != NULL) && (*p != '\0') && (*p != ',') ){
+            item += *p;
+            continue;
+        }
+        if( ! item.empty() ) values.push_back(item);
+        item.clear();
+        if( (p == NULL) || (*p == '\0') ) break;
+    }
+    std::sort(values.begin(),values.end());
+    values.erase(std::unique(values.begin(),values.end()),values.end());
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CCatalogBitmapIndex::CCatalogBitmapIndex(void)
+{
+    Built = false;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CCatalogBitmapIndex::Build(const CCatalogTable& table)
+{
+    CTableView<CCatalogBundle> bundles = table.GetBundleTable();
+    CTableView<CCatalogModule> modules = table.GetModuleTable();
+    CTableView<CCatalogBuild>  builds = table.GetBuildTable();
+
+    // builds are visited in ascending order as required by CCatalogBitmap::Set
+    std::string token;
+    for(uint32_t i=0; i < builds.size(); i++){
+        const CCatalogBuild&  build = builds[i];
+        const CCatalogModule& module = modules[build.Module];
+
+        All.Set(i);
+        if( build.HasACL || module.HasACL ) WithACL.Set(i);
+        Modes[table.GetString(build.Mode)].Set(i);
+        Bundles[table.GetString(bundles[module.Bundle].Name)].Set(i);
+
+        // repeated tokens set the same bit again
+        const char* p_arch = table.GetString(build.Arch);
+        for(const char* p = p_arch; ; p++){
+            if( (*p != '\0') && (*p != ARCH_TOKEN_SEPARATOR) ){
+                token += *p;
+                continue;
+            }
+            if( ! token.empty() ) ArchTokens[token].Set(i);
+            token.clear();
+            if( *p == '\0' ) break;
+        }
+    }
+
+    All.Compact();
+    WithACL.Compact();
+    BitmapMap* maps[3] = { &ArchTokens, &Modes, &Bundles };
+    for(int i=0; i < 3; i++){
+        for(BitmapMap::value_type& item : *maps[i]) item.second.Compact();
+    }
+
+    Built = true;
+}
+
+//------------------------------------------------------------------------------
+
+void CCatalogBitmapIndex::Evaluate(const CCatalogFilter& filter,CCatalogBitmap& result) const
+{
+    result = All;
+
+    CCatalogBitmap values;
+    if( ! filter.ArchTokens.empty() ) {
+        Union(ArchTokens,filter.ArchTokens,values);
+        CCatalogBitmap::And(result,values,result);
+    }
+    if( ! filter.Modes.empty() ) {
+        Union(Modes,filter.Modes,values);
+        CCatalogBitmap::And(result,values,result);
+    }
+    if( ! filter.Bundles.empty() ) {
+        Union(Bundles,filter.Bundles,values);
+        CCatalogBitmap::And(result,values,result);
+    }
+    if( filter.ACL == 1 ) {
+        CCatalogBitmap::And(result,WithACL,result);
+    }
+    if( filter.ACL == 0 ) {
+        CCatalogBitmap::AndNot(result,WithACL,result);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CCatalogBitmapIndex::Union(const BitmapMap& map,const std::vector<std::string>& values,
+                                CCatalogBitmap& result)
+{
+    result.Clear();
+    for(const std::string& value : values){
+        BitmapMap::const_iterator it = map.find(value);
+        if( it == map.end() ) continue;     // unknown values match nothing
+        CCatalogBitmap::Or(result,it->second,result);
+    }
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CCatalogBitmapIndex::IsBuilt(void) const
+{
+    return(Built);
+}
+
+//------------------------------------------------------------------------------
+
+size_t CCatalogBitmapIndex::GetNumOfBitmaps(void) const
+{
+    if( ! Built ) return(0);
+    return( 2 + ArchTokens.size() + Modes.size() + Bundles.size() );
+}
+
+//------------------------------------------------------------------------------
+
+size_t CCatalogBitmapIndex::GetSize(void) const
+{
+    size_t size = All.GetSize() + WithACL.GetSize();
+    const BitmapMap* maps[3] = { &ArchTokens, &Modes, &Bundles };
+    for(int i=0; i < 3; i++){
+        for(const BitmapMap::value_type& item : *maps[i]) {
+            size += item.first.capacity() + item.second.GetSize();
+        }
+    }
+    return(size);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
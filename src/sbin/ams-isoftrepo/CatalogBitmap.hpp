@@ -0,0 +1,170 @@
+#ifndef CatalogBitmapH
+#define CatalogBitmapH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+
+class CCatalogTable;
+
+//------------------------------------------------------------------------------
+
+/// compressed bitmap of build indexes
+/// only non-empty 64-bit words are stored together with their positions,
+/// thus sparse bitmaps (rare arch tokens, small bundles) are small and
+/// AND/OR touch only the stored words
+
+class CCatalogBitmap {
+public:
+    CCatalogBitmap(void);
+
+// main methods ----------------------------------------------------------------
+    /// set bit, bits must be set in ascending order
+    void Set(uint32_t bit);
+
+    /// test bit
+    bool Test(uint32_t bit) const;
+
+    /// is any bit set in the range [first,first+num)
+    bool TestRange(uint32_t first,uint32_t num) const;
+
+    /// remove all bits
+    void Clear(void);
+
+// operations ------------------------------------------------------------------
+    /// result = left AND right
+    static void And(const CCatalogBitmap& left,const CCatalogBitmap& right,CCatalogBitmap& result);
+
+    /// result = left OR right
+    static void Or(const CCatalogBitmap& left,const CCatalogBitmap& right,CCatalogBitmap& result);
+
+    /// result = left AND NOT right
+    static void AndNot(const CCatalogBitmap& left,const CCatalogBitmap& right,CCatalogBitmap& result);
+
+// information methods ---------------------------------------------------------
+    /// is any bit set
+    bool IsEmpty(void) const;
+
+    /// number of set bits
+    size_t GetCount(void) const;
+
+    /// get set bits in ascending order
+    void GetBits(std::vector<uint32_t>& bits) const;
+
+    /// number of bytes used by the bitmap
+    size_t GetSize(void) const;
+
+// section of private data -----------------------------------------------------
+private:
+    std::vector<uint32_t>   Positions;  // ascending word positions
+    std::vector<uint64_t>   Words;      // non-empty words
+
+    /// index of the first stored word with position >= pos
+    size_t FindWord(uint32_t pos) const;
+
+    /// release unused capacity
+    void Compact(void);
+
+    friend class CCatalogBitmapIndex;
+};
+
+//------------------------------------------------------------------------------
+
+/// build filter, values of one kind are ORed, kinds are ANDed
+
+class CCatalogFilter {
+public:
+    CCatalogFilter(void);
+
+// setup methods ---------------------------------------------------------------
+    /// set values from comma separated lists, acl is true, false or empty
+    void SetFilter(const char* p_archs,const char* p_modes,const char* p_bundles,
+                   const char* p_acl);
+
+// information methods ---------------------------------------------------------
+    /// is the filter empty
+    bool IsEmpty(void) const;
+
+    /// append canonical form of the filter used in cache keys
+    void AppendKey(std::string& key) const;
+
+// section of public data ------------------------------------------------------
+public:
+    std::vector<std::string>    ArchTokens;
+    std::vector<std::string>    Modes;
+    std::vector<std::string>    Bundles;
+    int                         ACL;        // -1 - any, 0 - without ACL, 1 - with ACL
+
+    /// split comma separated list, values are sorted and unique
+    static void SplitList(const char* p_list,std::vector<std::string>& values);
+};
+
+//------------------------------------------------------------------------------
+
+/// bitmap indexes over builds of the catalog table
+/// there is one bitmap per arch token, mode, bundle and for builds with ACL
+
+class CCatalogBitmapIndex {
+public:
+    CCatalogBitmapIndex(void);
+
+// main methods ----------------------------------------------------------------
+    /// build bitmaps from the catalog table
+    void Build(const CCatalogTable& table);
+
+    /// evaluate filter, all builds for the empty filter
+    void Evaluate(const CCatalogFilter& filter,CCatalogBitmap& result) const;
+
+// information methods ---------------------------------------------------------
+    /// were the bitmaps built
+    bool IsBuilt(void) const;
+
+    /// number of bitmaps
+    size_t GetNumOfBitmaps(void) const;
+
+    /// number of bytes used by the bitmaps
+    size_t GetSize(void) const;
+
+// section of private data -----------------------------------------------------
+private:
+    typedef std::unordered_map<std::string,CCatalogBitmap>  BitmapMap;
+
+    bool            Built;
+    CCatalogBitmap  All;
+    CCatalogBitmap  WithACL;
+    BitmapMap       ArchTokens;
+    BitmapMap       Modes;
+    BitmapMap       Bundles;
+
+    /// OR bitmaps of values
+    static void Union(const BitmapMap& map,const std::vector<std::string>& values,
+                      CCatalogBitmap& result);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,1029 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "CatalogTable.hpp"
+#include "CatalogBitmap.hpp"
+#include "VerRecord.hpp"
+#include "XMLStream.hpp"
+#include <ErrorSystem.hpp>
+#include <algorithm>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <string.h>
+#include <unistd.h>
+#include <stdlib.h>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+// bundle layout read by CModuleController::LoadBundles
+#define BUNDLE_DIR          "_ams_bundle"
+#define BUNDLE_CONFIG       "bundle.xml"
+#define BUNDLE_CACHE_BIG    "cache-big.xml"
+
+//------------------------------------------------------------------------------
+
+// combine stamps, the order matters
+#define COMBINE_STAMP(seed,value) ((seed) ^ ((value) + 0x9e3779b97f4a7c15ULL + ((seed) << 6) + ((seed) >> 2)))
+
+//------------------------------------------------------------------------------
+
+// FNV-1a over the string, it continues the given hash
+static uint64_t HashString(uint64_t hash,const char* p_str)
+{
+    for(const unsigned char* p = (const unsigned char*)p_str; *p != '\0'; p++){
+        hash ^= *p;
+        hash *= 1099511628211ULL;
+    }
+    return(hash);
+}
+
+//------------------------------------------------------------------------------
+
+// add hash of string to the stamp, the hash does not depend on the pool
+static uint64_t CombineString(uint64_t stamp,const char* p_str)
+{
+    return(COMBINE_STAMP(stamp,HashString(14695981039346656037ULL,p_str)));
+}
+
+//------------------------------------------------------------------------------
+
+// hash of name, name:ver or name:ver:arch:mode, the key is never built
+static uint64_t HashKey(const char* p_name,const char* p_ver = NULL,
+                        const char* p_arch = NULL,const char* p_mode = NULL)
+{
+    uint64_t hash = HashString(14695981039346656037ULL,p_name);
+    if( p_ver == NULL ) return(hash);
+    hash = HashString(HashString(hash,":"),p_ver);
+    if( p_arch == NULL ) return(hash);
+    hash = HashString(HashString(hash,":"),p_arch);
+    hash = HashString(HashString(hash,":"),p_mode);
+    return(hash);
+}
+
+//------------------------------------------------------------------------------
+
+// number of hash slots, at most half of them is used, zero for no items
+static size_t GetHashSize(size_t count)
+{
+    if( count == 0 ) return(0);
+    size_t size = 1;
+    while( size < 2*count ) size <<= 1;
+    return(size);
+}
+
+//------------------------------------------------------------------------------
+
+// find item by linear probing, slots hold index + 1, zero - empty slot
+template<class TEqual>
+static bool FindSlot(const uint32_t* p_slots,size_t size,uint64_t hash,const TEqual& equal,uint32_t& index)
+{
+    if( size == 0 ) return(false);
+    size_t mask = size - 1;
+    for(size_t slot = hash & mask; p_slots[slot] != 0; slot = (slot + 1) & mask){
+        if( equal(p_slots[slot] - 1) ) {
+            index = p_slots[slot] - 1;
+            return(true);
+        }
+    }
+    return(false);
+}
+
+//------------------------------------------------------------------------------
+
+// store item into the first empty slot
+static void InsertSlot(std::vector<uint32_t>& slots,uint64_t hash,uint32_t index)
+{
+    size_t mask = slots.size() - 1;
+    size_t slot = hash & mask;
+    while( slots[slot] != 0 ) slot = (slot + 1) & mask;
+    slots[slot] = index + 1;
+}
+
+//------------------------------------------------------------------------------
+
+// probing terminates only if an empty slot exists
+static bool IsValidHash(const uint32_t* p_slots,uint64_t size,uint64_t count)
+{
+    if( size == 0 ) return(true);
+    if( (size & (size - 1)) != 0 ) return(false);
+    uint64_t used = 0;
+    for(uint64_t i=0; i < size; i++){
+        if( p_slots[i] == 0 ) continue;
+        if( p_slots[i] > count ) return(false);
+        used++;
+    }
+    return(used < size);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+/// tables stored in the image
+
+enum ECatalogTable {
+    ECT_POOL,
+    ECT_BUNDLES,
+    ECT_MODULES,
+    ECT_BUILDS,
+    ECT_MODULE_CATEGORIES,
+    ECT_CATEGORIES,
+    ECT_CATEGORY_MODULES,
+    ECT_VERSIONS,
+    ECT_VERSION_BUILDS,
+    ECT_MODULE_HASH,
+    ECT_BUILD_HASH,
+    ECT_VERSION_HASH,
+    ECT_MAX
+};
+
+//------------------------------------------------------------------------------
+
+/// header of the image, tables follow aligned to eight bytes
+
+class CCatalogTableImage {
+public:
+    char        Magic[8];
+    uint32_t    RecordSizes[ECT_MAX];   // tables are usable only by the same layout
+    uint64_t    Offsets[ECT_MAX];       // from the beginning of the image
+    uint64_t    Counts[ECT_MAX];
+};
+
+//------------------------------------------------------------------------------
+
+static const char CatalogTableMagic[8] = {'I','S','R','T','A','B','0','2'};
+
+static const uint32_t CatalogTableRecordSizes[ECT_MAX] = {
+    sizeof(char),
+    sizeof(CCatalogBundle),
+    sizeof(CCatalogModule),
+    sizeof(CCatalogBuild),
+    sizeof(uint32_t),
+    sizeof(CCatalogCategory),
+    sizeof(uint32_t),
+    sizeof(CCatalogVersion),
+    sizeof(uint32_t),
+    sizeof(uint32_t),
+    sizeof(uint32_t),
+    sizeof(uint32_t)
+};
+
+//------------------------------------------------------------------------------
+
+static size_t AlignImage(size_t size)
+{
+    return((size + 7) & ~((size_t)7));
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+/// tables during building, they are stored into the image once complete
+
+class CCatalogTableData {
+public:
+    std::vector<char>               Pool;
+    std::vector<CCatalogBundle>     Bundles;
+    std::vector<CCatalogModule>     Modules;
+    std::vector<CCatalogBuild>      Builds;
+    std::vector<uint32_t>           ModuleCategories;
+    std::vector<CCatalogCategory>   Categories;
+    std::vector<uint32_t>           CategoryModules;
+    std::vector<CCatalogVersion>    Versions;
+    std::vector<uint32_t>           VersionBuilds;
+    std::vector<uint32_t>           ModuleHash;
+    std::vector<uint32_t>           BuildHash;
+    std::vector<uint32_t>           VersionHash;
+    std::unordered_map<std::string,uint32_t>    PoolIndex;
+
+    /// add string to the pool, equal strings are stored only once
+    uint32_t AddString(const char* p_str);
+
+    /// get string from the pool
+    const char* GetString(uint32_t offset) const;
+
+    /// build category lists, versions and hashes
+    void Finish(void);
+
+    /// order versions and their builds
+    void SortVersions(void);
+
+    /// build hashes of modules, builds and versions
+    void BuildHashes(void);
+};
+
+//------------------------------------------------------------------------------
+
+uint32_t CCatalogTableData::AddString(const char* p_str)
+{
+    std::unordered_map<std::string,uint32_t>::iterator it = PoolIndex.find(p_str);
+    if( it != PoolIndex.end() ) return(it->second);
+
+    uint32_t offset = Pool.size();
+    Pool.insert(Pool.end(),p_str,p_str + strlen(p_str) + 1);
+    PoolIndex.emplace(p_str,offset);
+    return(offset);
+}
+
+//------------------------------------------------------------------------------
+
+const char* CCatalogTableData::GetString(uint32_t offset) const
+{
+    return(&Pool[offset]);
+}
+
+//------------------------------------------------------------------------------
+
+void CCatalogTableData::Finish(void)
+{
+    // uncategorized modules are listed in sys
+    uint32_t sys = AddString("sys");
+
+    std::vector< std::pair<uint32_t,uint32_t> > pairs;  // category, module
+    for(uint32_t i=0; i < Modules.size(); i++){
+        const CCatalogModule& module = Modules[i];
+        if( module.NumOfCategories == 0 ) pairs.push_back(std::make_pair(sys,i));
+        for(uint32_t j=0; j < module.NumOfCategories; j++){
+            pairs.push_back(std::make_pair(ModuleCategories[module.FirstCategory + j],i));
+        }
+    }
+
+    std::sort(pairs.begin(),pairs.end(),
+              [this](const std::pair<uint32_t,uint32_t>& l,const std::pair<uint32_t,uint32_t>& r){
+        if( l.first != r.first ) return( strcmp(GetString(l.first),GetString(r.first)) < 0 );
+        return( strcmp(GetString(Modules[l.second].Name),GetString(Modules[r.second].Name)) < 0 );
+    });
+    pairs.erase(std::unique(pairs.begin(),pairs.end()),pairs.end());
+
+    CategoryModules.reserve(pairs.size());
+    for(const std::pair<uint32_t,uint32_t>& item : pairs){
+        if( Categories.empty() || (Categories.back().Name != item.first) ) {
+            CCatalogCategory category;
+            category.Name = item.first;
+            category.FirstModule = CategoryModules.size();
+            category.NumOfModules = 0;
+            category.Stamp = 0;
+            Categories.push_back(category);
+        }
+        CategoryModules.push_back(item.second);
+        Categories.back().NumOfModules++;
+    }
+
+    // stamps change only with listed names and versions, thus blocks of
+    // unchanged categories survive rebuilds of the catalog
+    for(CCatalogCategory& category : Categories){
+        for(uint32_t i=0; i < category.NumOfModules; i++){
+            const CCatalogModule& module = Modules[CategoryModules[category.FirstModule + i]];
+            category.Stamp = CombineString(category.Stamp,GetString(module.Name));
+            for(uint32_t j=0; j < module.NumOfBuilds; j++){
+                category.Stamp = CombineString(category.Stamp,GetString(Builds[module.FirstBuild + j].Version));
+            }
+        }
+    }
+
+    SortVersions();
+    BuildHashes();
+}
+
+//------------------------------------------------------------------------------
+
+void CCatalogTableData::SortVersions(void)
+{
+    std::unordered_map<uint32_t,std::vector<uint32_t> > builds;  // version, builds
+    std::list<CVerRecord>   records;
+
+    for(CCatalogModule& module : Modules){
+        // versions are interned, thus equal versions have equal offsets
+        builds.clear();
+        records.clear();
+        for(uint32_t j=0; j < module.NumOfBuilds; j++){
+            const CCatalogBuild& build = Builds[module.FirstBuild + j];
+            std::vector<uint32_t>& items = builds[build.Version];
+            if( items.empty() ) {
+                CVerRecord verrcd;
+                verrcd.version = GetString(build.Version);
+                verrcd.verindx = build.VerIndx;
+                records.push_back(verrcd);
+            }
+            items.push_back(module.FirstBuild + j);
+        }
+
+        // the same ordering as was used by the module page
+        records.sort(sort_tokens);
+
+        module.FirstVersion = Versions.size();
+        module.NumOfVersions = records.size();
+        for(const CVerRecord& verrcd : records){
+            CCatalogVersion version;
+            version.Version = AddString(verrcd.version);
+            version.FirstBuild = VersionBuilds.size();
+            version.NumOfBuilds = 0;
+
+            std::vector<uint32_t>& items = builds[version.Version];
+            std::stable_sort(items.begin(),items.end(),[this](uint32_t l,uint32_t r){
+                int result = strcmp(GetString(Builds[l].Arch),GetString(Builds[r].Arch));
+                if( result != 0 ) return( result < 0 );
+                return( strcmp(GetString(Builds[l].Mode),GetString(Builds[r].Mode)) < 0 );
+            });
+            for(uint32_t build : items){
+                VersionBuilds.push_back(build);
+                version.NumOfBuilds++;
+            }
+            Versions.push_back(version);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CCatalogTableData::BuildHashes(void)
+{
+    // module names are unique
+    ModuleHash.assign(GetHashSize(Modules.size()),0);
+    for(uint32_t i=0; i < Modules.size(); i++){
+        InsertSlot(ModuleHash,HashKey(GetString(Modules[i].Name)),i);
+    }
+
+    // the first of equal builds wins as in CModCache::GetBuild
+    BuildHash.assign(GetHashSize(Builds.size()),0);
+    for(uint32_t i=0; i < Builds.size(); i++){
+        const CCatalogBuild& build = Builds[i];
+        uint64_t hash = HashKey(GetString(Modules[build.Module].Name),GetString(build.Version),
+                                GetString(build.Arch),GetString(build.Mode));
+        uint32_t found;
+        bool     exists = FindSlot(BuildHash.data(),BuildHash.size(),hash,[&](uint32_t index){
+            const CCatalogBuild& item = Builds[index];
+            return( (item.Module == build.Module) && (item.Version == build.Version)
+                    && (item.Arch == build.Arch) && (item.Mode == build.Mode) );
+        },found);
+        if( exists == false ) InsertSlot(BuildHash,hash,i);
+    }
+
+    // versions of module are unique
+    VersionHash.assign(GetHashSize(Versions.size()),0);
+    for(uint32_t i=0; i < Modules.size(); i++){
+        const CCatalogModule& module = Modules[i];
+        for(uint32_t j=0; j < module.NumOfVersions; j++){
+            uint32_t version = module.FirstVersion + j;
+            InsertSlot(VersionHash,HashKey(GetString(module.Name),GetString(Versions[version].Version)),version);
+        }
+    }
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+/// fills the catalog tables from parser events and keeps texts of module records
+
+class CCatalogTableBuilder : public CXMLStreamHandler {
+public:
+    CCatalogTableBuilder(CCatalogTableData& data,CCatalogRecordTexts& texts);
+
+    /// load bundle config and its big cache
+    bool LoadBundle(const CFileName& bundle_dir);
+
+    virtual bool StartElement(const char* p_name,size_t len,
+                              const CXMLStreamAttr* p_attrs,size_t nattrs);
+    virtual bool EndElement(const char* p_name,size_t len);
+
+private:
+    enum EElement {
+        EE_OTHER,
+        EE_SKIP,        // inside of ignored module
+        EE_CACHE,
+        EE_MODULE,
+        EE_CATEGORIES,
+        EE_BUILDS,
+        EE_BUILD
+    };
+
+    CCatalogTableData&              Data;
+    CCatalogRecordTexts&            Texts;
+    CXMLStreamParser                Parser;
+    uint32_t                        Bundle;
+    std::vector<EElement>           Path;
+    CCatalogModule                  Module;
+    size_t                          ModuleOffset;   // start of module record
+    std::unordered_set<uint32_t>    Names;          // loaded modules
+};
+
+//------------------------------------------------------------------------------
+
+CCatalogTableBuilder::CCatalogTableBuilder(CCatalogTableData& data,CCatalogRecordTexts& texts)
+    : Data(data), Texts(texts)
+{
+    Bundle = 0;
+    ModuleOffset = 0;
+    memset(&Module,0,sizeof(Module));
+    Parser.SetHandler(this);
+}
+
+//------------------------------------------------------------------------------
+
+bool CCatalogTableBuilder::LoadBundle(const CFileName& bundle_dir)
+{
+    CCatalogBundle bundle;
+    bundle.Name = Data.AddString(bundle_dir.GetFileNameExt());
+    bundle.Maintainer = Data.AddString("");
+    bundle.Contact = Data.AddString("");
+    Bundle = Data.Bundles.size();
+    Data.Bundles.push_back(bundle);
+
+    const char* files[2] = { BUNDLE_CONFIG, BUNDLE_CACHE_BIG };
+    for(int i=0; i < 2; i++){
+        Path.clear();
+        if( Parser.ParseFile(bundle_dir / BUNDLE_DIR / files[i]) == false ) return(false);
+    }
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CCatalogTableBuilder::StartElement(const char* p_name,size_t len,
+                                        const CXMLStreamAttr* p_attrs,size_t nattrs)
+{
+    EElement parent = Path.empty() ? EE_OTHER : Path.back();
+    EElement element = EE_OTHER;
+
+    if( Path.empty() ) {
+        if( CXMLStreamParser::IsName(p_name,len,"bundle") ) {
+            CCatalogBundle& bundle = Data.Bundles[Bundle];
+            const char* p_value;
+            if( (p_value = CXMLStreamParser::GetAttribute(p_attrs,nattrs,"name")) != NULL ) {
+                bundle.Name = Data.AddString(p_value);
+            }
+            if( (p_value = CXMLStreamParser::GetAttribute(p_attrs,nattrs,"maintainer")) != NULL ) {
+                bundle.Maintainer = Data.AddString(p_value);
+            }
+            if( (p_value = CXMLStreamParser::GetAttribute(p_attrs,nattrs,"contact")) != NULL ) {
+                bundle.Contact = Data.AddString(p_value);
+            }
+        } else if( CXMLStreamParser::IsName(p_name,len,"cache") ) {
+            element = EE_CACHE;
+        }
+    } else {
+        switch(parent){
+            case EE_SKIP:
+                element = EE_SKIP;
+                break;
+            case EE_CACHE:
+                if( CXMLStreamParser::IsName(p_name,len,"module") ) {
+                    const char* p_value = CXMLStreamParser::GetAttribute(p_attrs,nattrs,"name");
+                    uint32_t name = Data.AddString(p_value ? p_value : "");
+                    if( Names.insert(name).second == false ) {
+                        // the first bundle providing the module wins
+                        element = EE_SKIP;
+                        break;
+                    }
+                    element = EE_MODULE;
+                    ModuleOffset = Parser.GetElementOffset();
+                    Module.Name = name;
+                    Module.Bundle = Bundle;
+                    Module.FirstCategory = Data.ModuleCategories.size();
+                    Module.NumOfCategories = 0;
+                    Module.FirstBuild = Data.Builds.size();
+                    Module.NumOfBuilds = 0;
+                    Module.FirstVersion = 0;
+                    Module.NumOfVersions = 0;
+                    Module.HasACL = false;
+                }
+                break;
+            case EE_MODULE:
+                if( CXMLStreamParser::IsName(p_name,len,"categories") ) {
+                    element = EE_CATEGORIES;
+                } else if( CXMLStreamParser::IsName(p_name,len,"builds") ) {
+                    element = EE_BUILDS;
+                } else if( CXMLStreamParser::IsName(p_name,len,"acl") ) {
+                    Module.HasACL = true;
+                }
+                break;
+            case EE_CATEGORIES:
+                if( CXMLStreamParser::IsName(p_name,len,"category") ) {
+                    const char* p_value = CXMLStreamParser::GetAttribute(p_attrs,nattrs,"name");
+                    if( p_value != NULL ) {
+                        Data.ModuleCategories.push_back(Data.AddString(p_value));
+                        Module.NumOfCategories++;
+                    }
+                }
+                break;
+            case EE_BUILDS:
+                if( CXMLStreamParser::IsName(p_name,len,"build") ) {
+                    element = EE_BUILD;
+                    const char* p_ver = CXMLStreamParser::GetAttribute(p_attrs,nattrs,"ver");
+                    const char* p_arch = CXMLStreamParser::GetAttribute(p_attrs,nattrs,"arch");
+                    const char* p_mode = CXMLStreamParser::GetAttribute(p_attrs,nattrs,"mode");
+                    const char* p_verindx = CXMLStreamParser::GetAttribute(p_attrs,nattrs,"verindx");
+                    CCatalogBuild build;
+                    build.Module = Data.Modules.size();
+                    build.Version = Data.AddString(p_ver ? p_ver : "");
+                    build.Arch = Data.AddString(p_arch ? p_arch : "");
+                    build.Mode = Data.AddString(p_mode ? p_mode : "");
+                    build.VerIndx = p_verindx ? atof(p_verindx) : 0.0;
+                    build.HasACL = false;
+                    Data.Builds.push_back(build);
+                    Module.NumOfBuilds++;
+                }
+                break;
+            case EE_BUILD:
+                if( CXMLStreamParser::IsName(p_name,len,"acl") ) {
+                    Data.Builds.back().HasACL = true;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    Path.push_back(element);
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CCatalogTableBuilder::EndElement(const char* p_name,size_t len)
+{
+    if( Path.empty() ) return(false);
+    if( Path.back() == EE_MODULE ) {
+        // the record is copied as it is, it is parsed only when it is used
+        Data.Modules.push_back(Module);
+        Texts.AddRecord(Parser.GetData() + ModuleOffset,Parser.GetOffset() - ModuleOffset);
+    }
+    Path.pop_back();
+    return(true);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CCatalogTable::CCatalogTable(void)
+{
+    Image = NULL;
+    ImageSize = 0;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CCatalogTable::Load(const CSmallString& names,const CFileName& path,CCatalogRecordTexts& texts)
+{
+    CCatalogTableData       data;
+    CCatalogTableBuilder    builder(data,texts);
+
+    texts.Clear();
+
+    std::vector<std::string> dirs;
+    std::string item;
+    for(const char* p = path; (p != NULL) && (*p != '\0'); p++){
+        if( *p == ':' ){
+            if( ! item.empty() ) dirs.push_back(item);
+            item.clear();
+        } else {
+            item += *p;
+        }
+    }
+    if( ! item.empty() ) dirs.push_back(item);
+
+    item.clear();
+    for(const char* p = names; ; p++){
+        if( (p != NULL) && (*p != '\0') && (*p != ',') ){
+            item += *p;
+            continue;
+        }
+        if( ! item.empty() ) {
+            // the first directory containing the bundle is used
+            bool found = false;
+            for(const std::string& dir : dirs){
+                CFileName bundle_dir = CFileName(dir.c_str()) / CSmallString(item.c_str());
+                if( access(bundle_dir / BUNDLE_DIR / BUNDLE_CACHE_BIG,R_OK) != 0 ) continue;
+                if( builder.LoadBundle(bundle_dir) == false ) {
+                    CSmallString error;
+                    error << "unable to load bundle '" << bundle_dir << "'";
+                    ES_ERROR(error);
+                    return(false);
+                }
+                found = true;
+                break;
+            }
+            if( found == false ) {
+                CSmallString error;
+                error << "cache of bundle '" << item.c_str() << "' was not found";
+                ES_ERROR(error);
+                return(false);
+            }
+        }
+        item.clear();
+        if( (p == NULL) || (*p == '\0') ) break;
+    }
+
+    data.Finish();
+    Store(data);
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+void CCatalogTable::Store(const CCatalogTableData& data)
+{
+    const void* p_tables[ECT_MAX] = {
+        data.Pool.data(), data.Bundles.data(), data.Modules.data(), data.Builds.data(),
+        data.ModuleCategories.data(), data.Categories.data(), data.CategoryModules.data(),
+        data.Versions.data(), data.VersionBuilds.data(),
+        data.ModuleHash.data(), data.BuildHash.data(), data.VersionHash.data()
+    };
+    size_t counts[ECT_MAX] = {
+        data.Pool.size(), data.Bundles.size(), data.Modules.size(), data.Builds.size(),
+        data.ModuleCategories.size(), data.Categories.size(), data.CategoryModules.size(),
+        data.Versions.size(), data.VersionBuilds.size(),
+        data.ModuleHash.size(), data.BuildHash.size(), data.VersionHash.size()
+    };
+
+    CCatalogTableImage header;
+    memset(&header,0,sizeof(header));
+    memcpy(header.Magic,CatalogTableMagic,sizeof(header.Magic));
+    size_t size = AlignImage(sizeof(CCatalogTableImage));
+    for(int i=0; i < ECT_MAX; i++){
+        header.RecordSizes[i] = CatalogTableRecordSizes[i];
+        header.Offsets[i] = size;
+        header.Counts[i] = counts[i];
+        size = AlignImage(size + counts[i]*CatalogTableRecordSizes[i]);
+    }
+
+    std::vector<uint64_t>(size / sizeof(uint64_t),0).swap(Storage);
+    char* p_image = reinterpret_cast<char*>(Storage.data());
+    memcpy(p_image,&header,sizeof(header));
+    for(int i=0; i < ECT_MAX; i++){
+        if( counts[i] == 0 ) continue;
+        memcpy(p_image + header.Offsets[i],p_tables[i],counts[i]*CatalogTableRecordSizes[i]);
+    }
+
+    Attach(p_image,size);
+}
+
+//------------------------------------------------------------------------------
+
+bool CCatalogTable::Attach(const void* p_image,size_t size)
+{
+    Image = NULL;
+    ImageSize = 0;
+    Pool = CTableView<char>();
+    Bundles = CTableView<CCatalogBundle>();
+    Modules = CTableView<CCatalogModule>();
+    Builds = CTableView<CCatalogBuild>();
+    ModuleCategories = CTableView<uint32_t>();
+    Categories = CTableView<CCatalogCategory>();
+    CategoryModules = CTableView<uint32_t>();
+    Versions = CTableView<CCatalogVersion>();
+    VersionBuilds = CTableView<uint32_t>();
+    ModuleHash = CTableView<uint32_t>();
+    BuildHash = CTableView<uint32_t>();
+    VersionHash = CTableView<uint32_t>();
+
+    const char* p_data = static_cast<const char*>(p_image);
+    if( (p_data == NULL) || (size < sizeof(CCatalogTableImage)) || ((uintptr_t)p_data % 8 != 0) ) {
+        ES_ERROR("catalog table image is too small or not aligned");
+        return(false);
+    }
+
+    const CCatalogTableImage* p_header = reinterpret_cast<const CCatalogTableImage*>(p_data);
+    if( memcmp(p_header->Magic,CatalogTableMagic,sizeof(p_header->Magic)) != 0 ) {
+        ES_ERROR("catalog table image has wrong magic");
+        return(false);
+    }
+    for(int i=0; i < ECT_MAX; i++){
+        if( (p_header->RecordSizes[i] != CatalogTableRecordSizes[i])
+            || (p_header->Offsets[i] % 8 != 0) || (p_header->Offsets[i] > size)
+            || (p_header->Counts[i] > (size - p_header->Offsets[i]) / CatalogTableRecordSizes[i]) ) {
+            ES_ERROR("catalog table image has incompatible layout");
+            return(false);
+        }
+    }
+
+    // the pool must end with a terminator
+    uint64_t pool_size = p_header->Counts[ECT_POOL];
+    if( (pool_size == 0) || (p_data[p_header->Offsets[ECT_POOL] + pool_size - 1] != '\0') ) {
+        ES_ERROR("catalog table image has corrupted string pool");
+        return(false);
+    }
+
+    CTableView<CCatalogModule>   modules(reinterpret_cast<const CCatalogModule*>(p_data + p_header->Offsets[ECT_MODULES]),
+                                         p_header->Counts[ECT_MODULES]);
+    CTableView<CCatalogCategory> categories(reinterpret_cast<const CCatalogCategory*>(p_data + p_header->Offsets[ECT_CATEGORIES]),
+                                            p_header->Counts[ECT_CATEGORIES]);
+    CTableView<uint32_t>         members(reinterpret_cast<const uint32_t*>(p_data + p_header->Offsets[ECT_CATEGORY_MODULES]),
+                                         p_header->Counts[ECT_CATEGORY_MODULES]);
+    CTableView<CCatalogVersion>  versions(reinterpret_cast<const CCatalogVersion*>(p_data + p_header->Offsets[ECT_VERSIONS]),
+                                          p_header->Counts[ECT_VERSIONS]);
+    CTableView<uint32_t>         version_builds(reinterpret_cast<const uint32_t*>(p_data + p_header->Offsets[ECT_VERSION_BUILDS]),
+                                                p_header->Counts[ECT_VERSION_BUILDS]);
+
+    // ranges are used without further checks by queries
+    bool valid = true;
+    for(const CCatalogModule& module : modules){
+        valid &= (module.Name < pool_size) && (module.Bundle < p_header->Counts[ECT_BUNDLES])
+                 && ((uint64_t)module.FirstCategory + module.NumOfCategories <= p_header->Counts[ECT_MODULE_CATEGORIES])
+                 && ((uint64_t)module.FirstBuild + module.NumOfBuilds <= p_header->Counts[ECT_BUILDS])
+                 && ((uint64_t)module.FirstVersion + module.NumOfVersions <= versions.size());
+    }
+    CTableView<CCatalogBuild>    builds(reinterpret_cast<const CCatalogBuild*>(p_data + p_header->Offsets[ECT_BUILDS]),
+                                        p_header->Counts[ECT_BUILDS]);
+    for(const CCatalogBuild& build : builds){
+        valid &= (build.Module < modules.size()) && (build.Version < pool_size)
+                 && (build.Arch < pool_size) && (build.Mode < pool_size);
+    }
+    for(const CCatalogCategory& category : categories){
+        valid &= (category.Name < pool_size)
+                 && ((uint64_t)category.FirstModule + category.NumOfModules <= members.size());
+    }
+    for(uint32_t index : members) valid &= index < modules.size();
+    for(const CCatalogVersion& version : versions){
+        valid &= (version.Version < pool_size)
+                 && ((uint64_t)version.FirstBuild + version.NumOfBuilds <= version_builds.size());
+    }
+    for(uint32_t index : version_builds) valid &= index < builds.size();
+    valid &= IsValidHash(reinterpret_cast<const uint32_t*>(p_data + p_header->Offsets[ECT_MODULE_HASH]),
+                         p_header->Counts[ECT_MODULE_HASH],modules.size());
+    valid &= IsValidHash(reinterpret_cast<const uint32_t*>(p_data + p_header->Offsets[ECT_BUILD_HASH]),
+                         p_header->Counts[ECT_BUILD_HASH],builds.size());
+    valid &= IsValidHash(reinterpret_cast<const uint32_t*>(p_data + p_header->Offsets[ECT_VERSION_HASH]),
+                         p_header->Counts[ECT_VERSION_HASH],versions.size());
+    if( valid == false ) {
+        ES_ERROR("catalog table image has corrupted tables");
+        return(false);
+    }
+
+    Image = p_data;
+    ImageSize = size;
+    Pool = CTableView<char>(p_data + p_header->Offsets[ECT_POOL],pool_size);
+    Bundles = CTableView<CCatalogBundle>(reinterpret_cast<const CCatalogBundle*>(p_data + p_header->Offsets[ECT_BUNDLES]),
+                                         p_header->Counts[ECT_BUNDLES]);
+    Modules = modules;
+    Builds = builds;
+    ModuleCategories = CTableView<uint32_t>(reinterpret_cast<const uint32_t*>(p_data + p_header->Offsets[ECT_MODULE_CATEGORIES]),
+                                            p_header->Counts[ECT_MODULE_CATEGORIES]);
+    Categories = categories;
+    CategoryModules = members;
+    Versions = versions;
+    VersionBuilds = version_builds;
+    ModuleHash = CTableView<uint32_t>(reinterpret_cast<const uint32_t*>(p_data + p_header->Offsets[ECT_MODULE_HASH]),
+                                      p_header->Counts[ECT_MODULE_HASH]);
+    BuildHash = CTableView<uint32_t>(reinterpret_cast<const uint32_t*>(p_data + p_header->Offsets[ECT_BUILD_HASH]),
+                                     p_header->Counts[ECT_BUILD_HASH]);
+    VersionHash = CTableView<uint32_t>(reinterpret_cast<const uint32_t*>(p_data + p_header->Offsets[ECT_VERSION_HASH]),
+                                       p_header->Counts[ECT_VERSION_HASH]);
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+const void* CCatalogTable::GetImage(void) const
+{
+    return(Image);
+}
+
+//------------------------------------------------------------------------------
+
+size_t CCatalogTable::GetImageSize(void) const
+{
+    return(ImageSize);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CCatalogTable::GetCategories(std::list<CSmallString>& cats) const
+{
+    for(const CCatalogCategory& category : Categories){
+        const char* p_name = GetString(category.Name);
+        if( strcmp(p_name,"sys") == 0 ) continue;
+        cats.push_back(p_name);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CCatalogTable::GetModules(const CSmallString& cat,std::list<CSmallString>& mods,bool include_vers,
+                               const CCatalogBitmap* p_builds) const
+{
+    const CCatalogCategory* p_category = FindCategory(cat);
+    if( p_category == NULL ) return;
+
+    std::vector<uint32_t> versions;
+    for(uint32_t i=0; i < p_category->NumOfModules; i++){
+        const CCatalogModule& module = Modules[CategoryModules[p_category->FirstModule + i]];
+        // builds of module are stored in one range
+        if( p_builds && (p_builds->TestRange(module.FirstBuild,module.NumOfBuilds) == false) ) continue;
+        if( include_vers == false ) {
+            mods.push_back(GetString(module.Name));
+            continue;
+        }
+        // versions are interned, thus equal versions have equal offsets
+        versions.clear();
+        for(uint32_t j=0; j < module.NumOfBuilds; j++){
+            if( p_builds && (p_builds->Test(module.FirstBuild + j) == false) ) continue;
+            uint32_t ver = Builds[module.FirstBuild + j].Version;
+            if( std::find(versions.begin(),versions.end(),ver) != versions.end() ) continue;
+            versions.push_back(ver);
+            CSmallString name(GetString(module.Name));
+            name << ":" << GetString(ver);
+            mods.push_back(name);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+const CCatalogCategory* CCatalogTable::FindCategory(const char* p_name) const
+{
+    if( p_name == NULL ) return(NULL);
+    const CCatalogCategory* it =
+            std::lower_bound(Categories.begin(),Categories.end(),p_name,
+                             [this](const CCatalogCategory& l,const char* p_r){
+        return( strcmp(GetString(l.Name),p_r) < 0 );
+    });
+    if( (it == Categories.end()) || (strcmp(GetString(it->Name),p_name) != 0) ) return(NULL);
+    return(&(*it));
+}
+
+//------------------------------------------------------------------------------
+
+bool CCatalogTable::FindModule(const char* p_name,uint32_t& module) const
+{
+    if( p_name == NULL ) return(false);
+    return(FindSlot(ModuleHash.begin(),ModuleHash.size(),HashKey(p_name),[&](uint32_t index){
+        return( strcmp(GetString(Modules[index].Name),p_name) == 0 );
+    },module));
+}
+
+//------------------------------------------------------------------------------
+
+bool CCatalogTable::FindBuild(uint32_t module,const char* p_ver,const char* p_arch,const char* p_mode,
+                              uint32_t& build) const
+{
+    if( (module >= Modules.size()) || (p_ver == NULL) || (p_arch == NULL) || (p_mode == NULL) ) return(false);
+    uint64_t hash = HashKey(GetString(Modules[module].Name),p_ver,p_arch,p_mode);
+    return(FindSlot(BuildHash.begin(),BuildHash.size(),hash,[&](uint32_t index){
+        const CCatalogBuild& item = Builds[index];
+        return( (item.Module == module) && (strcmp(GetString(item.Version),p_ver) == 0)
+                && (strcmp(GetString(item.Arch),p_arch) == 0) && (strcmp(GetString(item.Mode),p_mode) == 0) );
+    },build));
+}
+
+//------------------------------------------------------------------------------
+
+CTableView<uint32_t> CCatalogTable::GetVersionBuilds(uint32_t module,const char* p_ver) const
+{
+    if( (module >= Modules.size()) || (p_ver == NULL) ) return(CTableView<uint32_t>());
+    const CCatalogModule& record = Modules[module];
+
+    uint32_t version;
+    bool     found = FindSlot(VersionHash.begin(),VersionHash.size(),HashKey(GetString(record.Name),p_ver),
+                              [&](uint32_t index){
+        return( (index >= record.FirstVersion) && (index < record.FirstVersion + record.NumOfVersions)
+                && (strcmp(GetString(Versions[index].Version),p_ver) == 0) );
+    },version);
+    if( found == false ) return(CTableView<uint32_t>());
+
+    const CCatalogVersion& item = Versions[version];
+    return(CTableView<uint32_t>(VersionBuilds.begin() + item.FirstBuild,item.NumOfBuilds));
+}
+
+//------------------------------------------------------------------------------
+
+void CCatalogTable::GetModuleVersions(uint32_t module,std::vector<CSmallString>& versions) const
+{
+    versions.clear();
+    if( module >= Modules.size() ) return;
+
+    // versions are ordered when the tables are built
+    const CCatalogModule& record = Modules[module];
+    versions.reserve(record.NumOfVersions);
+    for(uint32_t j=0; j < record.NumOfVersions; j++){
+        versions.push_back(GetString(Versions[record.FirstVersion + j].Version));
+    }
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+const char* CCatalogTable::GetString(uint32_t offset) const
+{
+    return(&Pool[offset]);
+}
+
+//------------------------------------------------------------------------------
+
+CTableView<CCatalogBundle> CCatalogTable::GetBundleTable(void) const
+{
+    return(Bundles);
+}
+
+//------------------------------------------------------------------------------
+
+CTableView<CCatalogModule> CCatalogTable::GetModuleTable(void) const
+{
+    return(Modules);
+}
+
+//------------------------------------------------------------------------------
+
+CTableView<CCatalogBuild> CCatalogTable::GetBuildTable(void) const
+{
+    return(Builds);
+}
+
+//------------------------------------------------------------------------------
+
+CTableView<CCatalogCategory> CCatalogTable::GetCategoryTable(void) const
+{
+    return(Categories);
+}
+
+//------------------------------------------------------------------------------
+
+CTableView<uint32_t> CCatalogTable::GetCategoryModuleTable(void) const
+{
+    return(CategoryModules);
+}
+
+//------------------------------------------------------------------------------
+
+size_t CCatalogTable::GetSize(void) const
+{
+    return(Storage.capacity() * sizeof(uint64_t));
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CCatalogRecordTexts::AddRecord(const char* p_text,size_t length)
+{
+    Texts.append(p_text,length);
+    Ends.push_back(Texts.size());
+}
+
+//------------------------------------------------------------------------------
+
+void CCatalogRecordTexts::Clear(void)
+{
+    Texts.clear();
+    Ends.clear();
+}
+
+//------------------------------------------------------------------------------
+
+bool CCatalogRecordTexts::GetRecord(uint32_t index,const char*& p_text,size_t& length) const
+{
+    if( index >= Ends.size() ) return(false);
+    uint64_t begin = index > 0 ? Ends[index-1] : 0;
+    p_text = Texts.data() + begin;
+    length = Ends[index] - begin;
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+size_t CCatalogRecordTexts::GetNumOfRecords(void) const
+{
+    return(Ends.size());
+}
+
+//------------------------------------------------------------------------------
+
+size_t CCatalogRecordTexts::GetSize(void) const
+{
+    return(Texts.size() + Ends.size()*sizeof(uint64_t));
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
@@ -0,0 +1,248 @@
+#ifndef CatalogTableH
+#define CatalogTableH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <SmallString.hpp>
+#include <FileName.hpp>
+#include <list>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+
+class CCatalogBitmap;
+class CCatalogTableData;
+
+//------------------------------------------------------------------------------
+
+/// read-only view of a table stored in the table image
+
+template<class T>
+class CTableView {
+public:
+    CTableView(void) : Data(NULL), Size(0) {}
+    CTableView(const T* p_data,size_t size) : Data(p_data), Size(size) {}
+
+    const T&    operator [] (size_t index) const { return(Data[index]); }
+    const T*    begin(void) const { return(Data); }
+    const T*    end(void) const { return(Data + Size); }
+    size_t      size(void) const { return(Size); }
+    bool        empty(void) const { return(Size == 0); }
+
+private:
+    const T*    Data;
+    size_t      Size;
+};
+
+//------------------------------------------------------------------------------
+
+/// bundle record, strings are offsets into the string pool
+
+class CCatalogBundle {
+public:
+    uint32_t    Name;
+    uint32_t    Maintainer;
+    uint32_t    Contact;
+};
+
+//------------------------------------------------------------------------------
+
+/// module record, categories, builds and versions are ranges in the shared tables
+
+class CCatalogModule {
+public:
+    uint32_t    Name;
+    uint32_t    Bundle;             // index into bundles
+    uint32_t    FirstCategory;
+    uint32_t    NumOfCategories;
+    uint32_t    FirstBuild;
+    uint32_t    NumOfBuilds;
+    uint32_t    FirstVersion;
+    uint32_t    NumOfVersions;
+    bool        HasACL;
+};
+
+//------------------------------------------------------------------------------
+
+/// build record
+
+class CCatalogBuild {
+public:
+    uint32_t    Module;             // index into modules
+    uint32_t    Version;
+    uint32_t    Arch;
+    uint32_t    Mode;
+    double      VerIndx;
+    bool        HasACL;
+};
+
+//------------------------------------------------------------------------------
+
+/// version of module, its builds are a range of sorted build indexes
+
+class CCatalogVersion {
+public:
+    uint32_t    Version;
+    uint32_t    FirstBuild;         // index into version builds
+    uint32_t    NumOfBuilds;
+};
+
+//------------------------------------------------------------------------------
+
+/// category with sorted list of its modules
+
+class CCatalogCategory {
+public:
+    uint32_t    Name;
+    uint32_t    FirstModule;
+    uint32_t    NumOfModules;
+    uint64_t    Stamp;              // hash of names and versions of modules
+};
+
+//------------------------------------------------------------------------------
+
+/// texts of module records in the order of the module table, they are
+/// copied from the bundle caches as they are
+
+class CCatalogRecordTexts {
+public:
+// main methods ----------------------------------------------------------------
+    /// add text of the next record
+    void AddRecord(const char* p_text,size_t length);
+
+    /// remove all records
+    void Clear(void);
+
+// information methods ---------------------------------------------------------
+    /// get text of record
+    bool GetRecord(uint32_t index,const char*& p_text,size_t& length) const;
+
+    /// get number of records
+    size_t GetNumOfRecords(void) const;
+
+    /// get size of all texts
+    size_t GetSize(void) const;
+
+// section of private data -----------------------------------------------------
+private:
+    std::string             Texts;
+    std::vector<uint64_t>   Ends;       // end offsets of records in Texts
+};
+
+//------------------------------------------------------------------------------
+
+/// compact catalog tables loaded from bundle caches by a streaming parser
+/// modules and builds are stored in the order of the caches, the first
+/// bundle providing a module wins, thus the j-th build element of a module
+/// record is the build FirstBuild+j, the tables are immutable once built
+/// versions of each module are ordered the newest first and builds of each
+/// version by arch and mode, modules, versions and builds are found by open
+/// addressing hashes of their full names, thus lookups do not depend on
+/// the size of the catalog
+/// all tables are stored in one position independent image, which is either
+/// owned by the table or attached from shared memory
+
+class CCatalogTable {
+public:
+    CCatalogTable(void);
+
+// main methods ----------------------------------------------------------------
+    /// load tables from big caches of bundles in one pass, names are separated
+    /// by ',' and paths by ':', texts receive module records in the order
+    /// of the module table
+    bool Load(const CSmallString& names,const CFileName& path,CCatalogRecordTexts& texts);
+
+    /// attach image of tables, the image must outlive the table
+    bool Attach(const void* p_image,size_t size);
+
+    /// get image of tables
+    const void* GetImage(void) const;
+
+    /// get size of the image
+    size_t GetImageSize(void) const;
+
+// queries compatible with CModCache -------------------------------------------
+    /// get names of all categories except sys
+    void GetCategories(std::list<CSmallString>& cats) const;
+
+    /// get modules of category, sys includes uncategorized modules
+    /// only modules (versions) having builds in p_builds are listed if it is provided
+    void GetModules(const CSmallString& cat,std::list<CSmallString>& mods,bool include_vers,
+                    const CCatalogBitmap* p_builds = NULL) const;
+
+    /// find category by its name, sys includes uncategorized modules
+    const CCatalogCategory* FindCategory(const char* p_name) const;
+
+    /// find module by its name
+    bool FindModule(const char* p_name,uint32_t& module) const;
+
+    /// find build of module
+    bool FindBuild(uint32_t module,const char* p_ver,const char* p_arch,const char* p_mode,
+                   uint32_t& build) const;
+
+    /// get builds of module version ordered by arch and mode, empty if not found
+    CTableView<uint32_t> GetVersionBuilds(uint32_t module,const char* p_ver) const;
+
+    /// get versions of module, the newest first
+    void GetModuleVersions(uint32_t module,std::vector<CSmallString>& versions) const;
+
+// information methods ---------------------------------------------------------
+    /// get string from the pool
+    const char* GetString(uint32_t offset) const;
+
+    /// get tables
+    CTableView<CCatalogBundle>      GetBundleTable(void) const;
+    CTableView<CCatalogModule>      GetModuleTable(void) const;
+    CTableView<CCatalogBuild>       GetBuildTable(void) const;
+    CTableView<CCatalogCategory>    GetCategoryTable(void) const;
+    CTableView<uint32_t>            GetCategoryModuleTable(void) const;
+
+    /// get number of bytes owned by the table, attached image is not included
+    size_t GetSize(void) const;
+
+// section of private data -----------------------------------------------------
+private:
+    /// store complete tables into the own image
+    void Store(const CCatalogTableData& data);
+
+    std::vector<uint64_t>           Storage;            // own image, aligned
+    const char*                     Image;
+    size_t                          ImageSize;
+    CTableView<char>                Pool;               // zero terminated strings
+    CTableView<CCatalogBundle>      Bundles;
+    CTableView<CCatalogModule>      Modules;
+    CTableView<CCatalogBuild>       Builds;
+    CTableView<uint32_t>            ModuleCategories;   // category names
+    CTableView<CCatalogCategory>    Categories;
+    CTableView<uint32_t>            CategoryModules;    // module indexes
+    CTableView<CCatalogVersion>     Versions;
+    CTableView<uint32_t>            VersionBuilds;      // build indexes
+    CTableView<uint32_t>            ModuleHash;         // module index + 1, zero - empty slot
+    CTableView<uint32_t>            BuildHash;          // build index + 1
+    CTableView<uint32_t>            VersionHash;        // version index + 1
+};
+
+//------------------------------------------------------------------------------
+
+#endif
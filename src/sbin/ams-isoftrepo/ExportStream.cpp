@@ -0,0 +1,164 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "ExportStream.hpp"
+#include <ErrorSystem.hpp>
+#include <string.h>
+#include <stdio.h>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CExportStream::CExportStream(CResponseWriter& response)
+    : Response(response)
+{
+    Opened = false;
+    GZip = false;
+    memset(&ZStream,0,sizeof(ZStream));
+}
+
+//------------------------------------------------------------------------------
+
+CExportStream::~CExportStream(void)
+{
+    if( Opened && GZip ) deflateEnd(&ZStream);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CExportStream::Open(bool gzip)
+{
+    GZip = gzip;
+
+    if( GZip ) {
+        // 15+16 - gzip wrapper instead of raw zlib stream
+        if( deflateInit2(&ZStream,Z_DEFAULT_COMPRESSION,Z_DEFLATED,15+16,8,Z_DEFAULT_STRATEGY) != Z_OK ) {
+            ES_ERROR("unable to initialize gzip stream");
+            return(false);
+        }
+    }
+    Opened = true;
+
+    Response.Write("Content-type: application/x-ndjson\r\n");
+    if( GZip ) {
+        Response.Write("Content-Encoding: gzip\r\n");
+    }
+    Response.Write("\r\n");
+
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CExportStream::WriteRecord(const std::string& record)
+{
+    if( GZip ) {
+        if( Deflate(record.c_str(),record.size(),Z_NO_FLUSH) == false ) return(false);
+        return( Deflate("\n",1,Z_NO_FLUSH) );
+    }
+
+    Response.Write(record.c_str(),record.size());
+    Response.Write("\n",1);
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CExportStream::Close(void)
+{
+    if( GZip ) {
+        return( Deflate(NULL,0,Z_FINISH) );
+    }
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CExportStream::Deflate(const char* p_data,unsigned int len,int flush)
+{
+    ZStream.next_in = (Bytef*)p_data;
+    ZStream.avail_in = len;
+
+    do {
+        ZStream.next_out = ZBuffer;
+        ZStream.avail_out = sizeof(ZBuffer);
+        int ret = deflate(&ZStream,flush);
+        if( ret == Z_STREAM_ERROR ) {
+            ES_ERROR("unable to compress data");
+            return(false);
+        }
+        unsigned int have = sizeof(ZBuffer) - ZStream.avail_out;
+        if( have > 0 ) {
+            Response.Write((const char*)ZBuffer,have);
+        }
+    } while( ZStream.avail_out == 0 );
+
+    return(true);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CExportStream::AppendString(std::string& record,const char* p_str)
+{
+    record += '"';
+    if( p_str != NULL ) {
+        for(const char* p = p_str; *p != '\0'; p++) {
+            unsigned char c = *p;
+            switch(c) {
+                case '"':
+                    record += "\\\"";
+                    break;
+                case '\\':
+                    record += "\\\\";
+                    break;
+                case '\n':
+                    record += "\\n";
+                    break;
+                case '\r':
+                    record += "\\r";
+                    break;
+                case '\t':
+                    record += "\\t";
+                    break;
+                default:
+                    if( c < 0x20 ) {
+                        char buffer[8];
+                        snprintf(buffer,sizeof(buffer),"\\u%04x",c);
+                        record += buffer;
+                    } else {
+                        record += c;
+                    }
+                    break;
+            }
+        }
+    }
+    record += '"';
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
@@ -0,0 +1,68 @@
+#ifndef ExportStreamH
+#define ExportStreamH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "ResponseWriter.hpp"
+#include <SmallString.hpp>
+#include <string>
+#include <zlib.h>
+
+//------------------------------------------------------------------------------
+
+/// streaming writer of NDJSON records into the response
+/// records are written one by one, optionally compressed by gzip,
+/// the memory footprint does not depend on the number of records
+
+class CExportStream {
+public:
+    CExportStream(CResponseWriter& response);
+    ~CExportStream(void);
+
+// main methods ----------------------------------------------------------------
+    /// write headers and prepare the stream
+    bool Open(bool gzip);
+
+    /// write one record, a newline is appended
+    bool WriteRecord(const std::string& record);
+
+    /// flush all pending data
+    bool Close(void);
+
+// helper methods --------------------------------------------------------------
+    /// append JSON string literal including quotes
+    static void AppendString(std::string& record,const char* p_str);
+
+// section of private data -----------------------------------------------------
+private:
+    CResponseWriter&    Response;
+    bool                Opened;
+    bool                GZip;
+    z_stream            ZStream;
+    unsigned char       ZBuffer[16384];
+
+    bool Deflate(const char* p_data,unsigned int len,int flush);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
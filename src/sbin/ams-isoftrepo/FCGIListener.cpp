@@ -0,0 +1,1130 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "FCGIListener.hpp"
+#include "ISoftRepoServer.hpp"
+#include <ErrorSystem.hpp>
+#include "ServerMetrics.hpp"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <grp.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+// FastCGI protocol constants
+#define FCGI_VERSION_1              1
+#define FCGI_BEGIN_REQUEST          1
+#define FCGI_ABORT_REQUEST          2
+#define FCGI_END_REQUEST            3
+#define FCGI_PARAMS                 4
+#define FCGI_STDIN                  5
+#define FCGI_STDOUT                 6
+#define FCGI_GET_VALUES             9
+#define FCGI_GET_VALUES_RESULT      10
+#define FCGI_UNKNOWN_TYPE           11
+#define FCGI_RESPONDER              1
+#define FCGI_KEEP_CONN              1
+#define FCGI_REQUEST_COMPLETE       0
+#define FCGI_CANT_MPX_CONN          1
+#define FCGI_UNKNOWN_ROLE           3
+#define FCGI_MAX_CONTENT            65535
+
+// limits of the connection
+#define FCGI_MAX_PARAMS_SIZE        1048576
+#define FCGI_INPUT_CHUNK            65536
+#define FCGI_OUTPUT_CHUNK           32768
+
+// stages
+#define STAGE_REQUEST_QUEUE         1024    // per worker, power of two
+#define STAGE_OUTPUT_QUEUE          4096    // power of two
+#define STAGE_WRITE_CHUNK           65536   // output handed over at once
+#define STAGE_HIGH_WATER            1048576 // unsent bytes of request before the writer waits
+#define STAGE_MAX_EVENTS            64
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+// all worker queues are full, the configuration is not accessible here
+static const char* StageRejectedResponse =
+    "Status: 503 Service Unavailable\r\n"
+    "Retry-After: 1\r\n"
+    "Cache-Control: no-store\r\n"
+    "Content-type: text/plain\r\n"
+    "\r\n"
+    "The software repository is overloaded, please try again later.\n";
+
+//------------------------------------------------------------------------------
+
+/// monotonic time in ms
+static uint64_t GetTimeMS(void)
+{
+    return(GetMonotonicTime() / 1000);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CStagedRequest::CStagedRequest(CFCGIConnection* p_connection)
+    : Aborted(false), Pending(0)
+{
+    Connection = p_connection;
+}
+
+//------------------------------------------------------------------------------
+
+bool CStagedRequest::WaitForDrain(void)
+{
+    std::unique_lock<std::mutex> lock(Lock);
+    Drained.wait(lock,[this]{ return((Pending <= STAGE_HIGH_WATER) || Aborted); });
+    return(Aborted == false);
+}
+
+//------------------------------------------------------------------------------
+
+void CStagedRequest::Release(size_t sent)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+    // record headers are sent too, do not release more than written
+    size_t pending = Pending;
+    Pending -= sent < pending ? sent : pending;
+    if( (pending > STAGE_HIGH_WATER) && (Pending <= STAGE_HIGH_WATER) ) Drained.notify_one();
+}
+
+//------------------------------------------------------------------------------
+
+void CStagedRequest::Abort(void)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+    Aborted = true;
+    Drained.notify_one();
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CFCGIConnection::CFCGIConnection(int fd,int max_conns)
+{
+    Socket = fd;
+    InFlight = NULL;
+    Finished = false;
+    Failed = false;
+    Events = 0;
+    LastActivity = 0;
+    MaxConns = max_conns;
+    RequestID = 0;
+    KeepConn = false;
+    ParamsDone = false;
+    InputPos = 0;
+    OutputPos = 0;
+}
+
+//------------------------------------------------------------------------------
+
+CFCGIConnection::~CFCGIConnection(void)
+{
+    delete InFlight;
+    if( Socket >= 0 ) close(Socket);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CFCGIConnection::ReadInput(void)
+{
+    for(;;){
+        size_t size = Input.size();
+        Input.resize(size+FCGI_INPUT_CHUNK);
+        ssize_t ret = read(Socket,&Input[size],FCGI_INPUT_CHUNK);
+        if( ret < 0 ) {
+            Input.resize(size);
+            if( errno == EINTR ) continue;
+            if( (errno == EAGAIN) || (errno == EWOULDBLOCK) ) return(true);
+            return(false);
+        }
+        Input.resize(size+ret);
+        if( ret == 0 ) return(false);
+        if( ret < FCGI_INPUT_CHUNK ) return(true);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+bool CFCGIConnection::ParseRequest(void)
+{
+    bool completed = false;
+
+    while( (completed == false) && (Input.size() - InputPos >= 8) ){
+        const unsigned char* p_header = &Input[InputPos];
+        if( p_header[0] != FCGI_VERSION_1 ) {
+            ES_ERROR("unsupported FastCGI version");
+            Failed = true;
+            return(false);
+        }
+        int    type = p_header[1];
+        int    id = (p_header[2] << 8) | p_header[3];
+        size_t clen = (p_header[4] << 8) | p_header[5];
+        size_t plen = p_header[6];
+        if( Input.size() - InputPos < 8 + clen + plen ) break;
+
+        const unsigned char* p_content = p_header + 8;
+        InputPos += 8 + clen + plen;
+
+        switch(type){
+            case FCGI_BEGIN_REQUEST: {
+                if( clen < 8 ) break;
+                if( RequestID != 0 ) {
+                    // multiplexing is not supported
+                    AppendEndRequest(id,FCGI_CANT_MPX_CONN);
+                    break;
+                }
+                int role = (p_content[0] << 8) | p_content[1];
+                if( role != FCGI_RESPONDER ) {
+                    AppendEndRequest(id,FCGI_UNKNOWN_ROLE);
+                    break;
+                }
+                RequestID = id;
+                KeepConn = (p_content[2] & FCGI_KEEP_CONN) != 0;
+                ParamsDone = false;
+                ParamsData.clear();
+            }
+            break;
+
+            case FCGI_PARAMS:
+                if( (id != RequestID) || (RequestID == 0) ) break;
+                if( clen == 0 ) {
+                    ParamsDone = true;
+                    break;
+                }
+                if( ParamsData.size() + clen > FCGI_MAX_PARAMS_SIZE ) {
+                    ES_ERROR("too large FastCGI params");
+                    Failed = true;
+                    return(false);
+                }
+                ParamsData.append((const char*)p_content,clen);
+            break;
+
+            case FCGI_STDIN:
+                // request body is not used by the server
+                if( (id != RequestID) || (RequestID == 0) ) break;
+                if( (clen == 0) && ParamsDone ) completed = true;
+            break;
+
+            case FCGI_ABORT_REQUEST:
+                if( (id != RequestID) || (RequestID == 0) ) break;
+                AppendEndRequest(id,FCGI_REQUEST_COMPLETE);
+                RequestID = 0;
+                ParamsDone = false;
+                ParamsData.clear();
+                // close the connection once the end of the request is sent
+                if( KeepConn == false ) Finished = true;
+            break;
+
+            case FCGI_GET_VALUES:
+                AppendValues(p_content,clen);
+            break;
+
+            default:
+                if( id == 0 ) {
+                    unsigned char body[8];
+                    memset(body,0,sizeof(body));
+                    body[0] = type;
+                    AppendRecord(FCGI_UNKNOWN_TYPE,0,body,sizeof(body));
+                }
+            break;
+        }
+        if( Finished ) break;
+    }
+
+    // drop parsed records
+    if( InputPos > 0 ) {
+        Input.erase(Input.begin(),Input.begin()+InputPos);
+        InputPos = 0;
+    }
+
+    return(completed);
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIConnection::GetParams(CFCGIRequest& request)
+{
+    size_t pos = 0;
+    while( pos < ParamsData.size() ){
+        size_t nlen,vlen;
+        if( DecodeLength(ParamsData,pos,nlen) == false ) break;
+        if( DecodeLength(ParamsData,pos,vlen) == false ) break;
+        if( pos + nlen + vlen > ParamsData.size() ) break;
+        CSmallString name(ParamsData.substr(pos,nlen).c_str());
+        CSmallString value(ParamsData.substr(pos+nlen,vlen).c_str());
+        request.Params.SetValue(name,value);
+        pos += nlen + vlen;
+    }
+    ParamsData.clear();
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIConnection::AppendStdout(const char* p_data,size_t len)
+{
+    while( len > 0 ){
+        size_t chunk = len > FCGI_OUTPUT_CHUNK ? FCGI_OUTPUT_CHUNK : len;
+        AppendRecord(FCGI_STDOUT,RequestID,(const unsigned char*)p_data,chunk);
+        p_data += chunk;
+        len -= chunk;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIConnection::AppendEndRequest(void)
+{
+    AppendRecord(FCGI_STDOUT,RequestID,NULL,0);
+    AppendEndRequest(RequestID,FCGI_REQUEST_COMPLETE);
+    RequestID = 0;
+    ParamsDone = false;
+}
+
+//------------------------------------------------------------------------------
+
+bool CFCGIConnection::WriteOutput(size_t& sent)
+{
+    sent = 0;
+    while( OutputPos < Output.size() ){
+        ssize_t ret = send(Socket,&Output[OutputPos],Output.size()-OutputPos,MSG_NOSIGNAL);
+        if( ret < 0 ) {
+            if( errno == EINTR ) continue;
+            if( (errno == EAGAIN) || (errno == EWOULDBLOCK) ) break;
+            return(false);
+        }
+        OutputPos += ret;
+        sent += ret;
+    }
+
+    if( OutputPos == Output.size() ) {
+        Output.clear();
+        OutputPos = 0;
+    } else if( OutputPos >= Output.size() / 2 ) {
+        // keep the buffer from growing while the client reads slowly
+        Output.erase(Output.begin(),Output.begin()+OutputPos);
+        OutputPos = 0;
+    }
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+size_t CFCGIConnection::GetOutputSize(void) const
+{
+    return(Output.size() - OutputPos);
+}
+
+//------------------------------------------------------------------------------
+
+bool CFCGIConnection::GetKeepConn(void) const
+{
+    return(KeepConn);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CFCGIConnection::AppendRecord(int type,int id,const unsigned char* p_data,size_t len)
+{
+    unsigned char header[8];
+    header[0] = FCGI_VERSION_1;
+    header[1] = type;
+    header[2] = (id >> 8) & 0xFF;
+    header[3] = id & 0xFF;
+    header[4] = (len >> 8) & 0xFF;
+    header[5] = len & 0xFF;
+    header[6] = 0;
+    header[7] = 0;
+    Output.insert(Output.end(),header,header+8);
+    if( len > 0 ) Output.insert(Output.end(),p_data,p_data+len);
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIConnection::AppendEndRequest(int id,int protocol_status)
+{
+    unsigned char body[8];
+    memset(body,0,sizeof(body));
+    body[4] = protocol_status;
+    AppendRecord(FCGI_END_REQUEST,id,body,sizeof(body));
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIConnection::AppendValues(const unsigned char* p_data,size_t len)
+{
+    std::string data((const char*)p_data,len);
+    std::string result;
+
+    size_t pos = 0;
+    while( pos < data.size() ){
+        size_t nlen,vlen;
+        if( DecodeLength(data,pos,nlen) == false ) break;
+        if( DecodeLength(data,pos,vlen) == false ) break;
+        if( pos + nlen + vlen > data.size() ) break;
+        std::string name = data.substr(pos,nlen);
+        pos += nlen + vlen;
+
+        std::string value;
+        if( name == "FCGI_MPXS_CONNS" ) value = "0";
+        if( (name == "FCGI_MAX_CONNS") || (name == "FCGI_MAX_REQS") ) value = std::to_string(MaxConns);
+        if( value.empty() ) continue;
+
+        result += (char)name.size();
+        result += (char)value.size();
+        result += name;
+        result += value;
+    }
+
+    AppendRecord(FCGI_GET_VALUES_RESULT,0,(const unsigned char*)result.data(),result.size());
+}
+
+//------------------------------------------------------------------------------
+
+bool CFCGIConnection::DecodeLength(const std::string& data,size_t& pos,size_t& len)
+{
+    if( pos >= data.size() ) return(false);
+    unsigned char b0 = data[pos];
+    if( (b0 & 0x80) == 0 ) {
+        len = b0;
+        pos++;
+        return(true);
+    }
+    if( pos + 4 > data.size() ) return(false);
+    len = ((size_t)(b0 & 0x7F) << 24) | ((size_t)(unsigned char)data[pos+1] << 16)
+        | ((size_t)(unsigned char)data[pos+2] << 8) | (size_t)(unsigned char)data[pos+3];
+    pos += 4;
+    return(true);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CStagedWriter::CStagedWriter(CFCGIListener* p_listener,CStagedRequest* p_request)
+{
+    Listener = p_listener;
+    Request = p_request;
+    Finished = false;
+}
+
+//------------------------------------------------------------------------------
+
+bool CStagedWriter::Write(const char* p_data,size_t len)
+{
+    if( Finished ) return(false);
+    if( Request->Aborted ) return(false);
+    Buffer.append(p_data,len);
+    if( Buffer.size() < STAGE_WRITE_CHUNK ) return(true);
+    return(Flush(false));
+}
+
+//------------------------------------------------------------------------------
+
+bool CStagedWriter::Finish(void)
+{
+    // handlers still use the request after finishing the response,
+    // thus the end is handed over later by Complete
+    if( Finished ) return(true);
+    Finished = true;
+    if( Buffer.empty() ) return(Request->Aborted == false);
+    return(Flush(false));
+}
+
+//------------------------------------------------------------------------------
+
+void CStagedWriter::Complete(void)
+{
+    Finished = true;
+    Flush(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CStagedWriter::Flush(bool finished)
+{
+    // streamed responses wait here for slow clients instead of being
+    // buffered whole in the I/O stage
+    if( Request->Pending > STAGE_HIGH_WATER ) {
+        Listener->NumOfWriteWaits++;
+        Request->WaitForDrain();
+    }
+
+    bool aborted = Request->Aborted;
+    if( aborted ) {
+        Buffer.clear();
+        // the end must be handed over anyway, it releases the request
+        if( finished == false ) return(false);
+    }
+
+    CStagedOutput* p_output = new CStagedOutput;
+    p_output->Request = Request;
+    p_output->Data.swap(Buffer);
+    p_output->Finished = finished;
+    Request->Pending += p_output->Data.size();
+
+    // the request can be released by the I/O stage from now if it is finished
+    Listener->PushOutput(p_output);
+    return(aborted == false);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CFCGIWorker::CFCGIWorker(CFCGIListener* p_listener,size_t index)
+{
+    Listener = p_listener;
+    Index = index;
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIWorker::ExecuteThread(void)
+{
+    size_t num_of_queues = Listener->Requests.size();
+    Listener->Server->GetMetrics().StartWorker();
+
+    while( ThreadTerminated == false ){
+        Listener->WorkerBeat = GetTimeMS();
+
+        // wake up periodically to check for termination
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME,&deadline);
+        deadline.tv_sec += 1;
+        if( sem_timedwait(&Listener->Queued,&deadline) != 0 ) continue;
+
+        // the semaphore guarantees a queued request, the own queue is tried
+        // first, other queues are tried when the request was pushed to them
+        CStagedRequest* p_request = NULL;
+        while( p_request == NULL ){
+            for(size_t i=0; i < num_of_queues; i++){
+                p_request = Listener->Requests[(Index+i) % num_of_queues]->Pop();
+                if( p_request == NULL ) continue;
+                if( i > 0 ) Listener->NumOfSteals++;
+                break;
+            }
+        }
+
+        CStagedWriter response(Listener,p_request);
+        Listener->Server->ServeRequest(p_request->Request,response,p_request->Ticket);
+        response.Complete();   // p_request must not be used from now
+    }
+
+    Listener->Server->GetMetrics().StopWorker();
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CFCGIDispatcher::CFCGIDispatcher(CFCGIListener* p_listener)
+{
+    Listener = p_listener;
+    EPoll = -1;
+    NextWorker = 0;
+}
+
+//------------------------------------------------------------------------------
+
+CFCGIDispatcher::~CFCGIDispatcher(void)
+{
+    // the render stage is stopped, requests never served are released here
+    for(CFCGIConnection* p_connection : Connections){
+        delete p_connection;
+    }
+    Connections.clear();
+    if( EPoll >= 0 ) close(EPoll);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CFCGIDispatcher::ExecuteThread(void)
+{
+    EPoll = epoll_create1(EPOLL_CLOEXEC);
+    if( EPoll < 0 ) {
+        ES_ERROR("unable to create epoll");
+        return;
+    }
+
+    // NULL is the listening socket, this is the wake up eventfd
+    struct epoll_event event;
+    memset(&event,0,sizeof(event));
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    epoll_ctl(EPoll,EPOLL_CTL_ADD,Listener->Socket,&event);
+    event.data.ptr = this;
+    epoll_ctl(EPoll,EPOLL_CTL_ADD,Listener->WakeUp,&event);
+
+    uint64_t last_scan = GetTimeMS();
+
+    while( ThreadTerminated == false ){
+        struct epoll_event events[STAGE_MAX_EVENTS];
+        int num_of_events = epoll_wait(EPoll,events,STAGE_MAX_EVENTS,1000);
+        Listener->DispatcherBeat = GetTimeMS();
+
+        for(int i=0; i < num_of_events; i++){
+            void* p_tag = events[i].data.ptr;
+            if( p_tag == NULL ) {
+                AcceptConnections();
+                continue;
+            }
+            if( p_tag == this ) {
+                uint64_t count;
+                while( read(Listener->WakeUp,&count,sizeof(count)) > 0 );
+                continue;
+            }
+            CFCGIConnection* p_connection = static_cast<CFCGIConnection*>(p_tag);
+            if( p_connection->Failed ) continue;    // closed in this batch
+            if( events[i].events & EPOLLIN ) {
+                ProcessInput(p_connection);
+            } else if( events[i].events & (EPOLLERR | EPOLLHUP) ) {
+                CloseConnection(p_connection);
+                continue;
+            }
+            if( (p_connection->Failed == false) && (events[i].events & EPOLLOUT) ) {
+                WriteOutput(p_connection);
+            }
+        }
+
+        // outputs are processed in each round, wake ups can coalesce
+        ProcessOutputs();
+
+        uint64_t now = GetTimeMS();
+        if( now - last_scan >= 1000 ) {
+            CloseIdleConnections(now);
+            last_scan = now;
+        }
+
+        ReleaseConnections();
+    }
+
+    // workers are stopped before the dispatcher, hand over their last outputs
+    ProcessOutputs();
+    ReleaseConnections();
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIDispatcher::AcceptConnections(void)
+{
+    for(;;){
+        int fd = accept4(Listener->Socket,NULL,NULL,SOCK_CLOEXEC | SOCK_NONBLOCK);
+        if( fd < 0 ) {
+            if( errno == EINTR ) continue;
+            return;
+        }
+
+        CFCGIConnection* p_connection = new CFCGIConnection(fd,Listener->NumOfWorkers);
+        p_connection->LastActivity = GetTimeMS();
+
+        struct epoll_event event;
+        memset(&event,0,sizeof(event));
+        event.events = EPOLLIN;
+        event.data.ptr = p_connection;
+        if( epoll_ctl(EPoll,EPOLL_CTL_ADD,fd,&event) != 0 ) {
+            delete p_connection;
+            continue;
+        }
+        p_connection->Events = EPOLLIN;
+        Connections.insert(p_connection);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIDispatcher::ProcessInput(CFCGIConnection* p_connection)
+{
+    p_connection->LastActivity = GetTimeMS();
+
+    if( p_connection->ReadInput() == false ) {
+        CloseConnection(p_connection);
+        return;
+    }
+
+    StartRequest(p_connection);
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIDispatcher::StartRequest(CFCGIConnection* p_connection)
+{
+    if( (p_connection->InFlight != NULL) || p_connection->Finished ) return;
+
+    if( p_connection->ParseRequest() == false ) {
+        if( p_connection->Failed ) {
+            // protocol error, the connection is not usable anymore
+            p_connection->Failed = false;
+            CloseConnection(p_connection);
+            return;
+        }
+        // replies to management records
+        WriteOutput(p_connection);
+        return;
+    }
+
+    CStagedRequest* p_request = new CStagedRequest(p_connection);
+    p_connection->GetParams(p_request->Request);
+
+    // requests above the capacity are answered here, they are never queued
+    std::string reply;
+    if( Listener->Server->AdmitRequest(p_request->Request,p_request->Ticket,reply) == false ) {
+        delete p_request;
+        p_connection->AppendStdout(reply.c_str(),reply.size());
+        p_connection->AppendEndRequest();
+        p_connection->Finished = true;
+        WriteOutput(p_connection);
+        return;
+    }
+
+    p_connection->InFlight = p_request;
+
+    // round robin, the next queue is used if the selected one is full
+    size_t num_of_queues = Listener->Requests.size();
+    bool   queued = false;
+    for(size_t i=0; i < num_of_queues; i++){
+        size_t index = (NextWorker + i) % num_of_queues;
+        if( Listener->Requests[index]->Push(p_request) ) {
+            queued = true;
+            break;
+        }
+    }
+    NextWorker = (NextWorker + 1) % num_of_queues;
+
+    if( queued ) {
+        sem_post(&Listener->Queued);
+        UpdateEvents(p_connection);
+        return;
+    }
+
+    // all workers are far behind
+    Listener->NumOfRejected++;
+    Listener->Server->CancelRequest(p_request->Ticket);
+    p_connection->InFlight = NULL;
+    delete p_request;
+
+    p_connection->AppendStdout(StageRejectedResponse,strlen(StageRejectedResponse));
+    p_connection->AppendEndRequest();
+    p_connection->Finished = true;
+    WriteOutput(p_connection);
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIDispatcher::ProcessOutputs(void)
+{
+    CStagedOutput* p_output;
+    while( (p_output = Listener->Outputs.Pop()) != NULL ){
+        CStagedRequest*  p_request = p_output->Request;
+        CFCGIConnection* p_connection = p_request->Connection;
+
+        if( p_connection->Failed == false ) {
+            if( p_output->Data.empty() == false ) {
+                p_connection->AppendStdout(p_output->Data.c_str(),p_output->Data.size());
+            }
+            if( p_output->Finished ) {
+                p_connection->AppendEndRequest();
+            }
+        }
+
+        if( p_output->Finished ) {
+            p_connection->InFlight = NULL;
+            p_connection->Finished = true;
+            delete p_request;
+            if( p_connection->Failed ) Closed.push_back(p_connection);
+        }
+        delete p_output;
+
+        if( p_connection->Failed == false ) WriteOutput(p_connection);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIDispatcher::WriteOutput(CFCGIConnection* p_connection)
+{
+    size_t sent = 0;
+    if( p_connection->WriteOutput(sent) == false ) {
+        CloseConnection(p_connection);
+        return;
+    }
+
+    if( sent > 0 ) {
+        p_connection->LastActivity = GetTimeMS();
+        CStagedRequest* p_request = p_connection->InFlight;
+        if( p_request != NULL ) p_request->Release(sent);
+    }
+
+    if( (p_connection->GetOutputSize() == 0) && p_connection->Finished ) {
+        if( p_connection->GetKeepConn() == false ) {
+            CloseConnection(p_connection);
+            return;
+        }
+        // next request can be already buffered
+        p_connection->Finished = false;
+        StartRequest(p_connection);
+        if( p_connection->Failed ) return;
+    }
+
+    UpdateEvents(p_connection);
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIDispatcher::UpdateEvents(CFCGIConnection* p_connection)
+{
+    uint32_t events = 0;
+    if( (p_connection->InFlight == NULL) && (p_connection->Finished == false) ) events |= EPOLLIN;
+    if( p_connection->GetOutputSize() > 0 ) events |= EPOLLOUT;
+    if( events == p_connection->Events ) return;
+
+    struct epoll_event event;
+    memset(&event,0,sizeof(event));
+    event.events = events;
+    event.data.ptr = p_connection;
+    epoll_ctl(EPoll,EPOLL_CTL_MOD,p_connection->Socket,&event);
+    p_connection->Events = events;
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIDispatcher::CloseConnection(CFCGIConnection* p_connection)
+{
+    if( p_connection->Failed ) return;
+    p_connection->Failed = true;
+
+    epoll_ctl(EPoll,EPOLL_CTL_DEL,p_connection->Socket,NULL);
+    shutdown(p_connection->Socket,SHUT_RDWR);
+
+    // the request is released when the render stage finishes it
+    if( p_connection->InFlight != NULL ) {
+        p_connection->InFlight->Abort();
+        return;
+    }
+    Closed.push_back(p_connection);
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIDispatcher::CloseIdleConnections(uint64_t now)
+{
+    std::vector<CFCGIConnection*> idle;
+    for(CFCGIConnection* p_connection : Connections){
+        if( p_connection->Failed ) continue;
+        // rendered requests are not idle, unless the client stopped reading
+        if( (p_connection->InFlight != NULL) && (p_connection->GetOutputSize() == 0) ) continue;
+        if( now - p_connection->LastActivity < (uint64_t)Listener->IdleTimeout ) continue;
+        idle.push_back(p_connection);
+    }
+    for(CFCGIConnection* p_connection : idle){
+        CloseConnection(p_connection);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIDispatcher::ReleaseConnections(void)
+{
+    for(CFCGIConnection* p_connection : Closed){
+        Connections.erase(p_connection);
+        delete p_connection;
+    }
+    Closed.clear();
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CFCGIListener::CFCGIListener(void)
+    : Outputs(STAGE_OUTPUT_QUEUE), NumOfSteals(0), NumOfRejected(0), NumOfWriteWaits(0),
+      DispatcherBeat(0), WorkerBeat(0)
+{
+    Socket = -1;
+    Server = NULL;
+    IdleTimeout = 0;
+    NumOfWorkers = 0;
+    WakeUp = -1;
+    sem_init(&Queued,0,0);
+    sem_init(&Terminate,0,0);
+}
+
+//------------------------------------------------------------------------------
+
+CFCGIListener::~CFCGIListener(void)
+{
+    Close();
+    sem_destroy(&Queued);
+    sem_destroy(&Terminate);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CFCGIListener::Open(const CFileName& socket_path,int mode,const CSmallString& group)
+{
+    struct sockaddr_un addr;
+    memset(&addr,0,sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if( strlen(socket_path) >= sizeof(addr.sun_path) ) {
+        ES_ERROR("socket path is too long");
+        return(false);
+    }
+    strcpy(addr.sun_path,socket_path);
+
+    // remove stale socket from previous run, but never the socket of a running server
+    struct stat info;
+    if( (lstat(socket_path,&info) == 0) && S_ISSOCK(info.st_mode) ) {
+        if( IsSocketAlive(addr) ) {
+            CSmallString error;
+            error << "another server listens on unix socket '" << socket_path << "'";
+            ES_ERROR(error);
+            return(false);
+        }
+        unlink(socket_path);
+    }
+
+    Socket = socket(AF_UNIX,SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK,0);
+    if( Socket < 0 ) {
+        ES_ERROR("unable to create unix socket");
+        return(false);
+    }
+
+    if( bind(Socket,(struct sockaddr*)&addr,sizeof(addr)) != 0 ) {
+        CSmallString error;
+        error << "unable to bind unix socket '" << socket_path << "' (" << strerror(errno) << ")";
+        ES_ERROR(error);
+        close(Socket);
+        Socket = -1;
+        return(false);
+    }
+    SocketPath = socket_path;
+
+    // the web server runs under a different user, it gets access by the group,
+    // the socket is not usable before listen thus there is no window
+    if( group != NULL ) {
+        struct group* p_group = getgrnam(group);
+        if( (p_group == NULL) || (chown(socket_path,(uid_t)-1,p_group->gr_gid) != 0) ) {
+            CSmallString error;
+            error << "unable to set group '" << group << "' of unix socket '" << socket_path << "'";
+            ES_ERROR(error);
+            Close();
+            return(false);
+        }
+    }
+    if( chmod(socket_path,mode) != 0 ) {
+        CSmallString error;
+        error << "unable to set mode of unix socket '" << socket_path << "' (" << strerror(errno) << ")";
+        ES_ERROR(error);
+        Close();
+        return(false);
+    }
+
+    if( listen(Socket,SOMAXCONN) != 0 ) {
+        ES_ERROR("unable to listen on unix socket");
+        Close();
+        return(false);
+    }
+
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CFCGIListener::IsSocketAlive(const struct sockaddr_un& addr)
+{
+    int fd = socket(AF_UNIX,SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK,0);
+    if( fd < 0 ) return(false);
+
+    // refused connection means the socket is left by a dead server,
+    // non-blocking connect does not wait when the backlog is full
+    bool alive = connect(fd,(const struct sockaddr*)&addr,sizeof(addr)) == 0;
+    if( (alive == false) && (errno == EAGAIN) ) alive = true;  // full backlog
+    close(fd);
+    return(alive);
+}
+
+//------------------------------------------------------------------------------
+
+bool CFCGIListener::StartWorkers(CISoftRepoServer* p_server,int num_of_workers,int idle_timeout)
+{
+    Server = p_server;
+    NumOfWorkers = num_of_workers;
+    IdleTimeout = idle_timeout;
+
+    WakeUp = eventfd(0,EFD_CLOEXEC | EFD_NONBLOCK);
+    if( WakeUp < 0 ) {
+        ES_ERROR("unable to create eventfd");
+        return(false);
+    }
+
+    // threads are given time to report their first loop
+    DispatcherBeat = GetTimeMS();
+    WorkerBeat = GetTimeMS();
+
+    // queues must exist before any worker starts
+    for(int i=0; i < num_of_workers; i++){
+        Requests.push_back(std::unique_ptr<TRequestQueue>(new TRequestQueue(STAGE_REQUEST_QUEUE)));
+    }
+
+    for(int i=0; i < num_of_workers; i++){
+        CFCGIWorker* p_worker = new CFCGIWorker(this,i);
+        Workers.push_back(std::unique_ptr<CFCGIWorker>(p_worker));
+        if( p_worker->StartThread() == false ) {
+            ES_ERROR("unable to start worker");
+            return(false);
+        }
+    }
+
+    Dispatcher.reset(new CFCGIDispatcher(this));
+    if( Dispatcher->StartThread() == false ) {
+        ES_ERROR("unable to start dispatcher");
+        return(false);
+    }
+
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIListener::WaitForTermination(void)
+{
+    while( (sem_wait(&Terminate) != 0) && (errno == EINTR) );
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIListener::RequestTermination(void)
+{
+    sem_post(&Terminate);
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIListener::Close(void)
+{
+    // workers finish their current requests, the dispatcher is still running
+    // so that writers waiting for slow clients are not blocked
+    for(std::unique_ptr<CFCGIWorker>& worker : Workers){
+        worker->TerminateThread();
+    }
+    for(std::unique_ptr<CFCGIWorker>& worker : Workers){
+        worker->WaitForThread();
+    }
+    Workers.clear();
+
+    if( Dispatcher ) {
+        Dispatcher->TerminateThread();
+        Dispatcher->WaitForThread();
+        Dispatcher.reset();
+    }
+    Requests.clear();
+
+    CStagedOutput* p_output;
+    while( (p_output = Outputs.Pop()) != NULL ){
+        delete p_output;
+    }
+
+    if( WakeUp >= 0 ) {
+        close(WakeUp);
+        WakeUp = -1;
+    }
+
+    if( Socket >= 0 ) {
+        close(Socket);
+        Socket = -1;
+        unlink(SocketPath);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIListener::PushOutput(CStagedOutput* p_output)
+{
+    // the dispatcher drains the queue in each round
+    while( Outputs.Push(p_output) == false ){
+        sched_yield();
+    }
+    uint64_t count = 1;
+    if( write(WakeUp,&count,sizeof(count)) < 0 ) {
+        // the counter is saturated, the dispatcher is already woken up
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CFCGIListener::PrintMetrics(std::string& output)
+{
+    CServerMetrics::AppendHeader(output,"isoftrepo_stage_steals_total","counter",
+                                 "Number of requests served by other than the assigned worker.");
+    CServerMetrics::AppendSample(output,"isoftrepo_stage_steals_total",NULL,NumOfSteals);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_stage_rejected_total","counter",
+                                 "Number of requests answered with 503 because all worker queues were full.");
+    CServerMetrics::AppendSample(output,"isoftrepo_stage_rejected_total",NULL,NumOfRejected);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_stage_write_waits_total","counter",
+                                 "Number of responses that waited for a slow client.");
+    CServerMetrics::AppendSample(output,"isoftrepo_stage_write_waits_total",NULL,NumOfWriteWaits);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CFCGIListener::IsResponsive(uint64_t max_age) const
+{
+    // idle threads wake up every second, busy workers after each request
+    // beats are read first, thus they are not newer than now
+    uint64_t dispatcher = DispatcherBeat;
+    uint64_t worker = WorkerBeat;
+    uint64_t now = GetTimeMS();
+    if( now - dispatcher > max_age ) return(false);
+    if( now - worker > max_age ) return(false);
+    return(true);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
@@ -0,0 +1,304 @@
+#ifndef FCGIListenerH
+#define FCGIListenerH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <SmallThread.hpp>
+#include <FileName.hpp>
+#include <FCGIRequest.hpp>
+#include "ResponseWriter.hpp"
+#include "StageQueue.hpp"
+#include "AdmissionControl.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <semaphore.h>
+#include <sys/un.h>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+
+class CISoftRepoServer;
+class CFCGIListener;
+class CFCGIConnection;
+
+//------------------------------------------------------------------------------
+
+/// request handed over from the I/O stage to the render stage
+/// it is owned by its connection and released by the I/O stage after
+/// the render stage hands over the end of the response
+
+class CStagedRequest {
+public:
+    CStagedRequest(CFCGIConnection* p_connection);
+
+    /// wait until unsent data drop below the high water mark,
+    /// it returns false if the client is gone
+    bool WaitForDrain(void);
+
+    /// release sent data, used by the I/O stage
+    void Release(size_t sent);
+
+    /// mark the request aborted, used by the I/O stage
+    void Abort(void);
+
+    CFCGIRequest            Request;
+    CAdmissionTicket        Ticket;         // arrival and reservation
+    CFCGIConnection*        Connection;     // used only by the I/O stage
+    std::atomic<bool>       Aborted;        // the client is gone
+    std::atomic<size_t>     Pending;        // bytes written but not sent yet
+
+private:
+    std::mutex              Lock;
+    std::condition_variable Drained;        // signalled by the I/O stage
+};
+
+//------------------------------------------------------------------------------
+
+/// part of the response handed over from the render stage to the I/O stage
+
+class CStagedOutput {
+public:
+    CStagedRequest*         Request;
+    std::string             Data;
+    bool                    Finished;
+};
+
+//------------------------------------------------------------------------------
+
+/// server side of one FastCGI connection, it is used only by the I/O stage
+/// records are parsed from non-blocking reads, requests are not multiplexed,
+/// the connection is kept open when the web server sets FCGI_KEEP_CONN
+
+class CFCGIConnection {
+public:
+    CFCGIConnection(int fd,int max_conns);
+    ~CFCGIConnection(void);
+
+// main methods ----------------------------------------------------------------
+    /// read available data, false on closed connection or error
+    bool ReadInput(void);
+
+    /// parse buffered records, true if the request is complete
+    /// Failed is set for protocol errors
+    bool ParseRequest(void);
+
+    /// set parameters of the complete request
+    void GetParams(CFCGIRequest& request);
+
+    /// append stdout data of the current request
+    void AppendStdout(const char* p_data,size_t len);
+
+    /// append end of the current request
+    void AppendEndRequest(void);
+
+    /// write buffered output as far as the socket accepts it, false on error
+    bool WriteOutput(size_t& sent);
+
+    /// number of bytes waiting for write
+    size_t GetOutputSize(void) const;
+
+    /// should the connection be kept after the request
+    bool GetKeepConn(void) const;
+
+// section of public data ------------------------------------------------------
+public:
+    int                         Socket;
+    CStagedRequest*             InFlight;       // request in the render stage
+    bool                        Finished;       // the response is complete
+    bool                        Failed;         // closed, released without request
+    uint32_t                    Events;         // registered in epoll
+    uint64_t                    LastActivity;   // in ms
+
+// section of private data -----------------------------------------------------
+private:
+    int                         MaxConns;
+    int                         RequestID;
+    bool                        KeepConn;
+    bool                        ParamsDone;
+    std::vector<unsigned char>  Input;
+    size_t                      InputPos;       // start of unparsed records
+    std::string                 ParamsData;
+    std::vector<unsigned char>  Output;
+    size_t                      OutputPos;      // start of unsent data
+
+    void AppendRecord(int type,int id,const unsigned char* p_data,size_t len);
+    void AppendEndRequest(int id,int protocol_status);
+    void AppendValues(const unsigned char* p_data,size_t len);
+    static bool DecodeLength(const std::string& data,size_t& pos,size_t& len);
+};
+
+//------------------------------------------------------------------------------
+
+/// response of requests accepted by CFCGIListener
+/// data are handed over to the I/O stage in chunks, the writer waits only
+/// when too much data of the request is not sent yet (streamed exports)
+
+class CStagedWriter : public CResponseWriter {
+public:
+    CStagedWriter(CFCGIListener* p_listener,CStagedRequest* p_request);
+
+// main methods ----------------------------------------------------------------
+    virtual bool Write(const char* p_data,size_t len);
+    virtual bool Finish(void);
+
+    using CResponseWriter::Write;
+
+    /// hand the end of response over to the I/O stage, it is called by the worker
+    /// after the request is served as the I/O stage releases the request then
+    void Complete(void);
+
+// section of private data -----------------------------------------------------
+private:
+    CFCGIListener*      Listener;
+    CStagedRequest*     Request;
+    std::string         Buffer;
+    bool                Finished;
+
+    bool Flush(bool finished);
+};
+
+//------------------------------------------------------------------------------
+
+/// render stage worker, it serves requests from its queue and steals
+/// requests queued for other workers when its own queue is empty
+
+class CFCGIWorker : public CSmallThread {
+public:
+    CFCGIWorker(CFCGIListener* p_listener,size_t index);
+
+// section of private data -----------------------------------------------------
+private:
+    CFCGIListener*  Listener;
+    size_t          Index;
+
+    virtual void ExecuteThread(void);
+};
+
+//------------------------------------------------------------------------------
+
+/// I/O stage, it accepts connections, parses requests, hands them over to
+/// workers and writes finished responses to clients as fast as they read them
+
+class CFCGIDispatcher : public CSmallThread {
+public:
+    CFCGIDispatcher(CFCGIListener* p_listener);
+    ~CFCGIDispatcher(void);
+
+// section of private data -----------------------------------------------------
+private:
+    CFCGIListener*                          Listener;
+    int                                     EPoll;
+    std::unordered_set<CFCGIConnection*>    Connections;
+    std::vector<CFCGIConnection*>           Closed;     // released after the event batch
+    size_t                                  NextWorker;
+
+    virtual void ExecuteThread(void);
+
+    void AcceptConnections(void);
+    void ProcessInput(CFCGIConnection* p_connection);
+    void StartRequest(CFCGIConnection* p_connection);
+    void ProcessOutputs(void);
+    void WriteOutput(CFCGIConnection* p_connection);
+    void UpdateEvents(CFCGIConnection* p_connection);
+    void CloseConnection(CFCGIConnection* p_connection);
+    void CloseIdleConnections(uint64_t now);
+    void ReleaseConnections(void);
+};
+
+//------------------------------------------------------------------------------
+
+/// FastCGI listener on a unix domain socket
+/// requests pass three stages: the I/O stage accepts and parses them, the
+/// render stage executes them on a pool of workers and the I/O stage writes
+/// their responses, thus slow clients do not occupy workers
+
+class CFCGIListener {
+public:
+    CFCGIListener(void);
+    ~CFCGIListener(void);
+
+// main methods ----------------------------------------------------------------
+    /// create listening socket with given permissions, empty group - not changed
+    /// it fails if another server listens on the socket
+    bool Open(const CFileName& socket_path,int mode,const CSmallString& group);
+
+    /// start workers serving requests by the server
+    bool StartWorkers(CISoftRepoServer* p_server,int num_of_workers,int idle_timeout);
+
+    /// wait until termination is requested
+    void WaitForTermination(void);
+
+    /// request termination, it is async-signal-safe
+    void RequestTermination(void);
+
+    /// stop workers and remove the socket
+    void Close(void);
+
+    /// print stage metrics
+    void PrintMetrics(std::string& output);
+
+// information methods ---------------------------------------------------------
+    /// did the dispatcher and at least one worker run within max_age ms
+    bool IsResponsive(uint64_t max_age) const;
+
+// section of private data -----------------------------------------------------
+private:
+    typedef CStageQueue<CStagedRequest>     TRequestQueue;
+    typedef CStageQueue<CStagedOutput>      TOutputQueue;
+
+    CFileName                                       SocketPath;
+    int                                             Socket;
+    CISoftRepoServer*                               Server;
+    int                                             IdleTimeout;    // in ms
+    int                                             NumOfWorkers;
+    std::vector<std::unique_ptr<CFCGIWorker> >      Workers;
+    std::vector<std::unique_ptr<TRequestQueue> >    Requests;       // one per worker
+    sem_t                                           Queued;         // requests in all queues
+    std::unique_ptr<CFCGIDispatcher>                Dispatcher;
+    TOutputQueue                                    Outputs;
+    int                                             WakeUp;         // eventfd of the dispatcher
+    sem_t                                           Terminate;
+    std::atomic<uint64_t>                           NumOfSteals;
+    std::atomic<uint64_t>                           NumOfRejected;  // all queues were full
+    std::atomic<uint64_t>                           NumOfWriteWaits;
+    std::atomic<uint64_t>                           DispatcherBeat; // last loop in ms
+    std::atomic<uint64_t>                           WorkerBeat;     // last loop of any worker in ms
+
+    /// hand over output to the I/O stage
+    void PushOutput(CStagedOutput* p_output);
+
+    /// does a server accept connections on the socket
+    static bool IsSocketAlive(const struct sockaddr_un& addr);
+
+    friend class CFCGIWorker;
+    friend class CFCGIDispatcher;
+    friend class CStagedWriter;
+};
+
+//------------------------------------------------------------------------------
+
+#endif
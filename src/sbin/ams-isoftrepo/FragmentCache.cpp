@@ -0,0 +1,229 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "FragmentCache.hpp"
+#include "ServerMetrics.hpp"
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+// markers are printed as text, thus they must not contain escaped characters
+#define MARKER_SUFFIX   "@#"
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CFragmentCache::CFragmentCache(void)
+{
+    Capacity = 0;
+    Size = 0;
+    NumOfHits = 0;
+    NumOfMisses = 0;
+    NumOfInvalidated = 0;
+    NumOfEvictions = 0;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CFragmentCache::SetCapacity(size_t capacity)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+    Capacity = capacity;
+    while( (Size > Capacity) && (Fragments.empty() == false) ){
+        RemoveFragment(--Fragments.end());
+        NumOfEvictions++;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CFragmentCache::Clear(void)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+    Fragments.clear();
+    Index.clear();
+    Size = 0;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CFragmentCache::GetFragment(const std::string& key,uint64_t stamp,
+                                 const TPageRenderer& renderer,CFragmentPtr& fragment)
+{
+    std::unique_lock<std::mutex> lock(Lock);
+
+    std::unordered_map<std::string,TFragmentList::iterator>::iterator it = Index.find(key);
+    if( it != Index.end() ) {
+        if( it->second->Stamp == stamp ) {
+            Fragments.splice(Fragments.begin(),Fragments,it->second);
+            fragment = it->second->Fragment;
+            NumOfHits++;
+            return(true);
+        }
+        // one of the bundles was changed
+        RemoveFragment(it->second);
+        NumOfInvalidated++;
+    }
+    NumOfMisses++;
+    lock.unlock();
+
+    // fragments are cheap, concurrent renders are not coalesced
+    std::string* p_fragment = new std::string;
+    CFragmentPtr output(p_fragment);
+    if( renderer(*p_fragment) == false ) return(false);
+
+    lock.lock();
+    if( (p_fragment->size() <= Capacity) && (Index.count(key) == 0) ) {
+        while( (Size + p_fragment->size() > Capacity) && (Fragments.empty() == false) ){
+            RemoveFragment(--Fragments.end());
+            NumOfEvictions++;
+        }
+        CFragmentEntry entry;
+        entry.Key = key;
+        entry.Stamp = stamp;
+        entry.Fragment = output;
+        Fragments.push_front(entry);
+        Index[key] = Fragments.begin();
+        Size += p_fragment->size();
+    }
+
+    fragment = output;
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+void CFragmentCache::RemoveFragment(TFragmentList::iterator it)
+{
+    Size -= it->Fragment->size();
+    Index.erase(it->Key);
+    Fragments.erase(it);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CFragmentCache::PrintMetrics(std::string& output,const char* p_labels)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_fragment_cache_hits_total","counter",
+                                 "Number of fragments served from the fragment cache.");
+    CServerMetrics::AppendSample(output,"isoftrepo_fragment_cache_hits_total",p_labels,NumOfHits);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_fragment_cache_misses_total","counter",
+                                 "Number of rendered fragments.");
+    CServerMetrics::AppendSample(output,"isoftrepo_fragment_cache_misses_total",p_labels,NumOfMisses);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_fragment_cache_invalidated_total","counter",
+                                 "Number of fragments dropped because their bundles were changed.");
+    CServerMetrics::AppendSample(output,"isoftrepo_fragment_cache_invalidated_total",p_labels,NumOfInvalidated);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_fragment_cache_evictions_total","counter",
+                                 "Number of fragments evicted from the fragment cache.");
+    CServerMetrics::AppendSample(output,"isoftrepo_fragment_cache_evictions_total",p_labels,NumOfEvictions);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_fragment_cache_fragments","gauge",
+                                 "Number of fragments in the fragment cache.");
+    CServerMetrics::AppendSample(output,"isoftrepo_fragment_cache_fragments",p_labels,Fragments.size());
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_fragment_cache_bytes","gauge",
+                                 "Size of fragments in the fragment cache.");
+    CServerMetrics::AppendSample(output,"isoftrepo_fragment_cache_bytes",p_labels,Size);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+const CSmallString CPageFragments::AddFragment(const CFragmentPtr& fragment)
+{
+    CSmallString marker(GetMarkerPrefix().c_str());
+    marker << (int)Fragments.size() << MARKER_SUFFIX;
+    Fragments.push_back(fragment);
+    return(marker);
+}
+
+//------------------------------------------------------------------------------
+
+void CPageFragments::Splice(std::string& page) const
+{
+    if( Fragments.empty() ) return;
+
+    const std::string& prefix = GetMarkerPrefix();
+
+    size_t size = page.size();
+    for(const CFragmentPtr& fragment : Fragments) size += fragment->size();
+
+    std::string output;
+    output.reserve(size);
+
+    size_t pos = 0;
+    for(;;){
+        size_t start = page.find(prefix,pos);
+        if( start == std::string::npos ) break;
+        size_t end = page.find(MARKER_SUFFIX,start + prefix.size());
+        if( end == std::string::npos ) break;
+
+        size_t index = strtoul(page.c_str() + start + prefix.size(),NULL,10);
+        output.append(page,pos,start - pos);
+        if( index < Fragments.size() ) output += *Fragments[index];
+        pos = end + sizeof(MARKER_SUFFIX) - 1;
+    }
+    output.append(page,pos,std::string::npos);
+
+    page.swap(output);
+}
+
+//------------------------------------------------------------------------------
+
+bool CPageFragments::IsEmpty(void) const
+{
+    return(Fragments.empty());
+}
+
+//------------------------------------------------------------------------------
+
+const std::string& CPageFragments::GetMarkerPrefix(void)
+{
+    static const std::string prefix = []{
+        std::random_device device;
+        char buffer[64];
+        snprintf(buffer,sizeof(buffer),"#@fragment-%08x%08x:",device(),device());
+        return(std::string(buffer));
+    }();
+    return(prefix);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
@@ -0,0 +1,117 @@
+#ifndef FragmentCacheH
+#define FragmentCacheH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <SmallString.hpp>
+#include "PageCache.hpp"
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+
+/// rendered fragment, the bytes are already escaped
+typedef std::shared_ptr<const std::string> CFragmentPtr;
+
+//------------------------------------------------------------------------------
+
+/// LRU cache of page fragments bounded by their total size
+/// each fragment carries a stamp of the data it was rendered from, i.e. a hash
+/// of module names and versions for categories or a hash of dependencies
+/// from GetDependenciesStamp, thus it survives catalog rebuilds until
+/// the data it shows is changed
+
+class CFragmentCache {
+public:
+    CFragmentCache(void);
+
+// setup methods ---------------------------------------------------------------
+    /// set capacity in bytes, zero - fragments are not stored
+    void SetCapacity(size_t capacity);
+
+// main methods ----------------------------------------------------------------
+    /// get fragment from the cache or render it
+    bool GetFragment(const std::string& key,uint64_t stamp,
+                     const TPageRenderer& renderer,CFragmentPtr& fragment);
+
+    /// drop all fragments
+    void Clear(void);
+
+    /// print cache metrics
+    void PrintMetrics(std::string& output,const char* p_labels);
+
+// section of private data -----------------------------------------------------
+private:
+    class CFragmentEntry {
+    public:
+        std::string     Key;
+        uint64_t        Stamp;
+        CFragmentPtr    Fragment;
+    };
+    typedef std::list<CFragmentEntry>               TFragmentList;
+
+    std::mutex                                      Lock;
+    size_t                                          Capacity;
+    size_t                                          Size;
+    TFragmentList                                   Fragments;  // most recently used first
+    std::unordered_map<std::string,TFragmentList::iterator>     Index;
+    uint64_t                                        NumOfHits;
+    uint64_t                                        NumOfMisses;
+    uint64_t                                        NumOfInvalidated;
+    uint64_t                                        NumOfEvictions;
+
+    /// remove fragment, lock must be held
+    void RemoveFragment(TFragmentList::iterator it);
+};
+
+//------------------------------------------------------------------------------
+
+/// fragments of one page, template parameters get markers that are replaced
+/// by the fragments once the page is printed
+
+class CPageFragments {
+public:
+    /// add fragment and get its marker
+    const CSmallString AddFragment(const CFragmentPtr& fragment);
+
+    /// replace markers in the printed page
+    void Splice(std::string& page) const;
+
+    /// any fragment added
+    bool IsEmpty(void) const;
+
+// section of private data -----------------------------------------------------
+private:
+    std::vector<CFragmentPtr>   Fragments;
+
+    /// marker prefix unique for the process, it cannot clash with page content
+    static const std::string& GetMarkerPrefix(void);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
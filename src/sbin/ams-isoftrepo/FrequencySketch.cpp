@@ -0,0 +1,160 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "FrequencySketch.hpp"
+#include <algorithm>
+#include <functional>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+// counters are halved after this number of additions per counter in a row
+#define SAMPLE_FACTOR   10
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CFrequencySketch::CFrequencySketch(void)
+{
+    Mask = 0;
+    Additions = 0;
+    Agings = 0;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CFrequencySketch::SetWidth(size_t width)
+{
+    size_t size = 0;
+    if( width > 0 ) {
+        size = 1;
+        while( size < width ) size <<= 1;
+    }
+    if( (size == Mask + 1) && (Counters.empty() == false) ) return;
+
+    std::vector<uint8_t>(size*DEPTH).swap(Counters);
+    Mask = size > 0 ? size - 1 : 0;
+    Additions = 0;
+    Agings++;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+unsigned int CFrequencySketch::Increment(const std::string& key)
+{
+    if( Counters.empty() ) return(0);
+
+    size_t indexes[DEPTH];
+    GetIndexes(key,indexes);
+
+    // only the smallest counters are incremented (conservative update)
+    unsigned int estimate = 255;
+    for(int i=0; i < DEPTH; i++) estimate = std::min(estimate,(unsigned int)Counters[indexes[i]]);
+    if( estimate < 255 ) {
+        for(int i=0; i < DEPTH; i++){
+            if( Counters[indexes[i]] == estimate ) Counters[indexes[i]]++;
+        }
+        estimate++;
+    }
+
+    if( ++Additions >= SAMPLE_FACTOR*(Mask + 1) ) {
+        for(uint8_t& counter : Counters) counter >>= 1;
+        Additions /= 2;
+        Agings++;
+    }
+
+    return(estimate);
+}
+
+//------------------------------------------------------------------------------
+
+unsigned int CFrequencySketch::Estimate(const std::string& key) const
+{
+    if( Counters.empty() ) return(0);
+
+    size_t indexes[DEPTH];
+    GetIndexes(key,indexes);
+
+    unsigned int estimate = 255;
+    for(int i=0; i < DEPTH; i++) estimate = std::min(estimate,(unsigned int)Counters[indexes[i]]);
+    return(estimate);
+}
+
+//------------------------------------------------------------------------------
+
+void CFrequencySketch::Clear(void)
+{
+    std::fill(Counters.begin(),Counters.end(),0);
+    Additions = 0;
+    Agings++;
+}
+
+//------------------------------------------------------------------------------
+
+void CFrequencySketch::GetIndexes(const std::string& key,size_t* p_indexes) const
+{
+    // rows use independent mixes of one hash
+    uint64_t hash = std::hash<std::string>()(key);
+    static const uint64_t seeds[DEPTH] = {
+        0x9e3779b97f4a7c15ULL, 0xc2b2ae3d27d4eb4fULL,
+        0x165667b19e3779f9ULL, 0xd6e8feb86659fd93ULL
+    };
+    size_t width = Mask + 1;
+    for(int i=0; i < DEPTH; i++){
+        uint64_t h = (hash + seeds[i]) * seeds[(i + 1) % DEPTH];
+        h ^= h >> 32;
+        p_indexes[i] = i*width + (h & Mask);
+    }
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CFrequencySketch::IsEnabled(void) const
+{
+    return(Counters.empty() == false);
+}
+
+//------------------------------------------------------------------------------
+
+size_t CFrequencySketch::GetSize(void) const
+{
+    return(Counters.capacity());
+}
+
+//------------------------------------------------------------------------------
+
+uint64_t CFrequencySketch::GetNumOfAgings(void) const
+{
+    return(Agings);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
@@ -0,0 +1,81 @@
+#ifndef FrequencySketchH
+#define FrequencySketchH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+
+/// count-min sketch estimating how often keys were requested
+/// counters saturate at 255 and all are halved periodically, thus the estimate
+/// follows recent traffic, the object is not thread-safe
+
+class CFrequencySketch {
+public:
+    CFrequencySketch(void);
+
+// setup methods ---------------------------------------------------------------
+    /// set number of counters per row, it is rounded up to power of two
+    /// zero - the sketch is disabled
+    void SetWidth(size_t width);
+
+// main methods ----------------------------------------------------------------
+    /// count key occurrence and return its new estimate
+    unsigned int Increment(const std::string& key);
+
+    /// estimate number of key occurrences
+    unsigned int Estimate(const std::string& key) const;
+
+    /// forget all counts
+    void Clear(void);
+
+// information methods ---------------------------------------------------------
+    /// is the sketch enabled
+    bool IsEnabled(void) const;
+
+    /// number of bytes used by the sketch
+    size_t GetSize(void) const;
+
+    /// number of counter halvings, estimates obtained before it are stale
+    uint64_t GetNumOfAgings(void) const;
+
+// section of private data -----------------------------------------------------
+private:
+    enum {
+        DEPTH = 4
+    };
+
+    std::vector<uint8_t>    Counters;   // DEPTH rows
+    size_t                  Mask;       // width - 1
+    size_t                  Additions;  // since the last halving
+    uint64_t                Agings;     // number of halvings
+
+    /// get counter positions of key
+    void GetIndexes(const std::string& key,size_t* p_indexes) const;
+};
+
+//------------------------------------------------------------------------------
+
+#endif
@@ -21,18 +21,21 @@
 // =============================================================================
 
 #include "ISoftRepoServer.hpp"
+#include "RequestArena.hpp"
 #include <FCGIRequest.hpp>
 #include <ErrorSystem.hpp>
+#include <ModUtils.hpp>
 #include <SmallTimeAndDate.hpp>
 #include <signal.h>
 #include <XMLElement.hpp>
-#include <XMLParser.hpp>
 #include <TemplatePreprocessor.hpp>
-#include <TemplateCache.hpp>
 #include <Template.hpp>
 #include <XMLPrinter.hpp>
 #include <XMLText.hpp>
 #include <boost/algorithm/string/replace.hpp>
+#include <stdio.h>
+#include <errno.h>
+#include <sstream>
 
 using namespace std;
 
@@ -42,7 +45,8 @@ using namespace std;
 
 CISoftRepoServer ISoftRepoServer;
 
-MAIN_ENTRY_OBJECT(ISoftRepoServer)
+// snapshot used by handlers instead of the current one, see PrewarmPages
+static thread_local const CCatalogSnapshotPtr* PinnedSnapshot = NULL;
 
 //==============================================================================
 //------------------------------------------------------------------------------
@@ -50,6 +54,13 @@ MAIN_ENTRY_OBJECT(ISoftRepoServer)
 
 CISoftRepoServer::CISoftRepoServer(void)
 {
+    UnixSocket = false;
+    StartupStart = 0;
+    StartupPhase = 0;
+    Reloader.SetServer(this);
+    Log.SetConsole(&vout);
+    TemplateWatcher.SetServer(this);
+    Prewarmer.SetServer(this);
 }
 
 //==============================================================================
@@ -64,6 +75,10 @@ int CISoftRepoServer::Init(int argc,char* argv[])
     // should we exit or was it error?
     if( result != SO_CONTINUE ) return(result);
 
+    StartupStart = GetMonotonicTime();
+    StartupPhase = StartupStart;
+    Notifier.Init();
+
     // attach verbose stream to terminal stream and set desired verbosity level
     vout.Attach(Console);
     if( Options.GetOptVerbose() ) {
@@ -82,7 +97,20 @@ int CISoftRepoServer::Init(int argc,char* argv[])
     vout << "# ==============================================================================" << endl;
 
     // load server config
-    if( LoadConfig() == false ) return(SO_USER_ERROR);
+    CServerConfigPtr config;
+    if( LoadConfig(Options.GetArgConfigFile(),config,vout) == false ) return(SO_USER_ERROR);
+    EndStartupPhase("config");
+
+    Watcher.ProcessWatcherControl(vout,config->WatcherControl);
+    vout << "# Slow request threshold = " << config->SlowRequestThreshold << " ms" << endl;
+    vout << "#" << endl;
+
+    CTemplateSetPtr templates;
+    if( LoadTemplates(config->TemplatePath,templates,vout) == false ) return(SO_USER_ERROR);
+    EndStartupPhase("templates");
+
+    ApplyConfig(config,templates,PrepareSites(config));
+    EndStartupPhase("sites");
 
     return(SO_CONTINUE);
 }
@@ -97,21 +125,99 @@ bool CISoftRepoServer::Run(void)
     signal(SIGINT,CtrlCSignalHandler);
     signal(SIGTERM,CtrlCSignalHandler);
 
-    SetPort(GetPortNumber());
+    // reload
+    signal(SIGHUP,HupSignalHandler);
+
+    CServerConfigPtr config = GetConfig();
+    UnixSocket = config->SocketPath != NULL;
 
     // start servers
+    Log.StartThread(); // asynchronous log
     Watcher.StartThread(); // watcher
-    if( StartServer() == false ) { // and fcgi server
+
+    // the first requests must not pay for the catalog build
+    if( PrepareCatalogs() == false ) {
+        Notifier.NotifyFailure("Catalogs are not available",EIO);
+        Watcher.TerminateThread();
+        Watcher.WaitForThread();
+        Log.TerminateThread();
+        Log.WaitForThread();
         return(false);
     }
+    EndStartupPhase("catalog");
+
+    Reloader.StartThread(); // config reloader
+    Prewarmer.StartThread(); // page cache prewarming
+    TemplateWatcher.SetEnabled(config->TemplateHotReload);
+    TemplateWatcher.StartThread(); // template hot reload, it can be enabled by reload
+    if( UnixSocket ) { // and fcgi server on unix socket
+        if( Listener.Open(config->SocketPath,config->SocketMode,config->SocketGroup) == false ) {
+            Notifier.NotifyFailure("Unable to open socket",EADDRINUSE);
+            return(false);
+        }
+        Metrics.SetConfiguredWorkers(config->NumOfWorkers);
+        if( Listener.StartWorkers(this,config->NumOfWorkers,config->KeepAliveTimeout*1000) == false ) {
+            Listener.Close();
+            Notifier.NotifyFailure("Unable to start workers",EAGAIN);
+            return(false);
+        }
+        // keepalives stop when the dispatcher or all workers are stuck, idle
+        // threads wake up every second
+        uint64_t max_age = Notifier.GetWatchdogInterval() / 1000;
+        if( max_age < 2000 ) max_age = 2000;
+        Notifier.SetHealthCheck([this,max_age]{ return(Listener.IsResponsive(max_age)); });
+    } else { // or on TCP port
+        // requests are accepted by the single server thread
+        Metrics.SetConfiguredWorkers(1);
+        SetPort(config->PortNumber);
+        if( StartServer() == false ) {
+            Notifier.NotifyFailure("Unable to start server",EADDRINUSE);
+            return(false);
+        }
+    }
+    EndStartupPhase("listen");
+
+    // templates are compiled and catalogs are built, the server is ready
+    uint64_t total = (GetMonotonicTime() - StartupStart) / 1000;
+    std::string record = StartupTimes + " total=" + std::to_string(total);
+    // the log thread owns vout from now on
+    PrintToConsole("# Startup times [ms]: " + record + "\n");
+    WriteWatcherLog(CSmallString("startup ") + record.c_str());
+
+    std::string state = "READY=1\nSTATUS=Serving, started in " + std::to_string(total) + " ms";
+    Notifier.Notify(state.c_str());
+    Notifier.StartThread(); // watchdog keepalive
+
+    PrintToConsole("Waiting for server termination ...\n");
+    if( UnixSocket ) {
+        Listener.WaitForTermination();
+        Notifier.Notify("STOPPING=1");
+        Listener.Close();
+    } else {
+        WaitForServer();
+        Notifier.Notify("STOPPING=1");
+    }
 
-    vout << low;
-    vout << "Waiting for server termination ..." << endl;
-    WaitForServer();
+    Notifier.RequestTermination();
+    Notifier.TerminateThread();
+    Notifier.WaitForThread();
+
+    TemplateWatcher.TerminateThread();
+    TemplateWatcher.WaitForThread();
+
+    Reloader.TerminateThread();
+    Reloader.WaitForThread();
+
+    Prewarmer.TerminateThread();
+    Prewarmer.WaitForThread();
 
     Watcher.TerminateThread();
     Watcher.WaitForThread();
 
+    // pending records are written before the thread exits
+    Log.TerminateThread();
+    Log.WaitForThread();
+
     return(true);
 }
 
@@ -129,6 +235,11 @@ void CISoftRepoServer::Finalize(void)
     vout << "# isoftrepo.fcgi (AMS utility) terminated at " << dt.GetSDateAndTime() << endl;
     vout << "# ==============================================================================" << endl;
 
+    if( Options.GetOptVerbose() ){
+        vout << low;
+        PhaseStatistics.PrintStatistics(vout);
+    }
+
     if( ErrorSystem.IsError() || Options.GetOptVerbose() ){
         vout << low;
         ErrorSystem.PrintErrors(vout);
@@ -147,6 +258,13 @@ bool CISoftRepoServer::AcceptRequest(void)
 
     CFCGIRequest request;
 
+    // the accepting thread serves requests as the worker
+    static thread_local bool worker = false;
+    if( worker == false ) {
+        worker = true;
+        Metrics.StartWorker();
+    }
+
     // accept request
     if( request.AcceptRequest(this) == false ) {
         ES_ERROR("unable to accept request");
@@ -154,56 +272,372 @@ bool CISoftRepoServer::AcceptRequest(void)
         return(false);
     }
 
+    CFCGIRequestWriter response(request);
+    CAdmissionTicket   ticket;
+    std::string        reply;
+
+    if( AdmitRequest(request,ticket,reply) == false ) {
+        response.Write(reply.c_str(),reply.size());
+        response.Finish();
+        return(true);
+    }
+
+    ServeRequest(request,response,ticket);
+
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CISoftRepoServer::AdmitRequest(CFCGIRequest& request,CAdmissionTicket& ticket,
+                                    std::string& reply)
+{
     request.Params.LoadParamsFromQuery();
 
-    // write document
-    request.OutStream.PutStr("Content-type: text/html\r\n");
-    request.OutStream.PutStr("\r\n");
+    CSmallString     action = request.Params.GetValue("action");
+    CServerConfigPtr config = GetConfig();
+
+    // metrics ---------------------------------
+    // they must be available when the server is overloaded
+    if( (action == "metrics") && config->MetricsEnabled ) return(true);
+
+    // rate limiting ---------------------------
+    // throttled clients do not take admission slots from the others
+    double cost = config->RateCosts[CServerMetrics::GetAction(action)];
+    if( RateLimiter.Admit(request.Params.GetValue("REMOTE_ADDR"),cost) == false ) {
+        reply = config->ThrottledResponse;
+        return(false);
+    }
+
+    // admission control -----------------------
+    // requests above the capacity are answered before they occupy a worker
+    if( Admission.Reserve() == false ) {
+        reply = config->OverloadedResponse;
+        return(false);
+    }
+
+    ticket.Reserved = true;
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+void CISoftRepoServer::CancelRequest(CAdmissionTicket& ticket)
+{
+    if( ticket.Reserved == false ) return;
+    Admission.Release();
+    ticket.Reserved = false;
+}
+
+//------------------------------------------------------------------------------
+
+void CISoftRepoServer::ServeRequest(CFCGIRequest& request,CResponseWriter& response,
+                                    const CAdmissionTicket& ticket)
+{
+    CRequestTimer timer(ticket.Arrival);
+    Metrics.BeginRequest();
 
     // get request id
     CSmallString action;
     action = request.Params.GetValue("action");
 
+    uint64_t start = GetMonotonicTime();
+    bool result = DispatchRequest(request,response,action,ticket);
+    timer.Finish(GetMonotonicTime() - start);
+
+    Metrics.EndRequest(CServerMetrics::GetAction(action),result == false,timer.GetTotalTime());
+    ReportRequestTiming(request,action,timer);
+
+    // the request is finished, release its temporaries at once
+    CRequestArena::GetThreadArena().Reset();
+}
+
+//------------------------------------------------------------------------------
+
+bool CISoftRepoServer::DispatchRequest(CFCGIRequest& request,CResponseWriter& response,
+                                       const CSmallString& action,const CAdmissionTicket& ticket)
+{
+    // metrics ---------------------------------
+    // only they are admitted without reservation
+    if( ticket.Reserved == false ) {
+        if( _Metrics(request,response) == true ) return(true);
+        return(ProcessRequest(request,response,action,0));
+    }
+
+    // admission control -----------------------
+    // the deadline is counted from the arrival, thus time in queues counts too
+    if( Admission.Enter(ticket.Arrival) != EAD_ADMITTED ) {
+        WriteOverloaded(response);
+        return(false);
+    }
+
+    bool result = ProcessRequest(request,response,action,ticket.Arrival);
+
+    Admission.Leave();
+
+    return(result);
+}
+
+//------------------------------------------------------------------------------
+
+void CISoftRepoServer::WriteOverloaded(CResponseWriter& response)
+{
+    CServerConfigPtr config = GetConfig();
+    response.Write(config->OverloadedResponse.c_str(),config->OverloadedResponse.size());
+    response.Finish();
+}
+
+//------------------------------------------------------------------------------
+
+bool CISoftRepoServer::ProcessRequest(CFCGIRequest& request,CResponseWriter& response,
+                                      const CSmallString& action,uint64_t arrival)
+{
+    bool result = false;
+
+    // bulk export -----------------------------
+    if( action == "export" ) {
+        if( (arrival > 0) && (Admission.CheckDeadline(arrival) == false) ) {
+            WriteOverloaded(response);
+            return(false);
+        }
+        result = _Export(request,response);
+        if( result == true ) return(true);
+        // headers were not sent yet, report error page
+    }
+
+    // pages ---------------------------------
+    CPagePtr page;
+
+    CRepoSitePtr        site = FindSite(request);
+    CCatalogSnapshotPtr snapshot;
+    if( site ) snapshot = site->Catalog.GetSnapshot();
+
+    // the snapshot can take long, rendering for a client that gave up is useless
+    if( (arrival > 0) && (Admission.CheckDeadline(arrival) == false) ) {
+        WriteOverloaded(response);
+        return(false);
+    }
+
+    if( snapshot ) {
+        std::string key;
+        GetPageKey(request,action,key);
+        if( key.empty() == false ) {
+            result = site->PageCache.GetPage(key,snapshot->Generation,
+                                       [&](std::string& output){ return(RenderPage(request,action,output)); },
+                                       page);
+        }
+    } else {
+        ES_ERROR("catalog is not available");
+    }
+
+    // error handle -----------------------
+    // clients and load generators see the failure in the status
+    const char* p_status = NULL;
+    if( result == false ) {
+        ES_ERROR("error");
+        p_status = GetErrorStatus(request,action,snapshot);
+        std::string* p_error = new std::string;
+        page.reset(p_error);
+        if( _Error(request,*p_error) == false ) {
+            response.Write(p_status);
+            response.Write("Content-type: text/html\r\n");
+            response.Write("\r\n");
+            response.Finish(); // at least try to finish request
+            return(false);
+        }
+    }
+
+    // write document
+    {
+        CPhaseTimer phase(ERP_WRITE);
+        if( p_status != NULL ) {
+            response.Write(p_status);
+            response.Write("Cache-Control: no-store\r\n");
+        }
+        response.Write("Content-type: text/html\r\n");
+        response.Write("\r\n");
+        response.Write(page->c_str(),page->size());
+        response.Finish();
+    }
+
+    return(result);
+}
+
+//------------------------------------------------------------------------------
+
+bool CISoftRepoServer::RenderPage(CFCGIRequest& request,const CSmallString& action,
+                                  std::string& page)
+{
     bool result = false;
 
     // list categories -----------------------------
     if( (action == NULL) || (action == "categories") ) {
-        result = _ListCategories(request);
+        result = _ListCategories(request,page);
     }
 
     // module info -----------------------------
     if( action == "module" ) {
-        result = _Module(request);
+        result = _Module(request,page);
+    }
+
+    // other module versions -----------------------------
+    if( action == "versions" ) {
+        result = _ModuleVersions(request,page);
     }
 
     // versions info -----------------------------
     if( action == "version" ) {
-        result = _Version(request);
+        result = _Version(request,page);
     }
 
     // build -----------------------------
     if( action == "build" ) {
-        result = _Build(request);
+        result = _Build(request,page);
     }
 
-    // error handle -----------------------
-    if( result == false ) {
-        ES_ERROR("error");
-        result = _Error(request);
+    return(result);
+}
+
+//------------------------------------------------------------------------------
+
+void CISoftRepoServer::GetPageKey(CFCGIRequest& request,const CSmallString& action,
+                                  std::string& key)
+{
+    key.clear();
+
+    // only parameters used by page handlers are part of the key
+    if( (action == NULL) || (action == "categories") ) {
+        key = "categories";
+    } else if( (action == "module") || (action == "version") || (action == "build")
+               || (action == "versions") ) {
+        key = (const char*)action;
+    } else {
+        return;
     }
-    if( result == false ) request.FinishRequest(); // at least try to finish request
+
+    // pages contain SERVERSCRIPTURI
+    key += '\n';
+    key += (const char*)request.Params.GetValue("SERVER_PORT");
+    key += '\n';
+    key += (const char*)request.Params.GetValue("SERVER_NAME");
+    key += '\n';
+    key += (const char*)request.Params.GetValue("SCRIPT_NAME");
+    key += '\n';
+    key += (const char*)request.Params.GetValue("module");
+    key += '\n';
+    key += (const char*)request.Params.GetValue("include_vers");
+    key += '\n';
+    key += (const char*)request.Params.GetValue("offset");
+    key += '\n';
+    key += (const char*)request.Params.GetValue("limit");
+
+    // filters in the canonical form, thus the order of values does not matter
+    CCatalogFilter filter;
+    filter.SetFilter(request.Params.GetValue("arch"),request.Params.GetValue("mode"),
+                     request.Params.GetValue("bundle"),request.Params.GetValue("acl"));
+    key += '\n';
+    filter.AppendKey(key);
+
+    // pages of replaced templates are never hit again
+    key += '\n';
+    key += std::to_string(GetTemplates()->GetGeneration());
+}
+
+//------------------------------------------------------------------------------
+
+const char* CISoftRepoServer::GetErrorStatus(CFCGIRequest& request,const CSmallString& action,
+                                             const CCatalogSnapshotPtr& snapshot)
+{
+    if( FindSite(request) == NULL ) return("Status: 404 Not Found\r\n");
+    if( snapshot == NULL ) return("Status: 503 Service Unavailable\r\n");
+
+    // requests for missing records, the page could also fail for them
+    // in a coalesced render, thus it is decided here and not by the handler
+    CSmallString module_name,module_ver,module_arch,module_mode;
+    CModUtils::ParseModuleName(request.Params.GetValue("module"),module_name,module_ver,
+                               module_arch,module_mode);
+
+    bool     not_found = false;
+    uint32_t module,build;
+    if( (action == "module") || (action == "version") || (action == "versions") ) {
+        not_found = snapshot->Table.FindModule(module_name,module) == false;
+    } else if( action == "build" ) {
+        not_found = (snapshot->Table.FindModule(module_name,module) == false)
+                    || (snapshot->Table.FindBuild(module,module_ver,module_arch,module_mode,build) == false);
+    } else if( (action != NULL) && (action != "categories") && (action != "export") ) {
+        not_found = true;   // unknown action
+    }
+
+    if( not_found ) return("Status: 404 Not Found\r\n");
+    return("Status: 500 Internal Server Error\r\n");
+}
+
+//------------------------------------------------------------------------------
+
+bool CISoftRepoServer::SetupPageRequest(const std::string& key,const CRepoSite& site,
+                                        CFCGIRequest& request,CSmallString& action)
+{
+    // fields in the order of GetPageKey
+    std::vector<std::string> fields;
+    std::string::size_type pos = 0;
+    for(;;){
+        std::string::size_type end = key.find('\n',pos);
+        fields.push_back(key.substr(pos,end == std::string::npos ? end : end - pos));
+        if( end == std::string::npos ) break;
+        pos = end + 1;
+    }
+    if( fields.size() != 13 ) return(false);
+    if( fields[12] != std::to_string(GetTemplates()->GetGeneration()) ) return(false);
+
+    action = fields[0].c_str();
+    request.Params.SetValue("action",action);
+    request.Params.SetValue("site",site.Name);
+    request.Params.SetValue("SERVER_PORT",fields[1].c_str());
+    request.Params.SetValue("SERVER_NAME",fields[2].c_str());
+    request.Params.SetValue("SCRIPT_NAME",fields[3].c_str());
+
+    const char* names[] = { "module", "include_vers", "offset", "limit", "arch", "mode", "bundle" };
+    for(int i=0; i < 7; i++){
+        if( fields[4+i].empty() == false ) request.Params.SetValue(names[i],fields[4+i].c_str());
+    }
+    if( fields[11] == "1" ) request.Params.SetValue("acl","true");
+    if( fields[11] == "0" ) request.Params.SetValue("acl","false");
 
     return(true);
 }
 
 //------------------------------------------------------------------------------
 
-bool CISoftRepoServer::ProcessTemplate(CFCGIRequest& request,
-                                       const CSmallString& template_name,
-                                       CTemplateParams& template_params)
+void CISoftRepoServer::PrewarmPages(CRepoSite& site,const CCatalogSnapshotPtr& snapshot,
+                                    const std::atomic<bool>& cancelled)
+{
+    std::vector<std::string> keys;
+    site.PageCache.GetHotKeys(keys);
+
+    PinnedSnapshot = &snapshot;
+    for(const std::string& key : keys){
+        if( cancelled ) break;
+
+        CFCGIRequest request;
+        CSmallString action;
+        if( SetupPageRequest(key,site,request,action) == false ) continue;
+
+        site.PageCache.PrewarmPage(key,snapshot->Generation,
+                                   [&](std::string& output){ return(RenderPage(request,action,output)); });
+        CRequestArena::GetThreadArena().Reset();
+    }
+    PinnedSnapshot = NULL;
+}
+
+bool CISoftRepoServer::ProcessTemplate(const CSmallString& template_name,
+                                       CTemplateParams& template_params,
+                                       std::string& page,
+                                       const CPageFragments* p_fragments)
 {
     // template --------------------------------------------------------
-    CTemplate* p_tmp = TemplateCache.OpenTemplate(template_name);
+    // the set owns the template
+    CTemplateSetPtr templates = GetTemplates();
+    CTemplate* p_tmp = templates->FindTemplate(template_name);
 
     if( p_tmp == NULL ) {
         ES_ERROR("unable to open template");
@@ -217,9 +651,12 @@ bool CISoftRepoServer::ProcessTemplate(CFCGIRequest& request,
     preprocessor.SetInputTemplate(p_tmp);
     preprocessor.SetOutputDocument(&output_xml);
 
-    if( preprocessor.PreprocessTemplate(&template_params) == false ) {
-        ES_ERROR("unable to preprocess template");
-        return(false);
+    {
+        CPhaseTimer phase(ERP_PREPROCESS);
+        if( preprocessor.PreprocessTemplate(&template_params) == false ) {
+            ES_ERROR("unable to preprocess template");
+            return(false);
+        }
     }
 
     // print output ----------------------------------------------------
@@ -231,17 +668,117 @@ bool CISoftRepoServer::ProcessTemplate(CFCGIRequest& request,
     unsigned char* p_data;
     unsigned int   len = 0;
 
-    if( (p_data = xml_printer.Print(len)) == NULL ) {
-        ES_ERROR("unable to print output");
-        return(false);
+    {
+        CPhaseTimer phase(ERP_PRINT);
+        if( (p_data = xml_printer.Print(len)) == NULL ) {
+            ES_ERROR("unable to print output");
+            return(false);
+        }
     }
 
-    request.OutStream.PutStr((const char*)p_data,len);
-
+    page.assign((const char*)p_data,len);
     delete[] p_data;
 
-    request.FinishRequest();
+    if( p_fragments != NULL ) p_fragments->Splice(page);
+
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CISoftRepoServer::ProcessFragmentTemplate(const CSmallString& template_name,
+                                               CTemplateParams& template_params,
+                                               std::string& output)
+{
+    if( ProcessTemplate(template_name,template_params,output) == false ) return(false);
+
+    // the fragment is spliced into a page, which has its own declaration
+    if( output.compare(0,5,"<?xml") == 0 ) {
+        size_t end = output.find("?>");
+        if( end == std::string::npos ) {
+            ES_ERROR("fragment has malformed XML declaration");
+            return(false);
+        }
+        end = output.find_first_not_of(" \t\r\n",end + 2);
+        output.erase(0,end);
+    }
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CISoftRepoServer::GetFragment(CFCGIRequest& request,const CRepoSitePtr& site,
+                                   const std::string& name,uint64_t stamp,
+                                   const TPageRenderer& renderer,CFragmentPtr& fragment)
+{
+    if( site == NULL ) {
+        std::shared_ptr<std::string> output(new std::string);
+        if( renderer(*output) == false ) return(false);
+        fragment = output;
+        return(true);
+    }
+
+    // fragments contain links with SERVERSCRIPTURI
+    CTemplateSetPtr templates = GetTemplates();
+    std::string key;
+    key.reserve(name.size() + 128);
+    key = name;
+    key += '\n';
+    key += (const char*)request.Params.GetValue("SERVER_PORT");
+    key += '\n';
+    key += (const char*)request.Params.GetValue("SERVER_NAME");
+    key += '\n';
+    key += (const char*)request.Params.GetValue("SCRIPT_NAME");
+    key += '\n';
+    key += std::to_string(templates->GetGeneration());
+
+    return(site->FragmentCache.GetFragment(key,stamp,renderer,fragment));
+}
+
+//------------------------------------------------------------------------------
+
+uint64_t CISoftRepoServer::GetDependenciesStamp(CXMLElement* p_deps)
+{
+    // FNV-1a over names and types, the separator keeps boundaries
+    uint64_t stamp = 14695981039346656037ULL;
+    CXMLElement* p_dep = p_deps ? p_deps->GetFirstChildElement("dep") : NULL;
+    while( p_dep != NULL ){
+        CSmallString name,type;
+        p_dep->GetAttribute("name",name);
+        p_dep->GetAttribute("type",type);
+        CSmallString item = name + "\n" + type + "\n";
+        for(const unsigned char* p = (const unsigned char*)(const char*)item; *p != '\0'; p++){
+            stamp ^= *p;
+            stamp *= 1099511628211ULL;
+        }
+        p_dep = p_dep->GetNextSiblingElement("dep");
+    }
+    return(stamp);
+}
+
+//------------------------------------------------------------------------------
 
+bool CISoftRepoServer::SetMonitoringBlock(CFCGIRequest& request,CTemplateParams& template_params,
+                                          CPageFragments& fragments)
+{
+    // config reload always compiles new templates, thus the template
+    // generation in the key also follows the monitoring config
+    CServerConfigPtr config = GetConfig();
+    CFragmentPtr     fragment;
+    bool result = GetFragment(request,FindSite(request),"monitoring",0,[&](std::string& output){
+        CTemplateParams params;
+        params.Initialize();
+        params.Include("MONITORING",config->MonitoringIFrame);
+        ProcessCommonParams(request,params);
+        if( params.Finalize() == false ) {
+            ES_ERROR("unable to prepare parameters");
+            return(false);
+        }
+        return(ProcessFragmentTemplate("Monitoring.html",params,output));
+    },fragment);
+    if( result == false ) return(false);
+
+    template_params.SetParam("MONITORINGBLOCK",fragments.AddFragment(fragment));
     return(true);
 }
 
@@ -276,138 +813,440 @@ bool CISoftRepoServer::ProcessCommonParams(CFCGIRequest& request,
 //------------------------------------------------------------------------------
 //==============================================================================
 
+void CISoftRepoServer::ReportRequestTiming(CFCGIRequest& request,
+                                           const CSmallString& action,
+                                           const CRequestTimer& timer)
+{
+    // slow requests into the watcher log
+    int threshold = GetConfig()->SlowRequestThreshold;
+    if( (threshold > 0) && (timer.GetTotalTime() >= (uint64_t)threshold * 1000) ) {
+        WriteWatcherLog(timer.GetRecord(action,request.Params.GetValue("module")));
+    }
+
+    // rolling percentiles
+    if( Options.GetOptVerbose() ) {
+        if( PhaseStatistics.AddSample(timer) ) {
+            std::ostringstream str;
+            PhaseStatistics.PrintStatistics(str);
+            Log.Push(ELT_CONSOLE,str.str());
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CISoftRepoServer::WriteWatcherLog(const CSmallString& record)
+{
+    // formatted and written by the log thread
+    Log.Push(ELT_WATCHER,record,record.GetLength());
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
 void CISoftRepoServer::CtrlCSignalHandler(int signal)
 {
     ISoftRepoServer.vout << endl << endl;
     ISoftRepoServer.vout << "SIGINT or SIGTERM signal recieved. Initiating server shutdown!" << endl;
     ISoftRepoServer.vout << "Waiting for server finalization ... " << endl;
-    ISoftRepoServer.TerminateServer();
+    if( ISoftRepoServer.UnixSocket ) {
+        ISoftRepoServer.Listener.RequestTermination();
+    } else {
+        ISoftRepoServer.TerminateServer();
+    }
     if( ! ISoftRepoServer.Options.GetOptVerbose() ) ISoftRepoServer.vout << endl;
 }
 
+//------------------------------------------------------------------------------
+
+void CISoftRepoServer::HupSignalHandler(int signal)
+{
+    // reload is done by the reloader thread
+    ISoftRepoServer.Reloader.RequestReload();
+}
+
 //==============================================================================
 //------------------------------------------------------------------------------
 //==============================================================================
 
-bool CISoftRepoServer::LoadConfig(void)
+bool CISoftRepoServer::LoadConfig(const CFileName& config_path,CServerConfigPtr& config,CVerboseStr& out)
 {
-    CFileName config_path =  Options.GetArgConfigFile();
-
-    CXMLParser xml_parser;
-    xml_parser.SetOutputXMLNode(&ServerConfig);
-    xml_parser.EnableWhiteCharacters(true);
+    CServerConfig* p_config = new CServerConfig;
+    config.reset(p_config);
 
-    if( xml_parser.Parse(config_path) == false ) {
-        CSmallString error;
-        error << "unable to load server config";
-        ES_ERROR(error);
+    if( p_config->Load(config_path) == false ) {
+        config.reset();
         return(false);
     }
 
-    CFileName temp_dir = GetTemplatePath();
-    TemplateCache.SetTemplatePath(temp_dir);
+    p_config->PrintConfig(out);
 
-    vout << "#" << endl;
-    vout << "# === [server] =================================================================" << endl;
-    vout << "# FCGI Port  = " << GetPortNumber() << endl;
-    vout << "# Templates  = " << temp_dir << endl;
-    vout << "#" << endl;
+    return(true);
+}
 
-    BundleName = GetBundleName();
-    BundlePath = GetBundlePath();
+//------------------------------------------------------------------------------
 
-    vout << "#" << endl;
-    vout << "# === [ams-bundles] ============================================================" << endl;
-    vout << "# Name      = " << BundleName << endl;
-    vout << "# Path      = " << BundlePath << endl;
-    vout << "#" << endl;
+bool CISoftRepoServer::LoadTemplates(const CFileName& template_path,CTemplateSetPtr& templates,
+                                     CVerboseStr& out)
+{
+    CTemplateSet* p_templates = new CTemplateSet;
+    templates.reset(p_templates);
 
-    CXMLElement* p_watcher = ServerConfig.GetChildElementByPath("config/watcher");
-    Watcher.ProcessWatcherControl(vout,p_watcher);
-    vout << "#" << endl;
+    if( p_templates->Load(template_path) == false ) {
+        templates.reset();
+        return(false);
+    }
+
+    out << "# Compiled templates = " << p_templates->GetNumOfTemplates() << endl;
+    out << "#" << endl;
 
     return(true);
 }
 
-//==============================================================================
 //------------------------------------------------------------------------------
-//==============================================================================
 
-int CISoftRepoServer::GetPortNumber(void)
+CRepoSitesPtr CISoftRepoServer::PrepareSites(const CServerConfigPtr& config)
 {
-    int setup = 32696;
-    CXMLElement* p_ele = ServerConfig.GetChildElementByPath("config/server");
-    if( p_ele == NULL ) {
-        ES_ERROR("unable to open config path");
-        return(setup);
+    CRepoSitesPtr old_sites = GetSites();
+    CRepoSites*   p_sites = new CRepoSites;
+    CRepoSitesPtr sites(p_sites);
+
+    for(const CSiteConfig& site_config : config->Sites){
+        // kept sites keep their catalogs and page caches
+        CRepoSitePtr site;
+        if( old_sites ) site = old_sites->FindSite(site_config.Name);
+        if( site == NULL ) {
+            site.reset(new CRepoSite(site_config.Name));
+            site->Catalog.SetBundles(site_config.BundleName,site_config.BundlePath);
+            // the site owns the catalog, thus it outlives the prewarmer calls
+            CRepoSite* p_site = site.get();
+            site->Catalog.SetPrewarmer([this,p_site](const CCatalogSnapshotPtr& snapshot){
+                CServerConfigPtr config = GetConfig();
+                if( config->PageCacheHotKeys == 0 ) return;
+                Prewarmer.Prewarm(p_site,snapshot,config->PrewarmTimeout);
+            });
+        }
+        p_sites->AddSite(site,site_config.ScriptName);
     }
-    if( p_ele->GetAttribute("port",setup) == false ) {
-        ES_ERROR("unable to get port value");
-        return(setup);
+
+    return(sites);
+}
+
+//------------------------------------------------------------------------------
+
+bool CISoftRepoServer::PrepareCatalogs(void)
+{
+    bool result = true;
+    CRepoSitesPtr sites = GetSites();
+    for(const CRepoSitePtr& site : sites->GetSites()){
+        uint64_t start = GetMonotonicTime();
+        if( site->Catalog.GetSnapshot() == NULL ) {
+            vout << "# Catalog of site '" << site->Name << "' is not available" << endl;
+            CSmallString error;
+            error << "unable to build catalog of site '" << site->Name << "'";
+            ES_ERROR(error);
+            result = false;
+            continue;
+        }
+        vout << "# Catalog of site '" << site->Name << "' is ready in "
+             << (GetMonotonicTime() - start) / 1000 << " ms" << endl;
     }
-    return(setup);
+    vout << "#" << endl;
+    return(result);
 }
 
 //------------------------------------------------------------------------------
 
-const CFileName CISoftRepoServer::GetTemplatePath(void)
+void CISoftRepoServer::EndStartupPhase(const char* p_name)
 {
-    CFileName temp_dir = "/opt/ams-isoftrepo/9.0/var/html/isoftrepo/templates";
+    uint64_t now = GetMonotonicTime();
+    if( StartupTimes.empty() == false ) StartupTimes += " ";
+    StartupTimes += std::string(p_name) + "=" + std::to_string((now - StartupPhase) / 1000);
+    StartupPhase = now;
+}
 
-    CXMLElement* p_ele = ServerConfig.GetChildElementByPath("config/server");
-    if( p_ele == NULL ) {
-        ES_ERROR("unable to open config path");
-        return(temp_dir);
+//------------------------------------------------------------------------------
+
+void CISoftRepoServer::ApplyConfig(const CServerConfigPtr& config,
+                                   const CTemplateSetPtr& templates,
+                                   const CRepoSitesPtr& sites)
+{
+    Admission.SetLimits(config->AdmissionSlots,config->AdmissionQueueDepth,
+                        config->AdmissionDeadline);
+    RateLimiter.SetLimits(config->RateLimit,config->RateBurst,config->RateClients,
+                          config->RateIdleTimeout);
+
+    for(size_t i=0; i < config->Sites.size(); i++){
+        const CSiteConfig&  site_config = config->Sites[i];
+        const CRepoSitePtr& site = sites->GetSites()[i];
+        site->PageCache.SetCapacity(site_config.PageCacheSize);
+        site->PageCache.SetHotKeys(config->PageCacheHotKeys);
+        site->FragmentCache.SetCapacity(config->FragmentCacheSize);
+        site->Catalog.SetTimeToLive(config->CatalogTimeToLive);
+        site->Catalog.SetSharing(config->CatalogSharing,site_config.CatalogSegment);
     }
-    if( p_ele->GetAttribute("templates",temp_dir) == false ) {
-        ES_ERROR("unable to get templates values");
-        return(temp_dir);
+
+    Log.SetWatcherLogName(config->WatcherLogName);
+
+    std::atomic_store(&Templates,templates);
+    std::atomic_store(&Sites,sites);
+    std::atomic_store(&Config,config);
+}
+
+//------------------------------------------------------------------------------
+
+void CISoftRepoServer::ApplyThreadConfig(const CServerConfigPtr& config,CVerboseStr& out)
+{
+    // the watcher reads its control only when it starts
+    Watcher.TerminateThread();
+    Watcher.WaitForThread();
+    Watcher.ProcessWatcherControl(out,config->WatcherControl);
+    Watcher.StartThread();
+
+    TemplateWatcher.SetEnabled(config->TemplateHotReload);
+}
+
+//------------------------------------------------------------------------------
+
+void CISoftRepoServer::ReportRestartSettings(const CServerConfigPtr& old_config,
+                                             const CServerConfigPtr& config,CVerboseStr& out)
+{
+    // the listener is set up only at startup
+    std::string settings;
+    if( config->PortNumber != old_config->PortNumber ) settings += ",port";
+    if( config->SocketPath != old_config->SocketPath ) settings += ",socket";
+    if( config->NumOfWorkers != old_config->NumOfWorkers ) settings += ",workers";
+    if( config->KeepAliveTimeout != old_config->KeepAliveTimeout ) settings += ",keepalive";
+    if( settings.empty() ) return;
+
+    out << "# Changed settings require server restart, the previous ones are used: " << settings.substr(1) << endl;
+    WriteWatcherLog(CSmallString("config-reload restart-required=") + settings.substr(1).c_str());
+}
+
+//------------------------------------------------------------------------------
+
+CServerConfigPtr CISoftRepoServer::GetConfig(void)
+{
+    return(std::atomic_load(&Config));
+}
+
+//------------------------------------------------------------------------------
+
+CTemplateSetPtr CISoftRepoServer::GetTemplates(void)
+{
+    return(std::atomic_load(&Templates));
+}
+
+//------------------------------------------------------------------------------
+
+CRepoSitesPtr CISoftRepoServer::GetSites(void)
+{
+    return(std::atomic_load(&Sites));
+}
+
+//------------------------------------------------------------------------------
+
+CServerMetrics& CISoftRepoServer::GetMetrics(void)
+{
+    return(Metrics);
+}
+
+//------------------------------------------------------------------------------
+
+CRepoSitePtr CISoftRepoServer::FindSite(CFCGIRequest& request)
+{
+    CRepoSitesPtr sites = GetSites();
+
+    // explicit site parameter
+    CSmallString name = request.Params.GetValue("site");
+    if( name != NULL ) {
+        CRepoSitePtr site = sites->FindSite(name);
+        if( site == NULL ) {
+            CSmallString error;
+            error << "unknown site '" << name << "'";
+            ES_ERROR(error);
+        }
+        return(site);
     }
-    return(temp_dir);
+
+    // script mapped to the site
+    CRepoSitePtr site = sites->FindSiteByScript(request.Params.GetValue("SCRIPT_NAME"));
+    if( site ) return(site);
+
+    return(sites->GetDefaultSite());
+}
+
+//------------------------------------------------------------------------------
+
+CCatalogSnapshotPtr CISoftRepoServer::GetSnapshot(CFCGIRequest& request)
+{
+    // prewarmed pages are rendered from the snapshot that is not published yet
+    if( PinnedSnapshot != NULL ) return(*PinnedSnapshot);
+
+    CRepoSitePtr site = FindSite(request);
+    if( site == NULL ) return(CCatalogSnapshotPtr());
+    return(site->Catalog.GetSnapshot());
+}
+
+//------------------------------------------------------------------------------
+
+bool CISoftRepoServer::ReloadConfig(void)
+{
+    std::lock_guard<std::mutex> lock(ReloadLock);
+
+    std::stringstream   output;
+    CVerboseStr         out;
+    out.Attach(output);
+    out.Verbosity(Options.GetOptVerbose() ? CVerboseStr::high : CVerboseStr::low);
+
+    bool result = ReloadConfig(out);
+    PrintToConsole(output.str());
+    return(result);
 }
 
 //------------------------------------------------------------------------------
 
-const CSmallString CISoftRepoServer::GetBundleName(void)
+bool CISoftRepoServer::ReloadConfig(CVerboseStr& out)
 {
-    CSmallString name;
-    CXMLElement* p_ele = ServerConfig.GetChildElementByPath("config/ams");
-    if( p_ele == NULL ) {
-        ES_ERROR("unable to open config/ams path");
-        return(name);
+    CSmallTimeAndDate dt;
+    dt.GetActualTimeAndDate();
+
+    out << low;
+    out << endl;
+    out << "# ==============================================================================" << endl;
+    out << "# SIGHUP received at " << dt.GetSDateAndTime() << ", reloading configuration" << endl;
+    out << "# ==============================================================================" << endl;
+
+    CServerConfigPtr config;
+    if( LoadConfig(Options.GetArgConfigFile(),config,out) == false ) {
+        ES_ERROR("unable to reload server config, the previous one is kept");
+        WriteWatcherLog("config-reload status=failed reason=config");
+        return(false);
+    }
+
+    CTemplateSetPtr templates;
+    if( LoadTemplates(config->TemplatePath,templates,out) == false ) {
+        ES_ERROR("unable to compile templates for the reloaded config, the previous config is kept");
+        WriteWatcherLog("config-reload status=failed reason=templates");
+        return(false);
+    }
+
+    ReportRestartSettings(GetConfig(),config,out);
+
+    CRepoSitesPtr sites = PrepareSites(config);
+
+    if( config->CatalogSharing == ESCM_ATTACH ) {
+        // catalogs are built by the publisher, the next request maps them
+        for(size_t i=0; i < config->Sites.size(); i++){
+            const CSiteConfig& site_config = config->Sites[i];
+            sites->GetSites()[i]->Catalog.SetBundles(site_config.BundleName,site_config.BundlePath);
+        }
+        ApplyConfig(config,templates,sites);
+        ApplyThreadConfig(config,out);
+        out << "# Configuration reloaded, catalogs are attached to shared memory" << endl;
+        WriteWatcherLog("config-reload status=ok generation=shared");
+        return(true);
+    }
+
+    // requests are served from the previous catalogs until all new ones are ready
+    std::vector<CCatalogSnapshotPtr> snapshots;
+    for(const CSiteConfig& site_config : config->Sites){
+        CCatalogSnapshotPtr snapshot = CCatalog::BuildSnapshot(site_config.BundleName,site_config.BundlePath);
+        if( snapshot == NULL ) {
+            CSmallString error;
+            error << "unable to build catalog of site '" << site_config.Name << "' for the reloaded config, the previous one is kept";
+            ES_ERROR(error);
+            WriteWatcherLog("config-reload status=failed reason=catalog");
+            return(false);
+        }
+        snapshots.push_back(snapshot);
     }
-    if( p_ele->GetAttribute("name",name) == false ) {
-        ES_ERROR("unable to get name item");
-        return(name);
+
+    // swap, new generations also invalidate the page caches
+    CSmallString record;
+    record << "config-reload status=ok";
+    for(size_t i=0; i < config->Sites.size(); i++){
+        const CSiteConfig&  site_config = config->Sites[i];
+        const CRepoSitePtr& site = sites->GetSites()[i];
+        site->Catalog.SetSharing(config->CatalogSharing,site_config.CatalogSegment);
+        site->Catalog.PublishSnapshot(snapshots[i],site_config.BundleName,site_config.BundlePath);
+        out << "# Configuration reloaded, catalog of site '" << site->Name << "' generation " << snapshots[i]->Generation << endl;
+        record << " " << site->Name << "=" << std::to_string(snapshots[i]->Generation).c_str();
     }
-    return(name);
+    ApplyConfig(config,templates,sites);
+    ApplyThreadConfig(config,out);
+    WriteWatcherLog(record);
+
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CISoftRepoServer::ReloadTemplates(void)
+{
+    std::lock_guard<std::mutex> lock(ReloadLock);
+
+    std::stringstream   output;
+    CVerboseStr         out;
+    out.Attach(output);
+    out.Verbosity(Options.GetOptVerbose() ? CVerboseStr::high : CVerboseStr::low);
+
+    bool result = ReloadTemplates(out);
+    PrintToConsole(output.str());
+    return(result);
 }
 
 //------------------------------------------------------------------------------
 
-const CFileName CISoftRepoServer::GetBundlePath(void)
+bool CISoftRepoServer::ReloadTemplates(CVerboseStr& out)
 {
-    CSmallString path;
-    CXMLElement* p_ele = ServerConfig.GetChildElementByPath("config/ams");
-    if( p_ele == NULL ) {
-        ES_ERROR("unable to open config/ams path");
-        return(path);
+    CServerConfigPtr config = GetConfig();
+
+    out << low;
+    out << "# Template change detected, recompiling templates from " << config->TemplatePath << endl;
+
+    // broken template keeps the previous set
+    CTemplateSetPtr templates;
+    if( LoadTemplates(config->TemplatePath,templates,out) == false ) {
+        ES_ERROR("unable to recompile templates, the previous ones are kept");
+        WriteWatcherLog("template-reload status=failed");
+        return(false);
     }
-    if( p_ele->GetAttribute("path",path) == false ) {
-        ES_ERROR("unable to get path item");
-        return(path);
+
+    std::atomic_store(&Templates,templates);
+
+    // pages of the previous set are not reachable anymore
+    CRepoSitesPtr sites = GetSites();
+    for(const CRepoSitePtr& site : sites->GetSites()){
+        site->PageCache.Clear();
+        site->FragmentCache.Clear();
     }
-    return(path);
+
+    WriteWatcherLog("template-reload status=ok");
+
+    return(true);
 }
 
 //------------------------------------------------------------------------------
 
-CXMLElement* CISoftRepoServer::GetMonitoringIFrame(void)
+void CISoftRepoServer::PrintToConsole(const std::string& text)
 {
-    CXMLElement* p_ele = ServerConfig.GetChildElementByPath("config/monitoring",true);
-    return(p_ele);
+    // vout is written by the log thread, other threads must not touch it,
+    // lines are dropped when the log is full as other records are
+    Log.PushLines(ELT_NOTICE,text);
 }
 
-//==============================================================================
 //------------------------------------------------------------------------------
+
+void CISoftRepoServer::RefreshCatalog(void)
+{
+    // expired catalogs are rebuilt here rather than by requests, the publisher
+    // also keeps other processes up to date even without traffic
+    CRepoSitesPtr sites = GetSites();
+    for(const CRepoSitePtr& site : sites->GetSites()){
+        site->Catalog.Refresh();
+    }
+}
+
 //==============================================================================
@@ -30,6 +30,23 @@
 #include <VerboseStr.hpp>
 #include <TerminalStr.hpp>
 #include <ServerWatcher.hpp>
+#include "ServerMetrics.hpp"
+#include "RequestTimer.hpp"
+#include "RepoSite.hpp"
+#include "AdmissionControl.hpp"
+#include "RateLimiter.hpp"
+#include "ServerConfig.hpp"
+#include "ServerReloader.hpp"
+#include "TemplateSet.hpp"
+#include "TemplateWatcher.hpp"
+#include "ResponseWriter.hpp"
+#include "FCGIListener.hpp"
+#include "AsyncLog.hpp"
+#include "PagePrewarmer.hpp"
+#include "ServiceNotifier.hpp"
+#include <atomic>
+#include <mutex>
+#include <string>
 
 //------------------------------------------------------------------------------
 
@@ -47,47 +64,196 @@ public:
     /// finalize
     void Finalize(void);
 
-// section of private data -----------------------------------------------------
-private:
+    /// reload configuration, templates and catalog while serving requests
+    bool ReloadConfig(void);
+
+    /// recompile templates while serving requests
+    bool ReloadTemplates(void);
+
+    /// refresh catalogs of all sites in the background
+    void RefreshCatalog(void);
+
+    /// get current templates
+    CTemplateSetPtr GetTemplates(void);
+
+    /// get current sites
+    CRepoSitesPtr GetSites(void);
+
+    /// admit accepted request before it is handed over to a worker,
+    /// false if the request must be answered by reply at once
+    bool AdmitRequest(CFCGIRequest& request,CAdmissionTicket& ticket,std::string& reply);
+
+    /// release admitted request that is not served
+    void CancelRequest(CAdmissionTicket& ticket);
+
+    /// process one admitted request
+    void ServeRequest(CFCGIRequest& request,CResponseWriter& response,
+                      const CAdmissionTicket& ticket);
+
+    /// get metrics, worker threads register themselves
+    CServerMetrics& GetMetrics(void);
+
+    /// render hot pages of site for the snapshot that is not used yet
+    void PrewarmPages(CRepoSite& site,const CCatalogSnapshotPtr& snapshot,
+                      const std::atomic<bool>& cancelled);
+
+// section of protected data ---------------------------------------------------
+// handlers are accessible to the benchmark harness
+protected:
     CISoftRepoOptions   Options;
-    CXMLDocument        ServerConfig;
+    CServerConfigPtr    Config;         // use GetConfig to access it
+    CTemplateSetPtr     Templates;      // use GetTemplates to access it
+    CRepoSitesPtr       Sites;          // use GetSites to access it
+    std::mutex          ReloadLock;     // serializes config and template reloads
     CTerminalStr        Console;
     CVerboseStr         vout;
     CServerWatcher      Watcher;
-    CSmallString        BundleName;
-    CFileName           BundlePath;
+    CServerReloader     Reloader;
+    CTemplateWatcher    TemplateWatcher;
+    CFCGIListener       Listener;
+    bool                UnixSocket;     // Listener is used instead of CFCGIServer
+    CServerMetrics      Metrics;
+    CPhaseStatistics    PhaseStatistics;
+    CAsyncLog           Log;            // console and watcher log of request paths
+    CPagePrewarmer      Prewarmer;
+    CAdmissionControl   Admission;
+    CRateLimiter        RateLimiter;    // per REMOTE_ADDR
+    CServiceNotifier    Notifier;       // readiness and watchdog for systemd
+    uint64_t            StartupStart;   // in us
+    uint64_t            StartupPhase;   // in us, start of the current phase
+    std::string         StartupTimes;   // breakdown of finished phases
 
     static  void CtrlCSignalHandler(int signal);
+    static  void HupSignalHandler(int signal);
 
     virtual bool AcceptRequest(void);
+    bool DispatchRequest(CFCGIRequest& request,CResponseWriter& response,
+                         const CSmallString& action,const CAdmissionTicket& ticket);
+    bool ProcessRequest(CFCGIRequest& request,CResponseWriter& response,
+                        const CSmallString& action,uint64_t arrival);
+    void WriteOverloaded(CResponseWriter& response);
+    bool RenderPage(CFCGIRequest& request,const CSmallString& action,std::string& page);
+    void GetPageKey(CFCGIRequest& request,const CSmallString& action,std::string& key);
+
+    /// HTTP status line of the error page of the failed request
+    const char* GetErrorStatus(CFCGIRequest& request,const CSmallString& action,
+                               const CCatalogSnapshotPtr& snapshot);
+
+    /// prepare request of page from its key, false if the key is obsolete
+    bool SetupPageRequest(const std::string& key,const CRepoSite& site,
+                          CFCGIRequest& request,CSmallString& action);
+
+    /// site selected by the site parameter or by SCRIPT_NAME, NULL for unknown site
+    CRepoSitePtr FindSite(CFCGIRequest& request);
+
+    /// current catalog snapshot of the request site
+    CCatalogSnapshotPtr GetSnapshot(CFCGIRequest& request);
 
     // web pages handlers ------------------------------------------------------
-    bool _ListCategories(CFCGIRequest& request);
-    bool _Module(CFCGIRequest& request);
-    bool _Version(CFCGIRequest& request);
-    bool _Build(CFCGIRequest& request);
-    bool _Error(CFCGIRequest& request);
+    bool _ListCategories(CFCGIRequest& request,std::string& page);
+    bool _Module(CFCGIRequest& request,std::string& page);
+    bool _ModuleVersions(CFCGIRequest& request,std::string& page);
+    bool _Version(CFCGIRequest& request,std::string& page);
+    bool _Build(CFCGIRequest& request,std::string& page);
+    bool _Error(CFCGIRequest& request,std::string& page);
+
+    // bulk data, write their own headers --------------------------------------
+    bool _Export(CFCGIRequest& request,CResponseWriter& response);
+    bool _Metrics(CFCGIRequest& request,CResponseWriter& response);
 
     bool ProcessCommonParams(CFCGIRequest& request,
                              CTemplateParams& template_params);
 
-    bool ProcessTemplate(CFCGIRequest& request,
-                         const CSmallString& template_name,
-                         CTemplateParams& template_params);
+    /// VERSIONS cycle with a window of module versions, zero limit - all versions
+    void SetModuleVersionsParams(CTemplateParams& template_params,
+                                 const CSmallString& module_name,
+                                 const std::vector<CSmallString>& versions,
+                                 size_t offset,size_t limit);
+
+    /// render template, markers of fragments are replaced in the output
+    bool ProcessTemplate(const CSmallString& template_name,
+                         CTemplateParams& template_params,
+                         std::string& page,
+                         const CPageFragments* p_fragments = NULL);
+
+    /// render fragment template, the output has no XML declaration
+    bool ProcessFragmentTemplate(const CSmallString& template_name,
+                                 CTemplateParams& template_params,
+                                 std::string& output);
+
+    /// get fragment from the cache of site, it is rendered by each request without site
+    /// the key is extended by the script location and the template generation
+    bool GetFragment(CFCGIRequest& request,const CRepoSitePtr& site,
+                     const std::string& name,uint64_t stamp,
+                     const TPageRenderer& renderer,CFragmentPtr& fragment);
+
+    /// get cached block of category modules for the categories page
+    bool GetCategoryFragment(CFCGIRequest& request,const CRepoSitePtr& site,
+                             const CCatalogSnapshotPtr& snapshot,
+                             const CSmallString& category,bool include_vers,
+                             CFragmentPtr& fragment);
+
+    /// stamp of dependency list, cached tables of dependencies are rendered again
+    /// once it changes
+    static uint64_t GetDependenciesStamp(CXMLElement* p_deps);
+
+    /// set MONITORINGBLOCK to the cached monitoring block of the page footer
+    bool SetMonitoringBlock(CFCGIRequest& request,CTemplateParams& template_params,
+                            CPageFragments& fragments);
+
+    /// evaluate build filter given by arch, mode, bundle and acl parameters
+    /// p_builds is set to NULL for the empty filter
+    bool EvaluateFilter(CFCGIRequest& request,const CCatalogSnapshotPtr& snapshot,
+                        CCatalogFilter& filter,CCatalogBitmap& builds,
+                        const CCatalogBitmap*& p_builds);
+
+    // request timing ----------------------------------------------------------
+    void ReportRequestTiming(CFCGIRequest& request,const CSmallString& action,
+                             const CRequestTimer& timer);
+    void WriteWatcherLog(const CSmallString& record);
 
     // configuration options ---------------------------------------------------
-    bool LoadConfig(void);
+    /// parse configuration into a new object, it is printed to out
+    bool LoadConfig(const CFileName& config_path,CServerConfigPtr& config,CVerboseStr& out);
+
+    /// compile templates into a new set, the summary is printed to out
+    bool LoadTemplates(const CFileName& template_path,CTemplateSetPtr& templates,CVerboseStr& out);
+
+    /// create sites of the configuration, existing sites are reused by name
+    CRepoSitesPtr PrepareSites(const CServerConfigPtr& config);
+
+    /// use configuration, templates and sites for new requests
+    void ApplyConfig(const CServerConfigPtr& config,const CTemplateSetPtr& templates,
+                     const CRepoSitesPtr& sites);
+
+    /// reapply settings of helper threads after config reload
+    void ApplyThreadConfig(const CServerConfigPtr& config,CVerboseStr& out);
+
+    /// report changed settings that are used only after restart
+    void ReportRestartSettings(const CServerConfigPtr& old_config,const CServerConfigPtr& config,
+                               CVerboseStr& out);
+
+    // reload ------------------------------------------------------------------
+    /// reload configuration, messages are printed to out
+    bool ReloadConfig(CVerboseStr& out);
+
+    /// recompile templates, messages are printed to out
+    bool ReloadTemplates(CVerboseStr& out);
+
+    /// print text to the console by the log thread, it owns vout while
+    /// the server runs
+    void PrintToConsole(const std::string& text);
 
-    // fcgi server
-    int                 GetPortNumber(void);
-    const CFileName     GetTemplatePath(void);
+    /// get current configuration
+    CServerConfigPtr GetConfig(void);
 
-    // ams bundles
-    const CSmallString  GetBundleName(void);
-    const CFileName     GetBundlePath(void);
+    // startup -----------------------------------------------------------------
+    /// build or map catalogs of all sites before connections are accepted
+    /// it fails if any catalog is not available
+    bool PrepareCatalogs(void);
 
-    // monitoring
-    CXMLElement*        GetMonitoringIFrame(void);
+    /// record duration of the finished startup phase
+    void EndStartupPhase(const char* p_name);
 };
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,389 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "PageCache.hpp"
+#include "ServerMetrics.hpp"
+#include <algorithm>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+// counters per row of the frequency sketch, 64 KB per site
+#define SKETCH_WIDTH    16384
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CPageFlight::CPageFlight(void)
+{
+    Done = false;
+    Result = false;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CPageCache::CPageCache(void)
+{
+    Capacity = 0;
+    Size = 0;
+    Generation = 0;
+    NumOfHotKeys = 0;
+    HotAgings = 0;
+    NumOfHits = 0;
+    NumOfMisses = 0;
+    NumOfCoalesced = 0;
+    NumOfEvictions = 0;
+    NumOfRejected = 0;
+    NumOfPrewarmed = 0;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CPageCache::SetCapacity(size_t capacity)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+    Capacity = capacity;
+    while( (Size > Capacity) && (Pages.empty() == false) ){
+        EvictPage();
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CPageCache::SetHotKeys(size_t num)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+    if( (num == NumOfHotKeys) && (num > 0) ) return;   // keys survive config reloads
+    NumOfHotKeys = num;
+    Sketch.SetWidth(num > 0 ? SKETCH_WIDTH : 0);
+    HotKeys.clear();
+    HotOrder.clear();
+}
+
+//------------------------------------------------------------------------------
+
+void CPageCache::Clear(void)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+    Pages.clear();
+    Index.clear();
+    Size = 0;
+
+    // keys contain the template generation, thus they are not requested again
+    HotKeys.clear();
+    HotOrder.clear();
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CPageCache::GetPage(const std::string& key,uint64_t generation,
+                         const TPageRenderer& renderer,CPagePtr& page)
+{
+    std::unique_lock<std::mutex> lock(Lock);
+
+    UpdateGeneration(generation);
+    RecordKey(key);
+
+    return(FetchPage(lock,key,generation,renderer,false,page));
+}
+
+//------------------------------------------------------------------------------
+
+bool CPageCache::PrewarmPage(const std::string& key,uint64_t generation,
+                             const TPageRenderer& renderer)
+{
+    std::unique_lock<std::mutex> lock(Lock);
+
+    // pages of obsolete generations are not stored
+    if( generation < Generation ) return(false);
+
+    CPagePtr page;
+    return(FetchPage(lock,key,generation,renderer,true,page));
+}
+
+//------------------------------------------------------------------------------
+
+void CPageCache::GetHotKeys(std::vector<std::string>& keys)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+
+    RefreshHotKeys();
+
+    keys.clear();
+    for(THotOrder::reverse_iterator it = HotOrder.rbegin(); it != HotOrder.rend(); it++){
+        keys.push_back(it->second);
+    }
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CPageCache::FetchPage(std::unique_lock<std::mutex>& lock,const std::string& key,uint64_t generation,
+                           const TPageRenderer& renderer,bool prewarm,CPagePtr& page)
+{
+    // pages of other generations are never returned
+    std::string entry_key;
+    GetEntryKey(key,generation,entry_key);
+
+    std::unordered_map<std::string,TPageList::iterator>::iterator it = Index.find(entry_key);
+    if( it != Index.end() ) {
+        Pages.splice(Pages.begin(),Pages,it->second);
+        page = it->second->Page;
+        if( ! prewarm ) NumOfHits++;
+        return(true);
+    }
+
+    std::unordered_map<std::string,std::shared_ptr<CPageFlight> >::iterator fit = Flights.find(entry_key);
+    if( fit != Flights.end() ) {
+        std::shared_ptr<CPageFlight> flight = fit->second;
+        if( ! prewarm ) NumOfCoalesced++;
+        Rendered.wait(lock,[&flight]{ return(flight->Done); });
+        page = flight->Page;
+        return(flight->Result);
+    }
+
+    // this request renders the page
+    std::shared_ptr<CPageFlight> flight(new CPageFlight);
+    Flights[entry_key] = flight;
+    if( prewarm ) {
+        NumOfPrewarmed++;
+    } else {
+        NumOfMisses++;
+    }
+    lock.unlock();
+
+    std::string* p_page = new std::string;
+    CPagePtr     output(p_page);
+    bool         result = renderer(*p_page);
+
+    lock.lock();
+    Flights.erase(entry_key);
+    flight->Done = true;
+    flight->Result = result;
+    if( result ) {
+        flight->Page = output;
+        if( generation >= Generation ) InsertPage(key,generation,output,prewarm);
+    }
+    Rendered.notify_all();
+
+    page = output;
+    return(result);
+}
+
+//------------------------------------------------------------------------------
+
+void CPageCache::UpdateGeneration(uint64_t generation)
+{
+    if( generation <= Generation ) return;
+
+    // prewarmed pages of the new generation are kept
+    TPageList::iterator it = Pages.begin();
+    while( it != Pages.end() ){
+        if( it->Generation < generation ) {
+            std::string entry_key;
+            GetEntryKey(it->Key,it->Generation,entry_key);
+            Index.erase(entry_key);
+            Size -= it->Page->size();
+            it = Pages.erase(it);
+        } else {
+            it++;
+        }
+    }
+    Generation = generation;
+}
+
+//------------------------------------------------------------------------------
+
+void CPageCache::InsertPage(const std::string& key,uint64_t generation,const CPagePtr& page,bool prewarm)
+{
+    if( page->size() > Capacity ) return;
+
+    std::string entry_key;
+    GetEntryKey(key,generation,entry_key);
+
+    std::unordered_map<std::string,TPageList::iterator>::iterator it = Index.find(entry_key);
+    if( it != Index.end() ) {
+        Size -= it->second->Page->size();
+        Pages.erase(it->second);
+        Index.erase(it);
+    }
+
+    // the page must be requested more often than all pages it would evict,
+    // prewarmed pages are hot by definition
+    if( Sketch.IsEnabled() && (prewarm == false) ) {
+        unsigned int estimate = Sketch.Estimate(key);
+        size_t       size = Size;
+        TPageList::reverse_iterator rit = Pages.rbegin();
+        while( (size + page->size() > Capacity) && (rit != Pages.rend()) ){
+            if( Sketch.Estimate(rit->Key) >= estimate ) {
+                NumOfRejected++;
+                return;
+            }
+            size -= rit->Page->size();
+            rit++;
+        }
+    }
+
+    while( (Size + page->size() > Capacity) && (Pages.empty() == false) ){
+        EvictPage();
+    }
+
+    CPageEntry entry;
+    entry.Key = key;
+    entry.Generation = generation;
+    entry.Page = page;
+    Pages.push_front(entry);
+    Index[entry_key] = Pages.begin();
+    Size += page->size();
+}
+
+//------------------------------------------------------------------------------
+
+void CPageCache::EvictPage(void)
+{
+    std::string entry_key;
+    GetEntryKey(Pages.back().Key,Pages.back().Generation,entry_key);
+    Index.erase(entry_key);
+    Size -= Pages.back().Page->size();
+    Pages.pop_back();
+    NumOfEvictions++;
+}
+
+//------------------------------------------------------------------------------
+
+void CPageCache::RecordKey(const std::string& key)
+{
+    if( Sketch.IsEnabled() == false ) return;
+
+    unsigned int estimate = Sketch.Increment(key);
+
+    // counters were halved, all kept estimates are stale
+    RefreshHotKeys();
+
+    std::unordered_map<std::string,THotOrder::iterator>::iterator it = HotKeys.find(key);
+    if( it != HotKeys.end() ) {
+        HotOrder.erase(it->second);
+        it->second = HotOrder.insert(std::make_pair(estimate,key));
+        return;
+    }
+    if( HotKeys.size() < NumOfHotKeys ) {
+        HotKeys[key] = HotOrder.insert(std::make_pair(estimate,key));
+        return;
+    }
+    if( HotOrder.empty() || (estimate <= HotOrder.begin()->first) ) return;
+
+    // estimate of the coldest key can grow by collisions with other keys
+    THotOrder::iterator min_it = HotOrder.begin();
+    unsigned int min_estimate = Sketch.Estimate(min_it->second);
+    if( min_estimate >= estimate ) {
+        std::string min_key = min_it->second;
+        HotOrder.erase(min_it);
+        HotKeys[min_key] = HotOrder.insert(std::make_pair(min_estimate,min_key));
+        return;
+    }
+
+    HotKeys.erase(min_it->second);
+    HotOrder.erase(min_it);
+    HotKeys[key] = HotOrder.insert(std::make_pair(estimate,key));
+}
+
+//------------------------------------------------------------------------------
+
+void CPageCache::RefreshHotKeys(void)
+{
+    if( HotAgings == Sketch.GetNumOfAgings() ) return;
+    HotAgings = Sketch.GetNumOfAgings();
+
+    // halvings are rare, thus reordering all keys is cheap on average
+    THotOrder order;
+    for(std::pair<const std::string,THotOrder::iterator>& item : HotKeys){
+        item.second = order.insert(std::make_pair(Sketch.Estimate(item.first),item.first));
+    }
+    HotOrder.swap(order);
+}
+
+//------------------------------------------------------------------------------
+
+void CPageCache::GetEntryKey(const std::string& key,uint64_t generation,std::string& entry_key)
+{
+    entry_key = key;
+    entry_key += '\n';
+    entry_key += std::to_string(generation);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CPageCache::PrintMetrics(std::string& output,const char* p_labels)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_page_cache_hits_total","counter",
+                                 "Number of pages served from the page cache.");
+    CServerMetrics::AppendSample(output,"isoftrepo_page_cache_hits_total",p_labels,NumOfHits);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_page_cache_misses_total","counter",
+                                 "Number of rendered pages.");
+    CServerMetrics::AppendSample(output,"isoftrepo_page_cache_misses_total",p_labels,NumOfMisses);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_page_cache_coalesced_total","counter",
+                                 "Number of requests that shared a render started by another request.");
+    CServerMetrics::AppendSample(output,"isoftrepo_page_cache_coalesced_total",p_labels,NumOfCoalesced);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_page_cache_evictions_total","counter",
+                                 "Number of pages evicted from the page cache.");
+    CServerMetrics::AppendSample(output,"isoftrepo_page_cache_evictions_total",p_labels,NumOfEvictions);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_page_cache_rejected_total","counter",
+                                 "Number of rendered pages not admitted because of less frequent keys.");
+    CServerMetrics::AppendSample(output,"isoftrepo_page_cache_rejected_total",p_labels,NumOfRejected);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_page_cache_prewarmed_total","counter",
+                                 "Number of pages rendered ahead of a catalog swap.");
+    CServerMetrics::AppendSample(output,"isoftrepo_page_cache_prewarmed_total",p_labels,NumOfPrewarmed);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_page_cache_hot_keys","gauge",
+                                 "Number of tracked hot keys.");
+    CServerMetrics::AppendSample(output,"isoftrepo_page_cache_hot_keys",p_labels,HotKeys.size());
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_page_cache_pages","gauge",
+                                 "Number of pages in the page cache.");
+    CServerMetrics::AppendSample(output,"isoftrepo_page_cache_pages",p_labels,Pages.size());
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_page_cache_bytes","gauge",
+                                 "Size of pages in the page cache.");
+    CServerMetrics::AppendSample(output,"isoftrepo_page_cache_bytes",p_labels,Size);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
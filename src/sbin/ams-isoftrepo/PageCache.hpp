@@ -0,0 +1,152 @@
+#ifndef PageCacheH
+#define PageCacheH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+#include "FrequencySketch.hpp"
+
+//------------------------------------------------------------------------------
+
+/// rendered page shared by the cache and requests
+typedef std::shared_ptr<const std::string> CPagePtr;
+
+/// renders page into the buffer
+typedef std::function<bool(std::string& page)> TPageRenderer;
+
+//------------------------------------------------------------------------------
+
+/// render in progress, concurrent requests for the same key wait for it
+
+class CPageFlight {
+public:
+    CPageFlight(void);
+
+    bool        Done;
+    bool        Result;
+    CPagePtr    Page;
+};
+
+//------------------------------------------------------------------------------
+
+/// LRU cache of rendered pages bounded by their total size
+/// pages belong to one catalog generation, a newer generation drops older pages,
+/// pages of the next generation can be rendered ahead by PrewarmPage
+/// request frequency of keys is estimated by a sketch, a new page evicts only
+/// pages of less frequent keys and the most frequent keys are kept for prewarming
+/// identical concurrent renders are coalesced into one even if the cache is disabled
+
+class CPageCache {
+public:
+    CPageCache(void);
+
+// setup methods ---------------------------------------------------------------
+    /// set capacity in bytes, zero - pages are not stored
+    void SetCapacity(size_t capacity);
+
+    /// set number of tracked hot keys, zero - request frequency is not tracked
+    void SetHotKeys(size_t num);
+
+// main methods ----------------------------------------------------------------
+    /// get page from the cache or render it
+    bool GetPage(const std::string& key,uint64_t generation,
+                 const TPageRenderer& renderer,CPagePtr& page);
+
+    /// render page of the upcoming generation unless it is already stored
+    bool PrewarmPage(const std::string& key,uint64_t generation,
+                     const TPageRenderer& renderer);
+
+    /// get the most frequently requested keys, the most frequent first
+    void GetHotKeys(std::vector<std::string>& keys);
+
+    /// drop all pages and hot keys
+    void Clear(void);
+
+    /// print cache metrics
+    void PrintMetrics(std::string& output,const char* p_labels);
+
+// section of private data -----------------------------------------------------
+private:
+    class CPageEntry {
+    public:
+        std::string     Key;
+        uint64_t        Generation;
+        CPagePtr        Page;
+    };
+    typedef std::list<CPageEntry>                   TPageList;
+    typedef std::multimap<unsigned int,std::string> THotOrder;
+
+    std::mutex                                      Lock;
+    std::condition_variable                         Rendered;
+    size_t                                          Capacity;
+    size_t                                          Size;
+    uint64_t                                        Generation;
+    TPageList                                       Pages;      // most recently used first
+    std::unordered_map<std::string,TPageList::iterator>             Index;  // key and generation
+    std::unordered_map<std::string,std::shared_ptr<CPageFlight> >   Flights;
+    CFrequencySketch                                Sketch;
+    size_t                                          NumOfHotKeys;
+    THotOrder                                       HotOrder;   // estimate, key - the coldest first
+    std::unordered_map<std::string,THotOrder::iterator>             HotKeys;
+    uint64_t                                        HotAgings;  // sketch agings of estimates
+    uint64_t                                        NumOfHits;
+    uint64_t                                        NumOfMisses;
+    uint64_t                                        NumOfCoalesced;
+    uint64_t                                        NumOfEvictions;
+    uint64_t                                        NumOfRejected;
+    uint64_t                                        NumOfPrewarmed;
+
+    /// get page or render it, prewarmed pages are not counted as requests
+    bool FetchPage(std::unique_lock<std::mutex>& lock,const std::string& key,uint64_t generation,
+                   const TPageRenderer& renderer,bool prewarm,CPagePtr& page);
+
+    /// set current generation, lock must be held
+    void UpdateGeneration(uint64_t generation);
+
+    /// insert page, lock must be held
+    void InsertPage(const std::string& key,uint64_t generation,const CPagePtr& page,bool prewarm);
+
+    /// remove the least recently used page, lock must be held
+    void EvictPage(void);
+
+    /// count request of key, lock must be held
+    void RecordKey(const std::string& key);
+
+    /// reorder hot keys by fresh estimates after sketch aging, lock must be held
+    void RefreshHotKeys(void);
+
+    /// key of page in the index and in flights
+    static void GetEntryKey(const std::string& key,uint64_t generation,std::string& entry_key);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,128 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "PagePrewarmer.hpp"
+#include "ISoftRepoServer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CPrewarmJob::CPrewarmJob(void)
+    : Cancelled(false)
+{
+    Site = NULL;
+    Started = false;
+    Done = false;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CPagePrewarmer::CPagePrewarmer(void)
+{
+    Server = NULL;
+    Running = false;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CPagePrewarmer::SetServer(CISoftRepoServer* p_server)
+{
+    Server = p_server;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CPagePrewarmer::Prewarm(CRepoSite* p_site,const CCatalogSnapshotPtr& snapshot,int timeout)
+{
+    if( timeout <= 0 ) return;
+
+    CPrewarmJobPtr job(new CPrewarmJob);
+    job->Site = p_site;
+    job->Snapshot = snapshot;
+
+    std::unique_lock<std::mutex> lock(Lock);
+    if( Running == false ) return;
+    Jobs.push_back(job);
+    Changed.notify_all();
+
+    std::chrono::steady_clock::time_point deadline =
+            std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+    if( Changed.wait_until(lock,deadline,[&job]{ return(job->Done); }) ) return;
+
+    // the site can be released after return, thus the current page must be finished
+    job->Cancelled = true;
+    if( job->Started == false ) {
+        Jobs.erase(std::find(Jobs.begin(),Jobs.end(),job));
+        return;
+    }
+    Changed.wait(lock,[&job]{ return(job->Done); });
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CPagePrewarmer::ExecuteThread(void)
+{
+    // nice applies to the calling thread on Linux
+    setpriority(PRIO_PROCESS,syscall(SYS_gettid),19);
+
+    std::unique_lock<std::mutex> lock(Lock);
+    Running = true;
+    while( ThreadTerminated == false ){
+        // wake up periodically to check for termination
+        if( Jobs.empty() ) {
+            Changed.wait_for(lock,std::chrono::seconds(1));
+            continue;
+        }
+
+        CPrewarmJobPtr job = Jobs.front();
+        Jobs.pop_front();
+        job->Started = true;
+        lock.unlock();
+
+        if( Server != NULL ) Server->PrewarmPages(*job->Site,job->Snapshot,job->Cancelled);
+
+        lock.lock();
+        job->Done = true;
+        Changed.notify_all();
+    }
+
+    // waiting callers give up at their deadlines
+    Running = false;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
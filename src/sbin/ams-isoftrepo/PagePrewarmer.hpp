@@ -0,0 +1,86 @@
+#ifndef PagePrewarmerH
+#define PagePrewarmerH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <SmallThread.hpp>
+#include "Catalog.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+
+//------------------------------------------------------------------------------
+
+class CISoftRepoServer;
+class CRepoSite;
+
+//------------------------------------------------------------------------------
+
+/// request to render hot pages of a site for a new snapshot
+
+class CPrewarmJob {
+public:
+    CPrewarmJob(void);
+
+    CRepoSite*          Site;
+    CCatalogSnapshotPtr Snapshot;
+    bool                Started;
+    bool                Done;
+    std::atomic<bool>   Cancelled;
+};
+
+typedef std::shared_ptr<CPrewarmJob> CPrewarmJobPtr;
+
+//------------------------------------------------------------------------------
+
+/// renders hot pages into page caches before new catalog snapshots are used
+/// the thread runs with the lowest priority, thus it only takes idle CPU time
+
+class CPagePrewarmer : public CSmallThread {
+public:
+    CPagePrewarmer(void);
+
+// setup methods ---------------------------------------------------------------
+    /// set server rendering pages
+    void SetServer(CISoftRepoServer* p_server);
+
+// main methods ----------------------------------------------------------------
+    /// render hot pages of site and wait for them at most timeout ms
+    /// unfinished pages are abandoned after the timeout
+    void Prewarm(CRepoSite* p_site,const CCatalogSnapshotPtr& snapshot,int timeout);
+
+// section of private data -----------------------------------------------------
+private:
+    CISoftRepoServer*           Server;
+    std::mutex                  Lock;
+    std::condition_variable     Changed;
+    std::list<CPrewarmJobPtr>   Jobs;
+    bool                        Running;    // jobs are accepted only by running thread
+
+    virtual void ExecuteThread(void);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
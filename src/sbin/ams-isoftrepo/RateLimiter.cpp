@@ -0,0 +1,183 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "RateLimiter.hpp"
+#include "ServerMetrics.hpp"
+#include <functional>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CRateLimiter::CShard::CShard(void)
+{
+    Rate = 0;
+    Burst = 0;
+    Capacity = 0;
+    IdleTimeout = 0;
+    NumOfThrottled = 0;
+    NumOfEvicted = 0;
+}
+
+//------------------------------------------------------------------------------
+
+CRateLimiter::CRateLimiter(void)
+    : Enabled(false)
+{
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CRateLimiter::SetLimits(double rate,double burst,size_t max_clients,int idle_timeout)
+{
+    if( burst < 1 ) burst = 1;
+    size_t capacity = (max_clients + RATE_LIMIT_SHARDS - 1) / RATE_LIMIT_SHARDS;
+    if( capacity < 1 ) capacity = 1;
+
+    // an idle client is dropped only when its bucket is full again
+    uint64_t idle = (uint64_t)(idle_timeout > 0 ? idle_timeout : 0) * 1000000;
+    if( (rate > 0) && (idle < burst / rate * 1000000) ) idle = burst / rate * 1000000;
+
+    for(CShard& shard : Shards){
+        std::lock_guard<std::mutex> lock(shard.Lock);
+        shard.Rate = rate / 1000000.0;
+        shard.Burst = burst;
+        shard.Capacity = capacity;
+        shard.IdleTimeout = idle;
+        // limits of kept clients are changed too
+        if( rate <= 0 ) {
+            shard.Buckets.clear();
+            shard.Index.clear();
+        }
+        while( shard.Index.size() > shard.Capacity ){
+            shard.Index.erase(shard.Buckets.back().Address);
+            shard.Buckets.pop_back();
+        }
+        for(CClientBucket& bucket : shard.Buckets){
+            if( bucket.Tokens > burst ) bucket.Tokens = burst;
+        }
+    }
+
+    Enabled = rate > 0;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CRateLimiter::Admit(const char* p_address,double cost)
+{
+    if( Enabled == false ) return(true);
+    if( (p_address == NULL) || (p_address[0] == 0) ) return(true);
+    if( cost <= 0 ) return(true);
+
+    std::string address(p_address);
+    CShard&     shard = Shards[std::hash<std::string>()(address) % RATE_LIMIT_SHARDS];
+    uint64_t    now = GetMonotonicTime();
+
+    std::lock_guard<std::mutex> lock(shard.Lock);
+    if( shard.Rate <= 0 ) return(true);
+
+    ExpireBuckets(shard,now);
+
+    // cost above burst would never be admitted
+    if( cost > shard.Burst ) cost = shard.Burst;
+
+    CClientBucket* p_bucket;
+    std::unordered_map<std::string,TBucketList::iterator>::iterator it = shard.Index.find(address);
+    if( it == shard.Index.end() ) {
+        CClientBucket bucket;
+        bucket.Address = address;
+        bucket.Tokens = shard.Burst;
+        if( shard.Index.size() >= shard.Capacity ) {
+            shard.Index.erase(shard.Buckets.back().Address);
+            shard.Buckets.pop_back();
+            shard.NumOfEvicted++;
+            // the evicted client could be this one, thus a full table gives
+            // no burst, only the current request is admitted
+            bucket.Tokens = cost;
+        }
+        bucket.LastUpdate = now;
+        shard.Buckets.push_front(bucket);
+        shard.Index[address] = shard.Buckets.begin();
+        p_bucket = &shard.Buckets.front();
+    } else {
+        shard.Buckets.splice(shard.Buckets.begin(),shard.Buckets,it->second);
+        p_bucket = &(*it->second);
+        p_bucket->Tokens += (now - p_bucket->LastUpdate) * shard.Rate;
+        if( p_bucket->Tokens > shard.Burst ) p_bucket->Tokens = shard.Burst;
+        p_bucket->LastUpdate = now;
+    }
+
+    if( p_bucket->Tokens >= cost ) {
+        p_bucket->Tokens -= cost;
+        return(true);
+    }
+
+    shard.NumOfThrottled++;
+    return(false);
+}
+
+//------------------------------------------------------------------------------
+
+void CRateLimiter::ExpireBuckets(CShard& shard,uint64_t now)
+{
+    while( shard.Buckets.empty() == false ){
+        const CClientBucket& bucket = shard.Buckets.back();
+        if( now - bucket.LastUpdate < shard.IdleTimeout ) break;
+        shard.Index.erase(bucket.Address);
+        shard.Buckets.pop_back();
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CRateLimiter::PrintMetrics(std::string& output)
+{
+    uint64_t clients = 0;
+    uint64_t throttled = 0;
+    uint64_t evicted = 0;
+    for(CShard& shard : Shards){
+        std::lock_guard<std::mutex> lock(shard.Lock);
+        clients += shard.Index.size();
+        throttled += shard.NumOfThrottled;
+        evicted += shard.NumOfEvicted;
+    }
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_ratelimit_clients","gauge",
+                                 "Number of tracked client addresses.");
+    CServerMetrics::AppendSample(output,"isoftrepo_ratelimit_clients",NULL,clients);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_ratelimit_throttled_total","counter",
+                                 "Number of requests answered with 429.");
+    CServerMetrics::AppendSample(output,"isoftrepo_ratelimit_throttled_total",NULL,throttled);
+
+    CServerMetrics::AppendHeader(output,"isoftrepo_ratelimit_evicted_total","counter",
+                                 "Number of active clients dropped because the client table was full.");
+    CServerMetrics::AppendSample(output,"isoftrepo_ratelimit_evicted_total",NULL,evicted);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
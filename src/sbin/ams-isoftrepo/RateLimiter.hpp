@@ -0,0 +1,97 @@
+#ifndef RateLimiterH
+#define RateLimiterH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+
+/// number of independently locked parts of the client table
+#define RATE_LIMIT_SHARDS   64
+
+//------------------------------------------------------------------------------
+
+/// per-client rate limiting by token buckets
+/// each client address has a bucket of burst tokens refilled by rate tokens per
+/// second, a request takes tokens given by the cost of its action,
+/// clients are kept in sharded LRU tables, idle clients are dropped as their
+/// buckets would be full anyway and the least recent client is dropped when
+/// the table is full, clients added to a full table start without burst
+
+class CRateLimiter {
+public:
+    CRateLimiter(void);
+
+// setup methods ---------------------------------------------------------------
+    /// set limits, zero rate - rate limiting is disabled
+    /// idle_timeout is in seconds
+    void SetLimits(double rate,double burst,size_t max_clients,int idle_timeout);
+
+// main methods ----------------------------------------------------------------
+    /// take tokens of the request, false if the client is throttled
+    /// requests without address are not limited
+    bool Admit(const char* p_address,double cost);
+
+    /// print rate limiting metrics
+    void PrintMetrics(std::string& output);
+
+// section of private data -----------------------------------------------------
+private:
+    class CClientBucket {
+    public:
+        std::string     Address;
+        double          Tokens;
+        uint64_t        LastUpdate;     // in us
+    };
+    typedef std::list<CClientBucket>    TBucketList;
+
+    class CShard {
+    public:
+        CShard(void);
+
+        std::mutex                                          Lock;
+        TBucketList                                         Buckets;    // most recent first
+        std::unordered_map<std::string,TBucketList::iterator> Index;
+        double                                              Rate;       // tokens per us
+        double                                              Burst;
+        size_t                                              Capacity;
+        uint64_t                                            IdleTimeout; // in us
+        uint64_t                                            NumOfThrottled;
+        uint64_t                                            NumOfEvicted;  // active clients dropped
+    };
+
+    std::atomic<bool>   Enabled;
+    CShard              Shards[RATE_LIMIT_SHARDS];
+
+    /// drop idle clients, lock must be held
+    static void ExpireBuckets(CShard& shard,uint64_t now);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
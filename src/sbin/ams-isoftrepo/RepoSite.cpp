@@ -0,0 +1,84 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "RepoSite.hpp"
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CRepoSite::CRepoSite(const CSmallString& name)
+    : Name(name)
+{
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CRepoSites::AddSite(const CRepoSitePtr& site,const CSmallString& script_name)
+{
+    Sites.push_back(site);
+    SitesByName[std::string(site->Name)] = site;
+    if( script_name != NULL ) {
+        SitesByScript[std::string(script_name)] = site;
+    }
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CRepoSitePtr CRepoSites::FindSite(const CSmallString& name) const
+{
+    std::unordered_map<std::string,CRepoSitePtr>::const_iterator it = SitesByName.find(std::string(name));
+    if( it == SitesByName.end() ) return(CRepoSitePtr());
+    return(it->second);
+}
+
+//------------------------------------------------------------------------------
+
+CRepoSitePtr CRepoSites::FindSiteByScript(const CSmallString& script_name) const
+{
+    std::unordered_map<std::string,CRepoSitePtr>::const_iterator it = SitesByScript.find(std::string(script_name));
+    if( it == SitesByScript.end() ) return(CRepoSitePtr());
+    return(it->second);
+}
+
+//------------------------------------------------------------------------------
+
+CRepoSitePtr CRepoSites::GetDefaultSite(void) const
+{
+    if( Sites.empty() ) return(CRepoSitePtr());
+    return(Sites.front());
+}
+
+//------------------------------------------------------------------------------
+
+const std::vector<CRepoSitePtr>& CRepoSites::GetSites(void) const
+{
+    return(Sites);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
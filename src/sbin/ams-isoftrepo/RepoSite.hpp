@@ -0,0 +1,92 @@
+#ifndef RepoSiteH
+#define RepoSiteH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <SmallString.hpp>
+#include "Catalog.hpp"
+#include "PageCache.hpp"
+#include "FragmentCache.hpp"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//------------------------------------------------------------------------------
+
+/// one AMS site served by the process, it owns its catalog and caches
+/// the object survives config reloads as long as the site name is kept
+
+class CRepoSite {
+public:
+    CRepoSite(const CSmallString& name);
+
+// section of public data ------------------------------------------------------
+public:
+    const CSmallString  Name;
+    CCatalog            Catalog;
+    CPageCache          PageCache;
+    CFragmentCache      FragmentCache;
+};
+
+//------------------------------------------------------------------------------
+
+typedef std::shared_ptr<CRepoSite> CRepoSitePtr;
+
+//------------------------------------------------------------------------------
+
+/// sites selected by the site parameter or by SCRIPT_NAME
+/// the object is not changed once it is published, reload creates a new one
+
+class CRepoSites {
+public:
+// setup methods ---------------------------------------------------------------
+    /// add site, the first one is the default site
+    void AddSite(const CRepoSitePtr& site,const CSmallString& script_name);
+
+// main methods ----------------------------------------------------------------
+    /// find site by its name
+    CRepoSitePtr FindSite(const CSmallString& name) const;
+
+    /// find site by SCRIPT_NAME
+    CRepoSitePtr FindSiteByScript(const CSmallString& script_name) const;
+
+    /// get default site
+    CRepoSitePtr GetDefaultSite(void) const;
+
+    /// get all sites
+    const std::vector<CRepoSitePtr>& GetSites(void) const;
+
+// section of private data -----------------------------------------------------
+private:
+    std::vector<CRepoSitePtr>                       Sites;
+    std::unordered_map<std::string,CRepoSitePtr>    SitesByName;
+    std::unordered_map<std::string,CRepoSitePtr>    SitesByScript;
+};
+
+//------------------------------------------------------------------------------
+
+typedef std::shared_ptr<const CRepoSites> CRepoSitesPtr;
+
+//------------------------------------------------------------------------------
+
+#endif
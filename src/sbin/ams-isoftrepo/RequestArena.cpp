@@ -0,0 +1,147 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "RequestArena.hpp"
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+// size of the first chunk and the largest chunk kept across resets
+#define ARENA_MIN_CHUNK     (64*1024)
+#define ARENA_MAX_CHUNK     (1024*1024)
+
+static std::atomic<bool> ArenaEnabled(true);
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CRequestArena::CRequestArena(void)
+{
+    Top = NULL;
+    End = NULL;
+    UsedSize = 0;
+}
+
+//------------------------------------------------------------------------------
+
+CRequestArena::~CRequestArena(void)
+{
+    for(char* p_chunk : Chunks){
+        free(p_chunk);
+    }
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void* CRequestArena::Allocate(size_t size,size_t align)
+{
+    if( size == 0 ) size = 1;
+
+    uintptr_t top = ((uintptr_t)Top + align - 1) & ~(uintptr_t)(align - 1);
+    if( (Top == NULL) || (top + size > (uintptr_t)End) ) {
+        size_t chunk_size = Chunks.empty() ? ARENA_MIN_CHUNK : 2*ChunkSizes.back();
+        if( chunk_size < size + align ) chunk_size = size + align;
+        AddChunk(chunk_size);
+        top = ((uintptr_t)Top + align - 1) & ~(uintptr_t)(align - 1);
+    }
+
+    Top = (char*)(top + size);
+    UsedSize += size;
+    return((void*)top);
+}
+
+//------------------------------------------------------------------------------
+
+void CRequestArena::Reset(void)
+{
+    if( Chunks.size() > 1 ) {
+        // replace chunks by a single one large enough for a similar request
+        size_t total = 0;
+        for(size_t i=0; i < Chunks.size(); i++){
+            total += ChunkSizes[i];
+            free(Chunks[i]);
+        }
+        Chunks.clear();
+        ChunkSizes.clear();
+        if( total > ARENA_MAX_CHUNK ) total = ARENA_MAX_CHUNK;
+        AddChunk(total);
+    }
+    if( Chunks.empty() == false ) {
+        Top = Chunks.front();
+        End = Top + ChunkSizes.front();
+    }
+    UsedSize = 0;
+}
+
+//------------------------------------------------------------------------------
+
+size_t CRequestArena::GetUsedSize(void) const
+{
+    return(UsedSize);
+}
+
+//------------------------------------------------------------------------------
+
+void CRequestArena::AddChunk(size_t size)
+{
+    char* p_chunk = (char*)malloc(size);
+    if( p_chunk == NULL ) throw std::bad_alloc();
+    Chunks.push_back(p_chunk);
+    ChunkSizes.push_back(size);
+    Top = p_chunk;
+    End = p_chunk + size;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CRequestArena& CRequestArena::GetThreadArena(void)
+{
+    static thread_local CRequestArena arena;
+    return(arena);
+}
+
+//------------------------------------------------------------------------------
+
+void CRequestArena::SetEnabled(bool enabled)
+{
+    ArenaEnabled = enabled;
+}
+
+//------------------------------------------------------------------------------
+
+bool CRequestArena::IsEnabled(void)
+{
+    return(ArenaEnabled);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
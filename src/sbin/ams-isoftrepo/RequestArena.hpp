@@ -0,0 +1,157 @@
+#ifndef RequestArenaH
+#define RequestArenaH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+
+/// bump allocator for request temporaries owned by one worker thread
+/// memory is never freed individually, the whole arena is reset once the
+/// request is finished, so nothing allocated from it may outlive the request
+
+class CRequestArena {
+public:
+    CRequestArena(void);
+    ~CRequestArena(void);
+
+// main methods ----------------------------------------------------------------
+    /// allocate memory
+    void* Allocate(size_t size,size_t align);
+
+    /// release all allocations at once
+    void Reset(void);
+
+    /// number of bytes allocated since the last reset
+    size_t GetUsedSize(void) const;
+
+// thread arena ----------------------------------------------------------------
+    /// get arena of the calling thread
+    static CRequestArena& GetThreadArena(void);
+
+    /// enable or disable arenas, allocators created later use the heap if disabled
+    static void SetEnabled(bool enabled);
+
+    /// are arenas enabled?
+    static bool IsEnabled(void);
+
+// section of private data -----------------------------------------------------
+private:
+    std::vector<char*>  Chunks;         // the first one survives resets
+    std::vector<size_t> ChunkSizes;
+    char*               Top;
+    char*               End;
+    size_t              UsedSize;
+
+    /// allocate new chunk
+    void AddChunk(size_t size);
+};
+
+//------------------------------------------------------------------------------
+
+/// STL allocator backed by the arena of the creating thread
+
+template<class T>
+class CArenaAllocator {
+public:
+    typedef T value_type;
+
+    CArenaAllocator(void);
+    template<class U> CArenaAllocator(const CArenaAllocator<U>& src);
+
+    T*   allocate(size_t n);
+    void deallocate(T* p_data,size_t n);
+
+    CRequestArena*  Arena;      // NULL - heap is used
+};
+
+template<class T,class U>
+bool operator == (const CArenaAllocator<T>& left,const CArenaAllocator<U>& right);
+
+template<class T,class U>
+bool operator != (const CArenaAllocator<T>& left,const CArenaAllocator<U>& right);
+
+//------------------------------------------------------------------------------
+
+/// buffer for names joined during the request, template parameters take
+/// CSmallString, thus the joined name is converted only once
+typedef std::basic_string<char,std::char_traits<char>,CArenaAllocator<char> > CArenaString;
+
+//------------------------------------------------------------------------------
+
+// template implementation ----------------------------------------------------
+
+template<class T>
+CArenaAllocator<T>::CArenaAllocator(void)
+{
+    Arena = CRequestArena::IsEnabled() ? &CRequestArena::GetThreadArena() : NULL;
+}
+
+//------------------------------------------------------------------------------
+
+template<class T> template<class U>
+CArenaAllocator<T>::CArenaAllocator(const CArenaAllocator<U>& src)
+{
+    Arena = src.Arena;
+}
+
+//------------------------------------------------------------------------------
+
+template<class T>
+T* CArenaAllocator<T>::allocate(size_t n)
+{
+    if( Arena == NULL ) return(static_cast<T*>(::operator new(n*sizeof(T))));
+    return(static_cast<T*>(Arena->Allocate(n*sizeof(T),alignof(T))));
+}
+
+//------------------------------------------------------------------------------
+
+template<class T>
+void CArenaAllocator<T>::deallocate(T* p_data,size_t)
+{
+    // arena memory is released by Reset
+    if( Arena == NULL ) ::operator delete(p_data);
+}
+
+//------------------------------------------------------------------------------
+
+template<class T,class U>
+bool operator == (const CArenaAllocator<T>& left,const CArenaAllocator<U>& right)
+{
+    return(left.Arena == right.Arena);
+}
+
+//------------------------------------------------------------------------------
+
+template<class T,class U>
+bool operator != (const CArenaAllocator<T>& left,const CArenaAllocator<U>& right)
+{
+    return(left.Arena != right.Arena);
+}
+
+//------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,254 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "RequestTimer.hpp"
+#include "ServerMetrics.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <string>
+#include <stdio.h>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+// number of recent requests used for percentiles
+#define PHASE_STAT_WINDOW       1024
+
+// print summary after this number of requests
+#define PHASE_STAT_PERIOD       100
+
+static const char* PhaseNames[ERP_MAX] = {
+    "load", "merge", "params", "preprocess", "print", "write", "queue"
+};
+
+static thread_local CRequestTimer* ThreadTimer = NULL;
+
+//------------------------------------------------------------------------------
+
+// values are supplied by clients, percent-encode everything that could
+// break the record into more lines or fields
+static void AppendValue(CSmallString& record,const char* p_value)
+{
+    static const char* hex = "0123456789ABCDEF";
+
+    std::string value;
+    for(const unsigned char* p = (const unsigned char*)p_value; (p != NULL) && (*p != '\0'); p++){
+        if( (*p <= ' ') || (*p >= 0x7f) || (*p == '%') || (*p == '=') || (*p == '"') ) {
+            value += '%';
+            value += hex[*p >> 4];
+            value += hex[*p & 0x0f];
+        } else {
+            value += *p;
+        }
+    }
+    record << value.c_str();
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CRequestTimer::CRequestTimer(uint64_t arrival)
+{
+    StartTime = GetMonotonicTime();
+    TotalTime = 0;
+    for(int i=0; i < ERP_MAX; i++) PhaseTime[i] = 0;
+
+    if( (arrival > 0) && (arrival < StartTime) ) {
+        PhaseTime[ERP_QUEUE] = StartTime - arrival;
+        StartTime = arrival;
+    }
+
+    // attach to the thread
+    PrevTimer = ThreadTimer;
+    ThreadTimer = this;
+}
+
+//------------------------------------------------------------------------------
+
+CRequestTimer::~CRequestTimer(void)
+{
+    ThreadTimer = PrevTimer;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CRequestTimer::AddPhaseTime(ERequestPhase phase,uint64_t usec)
+{
+    PhaseTime[phase] += usec;
+}
+
+//------------------------------------------------------------------------------
+
+void CRequestTimer::Finish(uint64_t handler_usec)
+{
+    TotalTime = GetMonotonicTime() - StartTime;
+
+    uint64_t other = 0;
+    for(int i=0; i < ERP_MAX; i++){
+        if( (i != ERP_PARAMS) && (i != ERP_QUEUE) ) other += PhaseTime[i];
+    }
+    if( handler_usec > other ) {
+        PhaseTime[ERP_PARAMS] = handler_usec - other;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+uint64_t CRequestTimer::GetPhaseTime(ERequestPhase phase) const
+{
+    return(PhaseTime[phase]);
+}
+
+//------------------------------------------------------------------------------
+
+uint64_t CRequestTimer::GetTotalTime(void) const
+{
+    return(TotalTime);
+}
+
+//------------------------------------------------------------------------------
+
+const CSmallString CRequestTimer::GetRecord(const CSmallString& action,const CSmallString& module) const
+{
+    CSmallString record;
+    char         buffer[64];
+
+    record << "slow-request action=";
+    AppendValue(record,action == NULL ? "categories" : (const char*)action);
+    if( module != NULL ) {
+        record << " module=";
+        AppendValue(record,module);
+    }
+    snprintf(buffer,sizeof(buffer)," total_ms=%.3f",TotalTime * 1.0e-3);
+    record << buffer;
+    for(int i=0; i < ERP_MAX; i++){
+        snprintf(buffer,sizeof(buffer)," %s_ms=%.3f",PhaseNames[i],PhaseTime[i] * 1.0e-3);
+        record << buffer;
+    }
+    return(record);
+}
+
+//------------------------------------------------------------------------------
+
+CRequestTimer* CRequestTimer::GetThreadTimer(void)
+{
+    return(ThreadTimer);
+}
+
+//------------------------------------------------------------------------------
+
+const char* CRequestTimer::GetPhaseName(ERequestPhase phase)
+{
+    return(PhaseNames[phase]);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CPhaseTimer::CPhaseTimer(ERequestPhase phase)
+{
+    Phase = phase;
+    StartTime = GetMonotonicTime();
+}
+
+//------------------------------------------------------------------------------
+
+CPhaseTimer::~CPhaseTimer(void)
+{
+    CRequestTimer* p_timer = CRequestTimer::GetThreadTimer();
+    if( p_timer == NULL ) return;
+    p_timer->AddPhaseTime(Phase,GetMonotonicTime() - StartTime);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CPhaseStatistics::CPhaseStatistics(void)
+{
+    for(int i=0; i <= ERP_MAX; i++){
+        Samples[i].resize(PHASE_STAT_WINDOW);
+    }
+    Position = 0;
+    NumOfSamples = 0;
+    NumOfRequests = 0;
+}
+
+//------------------------------------------------------------------------------
+
+bool CPhaseStatistics::AddSample(const CRequestTimer& timer)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+
+    for(int i=0; i < ERP_MAX; i++){
+        Samples[i][Position] = timer.GetPhaseTime((ERequestPhase)i);
+    }
+    Samples[ERP_MAX][Position] = timer.GetTotalTime();
+
+    Position = (Position + 1) % PHASE_STAT_WINDOW;
+    if( NumOfSamples < PHASE_STAT_WINDOW ) NumOfSamples++;
+    NumOfRequests++;
+
+    return( NumOfRequests % PHASE_STAT_PERIOD == 0 );
+}
+
+//------------------------------------------------------------------------------
+
+void CPhaseStatistics::PrintStatistics(std::ostream& vout)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+
+    if( NumOfSamples == 0 ) return;
+
+    vout << "# Phase times [ms] of the last " << NumOfSamples << " requests (total " << NumOfRequests << ")" << std::endl;
+    vout << "# phase            p50        p90        p99        max" << std::endl;
+
+    // the stream is shared, restore its format at the end
+    std::ios_base::fmtflags flags = vout.flags();
+    std::streamsize         precision = vout.precision();
+
+    std::vector<uint64_t> data;
+    for(int i=0; i <= ERP_MAX; i++){
+        data.assign(Samples[i].begin(),Samples[i].begin() + NumOfSamples);
+        std::sort(data.begin(),data.end());
+
+        const char* p_name = i < ERP_MAX ? PhaseNames[i] : "total";
+        vout << "# " << std::left << std::setw(12) << p_name << std::right << std::fixed << std::setprecision(3);
+        vout << " " << std::setw(10) << data[(NumOfSamples-1)*50/100] * 1.0e-3;
+        vout << " " << std::setw(10) << data[(NumOfSamples-1)*90/100] * 1.0e-3;
+        vout << " " << std::setw(10) << data[(NumOfSamples-1)*99/100] * 1.0e-3;
+        vout << " " << std::setw(10) << data[NumOfSamples-1] * 1.0e-3;
+        vout << std::endl;
+    }
+
+    vout.flags(flags);
+    vout.precision(precision);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
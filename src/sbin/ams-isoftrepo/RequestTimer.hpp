@@ -0,0 +1,129 @@
+#ifndef RequestTimerH
+#define RequestTimerH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <SmallString.hpp>
+#include <ostream>
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+
+/// request processing phases
+enum ERequestPhase {
+    ERP_LOAD_BUNDLES    = 0,    // CCatalogTable::Load, streaming of bundle caches
+    ERP_MERGE_BUNDLES   = 1,    // CCatalogBitmapIndex::Build
+    ERP_PARAMS          = 2,    // building of CTemplateParams
+    ERP_PREPROCESS      = 3,    // CTemplatePreprocessor::PreprocessTemplate
+    ERP_PRINT           = 4,    // CXMLPrinter::Print
+    ERP_WRITE           = 5,    // FCGI output
+    ERP_QUEUE           = 6,    // from arrival to the worker
+    ERP_MAX             = 7
+};
+
+//------------------------------------------------------------------------------
+
+/// monotonic timer of one request split into phases
+/// the timer is attached to the thread processing the request
+
+class CRequestTimer {
+public:
+    /// the request arrived at arrival (monotonic, in us), zero - now
+    CRequestTimer(uint64_t arrival = 0);
+    ~CRequestTimer(void);
+
+// main methods ----------------------------------------------------------------
+    /// add time to the phase
+    void AddPhaseTime(ERequestPhase phase,uint64_t usec);
+
+    /// finish request measurement, the time not covered by other phases
+    /// of the handler is assigned to ERP_PARAMS, the total time includes
+    /// time spent in the queue
+    void Finish(uint64_t handler_usec);
+
+    /// get phase time in microseconds
+    uint64_t GetPhaseTime(ERequestPhase phase) const;
+
+    /// get total time in microseconds
+    uint64_t GetTotalTime(void) const;
+
+    /// get structured record of the request
+    const CSmallString GetRecord(const CSmallString& action,const CSmallString& module) const;
+
+    /// timer of the calling thread, NULL if none
+    static CRequestTimer* GetThreadTimer(void);
+
+    /// get phase name
+    static const char* GetPhaseName(ERequestPhase phase);
+
+// section of private data -----------------------------------------------------
+private:
+    uint64_t        StartTime;
+    uint64_t        TotalTime;
+    uint64_t        PhaseTime[ERP_MAX];
+    CRequestTimer*  PrevTimer;
+};
+
+//------------------------------------------------------------------------------
+
+/// measures the phase within its scope
+
+class CPhaseTimer {
+public:
+    CPhaseTimer(ERequestPhase phase);
+    ~CPhaseTimer(void);
+
+// section of private data -----------------------------------------------------
+private:
+    ERequestPhase   Phase;
+    uint64_t        StartTime;
+};
+
+//------------------------------------------------------------------------------
+
+/// rolling percentiles of phase times over the most recent requests
+
+class CPhaseStatistics {
+public:
+    CPhaseStatistics(void);
+
+// main methods ----------------------------------------------------------------
+    /// add request sample, returns true when a summary is due
+    bool AddSample(const CRequestTimer& timer);
+
+    /// print percentiles
+    void PrintStatistics(std::ostream& vout);
+
+// section of private data -----------------------------------------------------
+private:
+    std::mutex              Lock;
+    std::vector<uint64_t>   Samples[ERP_MAX+1];     // the last one is the total time
+    size_t                  Position;
+    size_t                  NumOfSamples;
+    uint64_t                NumOfRequests;
+};
+
+//------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef ResponseWriterH
+#define ResponseWriterH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <FCGIRequest.hpp>
+#include <string.h>
+
+//------------------------------------------------------------------------------
+
+/// destination of the response, it hides the FastCGI transport
+
+class CResponseWriter {
+public:
+    virtual ~CResponseWriter(void);
+
+// main methods ----------------------------------------------------------------
+    /// write response data
+    virtual bool Write(const char* p_data,size_t len) = 0;
+
+    /// write string
+    bool Write(const char* p_str);
+
+    /// finish response
+    virtual bool Finish(void) = 0;
+};
+
+//------------------------------------------------------------------------------
+
+/// response of requests accepted by CFCGIServer
+
+class CFCGIRequestWriter : public CResponseWriter {
+public:
+    CFCGIRequestWriter(CFCGIRequest& request);
+
+// main methods ----------------------------------------------------------------
+    virtual bool Write(const char* p_data,size_t len);
+    virtual bool Finish(void);
+
+    using CResponseWriter::Write;
+
+// section of private data -----------------------------------------------------
+private:
+    CFCGIRequest&   Request;
+};
+
+//------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,786 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "ServerConfig.hpp"
+#include <ErrorSystem.hpp>
+#include <XMLElement.hpp>
+#include <XMLParser.hpp>
+#include "ServerMetrics.hpp"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace std;
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CSiteConfig::CSiteConfig(void)
+{
+    PageCacheSize = 0;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CServerConfig::CServerConfig(void)
+{
+    PortNumber = 0;
+    SocketMode = 0;
+    NumOfWorkers = 0;
+    KeepAliveTimeout = 0;
+    TemplateHotReload = false;
+    CatalogTimeToLive = 0;
+    CatalogSharing = ESCM_NONE;
+    PageCacheSize = 0;
+    FragmentCacheSize = 0;
+    PageCacheHotKeys = 0;
+    PrewarmTimeout = 0;
+    ModuleVersionsLimit = 0;
+    AdmissionSlots = 0;
+    AdmissionQueueDepth = 0;
+    AdmissionDeadline = 0;
+    RetryAfter = 0;
+    RateLimit = 0;
+    RateBurst = 0;
+    RateClients = 0;
+    RateIdleTimeout = 0;
+    MetricsEnabled = false;
+    SlowRequestThreshold = 0;
+    WatcherControl = NULL;
+    MonitoringIFrame = NULL;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CServerConfig::Load(const CFileName& config_path)
+{
+    CXMLParser xml_parser;
+    xml_parser.SetOutputXMLNode(&Document);
+    xml_parser.EnableWhiteCharacters(true);
+
+    if( xml_parser.Parse(config_path) == false ) {
+        CSmallString error;
+        error << "unable to load server config";
+        ES_ERROR(error);
+        return(false);
+    }
+
+    PortNumber = GetPortNumber();
+    SocketPath = GetSocketPath();
+    SocketMode = GetSocketMode();
+    SocketGroup = GetSocketGroup();
+    NumOfWorkers = GetNumOfWorkers();
+    KeepAliveTimeout = GetKeepAliveTimeout();
+    TemplatePath = GetTemplatePath();
+    TemplateHotReload = GetTemplateHotReload();
+
+    CatalogTimeToLive = GetCatalogTimeToLive();
+    CatalogSharing = GetCatalogSharing();
+    CatalogSegment = GetCatalogSegment();
+
+    PageCacheSize = GetPageCacheSize();
+    FragmentCacheSize = GetFragmentCacheSize();
+    PageCacheHotKeys = GetPageCacheHotKeys();
+    PrewarmTimeout = GetPrewarmTimeout();
+
+    ModuleVersionsLimit = GetModuleVersionsLimit();
+
+    if( LoadSites() == false ) return(false);
+
+    AdmissionSlots = GetAdmissionSlots();
+    AdmissionQueueDepth = GetAdmissionQueueDepth();
+    AdmissionDeadline = GetAdmissionDeadline();
+    RetryAfter = GetRetryAfter();
+    PrepareOverloadedResponse(RetryAfter);
+
+    RateLimit = GetRateLimit();
+    RateBurst = GetRateBurst();
+    RateClients = GetRateClients();
+    RateIdleTimeout = GetRateIdleTimeout();
+    LoadRateCosts();
+    PrepareThrottledResponse();
+
+    MetricsEnabled = GetMetricsEnabled();
+
+    WatcherControl = Document.GetChildElementByPath("config/watcher");
+    WatcherLogName = GetWatcherLogName();
+    SlowRequestThreshold = GetSlowRequestThreshold();
+
+    MonitoringIFrame = Document.GetChildElementByPath("config/monitoring",true);
+
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+void CServerConfig::PrintConfig(CVerboseStr& vout)
+{
+    vout << "#" << endl;
+    vout << "# === [server] =================================================================" << endl;
+    if( SocketPath != NULL ) {
+        vout << "# FCGI Socket = " << SocketPath << endl;
+        char mode[16];
+        snprintf(mode,sizeof(mode),"%04o",SocketMode);
+        vout << "# Mode        = " << mode << endl;
+        if( SocketGroup != NULL ) {
+            vout << "# Group       = " << SocketGroup << endl;
+        }
+        vout << "# Workers     = " << NumOfWorkers << endl;
+        vout << "# Keep-alive  = " << KeepAliveTimeout << " s" << endl;
+    } else {
+        vout << "# FCGI Port  = " << PortNumber << endl;
+    }
+    vout << "# Templates  = " << TemplatePath << endl;
+    vout << "# Hot reload = " << (TemplateHotReload ? "true" : "false") << endl;
+    vout << "#" << endl;
+
+    for(const CSiteConfig& site : Sites){
+        vout << "#" << endl;
+        vout << "# === [ams-bundles] ============================================================" << endl;
+        vout << "# Site      = " << site.Name << endl;
+        vout << "# Name      = " << site.BundleName << endl;
+        vout << "# Path      = " << site.BundlePath << endl;
+        if( site.ScriptName != NULL ) {
+            vout << "# Script    = " << site.ScriptName << endl;
+        }
+        vout << "# Cache     = " << site.PageCacheSize / (1024*1024) << " MB" << endl;
+        if( CatalogSharing != ESCM_NONE ) {
+            vout << "# Segment   = " << site.CatalogSegment << endl;
+        }
+        vout << "#" << endl;
+    }
+
+    vout << "#" << endl;
+    vout << "# === [catalog] ================================================================" << endl;
+    vout << "# Catalog TTL = " << CatalogTimeToLive << " s" << endl;
+    if( CatalogSharing == ESCM_PUBLISH ) {
+        vout << "# Shared      = publish" << endl;
+    }
+    if( CatalogSharing == ESCM_ATTACH ) {
+        vout << "# Shared      = attach" << endl;
+    }
+    vout << "#" << endl;
+
+    vout << "#" << endl;
+    vout << "# === [pages] ==================================================================" << endl;
+    vout << "# Fragments   = " << FragmentCacheSize / (1024*1024) << " MB per site" << endl;
+    if( PageCacheHotKeys > 0 ) {
+        vout << "# Hot keys    = " << PageCacheHotKeys << " per site" << endl;
+        vout << "# Prewarm     = " << PrewarmTimeout << " ms" << endl;
+    } else {
+        vout << "# Hot keys    = disabled" << endl;
+    }
+    if( ModuleVersionsLimit > 0 ) {
+        vout << "# Versions    = " << ModuleVersionsLimit << endl;
+    } else {
+        vout << "# Versions    = all" << endl;
+    }
+    vout << "#" << endl;
+
+    vout << "#" << endl;
+    vout << "# === [admission] ==============================================================" << endl;
+    vout << "# Slots       = " << AdmissionSlots << endl;
+    vout << "# Queue depth = " << AdmissionQueueDepth << endl;
+    vout << "# Deadline    = " << AdmissionDeadline << " ms" << endl;
+    vout << "# Retry after = " << RetryAfter << " s" << endl;
+    vout << "#" << endl;
+
+    vout << "#" << endl;
+    vout << "# === [ratelimit] ==============================================================" << endl;
+    if( RateLimit > 0 ) {
+        vout << "# Rate        = " << RateLimit << " per s" << endl;
+        vout << "# Burst       = " << RateBurst << endl;
+        vout << "# Clients     = " << RateClients << endl;
+        vout << "# Idle        = " << RateIdleTimeout << " s" << endl;
+        vout << "# Costs       =";
+        for(int i=0; i < ERA_METRICS; i++){
+            vout << " " << CServerMetrics::GetActionName((ERequestAction)i) << ":" << RateCosts[i];
+        }
+        vout << endl;
+    } else {
+        vout << "# Rate        = disabled" << endl;
+    }
+    vout << "#" << endl;
+
+    vout << "#" << endl;
+    vout << "# === [metrics] ================================================================" << endl;
+    vout << "# Enabled   = " << (MetricsEnabled ? "true" : "false") << endl;
+    vout << "#" << endl;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+int CServerConfig::GetPortNumber(void)
+{
+    int setup = 32696;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/server");
+    if( p_ele == NULL ) {
+        ES_ERROR("unable to open config path");
+        return(setup);
+    }
+    if( p_ele->GetAttribute("port",setup) == false ) {
+        ES_ERROR("unable to get port value");
+        return(setup);
+    }
+    return(setup);
+}
+
+//------------------------------------------------------------------------------
+
+const CFileName CServerConfig::GetSocketPath(void)
+{
+    CFileName setup;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/server");
+    if( p_ele == NULL ) {
+        return(setup);
+    }
+    p_ele->GetAttribute("socket",setup);
+    return(setup);
+}
+
+//------------------------------------------------------------------------------
+
+int CServerConfig::GetSocketMode(void)
+{
+    int setup = 0660;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/server");
+    if( p_ele == NULL ) {
+        return(setup);
+    }
+    // octal as for chmod
+    CSmallString mode;
+    if( p_ele->GetAttribute("mode",mode) == false ) {
+        return(setup);
+    }
+    char* p_end = NULL;
+    long  value = strtol(mode,&p_end,8);
+    if( (p_end == NULL) || (*p_end != '\0') || (value < 0) || (value > 0777) ) {
+        ES_ERROR("invalid socket mode, 0660 is used");
+        return(setup);
+    }
+    setup = value;
+    return(setup);
+}
+
+//------------------------------------------------------------------------------
+
+const CSmallString CServerConfig::GetSocketGroup(void)
+{
+    CSmallString setup;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/server");
+    if( p_ele == NULL ) {
+        return(setup);
+    }
+    p_ele->GetAttribute("group",setup);
+    return(setup);
+}
+
+//------------------------------------------------------------------------------
+
+int CServerConfig::GetNumOfWorkers(void)
+{
+    int setup = 8;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/server");
+    if( p_ele != NULL ) {
+        p_ele->GetAttribute("workers",setup);
+    }
+    if( setup < 1 ) setup = 1;
+    return(setup);
+}
+
+//------------------------------------------------------------------------------
+
+int CServerConfig::GetKeepAliveTimeout(void)
+{
+    int setup = 60;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/server");
+    if( p_ele != NULL ) {
+        p_ele->GetAttribute("keepalive",setup);
+    }
+    if( setup < 1 ) setup = 1;
+    return(setup);
+}
+
+//------------------------------------------------------------------------------
+
+const CFileName CServerConfig::GetTemplatePath(void)
+{
+    CFileName temp_dir = "/opt/ams-isoftrepo/9.0/var/html/isoftrepo/templates";
+
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/server");
+    if( p_ele == NULL ) {
+        ES_ERROR("unable to open config path");
+        return(temp_dir);
+    }
+    if( p_ele->GetAttribute("templates",temp_dir) == false ) {
+        ES_ERROR("unable to get templates values");
+        return(temp_dir);
+    }
+    return(temp_dir);
+}
+
+//------------------------------------------------------------------------------
+
+bool CServerConfig::GetTemplateHotReload(void)
+{
+    bool setup = true;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/server");
+    if( p_ele == NULL ) {
+        return(setup);
+    }
+    p_ele->GetAttribute("hotreload",setup);
+    return(setup);
+}
+
+//------------------------------------------------------------------------------
+
+bool CServerConfig::LoadSites(void)
+{
+    std::vector<bool> own_cache;
+
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/ams");
+    if( p_ele == NULL ) {
+        ES_ERROR("unable to open config/ams path");
+        return(false);
+    }
+
+    while( p_ele != NULL ){
+        CSiteConfig site;
+        if( p_ele->GetAttribute("site",site.Name) == false ) {
+            if( Sites.empty() == false ) {
+                ES_ERROR("site attribute is required when several ams elements are specified");
+                return(false);
+            }
+            site.Name = "default";
+        }
+        if( p_ele->GetAttribute("name",site.BundleName) == false ) {
+            ES_ERROR("unable to get name item");
+            return(false);
+        }
+        CSmallString path;
+        if( p_ele->GetAttribute("path",path) == false ) {
+            ES_ERROR("unable to get path item");
+            return(false);
+        }
+        site.BundlePath = path;
+        p_ele->GetAttribute("script",site.ScriptName);
+
+        for(const CSiteConfig& other : Sites){
+            if( other.Name == site.Name ) {
+                CSmallString error;
+                error << "site '" << site.Name << "' is specified more than once";
+                ES_ERROR(error);
+                return(false);
+            }
+        }
+
+        // the first site keeps the segment name, so single site setups are not affected
+        site.CatalogSegment = CatalogSegment;
+        if( Sites.empty() == false ) {
+            site.CatalogSegment << "-" << site.Name;
+        }
+
+        int size = -1;
+        p_ele->GetAttribute("pagecache",size);
+        if( size >= 0 ) site.PageCacheSize = (size_t)size*1024*1024;
+
+        Sites.push_back(site);
+        own_cache.push_back(size >= 0);
+        p_ele = p_ele->GetNextSiblingElement("ams");
+    }
+
+    // sites without own page cache size split the rest of the global one
+    size_t reserved = 0;
+    size_t num_of_shared = 0;
+    for(size_t i=0; i < Sites.size(); i++){
+        if( own_cache[i] ) {
+            reserved += Sites[i].PageCacheSize;
+        } else {
+            num_of_shared++;
+        }
+    }
+    if( num_of_shared > 0 ) {
+        size_t size = PageCacheSize > reserved ? (PageCacheSize - reserved) / num_of_shared : 0;
+        for(size_t i=0; i < Sites.size(); i++){
+            if( own_cache[i] == false ) Sites[i].PageCacheSize = size;
+        }
+    }
+
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+int CServerConfig::GetCatalogTimeToLive(void)
+{
+    int setup = 60;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/catalog");
+    if( p_ele == NULL ) {
+        return(setup);
+    }
+    p_ele->GetAttribute("ttl",setup);
+    return(setup);
+}
+
+//------------------------------------------------------------------------------
+
+ESharedCatalogMode CServerConfig::GetCatalogSharing(void)
+{
+    CSmallString setup;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/catalog");
+    if( p_ele == NULL ) {
+        return(ESCM_NONE);
+    }
+    p_ele->GetAttribute("shared",setup);
+    if( (setup == NULL) || (setup == "none") ) return(ESCM_NONE);
+    if( setup == "publish" ) return(ESCM_PUBLISH);
+    if( setup == "attach" ) return(ESCM_ATTACH);
+
+    CSmallString error;
+    error << "unsupported catalog sharing '" << setup << "', sharing is disabled";
+    ES_ERROR(error);
+    return(ESCM_NONE);
+}
+
+//------------------------------------------------------------------------------
+
+const CSmallString CServerConfig::GetCatalogSegment(void)
+{
+    CSmallString setup = "/ams-isoftrepo-catalog";
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/catalog");
+    if( p_ele == NULL ) {
+        return(setup);
+    }
+    p_ele->GetAttribute("segment",setup);
+    return(setup);
+}
+
+//------------------------------------------------------------------------------
+
+size_t CServerConfig::GetPageCacheSize(void)
+{
+    int setup = 64;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/pagecache");
+    if( p_ele != NULL ) {
+        p_ele->GetAttribute("size",setup);
+    }
+    if( setup < 0 ) setup = 0;
+    return((size_t)setup*1024*1024);
+}
+
+//------------------------------------------------------------------------------
+
+size_t CServerConfig::GetFragmentCacheSize(void)
+{
+    int setup = 8;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/pagecache");
+    if( p_ele != NULL ) {
+        p_ele->GetAttribute("fragments",setup);
+    }
+    if( setup < 0 ) setup = 0;
+    return((size_t)setup*1024*1024);
+}
+
+//------------------------------------------------------------------------------
+
+int CServerConfig::GetPageCacheHotKeys(void)
+{
+    int setup = 32;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/pagecache");
+    if( p_ele != NULL ) {
+        p_ele->GetAttribute("hotkeys",setup);
+    }
+    if( setup < 0 ) setup = 0;
+    return(setup);
+}
+
+//------------------------------------------------------------------------------
+
+int CServerConfig::GetPrewarmTimeout(void)
+{
+    int setup = 2000;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/pagecache");
+    if( p_ele != NULL ) {
+        p_ele->GetAttribute("prewarm",setup);
+    }
+    if( setup < 0 ) setup = 0;
+    return(setup);
+}
+
+//------------------------------------------------------------------------------
+
+int CServerConfig::GetModuleVersionsLimit(void)
+{
+    int setup = 20;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/pages");
+    if( p_ele != NULL ) {
+        p_ele->GetAttribute("versions",setup);
+    }
+    if( setup < 0 ) setup = 0;
+    return(setup);
+}
+
+//------------------------------------------------------------------------------
+
+int CServerConfig::GetAdmissionSlots(void)
+{
+    int setup = 0;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/admission");
+    if( p_ele == NULL ) {
+        return(setup);
+    }
+    p_ele->GetAttribute("slots",setup);
+    return(setup);
+}
+
+//------------------------------------------------------------------------------
+
+int CServerConfig::GetAdmissionQueueDepth(void)
+{
+    int setup = 0;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/admission");
+    if( p_ele == NULL ) {
+        return(setup);
+    }
+    p_ele->GetAttribute("queue",setup);
+    return(setup);
+}
+
+//------------------------------------------------------------------------------
+
+int CServerConfig::GetAdmissionDeadline(void)
+{
+    int setup = 2000;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/admission");
+    if( p_ele == NULL ) {
+        return(setup);
+    }
+    p_ele->GetAttribute("deadline",setup);
+    return(setup);
+}
+
+//------------------------------------------------------------------------------
+
+int CServerConfig::GetRetryAfter(void)
+{
+    int setup = 10;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/admission");
+    if( p_ele == NULL ) {
+        return(setup);
+    }
+    p_ele->GetAttribute("retryafter",setup);
+    return(setup);
+}
+
+//------------------------------------------------------------------------------
+
+double CServerConfig::GetRateLimit(void)
+{
+    double setup = 0;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/ratelimit");
+    if( p_ele == NULL ) {
+        return(setup);
+    }
+    p_ele->GetAttribute("rate",setup);
+    if( setup < 0 ) setup = 0;
+    return(setup);
+}
+
+//------------------------------------------------------------------------------
+
+double CServerConfig::GetRateBurst(void)
+{
+    double setup = 20;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/ratelimit");
+    if( p_ele == NULL ) {
+        return(setup);
+    }
+    p_ele->GetAttribute("burst",setup);
+    if( setup < 1 ) setup = 1;
+    return(setup);
+}
+
+//------------------------------------------------------------------------------
+
+int CServerConfig::GetRateClients(void)
+{
+    int setup = 65536;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/ratelimit");
+    if( p_ele == NULL ) {
+        return(setup);
+    }
+    p_ele->GetAttribute("clients",setup);
+    if( setup < 1 ) setup = 1;
+    return(setup);
+}
+
+//------------------------------------------------------------------------------
+
+int CServerConfig::GetRateIdleTimeout(void)
+{
+    int setup = 600;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/ratelimit");
+    if( p_ele == NULL ) {
+        return(setup);
+    }
+    p_ele->GetAttribute("idle",setup);
+    if( setup < 0 ) setup = 0;
+    return(setup);
+}
+
+//------------------------------------------------------------------------------
+
+void CServerConfig::LoadRateCosts(void)
+{
+    // bulk data are more expensive than pages, metrics are never limited
+    RateCosts.assign(ERA_MAX,1.0);
+    RateCosts[ERA_EXPORT] = 10.0;
+    RateCosts[ERA_METRICS] = 0.0;
+
+    CSmallString setup;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/ratelimit");
+    if( p_ele == NULL ) return;
+    p_ele->GetAttribute("costs",setup);
+    if( setup == NULL ) return;
+
+    // list of action:cost items
+    std::string list(setup);
+    size_t      pos = 0;
+    while( pos < list.size() ){
+        size_t end = list.find(',',pos);
+        if( end == std::string::npos ) end = list.size();
+        std::string item = list.substr(pos,end-pos);
+        pos = end + 1;
+        if( item.empty() ) continue;
+
+        size_t sep = item.find(':');
+        ERequestAction action = ERA_UNKNOWN;
+        if( sep != std::string::npos ) {
+            action = CServerMetrics::GetAction(item.substr(0,sep).c_str());
+        }
+        if( (sep == std::string::npos) || (action == ERA_UNKNOWN) || (action == ERA_METRICS) ) {
+            CSmallString error;
+            error << "invalid rate limit cost '" << item.c_str() << "', it is ignored";
+            ES_ERROR(error);
+            continue;
+        }
+        double cost = atof(item.substr(sep+1).c_str());
+        if( cost < 0 ) cost = 0;
+        RateCosts[action] = cost;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CServerConfig::PrepareThrottledResponse(void)
+{
+    // static body, no templates are involved
+    const char* p_body =
+        "<!DOCTYPE html>\n"
+        "<html><head><title>Too Many Requests</title></head>\n"
+        "<body><h1>Too Many Requests</h1>\n"
+        "<p>Too many requests from your address, please slow down.</p></body></html>\n";
+
+    // time to get a token back
+    int retry_after = 1;
+    if( RateLimit > 0 ) retry_after = (int)ceil(1.0 / RateLimit);
+    if( retry_after < 1 ) retry_after = 1;
+
+    ThrottledResponse = "Status: 429 Too Many Requests\r\n";
+    ThrottledResponse += "Retry-After: " + std::to_string(retry_after) + "\r\n";
+    ThrottledResponse += "Cache-Control: no-store\r\n";
+    ThrottledResponse += "Content-type: text/html\r\n";
+    ThrottledResponse += "\r\n";
+    ThrottledResponse += p_body;
+}
+
+//------------------------------------------------------------------------------
+
+bool CServerConfig::GetMetricsEnabled(void)
+{
+    bool setup = false;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/metrics");
+    if( p_ele == NULL ) {
+        return(setup);
+    }
+    if( p_ele->GetAttribute("enabled",setup) == false ) {
+        ES_ERROR("unable to get enabled value");
+        return(setup);
+    }
+    return(setup);
+}
+
+//------------------------------------------------------------------------------
+
+const CFileName CServerConfig::GetWatcherLogName(void)
+{
+    CFileName name;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/watcher");
+    if( p_ele == NULL ) {
+        return(name);
+    }
+    p_ele->GetAttribute("logname",name);
+    return(name);
+}
+
+//------------------------------------------------------------------------------
+
+int CServerConfig::GetSlowRequestThreshold(void)
+{
+    int setup = 0;
+    CXMLElement* p_ele = Document.GetChildElementByPath("config/watcher");
+    if( p_ele == NULL ) {
+        return(setup);
+    }
+    p_ele->GetAttribute("slowrequest",setup);
+    return(setup);
+}
+
+//------------------------------------------------------------------------------
+
+void CServerConfig::PrepareOverloadedResponse(int retry_after)
+{
+    // static body, no templates are involved
+    const char* p_body =
+        "<!DOCTYPE html>\n"
+        "<html><head><title>Service Unavailable</title></head>\n"
+        "<body><h1>Service Unavailable</h1>\n"
+        "<p>The software repository is overloaded, please try again later.</p></body></html>\n";
+
+    OverloadedResponse = "Status: 503 Service Unavailable\r\n";
+    OverloadedResponse += "Retry-After: " + std::to_string(retry_after) + "\r\n";
+    OverloadedResponse += "Cache-Control: no-store\r\n";
+    OverloadedResponse += "Content-type: text/html\r\n";
+    OverloadedResponse += "\r\n";
+    OverloadedResponse += p_body;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
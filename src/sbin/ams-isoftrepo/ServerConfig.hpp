@@ -0,0 +1,159 @@
+#ifndef ServerConfigH
+#define ServerConfigH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <SmallString.hpp>
+#include <FileName.hpp>
+#include <XMLDocument.hpp>
+#include <VerboseStr.hpp>
+#include "SharedCatalog.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------
+
+/// one AMS site, <ams> element
+
+class CSiteConfig {
+public:
+    CSiteConfig(void);
+
+    CSmallString        Name;
+    CSmallString        BundleName;
+    CFileName           BundlePath;
+    CSmallString        ScriptName;             // SCRIPT_NAME selecting the site
+    size_t              PageCacheSize;          // in bytes
+    CSmallString        CatalogSegment;         // shared memory name
+};
+
+//------------------------------------------------------------------------------
+
+/// server configuration parsed from isoftrepo.xml
+/// the object is not changed once it is published, reload creates a new one
+
+class CServerConfig {
+public:
+    CServerConfig(void);
+
+// main methods ----------------------------------------------------------------
+    /// parse configuration file
+    bool Load(const CFileName& config_path);
+
+    /// print configuration summary
+    void PrintConfig(CVerboseStr& vout);
+
+// section of public data ------------------------------------------------------
+public:
+    CXMLDocument        Document;
+    int                 PortNumber;
+    CFileName           SocketPath;             // unix socket replaces the port
+    int                 SocketMode;             // permissions of the socket
+    CSmallString        SocketGroup;            // group of the socket, empty - not changed
+    int                 NumOfWorkers;           // for unix socket
+    int                 KeepAliveTimeout;       // in s, idle kept connections
+    CFileName           TemplatePath;
+    bool                TemplateHotReload;
+    std::vector<CSiteConfig>    Sites;          // the first one is the default site
+    int                 CatalogTimeToLive;      // in s
+    ESharedCatalogMode  CatalogSharing;
+    CSmallString        CatalogSegment;         // shared memory name
+    size_t              PageCacheSize;          // in bytes
+    size_t              FragmentCacheSize;      // in bytes, per site
+    int                 PageCacheHotKeys;       // prewarmed keys per site, zero - disabled
+    int                 PrewarmTimeout;         // in ms
+    int                 ModuleVersionsLimit;    // versions embedded in module page, zero - all
+    int                 AdmissionSlots;
+    int                 AdmissionQueueDepth;
+    int                 AdmissionDeadline;      // in ms
+    int                 RetryAfter;             // in s
+    double              RateLimit;              // requests per s per client, zero - disabled
+    double              RateBurst;
+    int                 RateClients;            // tracked client addresses
+    int                 RateIdleTimeout;        // in s
+    std::vector<double> RateCosts;              // tokens taken by action
+    bool                MetricsEnabled;
+    CFileName           WatcherLogName;
+    int                 SlowRequestThreshold;   // in ms, zero - disabled
+    CXMLElement*        WatcherControl;
+    CXMLElement*        MonitoringIFrame;
+    std::string         OverloadedResponse;     // pre-rendered 503 response
+    std::string         ThrottledResponse;      // pre-rendered 429 response
+
+// section of private data -----------------------------------------------------
+private:
+    // fcgi server
+    int                 GetPortNumber(void);
+    const CFileName     GetSocketPath(void);
+    int                 GetSocketMode(void);
+    const CSmallString  GetSocketGroup(void);
+    int                 GetNumOfWorkers(void);
+    int                 GetKeepAliveTimeout(void);
+    const CFileName     GetTemplatePath(void);
+    bool                GetTemplateHotReload(void);
+
+    // ams sites
+    bool                LoadSites(void);
+    int                 GetCatalogTimeToLive(void);
+    ESharedCatalogMode  GetCatalogSharing(void);
+    const CSmallString  GetCatalogSegment(void);
+
+    // page cache
+    size_t              GetPageCacheSize(void);
+    size_t              GetFragmentCacheSize(void);
+    int                 GetPageCacheHotKeys(void);
+    int                 GetPrewarmTimeout(void);
+
+    // pages
+    int                 GetModuleVersionsLimit(void);
+
+    // admission control
+    int                 GetAdmissionSlots(void);
+    int                 GetAdmissionQueueDepth(void);
+    int                 GetAdmissionDeadline(void);
+    int                 GetRetryAfter(void);
+    void                PrepareOverloadedResponse(int retry_after);
+
+    // rate limiting
+    double              GetRateLimit(void);
+    double              GetRateBurst(void);
+    int                 GetRateClients(void);
+    int                 GetRateIdleTimeout(void);
+    void                LoadRateCosts(void);
+    void                PrepareThrottledResponse(void);
+
+    // metrics
+    bool                GetMetricsEnabled(void);
+
+    // watcher
+    const CFileName     GetWatcherLogName(void);
+    int                 GetSlowRequestThreshold(void);
+};
+
+//------------------------------------------------------------------------------
+
+typedef std::shared_ptr<const CServerConfig> CServerConfigPtr;
+
+//------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,343 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "ServerMetrics.hpp"
+#include <map>
+#include <time.h>
+#include <stdio.h>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+static const double  LatencyBounds[METRICS_NUM_OF_BUCKETS] = {
+    0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0
+};
+
+static const char*   ActionNames[ERA_MAX] = {
+    "categories", "module", "version", "build", "versions", "export", "metrics", "unknown"
+};
+
+static thread_local CMetricsSlot* ThreadSlot = NULL;
+
+//------------------------------------------------------------------------------
+
+// single writer counters, plain load and store is enough
+
+static inline void Increment(std::atomic<uint64_t>& counter,uint64_t value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value,std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+
+uint64_t GetMonotonicTime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return( (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000 );
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CMetricsSlot::CMetricsSlot(void)
+{
+    for(int i=0; i < ERA_MAX; i++){
+        Requests[i] = 0;
+        Errors[i] = 0;
+        LatencySum[i] = 0;
+        for(int j=0; j <= METRICS_NUM_OF_BUCKETS; j++){
+            Buckets[i][j] = 0;
+        }
+    }
+    BusyTime = 0;
+    Busy = 0;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CServerMetrics::CServerMetrics(void)
+{
+    StartTime = GetMonotonicTime();
+    ConfiguredWorkers = 0;
+    LiveWorkers = 0;
+}
+
+//------------------------------------------------------------------------------
+
+CServerMetrics::~CServerMetrics(void)
+{
+    for(CMetricsSlot* p_slot : Slots){
+        delete p_slot;
+    }
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CMetricsSlot* CServerMetrics::GetSlot(void)
+{
+    if( ThreadSlot != NULL ) return(ThreadSlot);
+
+    // first request served by this thread
+    ThreadSlot = new CMetricsSlot;
+    std::lock_guard<std::mutex> lock(SlotsLock);
+    Slots.push_back(ThreadSlot);
+    return(ThreadSlot);
+}
+
+//------------------------------------------------------------------------------
+
+void CServerMetrics::BeginRequest(void)
+{
+    CMetricsSlot* p_slot = GetSlot();
+    p_slot->Busy.store(1,std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+
+void CServerMetrics::EndRequest(ERequestAction action,bool error,uint64_t usec)
+{
+    CMetricsSlot* p_slot = GetSlot();
+
+    Increment(p_slot->Requests[action],1);
+    if( error ) Increment(p_slot->Errors[action],1);
+
+    double sec = usec * 1.0e-6;
+    int bucket = 0;
+    while( (bucket < METRICS_NUM_OF_BUCKETS) && (sec > LatencyBounds[bucket]) ) bucket++;
+    Increment(p_slot->Buckets[action][bucket],1);
+    Increment(p_slot->LatencySum[action],usec);
+
+    Increment(p_slot->BusyTime,usec);
+    p_slot->Busy.store(0,std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+
+void CServerMetrics::SetConfiguredWorkers(int num)
+{
+    ConfiguredWorkers.store(num,std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+
+void CServerMetrics::StartWorker(void)
+{
+    LiveWorkers.fetch_add(1,std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+
+void CServerMetrics::StopWorker(void)
+{
+    LiveWorkers.fetch_sub(1,std::memory_order_relaxed);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CServerMetrics::PrintMetrics(std::string& output)
+{
+    uint64_t    requests[ERA_MAX];
+    uint64_t    errors[ERA_MAX];
+    uint64_t    buckets[ERA_MAX][METRICS_NUM_OF_BUCKETS+1];
+    uint64_t    sums[ERA_MAX];
+    uint64_t    busy_time = 0;
+    int         busy = 0;
+
+    for(int i=0; i < ERA_MAX; i++){
+        requests[i] = 0;
+        errors[i] = 0;
+        sums[i] = 0;
+        for(int j=0; j <= METRICS_NUM_OF_BUCKETS; j++) buckets[i][j] = 0;
+    }
+
+    // merge slots
+    {
+        std::lock_guard<std::mutex> lock(SlotsLock);
+        for(CMetricsSlot* p_slot : Slots){
+            for(int i=0; i < ERA_MAX; i++){
+                requests[i] += p_slot->Requests[i].load(std::memory_order_relaxed);
+                errors[i] += p_slot->Errors[i].load(std::memory_order_relaxed);
+                sums[i] += p_slot->LatencySum[i].load(std::memory_order_relaxed);
+                for(int j=0; j <= METRICS_NUM_OF_BUCKETS; j++){
+                    buckets[i][j] += p_slot->Buckets[i][j].load(std::memory_order_relaxed);
+                }
+            }
+            busy_time += p_slot->BusyTime.load(std::memory_order_relaxed);
+            busy += p_slot->Busy.load(std::memory_order_relaxed);
+        }
+    }
+
+    char labels[128];
+
+    // requests and errors
+    AppendHeader(output,"isoftrepo_requests_total","counter","Number of processed requests.");
+    for(int i=0; i < ERA_MAX; i++){
+        snprintf(labels,sizeof(labels),"action=\"%s\"",ActionNames[i]);
+        AppendSample(output,"isoftrepo_requests_total",labels,requests[i]);
+    }
+
+    AppendHeader(output,"isoftrepo_request_errors_total","counter","Number of requests answered by the error page.");
+    for(int i=0; i < ERA_MAX; i++){
+        snprintf(labels,sizeof(labels),"action=\"%s\"",ActionNames[i]);
+        AppendSample(output,"isoftrepo_request_errors_total",labels,errors[i]);
+    }
+
+    // latencies
+    AppendHeader(output,"isoftrepo_request_duration_seconds","histogram","Request processing time.");
+    for(int i=0; i < ERA_MAX; i++){
+        uint64_t cumulative = 0;
+        for(int j=0; j < METRICS_NUM_OF_BUCKETS; j++){
+            cumulative += buckets[i][j];
+            snprintf(labels,sizeof(labels),"action=\"%s\",le=\"%g\"",ActionNames[i],LatencyBounds[j]);
+            AppendSample(output,"isoftrepo_request_duration_seconds_bucket",labels,cumulative);
+        }
+        cumulative += buckets[i][METRICS_NUM_OF_BUCKETS];
+        snprintf(labels,sizeof(labels),"action=\"%s\",le=\"+Inf\"",ActionNames[i]);
+        AppendSample(output,"isoftrepo_request_duration_seconds_bucket",labels,cumulative);
+        snprintf(labels,sizeof(labels),"action=\"%s\"",ActionNames[i]);
+        AppendSample(output,"isoftrepo_request_duration_seconds_sum",labels,sums[i] * 1.0e-6);
+        AppendSample(output,"isoftrepo_request_duration_seconds_count",labels,cumulative);
+    }
+
+    // workers
+    AppendHeader(output,"isoftrepo_workers","gauge","Number of live worker threads.");
+    AppendSample(output,"isoftrepo_workers",NULL,LiveWorkers.load(std::memory_order_relaxed));
+    AppendHeader(output,"isoftrepo_workers_configured","gauge","Number of configured worker threads.");
+    AppendSample(output,"isoftrepo_workers_configured",NULL,ConfiguredWorkers.load(std::memory_order_relaxed));
+    AppendHeader(output,"isoftrepo_workers_busy","gauge","Number of worker threads processing a request.");
+    AppendSample(output,"isoftrepo_workers_busy",NULL,busy);
+    AppendHeader(output,"isoftrepo_workers_busy_seconds_total","counter","Time spent by workers in request processing.");
+    AppendSample(output,"isoftrepo_workers_busy_seconds_total",NULL,busy_time * 1.0e-6);
+
+    AppendHeader(output,"isoftrepo_uptime_seconds","gauge","Time since the server start.");
+    AppendSample(output,"isoftrepo_uptime_seconds",NULL,(GetMonotonicTime() - StartTime) * 1.0e-6);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+ERequestAction CServerMetrics::GetAction(const CSmallString& action)
+{
+    if( action == NULL ) return(ERA_CATEGORIES);
+    for(int i=0; i < ERA_UNKNOWN; i++){
+        if( action == ActionNames[i] ) return((ERequestAction)i);
+    }
+    return(ERA_UNKNOWN);
+}
+
+//------------------------------------------------------------------------------
+
+const char* CServerMetrics::GetActionName(ERequestAction action)
+{
+    return(ActionNames[action]);
+}
+
+//------------------------------------------------------------------------------
+
+void CServerMetrics::AppendSample(std::string& output,const char* p_name,
+                                  const char* p_labels,double value)
+{
+    char buffer[64];
+    snprintf(buffer,sizeof(buffer)," %.17g\n",value);
+
+    output += p_name;
+    if( p_labels != NULL ){
+        output += '{';
+        output += p_labels;
+        output += '}';
+    }
+    output += buffer;
+}
+
+//------------------------------------------------------------------------------
+
+void CServerMetrics::AppendHeader(std::string& output,const char* p_name,
+                                  const char* p_type,const char* p_help)
+{
+    output += "# HELP ";
+    output += p_name;
+    output += ' ';
+    output += p_help;
+    output += "\n# TYPE ";
+    output += p_name;
+    output += ' ';
+    output += p_type;
+    output += '\n';
+}
+
+//------------------------------------------------------------------------------
+
+void CServerMetrics::GroupFamilies(std::string& output)
+{
+    // samples always follow the header of their family
+    std::vector<std::string>                names;
+    std::map<std::string,std::string>       families;
+    std::string*                            p_family = NULL;
+
+    size_t pos = 0;
+    while( pos < output.size() ){
+        size_t end = output.find('\n',pos);
+        if( end == std::string::npos ) end = output.size() - 1;
+
+        if( output.compare(pos,7,"# HELP ") == 0 ) {
+            size_t name_end = output.find(' ',pos+7);
+            std::string name = output.substr(pos+7,name_end-pos-7);
+            std::map<std::string,std::string>::iterator it = families.find(name);
+            if( it == families.end() ) {
+                names.push_back(name);
+                p_family = &families[name];
+                p_family->append(output,pos,end-pos+1);
+            } else {
+                p_family = &it->second;
+            }
+        } else if( output.compare(pos,7,"# TYPE ") == 0 ) {
+            // printed together with HELP
+            if( (p_family != NULL) && (p_family->find("# TYPE ") == std::string::npos) ) {
+                p_family->append(output,pos,end-pos+1);
+            }
+        } else if( p_family != NULL ) {
+            p_family->append(output,pos,end-pos+1);
+        }
+        pos = end + 1;
+    }
+
+    std::string grouped;
+    grouped.reserve(output.size());
+    for(const std::string& name : names){
+        grouped += families[name];
+    }
+    output.swap(grouped);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
@@ -0,0 +1,135 @@
+#ifndef ServerMetricsH
+#define ServerMetricsH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <SmallString.hpp>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+
+/// request actions tracked by metrics
+enum ERequestAction {
+    ERA_CATEGORIES  = 0,
+    ERA_MODULE      = 1,
+    ERA_VERSION     = 2,
+    ERA_BUILD       = 3,
+    ERA_VERSIONS    = 4,
+    ERA_EXPORT      = 5,
+    ERA_METRICS     = 6,
+    ERA_UNKNOWN     = 7,
+    ERA_MAX         = 8
+};
+
+//------------------------------------------------------------------------------
+
+/// upper bounds of latency histogram buckets in seconds
+#define METRICS_NUM_OF_BUCKETS 13
+
+//------------------------------------------------------------------------------
+
+/// counters owned by one worker thread, only the owner writes them
+
+class CMetricsSlot {
+public:
+    CMetricsSlot(void);
+
+    std::atomic<uint64_t>   Requests[ERA_MAX];
+    std::atomic<uint64_t>   Errors[ERA_MAX];
+    std::atomic<uint64_t>   Buckets[ERA_MAX][METRICS_NUM_OF_BUCKETS+1];
+    std::atomic<uint64_t>   LatencySum[ERA_MAX];    // in microseconds
+    std::atomic<uint64_t>   BusyTime;               // in microseconds
+    std::atomic<int>        Busy;
+};
+
+//------------------------------------------------------------------------------
+
+/// server metrics in the Prometheus text format
+/// each worker thread updates its own slot without locks,
+/// slots are merged when metrics are scraped
+
+class CServerMetrics {
+public:
+    CServerMetrics(void);
+    ~CServerMetrics(void);
+
+// main methods ----------------------------------------------------------------
+    /// request processing started in the calling thread
+    void BeginRequest(void);
+
+    /// request processing finished in the calling thread
+    void EndRequest(ERequestAction action,bool error,uint64_t usec);
+
+    /// set number of configured worker threads
+    void SetConfiguredWorkers(int num);
+
+    /// worker thread started serving requests
+    void StartWorker(void);
+
+    /// worker thread stopped serving requests
+    void StopWorker(void);
+
+    /// print merged metrics
+    void PrintMetrics(std::string& output);
+
+// helper methods --------------------------------------------------------------
+    /// convert action name
+    static ERequestAction GetAction(const CSmallString& action);
+
+    /// get action name
+    static const char* GetActionName(ERequestAction action);
+
+    /// append a single sample line
+    static void AppendSample(std::string& output,const char* p_name,
+                             const char* p_labels,double value);
+
+    /// append HELP and TYPE lines
+    static void AppendHeader(std::string& output,const char* p_name,
+                             const char* p_type,const char* p_help);
+
+    /// merge repeated families, e.g. printed for each site, into single groups
+    static void GroupFamilies(std::string& output);
+
+// section of private data -----------------------------------------------------
+private:
+    std::mutex                  SlotsLock;  // only for slot registration and scraping
+    std::vector<CMetricsSlot*>  Slots;
+    uint64_t                    StartTime;
+    std::atomic<int>            ConfiguredWorkers;
+    std::atomic<int>            LiveWorkers;
+
+    /// get slot of the calling thread
+    CMetricsSlot* GetSlot(void);
+};
+
+//------------------------------------------------------------------------------
+
+/// monotonic time in microseconds
+uint64_t GetMonotonicTime(void);
+
+//------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,88 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "ServerReloader.hpp"
+#include "ISoftRepoServer.hpp"
+#include <errno.h>
+#include <time.h>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CServerReloader::CServerReloader(void)
+{
+    Server = NULL;
+    sem_init(&ReloadRequested,0,0);
+}
+
+//------------------------------------------------------------------------------
+
+CServerReloader::~CServerReloader(void)
+{
+    sem_destroy(&ReloadRequested);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CServerReloader::SetServer(CISoftRepoServer* p_server)
+{
+    Server = p_server;
+}
+
+//------------------------------------------------------------------------------
+
+void CServerReloader::RequestReload(void)
+{
+    sem_post(&ReloadRequested);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CServerReloader::ExecuteThread(void)
+{
+    while( ThreadTerminated == false ){
+        // wake up periodically to check for termination
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME,&deadline);
+        deadline.tv_sec += 1;
+
+        if( sem_timedwait(&ReloadRequested,&deadline) != 0 ) {
+            if( (ThreadTerminated == false) && (Server != NULL) ) Server->RefreshCatalog();
+            continue;
+        }
+        if( ThreadTerminated == true ) break;
+
+        // coalesce repeated signals
+        while( sem_trywait(&ReloadRequested) == 0 );
+
+        if( Server != NULL ) Server->ReloadConfig();
+    }
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
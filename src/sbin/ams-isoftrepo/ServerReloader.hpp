@@ -0,0 +1,60 @@
+#ifndef ServerReloaderH
+#define ServerReloaderH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <SmallThread.hpp>
+#include <semaphore.h>
+
+//------------------------------------------------------------------------------
+
+class CISoftRepoServer;
+
+//------------------------------------------------------------------------------
+
+/// reloads server configuration outside of the signal handler
+/// it also refreshes the shared catalog once per second
+
+class CServerReloader : public CSmallThread {
+public:
+    CServerReloader(void);
+    ~CServerReloader(void);
+
+// setup methods ---------------------------------------------------------------
+    /// set reloaded server
+    void SetServer(CISoftRepoServer* p_server);
+
+// main methods ----------------------------------------------------------------
+    /// request reload, it is async-signal-safe
+    void RequestReload(void);
+
+// section of private data -----------------------------------------------------
+private:
+    CISoftRepoServer*   Server;
+    sem_t               ReloadRequested;
+
+    virtual void ExecuteThread(void);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,178 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "ServiceNotifier.hpp"
+#include <ErrorSystem.hpp>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CServiceNotifier::CServiceNotifier(void)
+{
+    WatchdogInterval = 0;
+    sem_init(&Terminate,0,0);
+}
+
+//------------------------------------------------------------------------------
+
+CServiceNotifier::~CServiceNotifier(void)
+{
+    sem_destroy(&Terminate);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CServiceNotifier::Init(void)
+{
+    const char* p_socket = getenv("NOTIFY_SOCKET");
+    if( p_socket != NULL ) SocketPath = p_socket;
+
+    // the watchdog is set for the main process only
+    const char* p_usec = getenv("WATCHDOG_USEC");
+    const char* p_pid = getenv("WATCHDOG_PID");
+    if( (p_usec != NULL) && ((p_pid == NULL) || (atol(p_pid) == (long)getpid())) ) {
+        WatchdogInterval = strtoull(p_usec,NULL,10);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CServiceNotifier::SetHealthCheck(const std::function<bool(void)>& check)
+{
+    HealthCheck = check;
+}
+
+//------------------------------------------------------------------------------
+
+bool CServiceNotifier::Notify(const char* p_state)
+{
+    if( SocketPath.empty() ) return(true);
+
+    struct sockaddr_un addr;
+    memset(&addr,0,sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if( (SocketPath.size() < 2) || (SocketPath.size() >= sizeof(addr.sun_path)) ) {
+        ES_ERROR("invalid NOTIFY_SOCKET");
+        return(false);
+    }
+    memcpy(addr.sun_path,SocketPath.c_str(),SocketPath.size());
+    // abstract namespace
+    if( addr.sun_path[0] == '@' ) addr.sun_path[0] = 0;
+    socklen_t addr_len = offsetof(struct sockaddr_un,sun_path) + SocketPath.size();
+
+    int fd = socket(AF_UNIX,SOCK_DGRAM | SOCK_CLOEXEC,0);
+    if( fd < 0 ) {
+        ES_ERROR("unable to create notification socket");
+        return(false);
+    }
+
+    ssize_t len = strlen(p_state);
+    ssize_t ret = sendto(fd,p_state,len,MSG_NOSIGNAL,(struct sockaddr*)&addr,addr_len);
+    close(fd);
+
+    if( ret != len ) {
+        CSmallString error;
+        error << "unable to notify service manager (" << strerror(errno) << ")";
+        ES_ERROR(error);
+        return(false);
+    }
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CServiceNotifier::NotifyFailure(const char* p_status,int errnum)
+{
+    std::string state = std::string("STATUS=") + p_status + "\nERRNO=" + std::to_string(errnum);
+    return(Notify(state.c_str()));
+}
+
+//------------------------------------------------------------------------------
+
+void CServiceNotifier::RequestTermination(void)
+{
+    sem_post(&Terminate);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CServiceNotifier::IsEnabled(void) const
+{
+    return(SocketPath.empty() == false);
+}
+
+//------------------------------------------------------------------------------
+
+uint64_t CServiceNotifier::GetWatchdogInterval(void) const
+{
+    return(WatchdogInterval);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CServiceNotifier::ExecuteThread(void)
+{
+    if( (WatchdogInterval == 0) || SocketPath.empty() ) return;
+
+    // keepalive twice per interval as recommended by sd_watchdog_enabled(3)
+    uint64_t period = WatchdogInterval / 2;
+
+    bool healthy = true;
+
+    while( ThreadTerminated == false ){
+        // missing keepalives let systemd restart the stuck server
+        bool alive = (! HealthCheck) || HealthCheck();
+        if( alive ) Notify("WATCHDOG=1");
+        if( alive != healthy ) {
+            Notify(alive ? "STATUS=Serving" : "STATUS=Serving threads do not respond");
+            healthy = alive;
+        }
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME,&deadline);
+        uint64_t nsec = deadline.tv_nsec + (period % 1000000) * 1000;
+        deadline.tv_sec += period / 1000000 + nsec / 1000000000;
+        deadline.tv_nsec = nsec % 1000000000;
+
+        // timeouts and interrupts lead to the next keepalive
+        if( sem_timedwait(&Terminate,&deadline) == 0 ) break;
+    }
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
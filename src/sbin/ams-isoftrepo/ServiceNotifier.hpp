@@ -0,0 +1,81 @@
+#ifndef ServiceNotifierH
+#define ServiceNotifierH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <SmallThread.hpp>
+#include <semaphore.h>
+#include <stdint.h>
+#include <functional>
+#include <string>
+
+//------------------------------------------------------------------------------
+
+/// notifies systemd about the service state (sd_notify protocol)
+/// the thread sends watchdog keepalives when WatchdogSec is set for the service,
+/// keepalives are sent only while the health check reports progress of the
+/// serving threads, thus systemd restarts the server when they are stuck
+/// all methods do nothing when the server is not started by systemd
+
+class CServiceNotifier : public CSmallThread {
+public:
+    CServiceNotifier(void);
+    ~CServiceNotifier(void);
+
+// setup methods ---------------------------------------------------------------
+    /// read notification socket and watchdog interval from the environment
+    void Init(void);
+
+    /// set health check gating watchdog keepalives, it must be set before
+    /// the thread is started, no check - keepalives are always sent
+    void SetHealthCheck(const std::function<bool(void)>& check);
+
+// main methods ----------------------------------------------------------------
+    /// send state, e.g. READY=1, true if not started by systemd
+    bool Notify(const char* p_state);
+
+    /// report failed startup with status text and errno
+    bool NotifyFailure(const char* p_status,int errnum);
+
+    /// stop watchdog keepalives, it is async-signal-safe
+    void RequestTermination(void);
+
+// information methods ---------------------------------------------------------
+    /// is the notification socket available
+    bool IsEnabled(void) const;
+
+    /// watchdog interval in microseconds, zero - watchdog is not used
+    uint64_t GetWatchdogInterval(void) const;
+
+// section of private data -----------------------------------------------------
+private:
+    std::string     SocketPath;
+    uint64_t        WatchdogInterval;   // in us
+    sem_t           Terminate;
+    std::function<bool(void)>   HealthCheck;
+
+    virtual void ExecuteThread(void);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
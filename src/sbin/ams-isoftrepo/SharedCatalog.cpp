@@ -0,0 +1,435 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "SharedCatalog.hpp"
+#include "Catalog.hpp"
+#include "ServerMetrics.hpp"
+#include "RequestTimer.hpp"
+#include <ErrorSystem.hpp>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+static const char SharedCatalogMagic[8] = {'I','S','R','C','A','T','0','2'};
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CSharedCatalog::CSharedCatalog(void)
+{
+    Mode = ESCM_NONE;
+    Control = NULL;
+    LastAttach = 0;
+}
+
+//------------------------------------------------------------------------------
+
+CSharedCatalog::~CSharedCatalog(void)
+{
+    CloseControl();
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CSharedCatalogMapping::CSharedCatalogMapping(void* p_segment,size_t size)
+{
+    Segment = p_segment;
+    Size = size;
+}
+
+//------------------------------------------------------------------------------
+
+CSharedCatalogMapping::~CSharedCatalogMapping(void)
+{
+    munmap(Segment,Size);
+}
+
+//------------------------------------------------------------------------------
+
+const void* CSharedCatalogMapping::GetTableImage(size_t& size) const
+{
+    const CSharedCatalogHeader* p_header = static_cast<const CSharedCatalogHeader*>(Segment);
+    size = p_header->TableSize;
+    return(static_cast<const char*>(Segment) + sizeof(CSharedCatalogHeader));
+}
+
+//------------------------------------------------------------------------------
+
+bool CSharedCatalogMapping::GetRecord(uint32_t index,const char*& p_text,size_t& length) const
+{
+    const CSharedCatalogHeader* p_header = static_cast<const CSharedCatalogHeader*>(Segment);
+    if( index >= p_header->NumOfRecords ) return(false);
+
+    // the directory was checked when the segment was mapped
+    const char* p_dir = static_cast<const char*>(Segment) + sizeof(CSharedCatalogHeader) + p_header->TableSize;
+    const CSharedCatalogRecord* p_records = reinterpret_cast<const CSharedCatalogRecord*>(p_dir);
+    const char* p_texts = p_dir + p_header->NumOfRecords*sizeof(CSharedCatalogRecord);
+
+    p_text = p_texts + p_records[index].Offset;
+    length = p_records[index].Length;
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+size_t CSharedCatalogMapping::GetSize(void) const
+{
+    return(Size);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CSharedCatalog::SetSegment(ESharedCatalogMode mode,const CSmallString& name)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+    if( (Mode == mode) && (Name == name) ) return;
+
+    CloseControl();
+    Mode = mode;
+    Name = name;
+    LastAttach = 0;
+    if( Mode == ESCM_NONE ) return;
+
+    if( (Name == NULL) || (Name[0] != '/') ) {
+        CSmallString error;
+        error << "shared catalog segment '" << Name << "' must start with '/', sharing is disabled";
+        ES_ERROR(error);
+        Mode = ESCM_NONE;
+        return;
+    }
+
+    // the reader attaches lazily as the publisher might not run yet
+    if( Mode == ESCM_PUBLISH ) OpenControl();
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+uint64_t CSharedCatalog::GetGeneration(void)
+{
+    std::lock_guard<std::mutex> lock(Lock);
+    if( Mode == ESCM_NONE ) return(0);
+
+    if( Control == NULL ) {
+        // do not hammer shm_open when the publisher is not running
+        uint64_t now = GetMonotonicTime();
+        if( (LastAttach != 0) && (now - LastAttach < 1000000) ) return(0);
+        LastAttach = now;
+        if( OpenControl() == false ) return(0);
+    }
+    return(Control->Generation.load(std::memory_order_acquire));
+}
+
+//------------------------------------------------------------------------------
+
+bool CSharedCatalog::PublishSnapshot(CCatalogSnapshot& snapshot)
+{
+    CSmallString name;
+    uint64_t     generation;
+    {
+        std::lock_guard<std::mutex> lock(Lock);
+        if( Mode != ESCM_PUBLISH ) return(true);
+        if( (Control == NULL) && (OpenControl() == false) ) return(false);
+        name = Name;
+        generation = Control->Generation.load(std::memory_order_acquire) + 1;
+    }
+
+    if( (snapshot.Table.GetImage() == NULL)
+        || (snapshot.RecordTexts.GetNumOfRecords() != snapshot.Table.GetModuleTable().size()) ) {
+        ES_ERROR("catalog tables do not match module records");
+        return(false);
+    }
+
+    // records are copied one by one, thus readers can parse just one module
+    std::vector<CSharedCatalogRecord>   records;
+    size_t                              texts_size = 0;
+    records.reserve(snapshot.RecordTexts.GetNumOfRecords());
+    for(uint32_t i=0; i < snapshot.RecordTexts.GetNumOfRecords(); i++){
+        const char* p_text;
+        size_t      length;
+        snapshot.RecordTexts.GetRecord(i,p_text,length);
+        CSharedCatalogRecord record;
+        record.Offset = texts_size;
+        record.Length = length;
+        records.push_back(record);
+        texts_size += length;
+    }
+
+    size_t table_size = snapshot.Table.GetImageSize();
+    size_t data_size = table_size + records.size()*sizeof(CSharedCatalogRecord) + texts_size;
+
+    // write complete data segment before it becomes visible
+    CSmallString seg_name = GetSegmentName(name,generation);
+    size_t       seg_size = sizeof(CSharedCatalogHeader) + data_size;
+
+    shm_unlink(seg_name);   // leftover of a crashed publisher
+    int fd = shm_open(seg_name,O_CREAT|O_EXCL|O_RDWR,0644);
+    if( fd == -1 ) {
+        CSmallString error;
+        error << "unable to create shared catalog segment '" << seg_name << "' (" << strerror(errno) << ")";
+        ES_ERROR(error);
+        return(false);
+    }
+    fchmod(fd,0644);    // not affected by umask
+
+    void* p_seg = MAP_FAILED;
+    if( ftruncate(fd,seg_size) == 0 ) {
+        p_seg = mmap(NULL,seg_size,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+    }
+    close(fd);
+    if( p_seg == MAP_FAILED ) {
+        CSmallString error;
+        error << "unable to map shared catalog segment '" << seg_name << "' (" << strerror(errno) << ")";
+        ES_ERROR(error);
+        shm_unlink(seg_name);
+        return(false);
+    }
+
+    CSharedCatalogHeader* p_header = static_cast<CSharedCatalogHeader*>(p_seg);
+    memcpy(p_header->Magic,SharedCatalogMagic,sizeof(p_header->Magic));
+    p_header->Generation = generation;
+    p_header->Size = data_size;
+    p_header->PublishTime = time(NULL);
+    p_header->TableSize = table_size;
+    p_header->NumOfRecords = records.size();
+    char* p_dest = static_cast<char*>(p_seg) + sizeof(CSharedCatalogHeader);
+    memcpy(p_dest,snapshot.Table.GetImage(),table_size);
+    p_dest += table_size;
+    if( records.empty() == false ) {
+        memcpy(p_dest,records.data(),records.size()*sizeof(CSharedCatalogRecord));
+        p_dest += records.size()*sizeof(CSharedCatalogRecord);
+    }
+    for(uint32_t i=0; i < records.size(); i++){
+        const char* p_text;
+        size_t      length;
+        snapshot.RecordTexts.GetRecord(i,p_text,length);
+        memcpy(p_dest + records[i].Offset,p_text,length);
+    }
+    munmap(p_seg,seg_size);
+
+    // switch readers to the new generation
+    {
+        std::lock_guard<std::mutex> lock(Lock);
+        if( (Control == NULL) || (Name != name) ) {
+            // segment was changed by reload in the meantime
+            shm_unlink(seg_name);
+            return(false);
+        }
+        Control->Generation.store(generation,std::memory_order_release);
+    }
+
+    // readers that have already mapped the previous generation keep it until they unmap it
+    if( generation > 1 ) shm_unlink(GetSegmentName(name,generation-1));
+
+    snapshot.SharedGeneration = generation;
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CSharedCatalog::LoadSnapshot(CCatalogSnapshot& snapshot)
+{
+    // the publisher removes the previous generation once a new one is visible,
+    // retry with the newer generation in that case
+    for(int attempt = 0; attempt < 3; attempt++){
+        uint64_t generation = GetGeneration();
+        if( generation == 0 ) {
+            ES_ERROR("shared catalog is not published");
+            return(false);
+        }
+
+        CSmallString seg_name;
+        {
+            std::lock_guard<std::mutex> lock(Lock);
+            seg_name = GetSegmentName(Name,generation);
+        }
+
+        int fd = shm_open(seg_name,O_RDONLY,0);
+        if( fd == -1 ) {
+            if( errno == ENOENT ) continue;
+            CSmallString error;
+            error << "unable to open shared catalog segment '" << seg_name << "' (" << strerror(errno) << ")";
+            ES_ERROR(error);
+            return(false);
+        }
+
+        struct stat st;
+        void* p_seg = MAP_FAILED;
+        if( (fstat(fd,&st) == 0) && ((size_t)st.st_size >= sizeof(CSharedCatalogHeader)) ) {
+            p_seg = mmap(NULL,st.st_size,PROT_READ,MAP_SHARED,fd,0);
+        }
+        close(fd);
+        if( p_seg == MAP_FAILED ) {
+            CSmallString error;
+            error << "unable to map shared catalog segment '" << seg_name << "'";
+            ES_ERROR(error);
+            return(false);
+        }
+
+        if( CheckSegment(p_seg,st.st_size,generation) == false ) {
+            munmap(p_seg,st.st_size);
+            CSmallString error;
+            error << "shared catalog segment '" << seg_name << "' is corrupted";
+            ES_ERROR(error);
+            return(false);
+        }
+
+        // the snapshot serves directly from the segment, it is unmapped with
+        // the last snapshot using it
+        CSharedCatalogMappingPtr mapping(new CSharedCatalogMapping(p_seg,st.st_size));
+
+        size_t      table_size = 0;
+        const void* p_image = mapping->GetTableImage(table_size);
+        if( (snapshot.Table.Attach(p_image,table_size) == false)
+            || (snapshot.Table.GetModuleTable().size() != static_cast<const CSharedCatalogHeader*>(p_seg)->NumOfRecords) ) {
+            CSmallString error;
+            error << "shared catalog segment '" << seg_name << "' contains incompatible tables";
+            ES_ERROR(error);
+            return(false);
+        }
+
+        snapshot.Mapping = mapping;
+        snapshot.SharedGeneration = generation;
+        snapshot.CreationTime = GetMonotonicTime();
+        return(true);
+    }
+
+    ES_ERROR("shared catalog generation vanished repeatedly");
+    return(false);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CSharedCatalog::OpenControl(void)
+{
+    bool publish = Mode == ESCM_PUBLISH;
+
+    int fd = shm_open(Name,publish ? O_CREAT|O_RDWR : O_RDONLY,0644);
+    if( fd == -1 ) {
+        if( publish ) {
+            CSmallString error;
+            error << "unable to open shared catalog control '" << Name << "' (" << strerror(errno) << ")";
+            ES_ERROR(error);
+        }
+        return(false);
+    }
+
+    struct stat st;
+    if( fstat(fd,&st) != 0 ) {
+        close(fd);
+        return(false);
+    }
+    if( (size_t)st.st_size < sizeof(CSharedCatalogControl) ) {
+        if( (publish == false) || (ftruncate(fd,sizeof(CSharedCatalogControl)) != 0) ) {
+            close(fd);
+            return(false);
+        }
+        fchmod(fd,0644);
+    }
+
+    void* p_seg = mmap(NULL,sizeof(CSharedCatalogControl),publish ? PROT_READ|PROT_WRITE : PROT_READ,
+                       MAP_SHARED,fd,0);
+    close(fd);
+    if( p_seg == MAP_FAILED ) {
+        ES_ERROR("unable to map shared catalog control");
+        return(false);
+    }
+
+    Control = static_cast<CSharedCatalogControl*>(p_seg);
+    if( memcmp(Control->Magic,SharedCatalogMagic,sizeof(Control->Magic)) != 0 ) {
+        if( publish ) {
+            // fresh segment, generations continue after publisher restart otherwise
+            Control->Generation.store(0);
+            memcpy(Control->Magic,SharedCatalogMagic,sizeof(Control->Magic));
+        } else {
+            CloseControl();
+            return(false);
+        }
+    }
+
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+void CSharedCatalog::CloseControl(void)
+{
+    if( Control == NULL ) return;
+    munmap(Control,sizeof(CSharedCatalogControl));
+    Control = NULL;
+}
+
+//------------------------------------------------------------------------------
+
+const CSmallString CSharedCatalog::GetSegmentName(const CSmallString& name,uint64_t generation)
+{
+    CSmallString seg_name;
+    seg_name << name << "." << std::to_string(generation).c_str();
+    return(seg_name);
+}
+
+//------------------------------------------------------------------------------
+
+bool CSharedCatalog::CheckSegment(const void* p_segment,size_t size,uint64_t generation)
+{
+    const CSharedCatalogHeader* p_header = static_cast<const CSharedCatalogHeader*>(p_segment);
+    if( (memcmp(p_header->Magic,SharedCatalogMagic,sizeof(p_header->Magic)) != 0)
+        || (p_header->Generation != generation)
+        || (p_header->Size > size - sizeof(CSharedCatalogHeader))
+        || (p_header->TableSize % 8 != 0)
+        || (p_header->TableSize > p_header->Size)
+        || (p_header->NumOfRecords > (p_header->Size - p_header->TableSize) / sizeof(CSharedCatalogRecord)) ) {
+        return(false);
+    }
+
+    const char* p_dir = static_cast<const char*>(p_segment) + sizeof(CSharedCatalogHeader) + p_header->TableSize;
+    const CSharedCatalogRecord* p_records = reinterpret_cast<const CSharedCatalogRecord*>(p_dir);
+    uint64_t texts_size = p_header->Size - p_header->TableSize - p_header->NumOfRecords*sizeof(CSharedCatalogRecord);
+    for(uint64_t i=0; i < p_header->NumOfRecords; i++){
+        if( (p_records[i].Offset > texts_size) || (p_records[i].Length > texts_size - p_records[i].Offset) ) {
+            return(false);
+        }
+    }
+    return(true);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
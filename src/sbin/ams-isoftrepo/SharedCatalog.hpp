@@ -0,0 +1,161 @@
+#ifndef SharedCatalogH
+#define SharedCatalogH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <SmallString.hpp>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+
+class CCatalogSnapshot;
+
+//------------------------------------------------------------------------------
+
+/// sharing of the catalog among server processes on one host
+
+enum ESharedCatalogMode {
+    ESCM_NONE,      // each process builds its own catalog
+    ESCM_PUBLISH,   // process builds the catalog and publishes it
+    ESCM_ATTACH     // process maps the published catalog
+};
+
+//------------------------------------------------------------------------------
+
+/// control segment, it only points to the current generation
+
+class CSharedCatalogControl {
+public:
+    char                    Magic[8];
+    std::atomic<uint64_t>   Generation;
+};
+
+//------------------------------------------------------------------------------
+
+/// header of a data segment, the image of catalog tables follows, then
+/// the directory of module records and texts of records
+
+class CSharedCatalogHeader {
+public:
+    char                    Magic[8];
+    uint64_t                Generation;
+    uint64_t                Size;           // size of data following the header
+    uint64_t                PublishTime;    // realtime in s
+    uint64_t                TableSize;      // size of the table image
+    uint64_t                NumOfRecords;   // one record per module of the tables
+};
+
+//------------------------------------------------------------------------------
+
+/// module record stored as XML text
+
+class CSharedCatalogRecord {
+public:
+    uint64_t                Offset;         // from the beginning of texts
+    uint64_t                Length;
+};
+
+//------------------------------------------------------------------------------
+
+/// read-only mapping of a published data segment
+/// it is kept by snapshots serving from it, thus the segment can be
+/// unlinked by the publisher in the meantime
+
+class CSharedCatalogMapping {
+public:
+    CSharedCatalogMapping(void* p_segment,size_t size);
+    ~CSharedCatalogMapping(void);
+
+// information methods ---------------------------------------------------------
+    /// get image of catalog tables
+    const void* GetTableImage(size_t& size) const;
+
+    /// get text of module record
+    bool GetRecord(uint32_t index,const char*& p_text,size_t& length) const;
+
+    /// get size of the mapping
+    size_t GetSize(void) const;
+
+// section of private data -----------------------------------------------------
+private:
+    void*                   Segment;
+    size_t                  Size;
+};
+
+//------------------------------------------------------------------------------
+
+typedef std::shared_ptr<CSharedCatalogMapping> CSharedCatalogMappingPtr;
+
+//------------------------------------------------------------------------------
+
+/// catalog snapshots published in POSIX shared memory
+/// each generation is stored in its own segment '<name>.<generation>',
+/// the control segment '<name>' is switched atomically once the data segment
+/// is complete, readers map segments read-only
+
+class CSharedCatalog {
+public:
+    CSharedCatalog(void);
+    ~CSharedCatalog(void);
+
+// setup methods ---------------------------------------------------------------
+    /// set sharing mode and name of the control segment
+    void SetSegment(ESharedCatalogMode mode,const CSmallString& name);
+
+// main methods ----------------------------------------------------------------
+    /// get published generation, zero - nothing is published or not attached
+    uint64_t GetGeneration(void);
+
+    /// publish snapshot as a new generation
+    bool PublishSnapshot(CCatalogSnapshot& snapshot);
+
+    /// attach snapshot to the published generation, tables and records
+    /// are used directly from the mapped segment
+    bool LoadSnapshot(CCatalogSnapshot& snapshot);
+
+// section of private data -----------------------------------------------------
+private:
+    std::mutex              Lock;
+    ESharedCatalogMode      Mode;
+    CSmallString            Name;
+    CSharedCatalogControl*  Control;
+    uint64_t                LastAttach;     // monotonic time in usec
+
+    /// map control segment
+    bool OpenControl(void);
+
+    /// unmap control segment
+    void CloseControl(void);
+
+    /// name of data segment
+    const CSmallString GetSegmentName(const CSmallString& name,uint64_t generation);
+
+    /// check header and record directory of data segment
+    static bool CheckSegment(const void* p_segment,size_t size,uint64_t generation);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
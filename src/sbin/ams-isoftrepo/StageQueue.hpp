@@ -0,0 +1,140 @@
+#ifndef StageQueueH
+#define StageQueueH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+
+/// bounded lock-free multi-producer multi-consumer queue of pointers
+/// it hands requests and responses over between the request stages,
+/// every slot has a sequence number telling whether it is free or filled,
+/// the capacity must be a power of two
+
+template<class T>
+class CStageQueue {
+public:
+    CStageQueue(size_t capacity);
+    ~CStageQueue(void);
+
+// main methods ----------------------------------------------------------------
+    /// push item, false if the queue is full
+    bool Push(T* p_item);
+
+    /// pop item, NULL if the queue is empty
+    T* Pop(void);
+
+// section of private data -----------------------------------------------------
+private:
+    class CSlot {
+    public:
+        std::atomic<uint64_t>   Sequence;
+        T*                      Item;
+    };
+
+    CSlot*                  Slots;
+    size_t                  Mask;
+    std::atomic<uint64_t>   Tail;       // next slot for producers
+    std::atomic<uint64_t>   Head;       // next slot for consumers
+
+    CStageQueue(const CStageQueue&);
+    CStageQueue& operator=(const CStageQueue&);
+};
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+template<class T>
+CStageQueue<T>::CStageQueue(size_t capacity)
+    : Tail(0), Head(0)
+{
+    Slots = new CSlot[capacity];
+    Mask = capacity - 1;
+    for(size_t i=0; i < capacity; i++){
+        Slots[i].Sequence.store(i,std::memory_order_relaxed);
+        Slots[i].Item = NULL;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template<class T>
+CStageQueue<T>::~CStageQueue(void)
+{
+    delete[] Slots;
+}
+
+//------------------------------------------------------------------------------
+
+template<class T>
+bool CStageQueue<T>::Push(T* p_item)
+{
+    uint64_t pos = Tail.load(std::memory_order_relaxed);
+    CSlot*   p_slot;
+    for(;;){
+        p_slot = &Slots[pos & Mask];
+        uint64_t seq = p_slot->Sequence.load(std::memory_order_acquire);
+        int64_t  diff = (int64_t)seq - (int64_t)pos;
+        if( diff == 0 ) {
+            if( Tail.compare_exchange_weak(pos,pos+1,std::memory_order_relaxed) ) break;
+        } else if( diff < 0 ) {
+            return(false);  // full
+        } else {
+            pos = Tail.load(std::memory_order_relaxed);
+        }
+    }
+    p_slot->Item = p_item;
+    p_slot->Sequence.store(pos+1,std::memory_order_release);
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+template<class T>
+T* CStageQueue<T>::Pop(void)
+{
+    uint64_t pos = Head.load(std::memory_order_relaxed);
+    CSlot*   p_slot;
+    for(;;){
+        p_slot = &Slots[pos & Mask];
+        uint64_t seq = p_slot->Sequence.load(std::memory_order_acquire);
+        int64_t  diff = (int64_t)seq - (int64_t)(pos+1);
+        if( diff == 0 ) {
+            if( Head.compare_exchange_weak(pos,pos+1,std::memory_order_relaxed) ) break;
+        } else if( diff < 0 ) {
+            return(NULL);   // empty
+        } else {
+            pos = Head.load(std::memory_order_relaxed);
+        }
+    }
+    T* p_item = p_slot->Item;
+    p_slot->Sequence.store(pos+Mask+1,std::memory_order_release);
+    return(p_item);
+}
+
+//------------------------------------------------------------------------------
+
+#endif
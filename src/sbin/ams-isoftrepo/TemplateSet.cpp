@@ -0,0 +1,125 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "TemplateSet.hpp"
+#include <ErrorSystem.hpp>
+#include <DirectoryEnum.hpp>
+#include <XMLParser.hpp>
+#include <atomic>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+static std::atomic<uint64_t> LastGeneration(0);
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CTemplateSet::CTemplateSet(void)
+{
+    Generation = ++LastGeneration;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CTemplateSet::Load(const CFileName& template_path)
+{
+    TemplatePath = template_path;
+
+    CDirectoryEnum dir_enum(template_path);
+    if( dir_enum.StartFindFile("*.html") == false ) {
+        CSmallString error;
+        error << "unable to list template directory '" << template_path << "'";
+        ES_ERROR(error);
+        return(false);
+    }
+
+    CFileName name;
+    while( dir_enum.FindFile(name) ){
+        std::unique_ptr<CTemplate> p_tmp(new CTemplate);
+
+        CXMLParser xml_parser;
+        xml_parser.SetOutputXMLNode(p_tmp.get());
+        xml_parser.EnableWhiteCharacters(true);
+
+        if( xml_parser.Parse(template_path / name) == false ) {
+            CSmallString error;
+            error << "unable to compile template '" << name << "'";
+            ES_ERROR(error);
+            dir_enum.EndFindFile();
+            return(false);
+        }
+
+        Templates[std::string(name)] = std::move(p_tmp);
+    }
+    dir_enum.EndFindFile();
+
+    if( Templates.empty() ) {
+        CSmallString error;
+        error << "no templates found in '" << template_path << "'";
+        ES_ERROR(error);
+        return(false);
+    }
+
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+CTemplate* CTemplateSet::FindTemplate(const CSmallString& name) const
+{
+    std::unordered_map<std::string,std::unique_ptr<CTemplate> >::const_iterator
+            it = Templates.find(std::string(name));
+    if( it == Templates.end() ) return(NULL);
+    return(it->second.get());
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+uint64_t CTemplateSet::GetGeneration(void) const
+{
+    return(Generation);
+}
+
+//------------------------------------------------------------------------------
+
+const CFileName& CTemplateSet::GetTemplatePath(void) const
+{
+    return(TemplatePath);
+}
+
+//------------------------------------------------------------------------------
+
+size_t CTemplateSet::GetNumOfTemplates(void) const
+{
+    return(Templates.size());
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
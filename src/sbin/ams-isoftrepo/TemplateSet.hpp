@@ -0,0 +1,72 @@
+#ifndef TemplateSetH
+#define TemplateSetH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <SmallString.hpp>
+#include <FileName.hpp>
+#include <Template.hpp>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+
+/// all templates of the template directory compiled in advance
+/// the set is not changed once it is loaded, changed templates create a new set
+
+class CTemplateSet {
+public:
+    CTemplateSet(void);
+
+// main methods ----------------------------------------------------------------
+    /// compile all templates from the directory
+    bool Load(const CFileName& template_path);
+
+    /// find template, there is no filesystem access
+    CTemplate* FindTemplate(const CSmallString& name) const;
+
+// information methods ---------------------------------------------------------
+    /// get unique generation of the set
+    uint64_t GetGeneration(void) const;
+
+    /// get directory of templates
+    const CFileName& GetTemplatePath(void) const;
+
+    /// get number of templates
+    size_t GetNumOfTemplates(void) const;
+
+// section of private data -----------------------------------------------------
+private:
+    uint64_t                                                    Generation;
+    CFileName                                                   TemplatePath;
+    std::unordered_map<std::string,std::unique_ptr<CTemplate> > Templates;
+};
+
+//------------------------------------------------------------------------------
+
+typedef std::shared_ptr<const CTemplateSet> CTemplateSetPtr;
+
+//------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,133 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "TemplateWatcher.hpp"
+#include "ISoftRepoServer.hpp"
+#include <ErrorSystem.hpp>
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+// editors write files in several steps, wait for quiet period before reload
+#define TEMPLATE_SETTLE_TIME    250     // in ms
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CTemplateWatcher::CTemplateWatcher(void)
+    : Enabled(false)
+{
+    Server = NULL;
+}
+
+//------------------------------------------------------------------------------
+
+void CTemplateWatcher::SetServer(CISoftRepoServer* p_server)
+{
+    Server = p_server;
+}
+
+//------------------------------------------------------------------------------
+
+void CTemplateWatcher::SetEnabled(bool enabled)
+{
+    Enabled = enabled;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CTemplateWatcher::ExecuteThread(void)
+{
+    if( Server == NULL ) return;
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if( fd < 0 ) {
+        ES_ERROR("unable to initialize inotify, template hot reload is disabled");
+        return;
+    }
+
+    int       wd = -1;
+    CFileName watched_path;
+
+    while( ThreadTerminated == false ){
+        if( Enabled == false ) {
+            if( wd >= 0 ) inotify_rm_watch(fd,wd);
+            wd = -1;
+            watched_path = CFileName();
+            WaitForChanges(fd,1000);
+            continue;
+        }
+
+        // the directory can be changed by config reload
+        CFileName template_path = Server->GetTemplates()->GetTemplatePath();
+        if( template_path != watched_path ) {
+            if( wd >= 0 ) inotify_rm_watch(fd,wd);
+            wd = inotify_add_watch(fd,template_path,
+                                   IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE);
+            if( wd < 0 ) {
+                ES_ERROR("unable to watch template directory");
+            }
+            watched_path = template_path;
+        }
+
+        if( WaitForChanges(fd,1000) == false ) continue;
+
+        // settle
+        while( (ThreadTerminated == false) && WaitForChanges(fd,TEMPLATE_SETTLE_TIME) );
+        if( ThreadTerminated == true ) break;
+
+        Server->ReloadTemplates();
+    }
+
+    close(fd);
+}
+
+//------------------------------------------------------------------------------
+
+bool CTemplateWatcher::WaitForChanges(int fd,int timeout)
+{
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    if( poll(&pfd,1,timeout) <= 0 ) return(false);
+
+    // drain events, their content is not important
+    bool changed = false;
+    char buffer[4096];
+    while( read(fd,buffer,sizeof(buffer)) > 0 ){
+        changed = true;
+    }
+    return(changed);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
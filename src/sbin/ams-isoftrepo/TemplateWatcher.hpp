@@ -0,0 +1,62 @@
+#ifndef TemplateWatcherH
+#define TemplateWatcherH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <SmallThread.hpp>
+#include <FileName.hpp>
+#include <atomic>
+
+//------------------------------------------------------------------------------
+
+class CISoftRepoServer;
+
+//------------------------------------------------------------------------------
+
+/// watches the template directory and recompiles templates after changes
+/// the thread runs all the time, thus hot reload can be enabled by config reload
+
+class CTemplateWatcher : public CSmallThread {
+public:
+    CTemplateWatcher(void);
+
+// setup methods ---------------------------------------------------------------
+    /// set server owning templates
+    void SetServer(CISoftRepoServer* p_server);
+
+    /// enable or disable hot reload
+    void SetEnabled(bool enabled);
+
+// section of private data -----------------------------------------------------
+private:
+    CISoftRepoServer*   Server;
+    std::atomic<bool>   Enabled;
+
+    virtual void ExecuteThread(void);
+
+    /// wait for changes in the directory, true if something changed
+    bool WaitForChanges(int fd,int timeout);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,58 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "VerRecord.hpp"
+#include <string.h>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CVerRecord::CVerRecord(void)
+{
+    verindx = 0.0;
+}
+
+//------------------------------------------------------------------------------
+
+bool CVerRecord::operator == (const CVerRecord& left) const
+{
+    bool result = true;
+    result &= version == left.version;
+    return(result);
+}
+
+//------------------------------------------------------------------------------
+
+bool sort_tokens(const CVerRecord& left,const CVerRecord& right)
+{
+    if( left.version == right.version ) return(true);
+    if( left.verindx > right.verindx ) return(true);
+    if( left.verindx == right.verindx ){
+        return( strcmp(left.version,right.version) > 0);
+    }
+    return(false);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
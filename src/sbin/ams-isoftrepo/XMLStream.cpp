@@ -0,0 +1,427 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "XMLStream.hpp"
+#include <ErrorSystem.hpp>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CXMLStreamHandler::~CXMLStreamHandler(void)
+{
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CXMLStreamParser::CXMLStreamParser(void)
+{
+    Handler = NULL;
+    Begin = NULL;
+    End = NULL;
+    Pos = NULL;
+    Element = NULL;
+}
+
+//------------------------------------------------------------------------------
+
+void CXMLStreamParser::SetHandler(CXMLStreamHandler* p_handler)
+{
+    Handler = p_handler;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CXMLStreamParser::ParseFile(const CFileName& name)
+{
+    int fd = open(name,O_RDONLY);
+    if( fd == -1 ) {
+        CSmallString error;
+        error << "unable to open '" << name << "' (" << strerror(errno) << ")";
+        ES_ERROR(error);
+        return(false);
+    }
+
+    struct stat st;
+    if( (fstat(fd,&st) != 0) || (st.st_size == 0) ) {
+        close(fd);
+        CSmallString error;
+        error << "file '" << name << "' is empty or cannot be examined";
+        ES_ERROR(error);
+        return(false);
+    }
+
+    void* p_data = mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if( p_data == MAP_FAILED ) {
+        CSmallString error;
+        error << "unable to map '" << name << "' (" << strerror(errno) << ")";
+        ES_ERROR(error);
+        return(false);
+    }
+    madvise(p_data,st.st_size,MADV_SEQUENTIAL);
+
+    bool result = Parse(static_cast<const char*>(p_data),st.st_size);
+    munmap(p_data,st.st_size);
+
+    if( result == false ) {
+        CSmallString error;
+        error << "unable to parse '" << name << "'";
+        ES_ERROR(error);
+    }
+    return(result);
+}
+
+//------------------------------------------------------------------------------
+
+bool CXMLStreamParser::Parse(const char* p_data,size_t size)
+{
+    if( Handler == NULL ) {
+        ES_ERROR("no handler is set");
+        return(false);
+    }
+
+    Begin = p_data;
+    End = p_data + size;
+    Pos = p_data;
+    Open.clear();
+    OpenLength.clear();
+
+    bool root = false;
+
+    while( Pos < End ) {
+        // text is not reported
+        const char* p_lt = static_cast<const char*>(memchr(Pos,'<',End - Pos));
+        if( p_lt == NULL ) break;
+        Pos = p_lt;
+
+        if( (End - Pos >= 4) && (strncmp(Pos,"<!--",4) == 0) ) {
+            if( SkipTo("-->") == false ) return(false);
+        } else if( (End - Pos >= 9) && (strncmp(Pos,"<![CDATA[",9) == 0) ) {
+            if( SkipTo("]]>") == false ) return(false);
+        } else if( (End - Pos >= 2) && (Pos[1] == '?') ) {
+            if( SkipTo("?>") == false ) return(false);
+        } else if( (End - Pos >= 2) && (Pos[1] == '!') ) {
+            if( SkipDeclaration() == false ) return(false);
+        } else if( (End - Pos >= 2) && (Pos[1] == '/') ) {
+            if( ParseEndElement() == false ) return(false);
+        } else {
+            if( root && Open.empty() ) {
+                ReportError("more than one root element");
+                return(false);
+            }
+            root = true;
+            if( ParseElement() == false ) return(false);
+        }
+    }
+
+    if( root == false ) {
+        ReportError("no root element");
+        return(false);
+    }
+    if( Open.empty() == false ) {
+        ReportError("unexpected end of data");
+        return(false);
+    }
+    return(true);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+const char* CXMLStreamParser::GetAttribute(const CXMLStreamAttr* p_attrs,size_t nattrs,const char* p_name)
+{
+    for(size_t i=0; i < nattrs; i++){
+        if( IsName(p_attrs[i].Name,p_attrs[i].NameLength,p_name) ) return(p_attrs[i].Value.c_str());
+    }
+    return(NULL);
+}
+
+//------------------------------------------------------------------------------
+
+bool CXMLStreamParser::IsName(const char* p_name,size_t len,const char* p_expected)
+{
+    return( (strncmp(p_name,p_expected,len) == 0) && (p_expected[len] == '\0') );
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+const char* CXMLStreamParser::GetData(void) const
+{
+    return(Begin);
+}
+
+//------------------------------------------------------------------------------
+
+size_t CXMLStreamParser::GetElementOffset(void) const
+{
+    return(Element - Begin);
+}
+
+//------------------------------------------------------------------------------
+
+size_t CXMLStreamParser::GetOffset(void) const
+{
+    return(Pos - Begin);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CXMLStreamParser::ParseElement(void)
+{
+    Element = Pos;
+    Pos++;  // <
+    const char* p_name;
+    size_t      len;
+    if( ParseName(p_name,len) == false ) return(false);
+
+    size_t nattrs = 0;
+    for(;;){
+        SkipSpaces();
+        if( Pos >= End ) {
+            ReportError("unterminated element");
+            return(false);
+        }
+        if( *Pos == '>' ) {
+            Pos++;
+            if( Handler->StartElement(p_name,len,Attrs.data(),nattrs) == false ) return(false);
+            Open.push_back(p_name);
+            OpenLength.push_back(len);
+            return(true);
+        }
+        if( *Pos == '/' ) {
+            if( (End - Pos < 2) || (Pos[1] != '>') ) {
+                ReportError("'>' expected");
+                return(false);
+            }
+            Pos += 2;
+            if( Handler->StartElement(p_name,len,Attrs.data(),nattrs) == false ) return(false);
+            return(Handler->EndElement(p_name,len));
+        }
+
+        // attribute
+        if( nattrs == Attrs.size() ) Attrs.resize(nattrs + 1);
+        CXMLStreamAttr& attr = Attrs[nattrs];
+        if( ParseName(attr.Name,attr.NameLength) == false ) return(false);
+        SkipSpaces();
+        if( (Pos >= End) || (*Pos != '=') ) {
+            ReportError("'=' expected");
+            return(false);
+        }
+        Pos++;
+        SkipSpaces();
+        if( ParseAttrValue(attr.Value) == false ) return(false);
+        nattrs++;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+bool CXMLStreamParser::ParseEndElement(void)
+{
+    Pos += 2;  // </
+    const char* p_name;
+    size_t      len;
+    if( ParseName(p_name,len) == false ) return(false);
+    SkipSpaces();
+    if( (Pos >= End) || (*Pos != '>') ) {
+        ReportError("'>' expected");
+        return(false);
+    }
+    Pos++;
+
+    if( Open.empty() || (OpenLength.back() != len) || (strncmp(Open.back(),p_name,len) != 0) ) {
+        ReportError("mismatched end element");
+        return(false);
+    }
+    Open.pop_back();
+    OpenLength.pop_back();
+
+    return(Handler->EndElement(p_name,len));
+}
+
+//------------------------------------------------------------------------------
+
+bool CXMLStreamParser::SkipTo(const char* p_terminator)
+{
+    size_t len = strlen(p_terminator);
+    const char* p = Pos + 2;
+    while( End - p >= (ptrdiff_t)len ) {
+        p = static_cast<const char*>(memchr(p,p_terminator[0],End - p));
+        if( p == NULL ) break;
+        if( (End - p >= (ptrdiff_t)len) && (memcmp(p,p_terminator,len) == 0) ) {
+            Pos = p + len;
+            return(true);
+        }
+        p++;
+    }
+    ReportError("unterminated markup");
+    return(false);
+}
+
+//------------------------------------------------------------------------------
+
+bool CXMLStreamParser::SkipDeclaration(void)
+{
+    // <!DOCTYPE ...> with an optional internal subset in brackets
+    int level = 0;
+    for(const char* p = Pos + 2; p < End; p++){
+        if( *p == '[' ) level++;
+        if( *p == ']' ) level--;
+        if( (*p == '>') && (level <= 0) ) {
+            Pos = p + 1;
+            return(true);
+        }
+    }
+    ReportError("unterminated declaration");
+    return(false);
+}
+
+//------------------------------------------------------------------------------
+
+bool CXMLStreamParser::ParseName(const char*& p_name,size_t& len)
+{
+    p_name = Pos;
+    while( Pos < End ) {
+        char c = *Pos;
+        if( (c == ' ') || (c == '\t') || (c == '\n') || (c == '\r')
+            || (c == '>') || (c == '/') || (c == '=') ) break;
+        Pos++;
+    }
+    len = Pos - p_name;
+    if( len == 0 ) {
+        ReportError("name expected");
+        return(false);
+    }
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CXMLStreamParser::ParseAttrValue(std::string& value)
+{
+    if( (Pos >= End) || ((*Pos != '"') && (*Pos != '\'')) ) {
+        ReportError("quoted value expected");
+        return(false);
+    }
+    char quote = *Pos++;
+    const char* p_end = static_cast<const char*>(memchr(Pos,quote,End - Pos));
+    if( p_end == NULL ) {
+        ReportError("unterminated attribute value");
+        return(false);
+    }
+
+    value.clear();
+    while( Pos < p_end ) {
+        const char* p_amp = static_cast<const char*>(memchr(Pos,'&',p_end - Pos));
+        if( p_amp == NULL ) {
+            value.append(Pos,p_end - Pos);
+            break;
+        }
+        value.append(Pos,p_amp - Pos);
+        const char* p_semi = static_cast<const char*>(memchr(p_amp,';',p_end - p_amp));
+        if( p_semi == NULL ) {
+            ReportError("unterminated entity");
+            return(false);
+        }
+        const char* p_ent = p_amp + 1;
+        size_t      len = p_semi - p_ent;
+        if( IsName(p_ent,len,"amp") ) {
+            value += '&';
+        } else if( IsName(p_ent,len,"lt") ) {
+            value += '<';
+        } else if( IsName(p_ent,len,"gt") ) {
+            value += '>';
+        } else if( IsName(p_ent,len,"quot") ) {
+            value += '"';
+        } else if( IsName(p_ent,len,"apos") ) {
+            value += '\'';
+        } else if( (len > 1) && (p_ent[0] == '#') ) {
+            // the number is terminated by the semicolon
+            unsigned long code = (p_ent[1] == 'x') ? strtoul(p_ent + 2,NULL,16)
+                                                    : strtoul(p_ent + 1,NULL,10);
+            // UTF-8 encoding
+            if( code < 0x80 ) {
+                value += (char)code;
+            } else if( code < 0x800 ) {
+                value += (char)(0xC0 | (code >> 6));
+                value += (char)(0x80 | (code & 0x3F));
+            } else if( code < 0x10000 ) {
+                value += (char)(0xE0 | (code >> 12));
+                value += (char)(0x80 | ((code >> 6) & 0x3F));
+                value += (char)(0x80 | (code & 0x3F));
+            } else {
+                value += (char)(0xF0 | (code >> 18));
+                value += (char)(0x80 | ((code >> 12) & 0x3F));
+                value += (char)(0x80 | ((code >> 6) & 0x3F));
+                value += (char)(0x80 | (code & 0x3F));
+            }
+        } else {
+            ReportError("unknown entity");
+            return(false);
+        }
+        Pos = p_semi + 1;
+    }
+
+    Pos = p_end + 1;
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+void CXMLStreamParser::SkipSpaces(void)
+{
+    while( (Pos < End) && ((*Pos == ' ') || (*Pos == '\t') || (*Pos == '\n') || (*Pos == '\r')) ) Pos++;
+}
+
+//------------------------------------------------------------------------------
+
+void CXMLStreamParser::ReportError(const char* p_reason)
+{
+    int line = 1;
+    for(const char* p = Begin; (p < Pos) && (p < End); p++){
+        if( *p == '\n' ) line++;
+    }
+    CSmallString error;
+    error << p_reason << " at line " << line;
+    ES_ERROR(error);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
@@ -0,0 +1,117 @@
+#ifndef XMLStreamH
+#define XMLStreamH
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <FileName.hpp>
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+//------------------------------------------------------------------------------
+
+/// attribute of the element, the name points into the parsed data
+
+class CXMLStreamAttr {
+public:
+    const char*     Name;
+    size_t          NameLength;
+    std::string     Value;      // with resolved entities
+};
+
+//------------------------------------------------------------------------------
+
+/// receiver of parser events, names and attributes are valid only during the call
+
+class CXMLStreamHandler {
+public:
+    virtual ~CXMLStreamHandler(void);
+
+    /// element was opened, return false to stop parsing
+    virtual bool StartElement(const char* p_name,size_t len,
+                              const CXMLStreamAttr* p_attrs,size_t nattrs) = 0;
+
+    /// element was closed, return false to stop parsing
+    virtual bool EndElement(const char* p_name,size_t len) = 0;
+};
+
+//------------------------------------------------------------------------------
+
+/// event based XML parser, it does not build any document tree
+/// text, comments, processing instructions and DTD are skipped
+/// handlers can copy the raw text of an element from its start and end offsets
+
+class CXMLStreamParser {
+public:
+    CXMLStreamParser(void);
+
+// setup methods ---------------------------------------------------------------
+    /// set receiver of events
+    void SetHandler(CXMLStreamHandler* p_handler);
+
+// main methods ----------------------------------------------------------------
+    /// parse file mapped into memory
+    bool ParseFile(const CFileName& name);
+
+    /// parse data in memory
+    bool Parse(const char* p_data,size_t size);
+
+    /// get value of attribute or NULL if it is not present
+    static const char* GetAttribute(const CXMLStreamAttr* p_attrs,size_t nattrs,const char* p_name);
+
+    /// compare element name
+    static bool IsName(const char* p_name,size_t len,const char* p_expected);
+
+// information methods ---------------------------------------------------------
+    /// get parsed data, it is valid only during parsing
+    const char* GetData(void) const;
+
+    /// get offset of '<' of the element, it is valid in StartElement
+    size_t GetElementOffset(void) const;
+
+    /// get offset behind the parsed markup, in EndElement it is behind the element
+    size_t GetOffset(void) const;
+
+// section of private data -----------------------------------------------------
+private:
+    CXMLStreamHandler*          Handler;
+    const char*                 Begin;
+    const char*                 End;
+    const char*                 Pos;
+    const char*                 Element;    // start of the current element
+    std::vector<CXMLStreamAttr> Attrs;      // reused between elements
+    std::vector<const char*>    Open;       // names of open elements
+    std::vector<size_t>         OpenLength;
+
+    bool ParseElement(void);
+    bool ParseEndElement(void);
+    bool SkipTo(const char* p_terminator);
+    bool SkipDeclaration(void);
+    bool ParseName(const char*& p_name,size_t& len);
+    bool ParseAttrValue(std::string& value);
+    void SkipSpaces(void);
+    void ReportError(const char* p_reason);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
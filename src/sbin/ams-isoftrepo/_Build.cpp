@@ -25,20 +25,21 @@
 #include <ErrorSystem.hpp>
 #include <ModCache.hpp>
 #include <ModUtils.hpp>
-#include <ModuleController.hpp>
+#include <XMLDocument.hpp>
 
 //==============================================================================
 //------------------------------------------------------------------------------
 //==============================================================================
 
-bool CISoftRepoServer::_Build(CFCGIRequest& request)
+bool CISoftRepoServer::_Build(CFCGIRequest& request,std::string& page)
 {
     // parameters ------------------------------------------------------
     CTemplateParams    params;
+    CPageFragments     fragments;
 
     params.Initialize();
     params.SetParam("AMSVER",LibBuildVersion_AMS_Web);
-    params.Include("MONITORING",GetMonitoringIFrame());
+    if( SetMonitoringBlock(request,params,fragments) == false ) return(false);
 
     ProcessCommonParams(request,params);
 
@@ -50,29 +51,34 @@ bool CISoftRepoServer::_Build(CFCGIRequest& request)
     modver = module_name + ":" + module_ver;
     build = module_name + ":" + module_ver + ":" + module_arch + ":" + module_mode;
 
-    // populate cache ------------
-    CModuleController mod_controller;
-    mod_controller.InitModuleControllerConfig(BundleName,BundlePath);
-    mod_controller.LoadBundles(EMBC_SMALL);
-    CModCache mod_cache;
-    mod_controller.MergeBundles(mod_cache);
+    // catalog snapshot ----------
+    CCatalogSnapshotPtr snapshot = GetSnapshot(request);
+    if( snapshot == NULL ) {
+        ES_ERROR("catalog is not available");
+        return(false);
+    }
 
-    CXMLElement* p_module = mod_cache.GetModule(module_name);
-    if( p_module == NULL ) {
+    uint32_t     index,build_index;
+    if( snapshot->Table.FindModule(module_name,index) == false ) {
         CSmallString error;
         error << "module not found '" << module_name << "'";
         ES_ERROR(error);
         return(false);
     }
-
-    CXMLElement* p_build = CModCache::GetBuild(p_module,module_ver,module_arch,module_mode);
-    if( p_build == NULL ) {
+    if( snapshot->Table.FindBuild(index,module_ver,module_arch,module_mode,build_index) == false ) {
         CSmallString error;
         error << "build '" << module << "' was not found";
         ES_ERROR(error);
         return(false);
     }
 
+    CCatalogRecordPtr holder;
+    CXMLElement* p_build = snapshot->GetBuildRecord(build_index,holder);
+    if( p_build == NULL ) {
+        ES_ERROR("build record is not available");
+        return(false);
+    }
+
     params.SetParam("MODVER",modver);
     params.SetParam("MODVERURL",CFCGIParams::EncodeString(modver));
     params.SetParam("BUILD",build);
@@ -108,48 +114,67 @@ bool CISoftRepoServer::_Build(CFCGIRequest& request)
     params.EndCondition("ACL");
 
     // dependencies ------------------------------
+    // the table is a cached fragment, it changes only with the dependency list
     CXMLElement* p_deps = p_build->GetFirstChildElement("deps");
     params.StartCondition("DEPENDENCIES",p_deps != NULL);
     if( p_deps != NULL ){
-        params.StartCycle("DEPS");
-        CXMLElement* p_dep = p_deps->GetFirstChildElement("dep");
-        while( p_dep != NULL ){
-            CSmallString module;
-            CSmallString type;
-            p_dep->GetAttribute("name",module);
-            p_dep->GetAttribute("type",type);
-
-            params.SetParam("DTYPE",type);
-            CSmallString mname,mver,march,mmode;
-            CModUtils::ParseModuleName(module,mname,mver,march,mmode);
-
-            params.StartCondition("MNAM",mver == NULL);
-                params.SetParam("DNAME",mname);
-                params.SetParam("DNAMEURL",CFCGIParams::EncodeString(mname));
-            params.EndCondition("MNAM");
-
-            params.StartCondition("MVER",(mver != NULL) && (mmode == NULL));
-                params.SetParam("DNAME",mname);
-                params.SetParam("DNAMEURL",CFCGIParams::EncodeString(mname));
-                params.SetParam("DVER",mver);
-                params.SetParam("DVERURL",CFCGIParams::EncodeString(mver));
-            params.EndCondition("MVER");
-
-            params.StartCondition("MBUILD",mmode != NULL);
-                params.SetParam("DNAME",mname);
-                params.SetParam("DNAMEURL",CFCGIParams::EncodeString(mname));
-                params.SetParam("DVER",mver);
-                params.SetParam("DVERURL",CFCGIParams::EncodeString(mver));
-                params.SetParam("DARCH",march);
-                params.SetParam("DARCHURL",CFCGIParams::EncodeString(march));
-                params.SetParam("DMODE",mmode);
-                params.SetParam("DMODEURL",CFCGIParams::EncodeString(mmode));
-            params.EndCondition("MBUILD");
-
-            params.NextRun();
-            p_dep = p_dep->GetNextSiblingElement("dep");
-        }
-        params.EndCycle("DEPS");
+        std::string name;
+        name = "build-deps\n";
+        name += (const char*)build;
+        CFragmentPtr fragment;
+        bool result = GetFragment(request,FindSite(request),name,GetDependenciesStamp(p_deps),[&](std::string& output){
+            CTemplateParams deps_params;
+            deps_params.Initialize();
+            ProcessCommonParams(request,deps_params);
+
+            deps_params.StartCycle("DEPS");
+            CXMLElement* p_dep = p_deps->GetFirstChildElement("dep");
+            while( p_dep != NULL ){
+                CSmallString module;
+                CSmallString type;
+                p_dep->GetAttribute("name",module);
+                p_dep->GetAttribute("type",type);
+
+                deps_params.SetParam("DTYPE",type);
+                CSmallString mname,mver,march,mmode;
+                CModUtils::ParseModuleName(module,mname,mver,march,mmode);
+
+                deps_params.StartCondition("MNAM",mver == NULL);
+                    deps_params.SetParam("DNAME",mname);
+                    deps_params.SetParam("DNAMEURL",CFCGIParams::EncodeString(mname));
+                deps_params.EndCondition("MNAM");
+
+                deps_params.StartCondition("MVER",(mver != NULL) && (mmode == NULL));
+                    deps_params.SetParam("DNAME",mname);
+                    deps_params.SetParam("DNAMEURL",CFCGIParams::EncodeString(mname));
+                    deps_params.SetParam("DVER",mver);
+                    deps_params.SetParam("DVERURL",CFCGIParams::EncodeString(mver));
+                deps_params.EndCondition("MVER");
+
+                deps_params.StartCondition("MBUILD",mmode != NULL);
+                    deps_params.SetParam("DNAME",mname);
+                    deps_params.SetParam("DNAMEURL",CFCGIParams::EncodeString(mname));
+                    deps_params.SetParam("DVER",mver);
+                    deps_params.SetParam("DVERURL",CFCGIParams::EncodeString(mver));
+                    deps_params.SetParam("DARCH",march);
+                    deps_params.SetParam("DARCHURL",CFCGIParams::EncodeString(march));
+                    deps_params.SetParam("DMODE",mmode);
+                    deps_params.SetParam("DMODEURL",CFCGIParams::EncodeString(mmode));
+                deps_params.EndCondition("MBUILD");
+
+                deps_params.NextRun();
+                p_dep = p_dep->GetNextSiblingElement("dep");
+            }
+            deps_params.EndCycle("DEPS");
+
+            if( deps_params.Finalize() == false ) {
+                ES_ERROR("unable to prepare parameters");
+                return(false);
+            }
+            return(ProcessFragmentTemplate("BuildDependencies.html",deps_params,output));
+        },fragment);
+        if( result == false ) return(false);
+        params.SetParam("DEPSBLOCK",fragments.AddFragment(fragment));
     }
     params.EndCondition("DEPENDENCIES");
 
@@ -202,7 +227,7 @@ bool CISoftRepoServer::_Build(CFCGIRequest& request)
     }
 
     // process template ------------------------------------------------
-    bool result = ProcessTemplate(request,"Build.html",params);
+    bool result = ProcessTemplate("Build.html",params,page,&fragments);
 
     return(result);
 }
@@ -32,14 +32,16 @@
 //------------------------------------------------------------------------------
 //==============================================================================
 
-bool CISoftRepoServer::_Error(CFCGIRequest& request)
+bool CISoftRepoServer::_Error(CFCGIRequest& request,std::string& page)
 {
     // parameters ------------------------------------------------------
+    CServerConfigPtr   config = GetConfig();
     CTemplateParams    params;
 
     params.Initialize();
     params.SetParam("AMSVER",LibBuildVersion_AMS_Web);
-    params.Include("MONITORING",GetMonitoringIFrame());
+    // the error page does not use cached fragments, it must not fail on them
+    params.Include("MONITORING",config->MonitoringIFrame);
 
     ProcessCommonParams(request,params);
 
@@ -49,7 +51,7 @@ bool CISoftRepoServer::_Error(CFCGIRequest& request)
     }
 
     // process template ------------------------------------------------
-    bool result = ProcessTemplate(request,"Error.html",params);
+    bool result = ProcessTemplate("Error.html",params,page);
 
     return(result);
 }
@@ -0,0 +1,284 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "ISoftRepoServer.hpp"
+#include "RequestArena.hpp"
+#include "ExportStream.hpp"
+#include <ErrorSystem.hpp>
+#include <ModCache.hpp>
+#include <ModUtils.hpp>
+#include <XMLDocument.hpp>
+#include <string>
+#include <vector>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+static void AppendACL(std::string& record,CXMLElement* p_acl)
+{
+    CSmallString defrule;
+    if( p_acl ) p_acl->GetAttribute("default",defrule);
+    if( defrule == NULL ) defrule = "allow";
+
+    record += ",\"acl\":{\"default\":";
+    CExportStream::AppendString(record,defrule);
+    record += ",\"rules\":[";
+    if( p_acl != NULL ){
+        CXMLElement* p_rule = p_acl->GetFirstChildElement();
+        bool first = true;
+        while( p_rule != NULL ){
+            CSmallString group;
+            p_rule->GetAttribute("group",group);
+            if( ! first ) record += ',';
+            record += "{\"rule\":";
+            CExportStream::AppendString(record,p_rule->GetName());
+            record += ",\"group\":";
+            CExportStream::AppendString(record,group);
+            record += '}';
+            first = false;
+            p_rule = p_rule->GetNextSiblingElement();
+        }
+    }
+    record += "]}";
+}
+
+//------------------------------------------------------------------------------
+
+static void AppendDeps(std::string& record,CXMLElement* p_deps)
+{
+    record += ",\"deps\":[";
+    if( p_deps != NULL ){
+        CXMLElement* p_dep = p_deps->GetFirstChildElement("dep");
+        bool first = true;
+        while( p_dep != NULL ){
+            CSmallString name;
+            CSmallString type;
+            p_dep->GetAttribute("name",name);
+            p_dep->GetAttribute("type",type);
+            if( ! first ) record += ',';
+            record += "{\"name\":";
+            CExportStream::AppendString(record,name);
+            record += ",\"type\":";
+            CExportStream::AppendString(record,type);
+            record += '}';
+            first = false;
+            p_dep = p_dep->GetNextSiblingElement("dep");
+        }
+    }
+    record += ']';
+}
+
+//------------------------------------------------------------------------------
+
+static void AppendSetup(std::string& record,CXMLElement* p_build)
+{
+    record += ",\"setup\":[";
+    CXMLElement* p_sele = p_build->GetFirstChildElement("setup");
+    if( p_sele != NULL ) p_sele = p_sele->GetFirstChildElement();
+
+    bool first = true;
+    while( p_sele != NULL ) {
+        CSmallString name;
+        CSmallString value;
+        CSmallString operation;
+        CSmallString priority;
+        bool         secret = false;
+        if( p_sele->GetName() == "variable" ) {
+            p_sele->GetAttribute("name",name);
+            p_sele->GetAttribute("value",value);
+            p_sele->GetAttribute("operation",operation);
+            p_sele->GetAttribute("priority",priority);
+            p_sele->GetAttribute("secret",secret);
+        }
+        if( p_sele->GetName() == "script" ) {
+            p_sele->GetAttribute("name",name);
+            p_sele->GetAttribute("type",operation);
+            p_sele->GetAttribute("priority",priority);
+        }
+        if( p_sele->GetName() == "alias" ) {
+            p_sele->GetAttribute("name",name);
+            p_sele->GetAttribute("value",value);
+            p_sele->GetAttribute("priority",priority);
+        }
+        if( secret ){
+            value = "*******";
+        }
+        if( ! first ) record += ',';
+        record += "{\"type\":";
+        CExportStream::AppendString(record,p_sele->GetName());
+        record += ",\"name\":";
+        CExportStream::AppendString(record,name);
+        record += ",\"value\":";
+        CExportStream::AppendString(record,value);
+        record += ",\"operation\":";
+        CExportStream::AppendString(record,operation);
+        record += ",\"priority\":";
+        CExportStream::AppendString(record,priority);
+        record += '}';
+        first = false;
+        p_sele = p_sele->GetNextSiblingElement();
+    }
+    record += ']';
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CISoftRepoServer::_Export(CFCGIRequest& request,CResponseWriter& response)
+{
+    // filters ---------------------------------------------------------
+    CSmallString category = request.Params.GetValue("category");
+    bool         gzip = request.Params.GetValue("gzip") == "true";
+
+    // catalog snapshot ----------
+    CCatalogSnapshotPtr snapshot = GetSnapshot(request);
+    if( snapshot == NULL ) {
+        ES_ERROR("catalog is not available");
+        return(false);
+    }
+    const CCatalogTable& table = snapshot->Table;
+    CTableView<CCatalogModule> modules = table.GetModuleTable();
+
+    // builds selected by filters, bits are positions in the catalog table
+    CCatalogFilter          filter;
+    CCatalogBitmap          builds;
+    const CCatalogBitmap*   p_builds = NULL;
+    if( EvaluateFilter(request,snapshot,filter,builds,p_builds) == false ) return(false);
+
+    // modules of the requested category
+    std::vector<bool> cat_mods;
+    if( category != NULL ) {
+        cat_mods.resize(modules.size());
+        const CCatalogCategory* p_category = table.FindCategory(category);
+        CTableView<uint32_t> members = table.GetCategoryModuleTable();
+        for(uint32_t i=0; (p_category != NULL) && (i < p_category->NumOfModules); i++){
+            cat_mods[members[p_category->FirstModule + i]] = true;
+        }
+    }
+
+    // stream records --------------------------------------------------
+    CExportStream   stream(response);
+    if( stream.Open(gzip) == false ) {
+        ES_ERROR("unable to open export stream");
+        return(false);
+    }
+
+    std::string  record;
+    record.reserve(4096);
+    CArenaString full_name;
+
+    // the table and the cache list modules and their builds in the same order
+    for(uint32_t i=0; i < modules.size(); i++){
+        const CCatalogModule& module = modules[i];
+
+        if( (category != NULL) && (cat_mods[i] == false) ) continue;
+        if( (p_builds != NULL) && (p_builds->TestRange(module.FirstBuild,module.NumOfBuilds) == false) ) continue;
+
+        // records of attached snapshot are parsed one by one, they are not
+        // cached so that the export does not evict records of popular pages
+        CCatalogRecordPtr holder;
+        CXMLElement* p_module = snapshot->GetModuleRecord(i,holder,false);
+        if( p_module == NULL ) continue;
+
+        const CCatalogBundle& bundle = table.GetBundleTable()[module.Bundle];
+        CSmallString module_name(table.GetString(module.Name));
+        CSmallString bundle_name(table.GetString(bundle.Name));
+        CSmallString maintainer(table.GetString(bundle.Maintainer));
+        CSmallString contact(table.GetString(bundle.Contact));
+
+        CSmallString dver,darch,dmode;
+        CModCache::GetModuleDefaults(p_module,dver,darch,dmode);
+
+        CXMLElement* p_build = p_module->GetChildElementByPath("builds/build");
+        for(uint32_t index = module.FirstBuild; p_build != NULL; index++){
+            if( (p_builds != NULL) && (p_builds->Test(index) == false) ) {
+                p_build = p_build->GetNextSiblingElement("build");
+                continue;
+            }
+
+            CSmallString ver,arch,mode;
+            double       verindx = 0.0;
+            p_build->GetAttribute("ver",ver);
+            p_build->GetAttribute("arch",arch);
+            p_build->GetAttribute("mode",mode);
+            p_build->GetAttribute("verindx",verindx);
+
+            full_name.assign(module_name);
+            full_name += ':';
+            full_name += ver;
+            full_name += ':';
+            full_name += arch;
+            full_name += ':';
+            full_name += mode;
+
+            char buffer[32];
+            snprintf(buffer,sizeof(buffer),"%.10g",verindx);
+
+            record.clear();
+            record += "{\"build\":";
+            CExportStream::AppendString(record,full_name.c_str());
+            record += ",\"module\":";
+            CExportStream::AppendString(record,module_name);
+            record += ",\"version\":";
+            CExportStream::AppendString(record,ver);
+            record += ",\"arch\":";
+            CExportStream::AppendString(record,arch);
+            record += ",\"mode\":";
+            CExportStream::AppendString(record,mode);
+            record += ",\"verindx\":";
+            record += buffer;
+            record += ",\"default\":";
+            record += (ver == dver) && ((darch == NULL) || (arch == darch))
+                      && ((dmode == NULL) || (mode == dmode)) ? "true" : "false";
+            record += ",\"bundle\":";
+            CExportStream::AppendString(record,bundle_name);
+            record += ",\"maintainer\":";
+            CExportStream::AppendString(record,maintainer);
+            record += ",\"contact\":";
+            CExportStream::AppendString(record,contact);
+            AppendACL(record,p_build->GetFirstChildElement("acl"));
+            AppendDeps(record,p_build->GetFirstChildElement("deps"));
+            AppendSetup(record,p_build);
+            record += '}';
+
+            if( stream.WriteRecord(record) == false ) {
+                ES_ERROR("unable to write export record");
+                stream.Close();
+                response.Finish();
+                return(true);  // headers are already sent
+            }
+
+            p_build = p_build->GetNextSiblingElement("build");
+        }
+    }
+
+    stream.Close();
+    response.Finish();
+
+    return(true);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
@@ -23,31 +23,31 @@
 #include "ISoftRepoServer.hpp"
 #include <TemplateParams.hpp>
 #include <ErrorSystem.hpp>
-#include <ModCache.hpp>
 #include <ModUtils.hpp>
-#include <ModuleController.hpp>
 
 //==============================================================================
 //------------------------------------------------------------------------------
 //==============================================================================
 
-bool CISoftRepoServer::_ListCategories(CFCGIRequest& request)
+bool CISoftRepoServer::_ListCategories(CFCGIRequest& request,std::string& page)
 {
     // parameters ------------------------------------------------------
     CTemplateParams    params;
+    CPageFragments     fragments;
 
     params.Initialize();
     params.SetParam("AMSVER",LibBuildVersion_AMS_Web);
-    params.Include("MONITORING",GetMonitoringIFrame());
+    if( SetMonitoringBlock(request,params,fragments) == false ) return(false);
 
     ProcessCommonParams(request,params);
 
-    // populate cache ------------
-    CModuleController mod_controller;
-    mod_controller.InitModuleControllerConfig(BundleName,BundlePath);
-    mod_controller.LoadBundles(EMBC_SMALL);
-    CModCache mod_cache;
-    mod_controller.MergeBundles(mod_cache);
+    // catalog snapshot ----------
+    CCatalogSnapshotPtr snapshot = GetSnapshot(request);
+    if( snapshot == NULL ) {
+        ES_ERROR("catalog is not available");
+        return(false);
+    }
+    const CCatalogTable& table = snapshot->Table;
 
     CSmallString tmp;
     bool include_vers;
@@ -57,6 +57,23 @@ bool CISoftRepoServer::_ListCategories(CFCGIRequest& request)
     params.StartCondition("CHECKED_VERS",include_vers);
     params.EndCondition("CHECKED_VERS");
 
+    // filters are evaluated over bitmaps of builds
+    CCatalogFilter          filter;
+    CCatalogBitmap          builds;
+    const CCatalogBitmap*   p_builds = NULL;
+    if( EvaluateFilter(request,snapshot,filter,builds,p_builds) == false ) return(false);
+
+    params.SetParam("FILTERARCH",request.Params.GetValue("arch"));
+    params.SetParam("FILTERMODE",request.Params.GetValue("mode"));
+    params.SetParam("FILTERBUNDLE",request.Params.GetValue("bundle"));
+    params.SetParam("FILTERACL",request.Params.GetValue("acl"));
+    params.StartCondition("ACL_TRUE",request.Params.GetValue("acl") == "true");
+    params.EndCondition("ACL_TRUE");
+    params.StartCondition("ACL_FALSE",request.Params.GetValue("acl") == "false");
+    params.EndCondition("ACL_FALSE");
+    params.StartCondition("FILTERED",p_builds != NULL);
+    params.EndCondition("FILTERED");
+
     if( include_vers ) {
         params.SetParam("ACTION",CSmallString("version"));
     } else {
@@ -65,21 +82,44 @@ bool CISoftRepoServer::_ListCategories(CFCGIRequest& request)
 
 // get categories
     std::list<CSmallString> cats;
-    mod_cache.GetCategories(cats);
+    table.GetCategories(cats);
     cats.sort();
     cats.unique();
 
+    // blocks of modules are cached fragments, ListCategories.html prints
+    // MODULESBLOCK instead of the MODULES cycle for them, filtered pages are
+    // rendered inline and only kept in the page cache
+    CRepoSitePtr    site = FindSite(request);
+    bool            use_fragments = p_builds == NULL;
+
     params.StartCycle("CATEGORIES");
 
 // print modules
     for(CSmallString cat : cats){
+        if( use_fragments ) {
+            const CCatalogCategory* p_category = table.FindCategory(cat);
+            if( (p_category == NULL) || (p_category->NumOfModules == 0) ) continue;
+            CFragmentPtr fragment;
+            if( GetCategoryFragment(request,site,snapshot,cat,include_vers,fragment) == false ) return(false);
+            params.SetParam("CATEGORY",cat);
+            params.StartCondition("FRAGMENT",true);
+            params.SetParam("MODULESBLOCK",fragments.AddFragment(fragment));
+            params.EndCondition("FRAGMENT");
+            params.StartCycle("MODULES");
+            params.EndCycle("MODULES");
+            params.NextRun();
+            continue;
+        }
+
         std::list<CSmallString> mods;
-        mod_cache.GetModules(cat,mods,include_vers);
+        table.GetModules(cat,mods,include_vers,p_builds);
         mods.sort();
         mods.unique();
         if( mods.empty() ) continue;
 
         params.SetParam("CATEGORY",cat);
+        params.StartCondition("FRAGMENT",false);
+        params.EndCondition("FRAGMENT");
 
         params.StartCycle("MODULES");
 
@@ -93,22 +133,39 @@ bool CISoftRepoServer::_ListCategories(CFCGIRequest& request)
         params.NextRun();
     }
 
-    std::list<CSmallString> mods;
-    mod_cache.GetModules("sys",mods,include_vers);
-    mods.sort();
-    mods.unique();
-    if( ! mods.empty() ){
-        params.SetParam("CATEGORY","System & Uncategorized Modules");
-
-        params.StartCycle("MODULES");
-        for(CSmallString mod : mods){
-            params.SetParam("MODULE",mod);
-            params.SetParam("MODULEURL",CFCGIParams::EncodeString(mod));
+    if( use_fragments ) {
+        const CCatalogCategory* p_category = table.FindCategory("sys");
+        if( (p_category != NULL) && (p_category->NumOfModules != 0) ){
+            CFragmentPtr fragment;
+            if( GetCategoryFragment(request,site,snapshot,"sys",include_vers,fragment) == false ) return(false);
+            params.SetParam("CATEGORY","System & Uncategorized Modules");
+            params.StartCondition("FRAGMENT",true);
+            params.SetParam("MODULESBLOCK",fragments.AddFragment(fragment));
+            params.EndCondition("FRAGMENT");
+            params.StartCycle("MODULES");
+            params.EndCycle("MODULES");
             params.NextRun();
         }
+    } else {
+        std::list<CSmallString> mods;
+        table.GetModules("sys",mods,include_vers,p_builds);
+        mods.sort();
+        mods.unique();
+        if( ! mods.empty() ){
+            params.SetParam("CATEGORY","System & Uncategorized Modules");
+            params.StartCondition("FRAGMENT",false);
+            params.EndCondition("FRAGMENT");
 
-        params.EndCycle("MODULES");
-        params.NextRun();
+            params.StartCycle("MODULES");
+            for(CSmallString mod : mods){
+                params.SetParam("MODULE",mod);
+                params.SetParam("MODULEURL",CFCGIParams::EncodeString(mod));
+                params.NextRun();
+            }
+
+            params.EndCycle("MODULES");
+            params.NextRun();
+        }
     }
 
     params.EndCycle("CATEGORIES");
@@ -119,7 +176,7 @@ bool CISoftRepoServer::_ListCategories(CFCGIRequest& request)
     }
 
     // process template ------------------------------------------------
-    bool result = ProcessTemplate(request,"ListCategories.html",params);
+    bool result = ProcessTemplate("ListCategories.html",params,page,&fragments);
 
     return(result);
 }
@@ -127,3 +184,79 @@ bool CISoftRepoServer::_ListCategories(CFCGIRequest& request)
 //==============================================================================
 //------------------------------------------------------------------------------
 //==============================================================================
+
+bool CISoftRepoServer::GetCategoryFragment(CFCGIRequest& request,const CRepoSitePtr& site,
+                                           const CCatalogSnapshotPtr& snapshot,
+                                           const CSmallString& category,bool include_vers,
+                                           CFragmentPtr& fragment)
+{
+    const CCatalogTable& table = snapshot->Table;
+    const CCatalogCategory* p_category = table.FindCategory(category);
+    if( p_category == NULL ) {
+        ES_ERROR("category not found");
+        return(false);
+    }
+
+    std::string name;
+    name = "category\n";
+    name += (const char*)category;
+    name += include_vers ? "\nversions" : "\nmodules";
+
+    return(GetFragment(request,site,name,p_category->Stamp,[&](std::string& output){
+        CTemplateParams params;
+        params.Initialize();
+        ProcessCommonParams(request,params);
+
+        if( include_vers ) {
+            params.SetParam("ACTION",CSmallString("version"));
+        } else {
+            params.SetParam("ACTION",CSmallString("module"));
+        }
+        params.SetParam("CATEGORY",category);
+
+        std::list<CSmallString> mods;
+        table.GetModules(category,mods,include_vers);
+        mods.sort();
+        mods.unique();
+
+        params.StartCycle("MODULES");
+        for(CSmallString mod : mods){
+            params.SetParam("MODULE",mod);
+            params.SetParam("MODULEURL",CFCGIParams::EncodeString(mod));
+            params.NextRun();
+        }
+        params.EndCycle("MODULES");
+
+        if( params.Finalize() == false ) {
+            ES_ERROR("unable to prepare parameters");
+            return(false);
+        }
+        return(ProcessFragmentTemplate("CategoryModules.html",params,output));
+    },fragment));
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CISoftRepoServer::EvaluateFilter(CFCGIRequest& request,const CCatalogSnapshotPtr& snapshot,
+                                      CCatalogFilter& filter,CCatalogBitmap& builds,
+                                      const CCatalogBitmap*& p_builds)
+{
+    p_builds = NULL;
+    filter.SetFilter(request.Params.GetValue("arch"),request.Params.GetValue("mode"),
+                     request.Params.GetValue("bundle"),request.Params.GetValue("acl"));
+    if( filter.IsEmpty() ) return(true);
+
+    if( snapshot->Bitmaps.IsBuilt() == false ) {
+        ES_ERROR("catalog filters are not available");
+        return(false);
+    }
+    snapshot->Bitmaps.Evaluate(filter,builds);
+    p_builds = &builds;
+    return(true);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
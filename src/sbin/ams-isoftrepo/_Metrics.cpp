@@ -0,0 +1,62 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "ISoftRepoServer.hpp"
+#include <ErrorSystem.hpp>
+#include <string>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CISoftRepoServer::_Metrics(CFCGIRequest& request,CResponseWriter& response)
+{
+    std::string output;
+    output.reserve(16384);
+
+    Metrics.PrintMetrics(output);
+
+    CRepoSitesPtr sites = GetSites();
+    for(const CRepoSitePtr& site : sites->GetSites()){
+        std::string labels = "site=\"" + std::string(site->Name) + "\"";
+        site->Catalog.PrintMetrics(output,labels.c_str());
+        site->PageCache.PrintMetrics(output,labels.c_str());
+        site->FragmentCache.PrintMetrics(output,labels.c_str());
+    }
+    CServerMetrics::GroupFamilies(output);
+
+    Admission.PrintMetrics(output);
+    RateLimiter.PrintMetrics(output);
+    Log.PrintMetrics(output);
+    if( UnixSocket ) Listener.PrintMetrics(output);
+
+    response.Write("Content-type: text/plain; version=0.0.4\r\n");
+    response.Write("\r\n");
+    response.Write(output.c_str(),output.size());
+    response.Finish();
+
+    return(true);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
@@ -25,7 +25,7 @@
 #include <ErrorSystem.hpp>
 #include <ModCache.hpp>
 #include <ModUtils.hpp>
-#include <ModuleController.hpp>
+#include <XMLDocument.hpp>
 #include <vector>
 #include <boost/shared_ptr.hpp>
 
@@ -33,54 +33,16 @@
 //------------------------------------------------------------------------------
 //==============================================================================
 
-class CVerRecord {
-    public:
-    CVerRecord(void);
-    CSmallString   version;
-    int            verindx;
-    bool operator == (const CVerRecord& left) const;
-};
-
-//------------------------------------------------------------------------------
-
-CVerRecord::CVerRecord(void)
-{
-    verindx = 0.0;
-}
-
-//------------------------------------------------------------------------------
-
-bool CVerRecord::operator == (const CVerRecord& left) const
-{
-    bool result = true;
-    result &= version == left.version;
-    return(result);
-}
-
-//------------------------------------------------------------------------------
-
-bool sort_tokens(const CVerRecord& left,const CVerRecord& right)
-{
-    if( left.version == right.version ) return(true);
-    if( left.verindx > right.verindx ) return(true);
-    if( left.verindx == right.verindx ){
-        return( strcmp(left.version,right.version) > 0);
-    }
-    return(false);
-}
-
-//==============================================================================
-//------------------------------------------------------------------------------
-//==============================================================================
-
-bool CISoftRepoServer::_Module(CFCGIRequest& request)
+bool CISoftRepoServer::_Module(CFCGIRequest& request,std::string& page)
 {
     // parameters ------------------------------------------------------
+    CServerConfigPtr   config = GetConfig();
     CTemplateParams    params;
+    CPageFragments     fragments;
 
     params.Initialize();
     params.SetParam("AMSVER",LibBuildVersion_AMS_Web);
-    params.Include("MONITORING",GetMonitoringIFrame());
+    if( SetMonitoringBlock(request,params,fragments) == false ) return(false);
 
     ProcessCommonParams(request,params);
 
@@ -91,15 +53,22 @@ bool CISoftRepoServer::_Module(CFCGIRequest& request)
     params.SetParam("MODULE",module_name);
     params.SetParam("MODULEURL",CFCGIParams::EncodeString(module_name));
 
-    // populate cache ------------
-    CModuleController mod_controller;
-    mod_controller.InitModuleControllerConfig(BundleName,BundlePath);
-    mod_controller.LoadBundles(EMBC_BIG);
-    CModCache mod_cache;
-    mod_controller.MergeBundles(mod_cache);
+    // catalog snapshot ----------
+    CCatalogSnapshotPtr snapshot = GetSnapshot(request);
+    if( snapshot == NULL ) {
+        ES_ERROR("catalog is not available");
+        return(false);
+    }
+    CModCache& mod_cache = snapshot->Cache;
+    const CCatalogTable& table = snapshot->Table;
 
     // get module
-    CXMLElement* p_module = mod_cache.GetModule(module_name);
+    uint32_t     module;
+    CCatalogRecordPtr holder;
+    CXMLElement* p_module = NULL;
+    if( table.FindModule(module_name,module) == true ) {
+        p_module = snapshot->GetModuleRecord(module,holder);
+    }
     if( p_module == NULL ) {
         CSmallString error;
         error << "module not found '" << module_name << "'";
@@ -107,50 +76,18 @@ bool CISoftRepoServer::_Module(CFCGIRequest& request)
         return(false);
     }
 
-    params.SetParam("NBUNDLE",CModCache::GetBundleName(p_module));
-    params.SetParam("NMAINTAINER",CModCache::GetBundleMaintainer(p_module));
-    params.SetParam("NCONTACT",CModCache::GetBundleContact(p_module));
+    const CCatalogBundle& bundle = table.GetBundleTable()[table.GetModuleTable()[module].Bundle];
+    params.SetParam("NBUNDLE",table.GetString(bundle.Name));
+    params.SetParam("NMAINTAINER",table.GetString(bundle.Maintainer));
+    params.SetParam("NCONTACT",table.GetString(bundle.Contact));
 
     // module versions ---------------------------
-    CXMLElement* p_tele = p_module->GetChildElementByPath("builds/build");
-    std::list<CVerRecord>   versions;
-
-    while( p_tele != NULL ) {
-        CVerRecord verrcd;
-        verrcd.verindx = 0.0;
-        p_tele->GetAttribute("ver",verrcd.version);
-        p_tele->GetAttribute("verindx",verrcd.verindx);
-        versions.push_back(verrcd);
-
-        p_tele = p_tele->GetNextSiblingElement("build");
-    }
-
-    versions.sort(sort_tokens);
-    versions.unique();
+    // only the newest versions, the others are loaded by the versions fragment
+    std::vector<CSmallString> versions;
+    table.GetModuleVersions(module,versions);
+    SetModuleVersionsParams(params,module_name,versions,0,config->ModuleVersionsLimit);
 
-    params.StartCycle("VERSIONS");
-
-    std::list<CVerRecord>::iterator it = versions.begin();
-    std::list<CVerRecord>::iterator ie = versions.end();
-
-    int count = 0;
-    while( it != ie ){
-        count++;
-        CSmallString full_name;
-        full_name = module_name + ":" + (*it).version;
-        params.SetParam("MODVER",full_name);
-        params.SetParam("MODVERURL",CFCGIParams::EncodeString(full_name));
-        if( count > 5 ){
-            params.SetParam("CLASS","old");
-        } else {
-            params.SetParam("CLASS","new");
-        }
-        params.NextRun();
-        it++;
-    }
-    params.EndCycle("VERSIONS");
-
-    params.StartCondition("SHOWOLD",count > 5 );
+    params.StartCondition("SHOWOLD",versions.size() > 5 );
     params.EndCondition("SHOWOLD");
 
     // description --------------------------------
@@ -207,83 +144,92 @@ bool CISoftRepoServer::_Module(CFCGIRequest& request)
     } else {
         params.SetParam("DEFACL","deny all");
     }
-    bool any_acl_for_build = false;
-    CXMLElement* p_build;
-
-    p_build = p_module->GetChildElementByPath("builds/build");
-    while( p_build != NULL ){
-        if( p_build->GetFirstChildElement("acl") != NULL ){
-            any_acl_for_build = true;
+    // acl flags of builds are in the tables, the first build with acl is listed
+    const CCatalogModule& record = table.GetModuleTable()[module];
+    const CCatalogBuild*  p_acl_build = NULL;
+    for(uint32_t j=0; j < record.NumOfBuilds; j++){
+        const CCatalogBuild& build = table.GetBuildTable()[record.FirstBuild + j];
+        if( build.HasACL ){
+            p_acl_build = &build;
             break;
         }
-        p_build = p_build->GetNextSiblingElement("build");
     }
 
-    params.StartCondition("EXTRAACL",any_acl_for_build);
-    p_build = p_module->GetChildElementByPath("builds/build");
+    params.StartCondition("EXTRAACL",p_acl_build != NULL);
     params.StartCycle("EBUILDS");
-    while( p_build != NULL ){
-        CSmallString lver,larch,lmode;
-        p_build->GetAttribute("ver",lver);
-        p_build->GetAttribute("arch",larch);
-        p_build->GetAttribute("mode",lmode);
+    if( p_acl_build != NULL ){
         CSmallString full_name;
-        full_name = module_name + ":" + lver + ":" + larch + ":" + lmode;
-
-        if( p_build->GetFirstChildElement("acl") != NULL ){
-            params.SetParam("BUILD",full_name);
-            params.NextRun();
-            break;
-        }
-        p_build = p_build->GetNextSiblingElement("build");
+        full_name = module_name + ":" + table.GetString(p_acl_build->Version) + ":"
+                  + table.GetString(p_acl_build->Arch) + ":" + table.GetString(p_acl_build->Mode);
+        params.SetParam("BUILD",full_name);
+        params.NextRun();
     }
     params.EndCycle("EBUILDS");
     params.EndCondition("EXTRAACL");
     params.EndCondition("ACL");
 
     // dependencies ------------------------------
+    // the table is a cached fragment, it changes only with the dependency list
     CXMLElement* p_deps = p_module->GetFirstChildElement("deps");
     params.StartCondition("DEPENDENCIES",p_deps != NULL);
     if( p_deps != NULL ){
-        params.StartCycle("DEPS");
-        CXMLElement* p_dep = p_deps->GetFirstChildElement("dep");
-        while( p_dep != NULL ){
-            CSmallString module;
-            CSmallString type;
-            p_dep->GetAttribute("name",module);
-            p_dep->GetAttribute("type",type);
-
-            params.SetParam("DTYPE",type);
-            CSmallString mname,mver,march,mmode;
-            CModUtils::ParseModuleName(module,mname,mver,march,mmode);
-
-            params.StartCondition("MNAM",mver == NULL);
-                params.SetParam("DNAME",mname);
-                params.SetParam("DNAMEURL",CFCGIParams::EncodeString(mname));
-            params.EndCondition("MNAM");
-
-            params.StartCondition("MVER",mver != NULL);
-                params.SetParam("DNAME",mname);
-                params.SetParam("DNAMEURL",CFCGIParams::EncodeString(mname));
-                params.SetParam("DVER",mver);
-                params.SetParam("DVERURL",CFCGIParams::EncodeString(mver));
-            params.EndCondition("MVER");
-
-            params.StartCondition("MBUILD",mmode != NULL);
-                params.SetParam("DNAME",mmode);
-                params.SetParam("DNAMEURL",CFCGIParams::EncodeString(mmode));
-                params.SetParam("DVER",mmode);
-                params.SetParam("DVERURL",CFCGIParams::EncodeString(mmode));
-                params.SetParam("DARCH",mmode);
-                params.SetParam("DARCHURL",CFCGIParams::EncodeString(mmode));
-                params.SetParam("DMODE",mmode);
-                params.SetParam("DMODEURL",CFCGIParams::EncodeString(mmode));
-            params.EndCondition("MBUILD");
-
-            params.NextRun();
-            p_dep = p_dep->GetNextSiblingElement("dep");
-        }
-        params.EndCycle("DEPS");
+        std::string name;
+        name = "module-deps\n";
+        name += (const char*)module_name;
+        CFragmentPtr fragment;
+        bool result = GetFragment(request,FindSite(request),name,GetDependenciesStamp(p_deps),[&](std::string& output){
+            CTemplateParams deps_params;
+            deps_params.Initialize();
+            ProcessCommonParams(request,deps_params);
+
+            deps_params.StartCycle("DEPS");
+            CXMLElement* p_dep = p_deps->GetFirstChildElement("dep");
+            while( p_dep != NULL ){
+                CSmallString module;
+                CSmallString type;
+                p_dep->GetAttribute("name",module);
+                p_dep->GetAttribute("type",type);
+
+                deps_params.SetParam("DTYPE",type);
+                CSmallString mname,mver,march,mmode;
+                CModUtils::ParseModuleName(module,mname,mver,march,mmode);
+
+                deps_params.StartCondition("MNAM",mver == NULL);
+                    deps_params.SetParam("DNAME",mname);
+                    deps_params.SetParam("DNAMEURL",CFCGIParams::EncodeString(mname));
+                deps_params.EndCondition("MNAM");
+
+                deps_params.StartCondition("MVER",mver != NULL);
+                    deps_params.SetParam("DNAME",mname);
+                    deps_params.SetParam("DNAMEURL",CFCGIParams::EncodeString(mname));
+                    deps_params.SetParam("DVER",mver);
+                    deps_params.SetParam("DVERURL",CFCGIParams::EncodeString(mver));
+                deps_params.EndCondition("MVER");
+
+                deps_params.StartCondition("MBUILD",mmode != NULL);
+                    deps_params.SetParam("DNAME",mmode);
+                    deps_params.SetParam("DNAMEURL",CFCGIParams::EncodeString(mmode));
+                    deps_params.SetParam("DVER",mmode);
+                    deps_params.SetParam("DVERURL",CFCGIParams::EncodeString(mmode));
+                    deps_params.SetParam("DARCH",mmode);
+                    deps_params.SetParam("DARCHURL",CFCGIParams::EncodeString(mmode));
+                    deps_params.SetParam("DMODE",mmode);
+                    deps_params.SetParam("DMODEURL",CFCGIParams::EncodeString(mmode));
+                deps_params.EndCondition("MBUILD");
+
+                deps_params.NextRun();
+                p_dep = p_dep->GetNextSiblingElement("dep");
+            }
+            deps_params.EndCycle("DEPS");
+
+            if( deps_params.Finalize() == false ) {
+                ES_ERROR("unable to prepare parameters");
+                return(false);
+            }
+            return(ProcessFragmentTemplate("ModuleDependencies.html",deps_params,output));
+        },fragment);
+        if( result == false ) return(false);
+        params.SetParam("DEPSBLOCK",fragments.AddFragment(fragment));
     }
     params.EndCondition("DEPENDENCIES");
 
@@ -293,7 +239,7 @@ bool CISoftRepoServer::_Module(CFCGIRequest& request)
     }
 
     // process template ------------------------------------------------
-    bool result = ProcessTemplate(request,"Module.html",params);
+    bool result = ProcessTemplate("Module.html",params,page,&fragments);
 
     return(result);
 }
@@ -0,0 +1,158 @@
+// =============================================================================
+//  AMS - Advanced Module System
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2012 Petr Kulhanek (kulhanek@chemi.muni.cz)
+//     Copyright (C) 2011      Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2001-2008 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include "ISoftRepoServer.hpp"
+#include "RequestArena.hpp"
+#include <TemplateParams.hpp>
+#include <ErrorSystem.hpp>
+#include <ModUtils.hpp>
+#include <algorithm>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+// upper bound of the limit parameter
+#define MAX_VERSIONS_LIMIT  1000
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CISoftRepoServer::_ModuleVersions(CFCGIRequest& request,std::string& page)
+{
+    // parameters ------------------------------------------------------
+    CServerConfigPtr   config = GetConfig();
+    CTemplateParams    params;
+    CPageFragments     fragments;
+
+    params.Initialize();
+    params.SetParam("AMSVER",LibBuildVersion_AMS_Web);
+    if( SetMonitoringBlock(request,params,fragments) == false ) return(false);
+
+    ProcessCommonParams(request,params);
+
+    // IDs ------------------------------------------
+    CSmallString module_name;
+
+    CModUtils::ParseModuleName(request.Params.GetValue("module"),module_name);
+    params.SetParam("MODULE",module_name);
+    params.SetParam("MODULEURL",CFCGIParams::EncodeString(module_name));
+
+    // window ---------------------------------------
+    int offset = 0;
+    int limit = config->ModuleVersionsLimit;
+
+    CSmallString tmp;
+    tmp = request.Params.GetValue("offset");
+    if( tmp != NULL ) {
+        if( tmp.IsInt() == false ) {
+            ES_ERROR("offset must be an integer");
+            return(false);
+        }
+        offset = tmp.ToInt();
+    }
+    tmp = request.Params.GetValue("limit");
+    if( tmp != NULL ) {
+        if( tmp.IsInt() == false ) {
+            ES_ERROR("limit must be an integer");
+            return(false);
+        }
+        limit = tmp.ToInt();
+    }
+    if( offset < 0 ) offset = 0;
+    if( (limit <= 0) || (limit > MAX_VERSIONS_LIMIT) ) limit = MAX_VERSIONS_LIMIT;
+
+    // catalog snapshot ----------
+    CCatalogSnapshotPtr snapshot = GetSnapshot(request);
+    if( snapshot == NULL ) {
+        ES_ERROR("catalog is not available");
+        return(false);
+    }
+
+    uint32_t module;
+    if( snapshot->Table.FindModule(module_name,module) == false ) {
+        CSmallString error;
+        error << "module not found '" << module_name << "'";
+        ES_ERROR(error);
+        return(false);
+    }
+
+    std::vector<CSmallString> versions;
+    snapshot->Table.GetModuleVersions(module,versions);
+    SetModuleVersionsParams(params,module_name,versions,offset,limit);
+
+    if( params.Finalize() == false ) {
+        ES_ERROR("unable to prepare parameters");
+        return(false);
+    }
+
+    // process template ------------------------------------------------
+    bool result = ProcessTemplate("ModuleVersions.html",params,page,&fragments);
+
+    return(result);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CISoftRepoServer::SetModuleVersionsParams(CTemplateParams& params,
+                                               const CSmallString& module_name,
+                                               const std::vector<CSmallString>& versions,
+                                               size_t offset,size_t limit)
+{
+    size_t first = std::min(offset,versions.size());
+    size_t last = versions.size();
+    if( (limit > 0) && (last - first > limit) ) last = first + limit;
+
+    params.StartCycle("VERSIONS");
+
+    CArenaString name_buffer;
+    for(size_t i = first; i < last; i++){
+        name_buffer.assign(module_name);
+        name_buffer += ':';
+        name_buffer += versions[i];
+        CSmallString full_name(name_buffer.c_str());
+        params.SetParam("MODVER",full_name);
+        params.SetParam("MODVERURL",CFCGIParams::EncodeString(full_name));
+        // the five newest versions are shown expanded
+        if( i >= 5 ){
+            params.SetParam("CLASS","old");
+        } else {
+            params.SetParam("CLASS","new");
+        }
+        params.NextRun();
+    }
+    params.EndCycle("VERSIONS");
+
+    // link to the next window
+    params.SetParam("NUMOFVERSIONS",(int)versions.size());
+    params.StartCondition("MOREVERSIONS",last < versions.size());
+        params.SetParam("NEXTOFFSET",(int)last);
+        params.SetParam("LIMIT",(int)(last - first));
+    params.EndCondition("MOREVERSIONS");
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
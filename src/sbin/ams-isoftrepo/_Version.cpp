@@ -21,11 +21,10 @@
 // =============================================================================
 
 #include "ISoftRepoServer.hpp"
+#include "RequestArena.hpp"
 #include <TemplateParams.hpp>
 #include <ErrorSystem.hpp>
-#include <ModCache.hpp>
 #include <ModUtils.hpp>
-#include <ModuleController.hpp>
 
 using namespace std;
 
@@ -33,14 +32,15 @@ using namespace std;
 //------------------------------------------------------------------------------
 //==============================================================================
 
-bool CISoftRepoServer::_Version(CFCGIRequest& request)
+bool CISoftRepoServer::_Version(CFCGIRequest& request,std::string& page)
 {
     // parameters ------------------------------------------------------
     CTemplateParams    params;
+    CPageFragments     fragments;
 
     params.Initialize();
     params.SetParam("AMSVER",LibBuildVersion_AMS_Web);
-    params.Include("MONITORING",GetMonitoringIFrame());
+    if( SetMonitoringBlock(request,params,fragments) == false ) return(false);
 
     ProcessCommonParams(request,params);
 
@@ -56,28 +56,37 @@ bool CISoftRepoServer::_Version(CFCGIRequest& request)
     params.SetParam("MODULEURL",CFCGIParams::EncodeString(module_name));
     params.SetParam("VERSION",module_ver);
 
-    // populate cache ------------
-    CModuleController mod_controller;
-    mod_controller.InitModuleControllerConfig(BundleName,BundlePath);
-    mod_controller.LoadBundles(EMBC_SMALL);
-    CModCache mod_cache;
-    mod_controller.MergeBundles(mod_cache);
+    // catalog snapshot ----------
+    CCatalogSnapshotPtr snapshot = GetSnapshot(request);
+    if( snapshot == NULL ) {
+        ES_ERROR("catalog is not available");
+        return(false);
+    }
 
     // get module
-    CXMLElement* p_module = mod_cache.GetModule(module_name);
-    if( p_module == NULL ) {
-        ES_ERROR("module record was not found");
+    const CCatalogTable& table = snapshot->Table;
+    uint32_t module;
+    if( table.FindModule(module_name,module) == false ) {
+        CSmallString error;
+        error << "module not found '" << module_name << "'";
+        ES_ERROR(error);
         return(false);
     }
 
     // list of builds ----------------------------
-    std::list<CSmallString>   builds;
-    CModCache::GetModuleBuildsSorted(p_module,module_ver,builds);
-
+    // builds are presorted by arch and mode in the catalog tables
     params.StartCycle("BUILDS");
-    for(CSmallString bld_name: builds){
-        CSmallString full_name;
-        full_name << module_name << ":" << bld_name;
+    CArenaString name_buffer;
+    for(uint32_t index : table.GetVersionBuilds(module,module_ver)){
+        const CCatalogBuild& build = table.GetBuildTable()[index];
+        name_buffer.assign(module_name);
+        name_buffer += ':';
+        name_buffer += table.GetString(build.Version);
+        name_buffer += ':';
+        name_buffer += table.GetString(build.Arch);
+        name_buffer += ':';
+        name_buffer += table.GetString(build.Mode);
+        CSmallString full_name(name_buffer.c_str());
         params.SetParam("BUILD",full_name);
         params.SetParam("TBUILD",CFCGIParams::EncodeString(full_name));
         params.NextRun();
@@ -90,7 +99,7 @@ bool CISoftRepoServer::_Version(CFCGIRequest& request)
     }
 
     // process template ------------------------------------------------
-    bool result = ProcessTemplate(request,"Version.html",params);
+    bool result = ProcessTemplate("Version.html",params,page,&fragments);
 
     return(result);
 }